@@ -144,6 +144,8 @@ magma_thread_queue::~magma_thread_queue()
 
 /***************************************************************************//**
     Creates threads.
+    If a thread cannot be created, throws an exception; the threads created
+    until then are joined by quit() or the destructor.
     @param[in] in_nthread    Number of threads to launch.
 *******************************************************************************/
 void magma_thread_queue::launch( magma_int_t in_nthread )
@@ -155,7 +157,11 @@ void magma_thread_queue::launch( magma_int_t in_nthread )
     }
     threads = new pthread_t[ nthread ];
     for( magma_int_t i=0; i < nthread; ++i ) {
-        check( pthread_create( &threads[i], NULL, magma_thread_main, this ));
+        int err = pthread_create( &threads[i], NULL, magma_thread_main, this );
+        if ( err != 0 ) {
+            nthread = i;  // join only the threads that exist
+            check( err );
+        }
         //printf( "launch %d (%lx)\n", i, (long) threads[i] );
     }
 }
@@ -245,7 +251,8 @@ void magma_thread_queue::sync()
     Signals all threads that are waiting in pop_task().
     Waits for all threads to exit (i.e., joins them).
     It is safe to call quit multiple times -- the first time all the threads are
-    joined; subsequent times it does nothing.
+    joined; subsequent times it does nothing. If launch was never called,
+    there is nothing to join.
     (Destructor also calls quit, but you may prefer to call it explicitly.)
 *******************************************************************************/
 void magma_thread_queue::quit()
@@ -264,8 +271,7 @@ void magma_thread_queue::quit()
     check( pthread_mutex_unlock( &mutex ));
     
     // next, join all threads
-    if ( join ) {
-        assert( threads != NULL );
+    if ( join && threads != NULL ) {
         for( magma_int_t i=0; i < nthread; ++i ) {
             check( pthread_join( threads[i], NULL ));
             //printf( "joined %d (%lx)\n", i, (long) threads[i] );
@@ -716,7 +716,8 @@ typedef enum {
     Magma_CSRCOO       = 629,
     Magma_CUCSR        = 630,
     Magma_COOLIST      = 631,
-    Magma_CSR5         = 632
+    Magma_CSR5         = 632,
+    Magma_CSRDELTA     = 633
 } magma_storage_t;
 
 
@@ -778,7 +779,14 @@ typedef enum {
     Magma_VBJACOBI     = 508,
     Magma_PARDISO      = 509,
     Magma_SYNCFREESOLVE= 510,
-    Magma_ILUT         = 511
+    Magma_ILUT         = 511,
+    Magma_CACG         = 512,
+    Magma_CAGMRES      = 513,
+    Magma_PCAGMRES     = 514,
+    Magma_PIPECG       = 515,
+    Magma_PPIPECG      = 516,
+    Magma_PIPEGMRES    = 517,
+    Magma_PPIPEGMRES   = 518
 } magma_solver_type;
 
 typedef enum {
@@ -820,6 +828,17 @@ typedef enum {
     Magma_UNITDIAGCOL  = 516, // to be deprecated
 } magma_scale_t;
 
+typedef enum {
+    Magma_NOREORDER    = 521,
+    Magma_RCM          = 522,
+    Magma_ND           = 523
+} magma_reorder_t;
+
+typedef enum {
+    Magma_MONOMIAL     = 531,
+    Magma_NEWTON       = 532
+} magma_basis_t;
+
 
 typedef enum {
     Magma_SOLVE        = 801,
@@ -25,4 +25,18 @@ void magma_trisolve_free(magma_solve_info_t *solve_info) {
         solve_info->descr = NULL;
     }
 #endif
+    magma_free_cpu(solve_info->level_ptr);
+    magma_free_cpu(solve_info->perm);
+    magma_free_cpu(solve_info->row);
+    magma_free_cpu(solve_info->col);
+    magma_free_cpu(solve_info->val);
+    magma_free_cpu(solve_info->diag);
+    solve_info->level_ptr = NULL;
+    solve_info->perm = NULL;
+    solve_info->row = NULL;
+    solve_info->col = NULL;
+    solve_info->val = NULL;
+    solve_info->diag = NULL;
+    solve_info->num_rows = 0;
+    solve_info->num_levels = 0;
 }
@@ -35,6 +35,8 @@ void magma_trisolve_free(magma_solve_info_t *solve_info);
 
     Performs a triangular solve analysis for the given system matrix.
     Abstracts away interface for cuSPARSE/hipSPARSE.
+    For a matrix on Magma_CPU, the level sets of the rows are computed once
+    and the rows are stored level by level for a parallel host solve.
 
     Arguments
     ---------
@@ -80,6 +82,9 @@ magma_int_t magma_ztrisolve_analysis(
 
     Performs a triangular solve with the given solve info.
     Abstracts away interface for cuSPARSE/hipSPARSE.
+    For a matrix on Magma_CPU, the levels are solved one after the other,
+    the rows of each level in parallel. b and x may hold several
+    right-hand sides (column-major).
 
     Arguments
     ---------
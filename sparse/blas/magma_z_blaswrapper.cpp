@@ -100,6 +100,12 @@
     For a given input matrix A and vectors x, y and scalars alpha, beta
     the wrapper determines the suitable SpMV computing
               y = alpha * A * x + beta * y.
+    If the operands are located in CPU memory, the OpenMP host kernels are
+    used; they support CSR, ELL, ELLPACKT, ELLD, ELLRT, SELLP, CSR5 and
+    CSRDELTA, and CSR and SELLP for multiple vectors (the result is
+    column-major).
+    If a CPU matrix in CSR, CSRDELTA or SELLP carries a reduced-precision copy of its
+    values (see magma_zmlag2c_cpu), the single vector SpMV reads that copy.
     Arguments
     ---------
 
@@ -140,9 +146,6 @@ magma_z_spmv(
     magma_int_t info = 0;
 
     magma_z_matrix x2={Magma_CSR};
-    magma_z_matrix dA={Magma_CSR};
-    magma_z_matrix dx={Magma_CSR};
-    magma_z_matrix dy={Magma_CSR};
 
     cusparseHandle_t cusparseHandle = 0;
     cusparseMatDescr_t descr = 0;
@@ -327,28 +330,113 @@ magma_z_spmv(
             }
         }
     }
-    // CPU case missing!
+    // CPU case
     else {
-        CHECK( magma_zmtransfer( x, &dx, x.memory_location, Magma_DEV, queue ));
-        CHECK( magma_zmtransfer( y, &dy, y.memory_location, Magma_DEV, queue ));
-        CHECK( magma_zmtransfer( A, &dA, A.memory_location, Magma_DEV, queue ));
-        CHECK( magma_z_spmv( alpha, dA, dx, beta, dy, queue ) );
-        magma_zmfree(&x, queue );
-        magma_zmfree(&y, queue );
-        magma_zmfree(&A, queue );
-        CHECK( magma_zmtransfer( dx, &x, dx.memory_location, Magma_CPU, queue ));
-        CHECK( magma_zmtransfer( dy, &y, dy.memory_location, Magma_CPU, queue ));
-        CHECK( magma_zmtransfer( dA, &A, dA.memory_location, Magma_CPU, queue ));
-
+        if ( A.num_cols == x.num_rows && x.num_cols == 1 ) {
+            if ( A.storage_type == Magma_CSR   ||
+                 A.storage_type == Magma_CUCSR ||
+                 A.storage_type == Magma_CSRD  ||
+                 A.storage_type == Magma_CSRL  ||
+                 A.storage_type == Magma_CSRU )
+            {
+                if ( A.lval != NULL ) {
+                    CHECK( magma_zgecsrmv_mixed_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       alpha, A.lval_bits, A.lval, A.row, A.col, x.val, beta, y.val, queue ));
+                } else {
+                    CHECK( magma_zgecsrmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       alpha, A.val, A.row, A.col, x.val, beta, y.val, queue ));
+                }
+            }
+            else if ( A.storage_type == Magma_ELL ) {
+                CHECK( magma_zgeelltmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.max_nnz_row, alpha, A.val, A.col, x.val, beta,
+                   y.val, queue ));
+            }
+            else if ( A.storage_type == Magma_ELLPACKT ||
+                      A.storage_type == Magma_ELLD ) {
+                CHECK( magma_zgeellmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.max_nnz_row, alpha, A.val, A.col, x.val, beta,
+                   y.val, queue ));
+            }
+            else if ( A.storage_type == Magma_ELLRT ) {
+                CHECK( magma_zgeellrtmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.max_nnz_row, alpha, A.val, A.col, A.row, x.val,
+                   beta, y.val, A.alignment, queue ));
+            }
+            else if ( A.storage_type == Magma_CSRDELTA ) {
+                if ( A.lval != NULL ) {
+                    CHECK( magma_zgecsrdeltamv_mixed_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       alpha, A.lval_bits, A.lval, A.row, A.delta_ptr, A.delta_desc,
+                       A.delta_base, A.delta_col, x.val, beta, y.val, queue ));
+                } else {
+                    CHECK( magma_zgecsrdeltamv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       alpha, A.val, A.row, A.delta_ptr, A.delta_desc,
+                       A.delta_base, A.delta_col, x.val, beta, y.val, queue ));
+                }
+            }
+            else if ( A.storage_type == Magma_SELLP && A.lval != NULL ) {
+                CHECK( magma_zgesellpmv_mixed_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.blocksize, A.numblocks, A.alignment,
+                   alpha, A.lval_bits, A.lval, A.col, A.row, x.val, beta, y.val, queue ));
+            }
+            else if ( A.storage_type == Magma_SELLP ) {
+                CHECK( magma_zgesellpmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.blocksize, A.numblocks, A.alignment,
+                   alpha, A.val, A.col, A.row, x.val, beta, y.val, queue ));
+            }
+            else if ( A.storage_type == Magma_CSR5 ) {
+                CHECK( magma_zgecsr5mv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   A.csr5_p, alpha, A.csr5_sigma, A.csr5_bit_y_offset,
+                   A.csr5_bit_scansum_offset, A.csr5_num_packets,
+                   A.tile_ptr, A.tile_desc, A.tile_desc_offset_ptr, A.tile_desc_offset,
+                   A.calibrator, A.csr5_tail_tile_start,
+                   A.val, A.row, A.col, x.val, beta, y.val, queue ));
+            }
+            else {
+                printf("error: format not supported.\n");
+                info = MAGMA_ERR_NOT_SUPPORTED;
+            }
+        }
+        else if ( A.num_cols < x.num_rows || x.num_cols > 1 ) {
+            magma_int_t num_vecs = x.num_rows / A.num_cols * x.num_cols;
+            // the host kernels read X row-major and write Y column-major
+            magmaDoubleComplex_ptr xval = x.val;
+            if ( x.major == MagmaColMajor ) {
+                magma_z_matrix xv = x;
+                xv.num_rows = A.num_cols;
+                xv.num_cols = num_vecs;
+                CHECK( magma_zvtranspose( xv, &x2, queue ));
+                xval = x2.val;
+            }
+            if ( A.storage_type == Magma_CSR   ||
+                 A.storage_type == Magma_CUCSR ||
+                 A.storage_type == Magma_CSRD  ||
+                 A.storage_type == Magma_CSRL  ||
+                 A.storage_type == Magma_CSRU )
+            {
+                CHECK( magma_zmgecsrmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   num_vecs, alpha, A.val, A.row, A.col, xval, beta, y.val, queue ));
+            }
+            else if ( A.storage_type == Magma_SELLP ) {
+                CHECK( magma_zmgesellpmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                   num_vecs, A.blocksize, A.numblocks, A.alignment,
+                   alpha, A.val, A.col, A.row, xval, beta, y.val, queue ));
+            }
+            else {
+                printf("error: format not supported.\n");
+                info = MAGMA_ERR_NOT_SUPPORTED;
+            }
+        }
+        else {
+            printf("error: format not supported.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
     }
 
 cleanup:
     cusparseDestroyMatDescr( descr );
     descr = 0;
     magma_zmfree(&x2, queue );
-    magma_zmfree(&dx, queue );
-    magma_zmfree(&dy, queue );
-    magma_zmfree(&dA, queue );
     
     return info;
 }
@@ -0,0 +1,1288 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+#include <math.h>
+#include <new>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "thread_queue.hpp"
+#include "magmasparse_internal.h"  // after thread_queue.hpp, so max, min are defined
+
+#define PRECISION_z
+
+/*
+    Sum of conj(x[i]) * y[i] for start <= i < end.
+*/
+static inline magmaDoubleComplex
+magma_zdotc_chunk_cpu(
+    magma_int_t start,
+    magma_int_t end,
+    const magmaDoubleComplex *x,
+    const magmaDoubleComplex *y )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re = 0.0, im = 0.0;
+    #pragma omp simd reduction(+:re,im)
+    for( magma_int_t i=start; i < end; i++ ) {
+        magmaDoubleComplex a = x[i];
+        magmaDoubleComplex b = y[i];
+        re += MAGMA_Z_REAL(a) * MAGMA_Z_REAL(b) + MAGMA_Z_IMAG(a) * MAGMA_Z_IMAG(b);
+        im += MAGMA_Z_REAL(a) * MAGMA_Z_IMAG(b) - MAGMA_Z_IMAG(a) * MAGMA_Z_REAL(b);
+    }
+    return MAGMA_Z_MAKE( re, im );
+#else
+    magmaDoubleComplex dot = MAGMA_Z_ZERO;
+    #pragma omp simd reduction(+:dot)
+    for( magma_int_t i=start; i < end; i++ ) {
+        dot += x[i] * y[i];
+    }
+    return dot;
+#endif
+}
+
+
+/**
+    Purpose
+    -------
+
+    Copies a vector on the CPU: y = x.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    x           const magmaDoubleComplex*
+                input vector x
+
+    @param[out]
+    y           magmaDoubleComplex*
+                output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" void
+magma_zcopy_cpu(
+    magma_int_t n,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            y[i] = x[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Sets all entries of a vector on the CPU: x = alpha.
+    Called on freshly allocated memory, the pages are first touched by the
+    threads that later work on them in the other host kernels, which use
+    the same static partition.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                value
+
+    @param[out]
+    x           magmaDoubleComplex*
+                vector x
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" void
+magma_zset_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *x,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            x[i] = alpha;
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Scales a vector on the CPU: x = alpha * x.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in,out]
+    x           magmaDoubleComplex*
+                vector x
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" void
+magma_zscal_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *x,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            x[i] = alpha * x[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes y = alpha * x + y on the CPU.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    x           const magmaDoubleComplex*
+                input vector x
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" void
+magma_zaxpy_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            y[i] = y[i] + alpha * x[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges two vector updates into one sweep on the CPU:
+
+    y = y + alpha * x
+    v = v + beta * u
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    x           const magmaDoubleComplex*
+                input vector x
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in]
+    u           const magmaDoubleComplex*
+                input vector u
+
+    @param[in,out]
+    v           magmaDoubleComplex*
+                input/output vector v
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" void
+magma_zaxpy2_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y,
+    magmaDoubleComplex beta,
+    const magmaDoubleComplex *u,
+    magmaDoubleComplex *v,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            y[i] = y[i] + alpha * x[i];
+            v[i] = v[i] + beta * u[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the dot product conj(x)^T * y on the CPU.
+    The vectors are split into chunks that only depend on n, and the
+    partial sums of the chunks are added in order, so the result is the
+    same for any number of OpenMP threads.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    x           const magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    y           const magmaDoubleComplex*
+                input vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magmaDoubleComplex
+magma_zdotc_cpu(
+    magma_int_t n,
+    const magmaDoubleComplex *x,
+    const magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    magmaDoubleComplex partial[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    magmaDoubleComplex dot = MAGMA_Z_ZERO;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        partial[c] = magma_zdotc_chunk_cpu( c*len, min( n, (c+1)*len ), x, y );
+    }
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        dot += partial[c];
+    }
+    return dot;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the Euclidean norm of a vector on the CPU, with the same
+    thread-independent reduction as magma_zdotc_cpu.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    x           const magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" double
+magma_dznrm2_cpu(
+    magma_int_t n,
+    const magmaDoubleComplex *x,
+    magma_queue_t queue )
+{
+    double partial[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    double nrm = 0.0;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        double sum = 0.0;
+        #pragma omp simd reduction(+:sum)
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            sum += MAGMA_Z_REAL(x[i]) * MAGMA_Z_REAL(x[i])
+             + MAGMA_Z_IMAG(x[i]) * MAGMA_Z_IMAG(x[i]);
+        }
+        partial[c] = sum;
+    }
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        nrm += partial[c];
+    }
+    return sqrt( nrm );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes all inner products of two blocks of vectors on the CPU,
+    G = V^H * W, in one sweep over the vectors.
+    For the s-step solvers this is the single global reduction of a block.
+    Each chunk of rows (see magma_sparse_cpu_chunks) accumulates a k-by-l
+    partial result, and the partial results are added in chunk order, so G
+    is the same for any number of OpenMP threads.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    k           magma_int_t
+                number of vectors in V
+
+    @param[in]
+    V           const magmaDoubleComplex*
+                n-by-k block V
+
+    @param[in]
+    ldv         magma_int_t
+                leading dimension of V
+
+    @param[in]
+    l           magma_int_t
+                number of vectors in W
+
+    @param[in]
+    W           const magmaDoubleComplex*
+                n-by-l block W
+
+    @param[in]
+    ldw         magma_int_t
+                leading dimension of W
+
+    @param[out]
+    G           magmaDoubleComplex*
+                k-by-l matrix G = V^H * W
+
+    @param[in]
+    ldg         magma_int_t
+                leading dimension of G
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmdotc_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    const magmaDoubleComplex *V,
+    magma_int_t ldv,
+    magma_int_t l,
+    const magmaDoubleComplex *W,
+    magma_int_t ldw,
+    magmaDoubleComplex *G,
+    magma_int_t ldg,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magmaDoubleComplex *partial = NULL;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    CHECK( magma_zmalloc_cpu( &partial, chunks*k*l + 1 ));
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        for( magma_int_t j=0; j < l; j++ ) {
+            for( magma_int_t i=0; i < k; i++ ) {
+                partial[ c*k*l + j*k + i ] =
+                    magma_zdotc_chunk_cpu( c*len, end, V+i*ldv, W+j*ldw );
+            }
+        }
+    }
+    for( magma_int_t j=0; j < l; j++ ) {
+        for( magma_int_t i=0; i < k; i++ ) {
+            magmaDoubleComplex dot = MAGMA_Z_ZERO;
+            for( magma_int_t c=0; c < chunks; c++ ) {
+                dot += partial[ c*k*l + j*k + i ];
+            }
+            G[ j*ldg + i ] = dot;
+        }
+    }
+
+cleanup:
+    magma_free_cpu( partial );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Updates a block of vectors with a linear combination of another block
+    on the CPU, in one sweep over the vectors:
+
+    W = beta * W + alpha * V * C
+
+    where C is a small k-by-l matrix. For beta = 0, W is not read.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    k           magma_int_t
+                number of vectors in V
+
+    @param[in]
+    l           magma_int_t
+                number of vectors in W
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    V           const magmaDoubleComplex*
+                n-by-k block V
+
+    @param[in]
+    ldv         magma_int_t
+                leading dimension of V
+
+    @param[in]
+    C           const magmaDoubleComplex*
+                k-by-l coefficient matrix
+
+    @param[in]
+    ldc         magma_int_t
+                leading dimension of C
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in,out]
+    W           magmaDoubleComplex*
+                n-by-l block W, must not overlap V
+
+    @param[in]
+    ldw         magma_int_t
+                leading dimension of W
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" void
+magma_zmgemm_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magma_int_t l,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *V,
+    magma_int_t ldv,
+    const magmaDoubleComplex *C,
+    magma_int_t ldc,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *W,
+    magma_int_t ldw,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        for( magma_int_t j=0; j < l; j++ ) {
+            magmaDoubleComplex *w = W + j*ldw;
+            if ( beta == MAGMA_Z_ZERO ) {
+                #pragma omp simd
+                for( magma_int_t i=c*len; i < end; i++ ) {
+                    w[i] = MAGMA_Z_ZERO;
+                }
+            } else if ( beta != MAGMA_Z_ONE ) {
+                #pragma omp simd
+                for( magma_int_t i=c*len; i < end; i++ ) {
+                    w[i] = beta * w[i];
+                }
+            }
+            for( magma_int_t p=0; p < k; p++ ) {
+                magmaDoubleComplex coef = alpha * C[ j*ldc + p ];
+                const magmaDoubleComplex *v = V + p*ldv;
+                if ( coef == MAGMA_Z_ZERO ) {
+                    continue;
+                }
+                #pragma omp simd
+                for( magma_int_t i=c*len; i < end; i++ ) {
+                    w[i] = w[i] + coef * v[i];
+                }
+            }
+        }
+    }
+}
+
+
+/*
+    Helper threads and partial sums of a non-blocking reduction,
+    see magma_zdotc_start_cpu.
+*/
+struct magma_z_reduction
+{
+    magma_thread_queue helpers;         // helper threads computing the dot products
+    magma_int_t nhelp;                  // number of helper threads, 0 = synchronous
+    magma_int_t nthread;                // OpenMP threads of the caller outside a reduction
+    magma_int_t n;                      // vector length
+    magma_int_t maxdots;                // dot products per reduction, at most
+    magma_int_t ndots;                  // dot products of the pending reduction, 0 = none
+    const magmaDoubleComplex **x;       // vectors of the pending reduction
+    const magmaDoubleComplex **y;
+    magmaDoubleComplex *dots;           // result of the pending reduction
+    magmaDoubleComplex *partial;        // one partial sum per chunk and dot product
+};
+
+
+/*
+    Computes the partial sums of the chunks cstart <= c < cend of the
+    dot products of a pending reduction, on a helper thread.
+*/
+class magma_zdotc_task: public magma_task
+{
+public:
+    magma_zdotc_task( magma_z_reduction *red, magma_int_t cstart, magma_int_t cend ):
+        m_red( red ), m_cstart( cstart ), m_cend( cend ) {}
+
+    virtual void run()
+    {
+        magma_int_t len;
+        magma_int_t n = m_red->n, ndots = m_red->ndots;
+        magma_sparse_cpu_chunks( n, &len );
+        for( magma_int_t c=m_cstart; c < m_cend; c++ ) {
+            magma_int_t end = min( n, (c+1)*len );
+            for( magma_int_t d=0; d < ndots; d++ ) {
+                m_red->partial[ c*ndots + d ] =
+                    magma_zdotc_chunk_cpu( c*len, end, m_red->x[d], m_red->y[d] );
+            }
+        }
+    }
+
+private:
+    magma_z_reduction *m_red;
+    magma_int_t m_cstart, m_cend;
+};
+
+
+/**
+    Purpose
+    -------
+
+    Creates the helper threads of the non-blocking reductions of the
+    pipelined host solvers, see magma_zdotc_start_cpu.
+
+    The helper threads are taken from the OpenMP threads of the caller:
+    with nt = omp_get_max_threads(), the number of helper threads is
+    chosen in proportion to the memory traffic of one reduction against
+    the one of the SpMV with A it overlaps,
+
+    nhelp = nt * bytes( reduction ) / ( bytes( reduction ) + bytes( SpMV ) ),
+
+    at least 1 and at most nt/2, so that both finish at about the same
+    time. While a reduction is in flight, the OpenMP parallel regions of
+    the caller run with nt - nhelp threads. With nt = 1 there are no helper
+    threads, and magma_zdotc_start_cpu computes the dot products at once.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                system matrix, its SpMV is overlapped with the reductions
+
+    @param[in]
+    maxdots     magma_int_t
+                maximum number of dot products per reduction
+
+    @param[in]
+    nvec        magma_int_t
+                average number of distinct vectors read by one reduction
+
+    @param[out]
+    red         magma_z_reduction_t*
+                reduction handle
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zreduction_create_cpu(
+    magma_z_matrix A,
+    magma_int_t maxdots,
+    magma_int_t nvec,
+    magma_z_reduction_t *red,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_z_reduction *r = NULL;
+    magma_int_t len, nthread = 1;
+    magma_int_t n = A.num_rows;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    double rbytes = (double) nvec * n * sizeof(magmaDoubleComplex);
+    double sbytes = (double) A.nnz * ( sizeof(magmaDoubleComplex) + sizeof(magma_index_t) )
+                  + 2.0 * n * sizeof(magmaDoubleComplex);
+
+    #ifdef _OPENMP
+    nthread = omp_get_max_threads();
+    #endif
+
+    *red = NULL;
+    r = new (std::nothrow) magma_z_reduction;
+    if ( r == NULL ) {
+        return MAGMA_ERR_HOST_ALLOC;
+    }
+    r->nthread = nthread;
+    r->nhelp = 0;
+    if ( nthread > 1 ) {
+        r->nhelp = (magma_int_t) ( nthread * rbytes / ( rbytes + sbytes ) + 0.5 );
+        r->nhelp = max( 1, min( min( r->nhelp, nthread/2 ), chunks ));
+    }
+    r->n = n;
+    r->maxdots = maxdots;
+    r->ndots = 0;
+    r->x = NULL;
+    r->y = NULL;
+    r->dots = NULL;
+    r->partial = NULL;
+    if ( r->nhelp > 0 ) {
+        try {
+            r->helpers.launch( r->nhelp );
+        }
+        catch( ... ) {
+            // the threads launched so far are joined by the destructor
+            info = MAGMA_ERR;
+        }
+        if ( info != 0 ) {
+            goto cleanup;
+        }
+    }
+    CHECK( magma_malloc_cpu( (void**) &r->x, maxdots*sizeof(magmaDoubleComplex*) ));
+    CHECK( magma_malloc_cpu( (void**) &r->y, maxdots*sizeof(magmaDoubleComplex*) ));
+    CHECK( magma_zmalloc_cpu( &r->partial, chunks*maxdots ));
+    *red = r;
+    r = NULL;
+
+cleanup:
+    if ( r != NULL ) {
+        magma_zreduction_destroy_cpu( r, queue );
+    }
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Waits for a pending reduction, then stops the helper threads and
+    frees the handle.
+
+    Arguments
+    ---------
+
+    @param[in]
+    red         magma_z_reduction_t
+                reduction handle, may be NULL
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zreduction_destroy_cpu(
+    magma_z_reduction_t red,
+    magma_queue_t queue )
+{
+    if ( red == NULL ) {
+        return MAGMA_SUCCESS;
+    }
+    magma_zdotc_wait_cpu( red, queue );
+    magma_free_cpu( red->x );
+    magma_free_cpu( red->y );
+    magma_free_cpu( red->partial );
+    delete red;
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Starts a non-blocking reduction on the CPU: the dot products
+
+    dots[d] = x[d]' * y[d],  d = 0, ..., ndots-1
+
+    are computed by the helper threads of red, while the caller goes on,
+    typically with the SpMV and the preconditioner of the next iteration
+    of a pipelined solver. The result is available after
+    magma_zdotc_wait_cpu; until then, the vectors must not be modified
+    and dots must not be read.
+    The partial sums of the chunks of magma_sparse_cpu_chunks are added
+    in chunk order, so the dot products are the same as the ones of
+    magma_zdotc_cpu, for any number of threads.
+
+    Arguments
+    ---------
+
+    @param[in]
+    ndots       magma_int_t
+                number of dot products, at most the maxdots of red
+
+    @param[in]
+    x           const magmaDoubleComplex**
+                array of the ndots left vectors
+
+    @param[in]
+    y           const magmaDoubleComplex**
+                array of the ndots right vectors
+
+    @param[out]
+    dots        magmaDoubleComplex*
+                array of the ndots dot products
+
+    @param[in]
+    red         magma_z_reduction_t
+                reduction handle without pending reduction
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zdotc_start_cpu(
+    magma_int_t ndots,
+    const magmaDoubleComplex **x,
+    const magmaDoubleComplex **y,
+    magmaDoubleComplex *dots,
+    magma_z_reduction_t red,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( red->n, &len );
+
+    if ( red->ndots != 0 || ndots > red->maxdots ) {
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    if ( ndots == 0 ) {
+        return MAGMA_SUCCESS;
+    }
+    for( magma_int_t d=0; d < ndots; d++ ) {
+        red->x[d] = x[d];
+        red->y[d] = y[d];
+    }
+    red->ndots = ndots;
+    red->dots = dots;
+    if ( red->nhelp == 0 ) {
+        // no helper threads, the partial sums are added in magma_zdotc_wait_cpu
+        magma_zdotc_task( red, 0, chunks ).run();
+        return MAGMA_SUCCESS;
+    }
+    // contiguous ranges of chunks, one per helper thread
+    for( magma_int_t t=0; t < red->nhelp; t++ ) {
+        red->helpers.push_task( new magma_zdotc_task( red,
+                                    t*chunks/red->nhelp, (t+1)*chunks/red->nhelp ));
+    }
+    #ifdef _OPENMP
+    omp_set_num_threads( max( 1, red->nthread - red->nhelp ));
+    #endif
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Completes a non-blocking reduction started with magma_zdotc_start_cpu:
+    waits for the helper threads and adds up the partial sums. Returns
+    immediately if no reduction is pending.
+
+    Arguments
+    ---------
+
+    @param[in]
+    red         magma_z_reduction_t
+                reduction handle
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zdotc_wait_cpu(
+    magma_z_reduction_t red,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( red->n, &len );
+    magma_int_t ndots = red->ndots;
+
+    if ( ndots == 0 ) {
+        return MAGMA_SUCCESS;
+    }
+    if ( red->nhelp > 0 ) {
+        red->helpers.sync();
+        #ifdef _OPENMP
+        omp_set_num_threads( red->nthread );
+        #endif
+    }
+    for( magma_int_t d=0; d < ndots; d++ ) {
+        magmaDoubleComplex dot = MAGMA_Z_ZERO;
+        for( magma_int_t c=0; c < chunks; c++ ) {
+            dot += red->partial[ c*ndots + d ];
+        }
+        red->dots[d] = dot;
+    }
+    red->ndots = 0;
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges multiple operations into one sweep on the CPU:
+
+    p = r + beta * ( p - omega * v )
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                dimension m
+
+    @param[in]
+    num_cols    magma_int_t
+                dimension n
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in]
+    omega       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    r           const magmaDoubleComplex*
+                vector
+
+    @param[in]
+    v           const magmaDoubleComplex*
+                vector
+
+    @param[in,out]
+    p           magmaDoubleComplex*
+                input/output vector
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" void
+magma_zbicgstab_1_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex omega,
+    const magmaDoubleComplex *r,
+    const magmaDoubleComplex *v,
+    magmaDoubleComplex *p,
+    magma_queue_t queue )
+{
+    magma_int_t n = num_rows*num_cols;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            p[i] = r[i] + beta * ( p[i] - omega * v[i] );
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges multiple operations into one sweep on the CPU:
+
+    s = r - alpha v
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                dimension m
+
+    @param[in]
+    num_cols    magma_int_t
+                dimension n
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    r           const magmaDoubleComplex*
+                vector
+
+    @param[in]
+    v           const magmaDoubleComplex*
+                vector
+
+    @param[out]
+    s           magmaDoubleComplex*
+                output vector
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" void
+magma_zbicgstab_2_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *r,
+    const magmaDoubleComplex *v,
+    magmaDoubleComplex *s,
+    magma_queue_t queue )
+{
+    magma_int_t n = num_rows*num_cols;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            s[i] = r[i] - alpha * v[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges multiple operations into one sweep on the CPU:
+
+    x = x + alpha * y + omega * z
+    r = s - omega * t
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                dimension m
+
+    @param[in]
+    num_cols    magma_int_t
+                dimension n
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    omega       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    y           const magmaDoubleComplex*
+                vector
+
+    @param[in]
+    z           const magmaDoubleComplex*
+                vector
+
+    @param[in]
+    s           const magmaDoubleComplex*
+                vector
+
+    @param[in]
+    t           const magmaDoubleComplex*
+                vector
+
+    @param[in,out]
+    x           magmaDoubleComplex*
+                input/output vector
+
+    @param[out]
+    r           magmaDoubleComplex*
+                output vector
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" void
+magma_zbicgstab_4_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex omega,
+    const magmaDoubleComplex *y,
+    const magmaDoubleComplex *z,
+    const magmaDoubleComplex *s,
+    const magmaDoubleComplex *t,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magma_queue_t queue )
+{
+    magma_int_t n = num_rows*num_cols;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        #pragma omp simd
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            x[i] = x[i] + alpha * y[i] + omega * z[i];
+            r[i] = s[i] - omega * t[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Applies the Jacobi scaling on the CPU: c = D^(-1) * b, where d holds
+    the inverse diagonal entries as returned by
+    magma_zjacobisetup_diagscal_cpu.
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                number of rows
+
+    @param[in]
+    d           magma_z_matrix
+                vector with the inverse diagonal entries
+
+    @param[in]
+    b           magma_z_matrix
+                input vector b
+
+    @param[out]
+    c           magma_z_matrix*
+                c = D^(-1) * b
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_z
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zjacobi_diagscal_cpu(
+    magma_int_t num_rows,
+    magma_z_matrix d,
+    magma_z_matrix b,
+    magma_z_matrix *c,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t num_vecs = b.num_rows*b.num_cols/num_rows;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( num_rows, &len );
+
+    if ( d.memory_location != Magma_CPU || b.memory_location != Magma_CPU ||
+         c->memory_location != Magma_CPU ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    for( magma_int_t j=0; j < num_vecs; j++ ) {
+        const magmaDoubleComplex *bj = b.val + j*num_rows;
+        magmaDoubleComplex *cj = c->val + j*num_rows;
+        #pragma omp parallel for schedule(static) if( chunks > 1 )
+        for( magma_int_t k=0; k < chunks; k++ ) {
+            magma_int_t end = min( num_rows, (k+1)*len );
+            #pragma omp simd
+            for( magma_int_t i=k*len; i < end; i++ ) {
+                cj[i] = d.val[i] * bj[i];
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
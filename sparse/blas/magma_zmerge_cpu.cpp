@@ -0,0 +1,898 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+/*
+    Host counterparts of the fused kernels in zmergecg.cu and
+    zmergebicgstab.cu. Every kernel makes one pass over the vectors for the
+    update and computes the dot products needed next from the values it
+    just wrote. For CSR matrices the vector update, the SpMV and the dot
+    products run in one parallel region, with one barrier between the
+    update and the SpMV.
+
+    All loops use the static partition of magma_sparse_cpu_chunks, so a
+    thread always works on the same rows of all vectors (NUMA first touch,
+    see magma_zset_cpu), and the dot products add the partial sums of the
+    chunks in order: the results do not depend on the number of threads.
+*/
+
+// sum += conj(a) * b, on the real and imaginary part separately;
+// in the real precisions, im is not declared and the macros ignore it
+#if defined(PRECISION_z) || defined(PRECISION_c)
+#define MAGMA_ZMERGE_DOTC_INIT( re, im )  double re = 0.0, im = 0.0
+#define MAGMA_ZMERGE_DOTC( re, im, a, b )                                   \
+    re += MAGMA_Z_REAL(a) * MAGMA_Z_REAL(b) + MAGMA_Z_IMAG(a) * MAGMA_Z_IMAG(b); \
+    im += MAGMA_Z_REAL(a) * MAGMA_Z_IMAG(b) - MAGMA_Z_IMAG(a) * MAGMA_Z_REAL(b)
+#define MAGMA_ZMERGE_SUM( re, im )  MAGMA_Z_MAKE( re, im )
+#else
+#define MAGMA_ZMERGE_DOTC_INIT( re, im )  double re = 0.0
+#define MAGMA_ZMERGE_DOTC( re, im, a, b )  re += (a) * (b)
+#define MAGMA_ZMERGE_SUM( re, im )  (re)
+#endif
+
+
+/*
+    Returns true if the SpMV with A can be fused into the vector kernels:
+    CSR-type storage on the CPU, without reduced-precision values.
+*/
+static inline bool
+magma_zmerge_fused_cpu(
+    magma_z_matrix A )
+{
+    return A.memory_location == Magma_CPU && A.lval == NULL &&
+           ( A.storage_type == Magma_CSR   ||
+             A.storage_type == Magma_CUCSR ||
+             A.storage_type == Magma_CSRD  ||
+             A.storage_type == Magma_CSRL  ||
+             A.storage_type == Magma_CSRU );
+}
+
+
+/*
+    Row i of A times x for A in CSR.
+*/
+static inline magmaDoubleComplex
+magma_zmerge_rowdot_cpu(
+    magma_index_t start,
+    magma_index_t end,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re = 0.0, im = 0.0;
+    #pragma omp simd reduction(+:re,im)
+    for( magma_index_t j=start; j < end; j++ ) {
+        magmaDoubleComplex a = val[j];
+        magmaDoubleComplex b = x[ col[j] ];
+        re += MAGMA_Z_REAL(a) * MAGMA_Z_REAL(b) - MAGMA_Z_IMAG(a) * MAGMA_Z_IMAG(b);
+        im += MAGMA_Z_REAL(a) * MAGMA_Z_IMAG(b) + MAGMA_Z_IMAG(a) * MAGMA_Z_REAL(b);
+    }
+    return MAGMA_Z_MAKE( re, im );
+#else
+    magmaDoubleComplex dot = MAGMA_Z_ZERO;
+    #pragma omp simd reduction(+:dot)
+    for( magma_index_t j=start; j < end; j++ ) {
+        dot += val[j] * x[ col[j] ];
+    }
+    return dot;
+#endif
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the search direction update, the SpMV and the dot product of
+    the (preconditioned) CG on the CPU:
+
+    d = h + beta * d
+    z = A * d
+    rho = d' * z
+
+    For A in CSR, this is one parallel sweep. Otherwise, the update and
+    the dot product are OpenMP vector kernels around magma_z_spmv.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                system matrix on the CPU
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in]
+    h           magma_z_matrix
+                (preconditioned) residual
+
+    @param[in,out]
+    d           magma_z_matrix
+                search direction
+
+    @param[out]
+    z           magma_z_matrix
+                z = A * d
+
+    @param[out]
+    rho         magmaDoubleComplex*
+                rho = d' * z
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcgmerge_spmv1_cpu(
+    magma_z_matrix A,
+    magmaDoubleComplex beta,
+    magma_z_matrix h,
+    magma_z_matrix d,
+    magma_z_matrix z,
+    magmaDoubleComplex *rho,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    magmaDoubleComplex partial[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    magmaDoubleComplex c_one = MAGMA_Z_ONE, c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex *hv = h.val;
+    magmaDoubleComplex *dv = d.val, *zv = z.val;
+
+    if ( ! magma_zmerge_fused_cpu( A ) ) {
+        magma_zscal_cpu( n, beta, dv, queue );
+        magma_zaxpy_cpu( n, c_one, hv, dv, queue );
+        CHECK( magma_z_spmv( c_one, A, d, c_zero, z, queue ));
+        *rho = magma_zdotc_cpu( n, dv, zv, queue );
+        goto cleanup;
+    }
+
+    #pragma omp parallel if( chunks > 1 )
+    {
+        #pragma omp for schedule(static)
+        for( magma_int_t c=0; c < chunks; c++ ) {
+            magma_int_t end = min( n, (c+1)*len );
+            #pragma omp simd
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                dv[i] = hv[i] + beta * dv[i];
+            }
+        }
+        // implicit barrier: the SpMV reads all of d
+        #pragma omp for schedule(static)
+        for( magma_int_t c=0; c < chunks; c++ ) {
+            magma_int_t end = min( n, (c+1)*len );
+            MAGMA_ZMERGE_DOTC_INIT( re, im );
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                magmaDoubleComplex zi = magma_zmerge_rowdot_cpu(
+                    A.row[i], A.row[i+1], A.val, A.col, dv );
+                zv[i] = zi;
+                MAGMA_ZMERGE_DOTC( re, im, dv[i], zi );
+            }
+            partial[c] = MAGMA_ZMERGE_SUM( re, im );
+        }
+    }
+    *rho = c_zero;
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        *rho += partial[c];
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the solution and residual update of the CG on the CPU, and
+    computes the squared residual norm from the new residual:
+
+    x = x + alpha * d
+    r = r - alpha * z
+    nom = r' * r
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    d           const magmaDoubleComplex*
+                search direction
+
+    @param[in]
+    z           const magmaDoubleComplex*
+                z = A * d
+
+    @param[in,out]
+    x           magmaDoubleComplex*
+                solution approximation
+
+    @param[in,out]
+    r           magmaDoubleComplex*
+                residual
+
+    @param[out]
+    nom         double*
+                nom = r' * r
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" void
+magma_zcgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *d,
+    const magmaDoubleComplex *z,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    double *nom,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    double partial[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        double sum = 0.0;
+        #pragma omp simd reduction(+:sum)
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            magmaDoubleComplex ri = r[i] - alpha * z[i];
+            x[i] = x[i] + alpha * d[i];
+            r[i] = ri;
+            sum += MAGMA_Z_REAL(ri) * MAGMA_Z_REAL(ri)
+                 + MAGMA_Z_IMAG(ri) * MAGMA_Z_IMAG(ri);
+        }
+        partial[c] = sum;
+    }
+    *nom = 0.0;
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        *nom += partial[c];
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the solution and residual update of the Jacobi-preconditioned
+    CG with the application of the preconditioner on the CPU:
+
+    x = x + alpha * d
+    r = r - alpha * z
+    h = diag .* r
+    nom = r' * r
+    gamma = r' * h
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    diag        const magmaDoubleComplex*
+                inverse diagonal of A
+
+    @param[in]
+    d           const magmaDoubleComplex*
+                search direction
+
+    @param[in]
+    z           const magmaDoubleComplex*
+                z = A * d
+
+    @param[in,out]
+    x           magmaDoubleComplex*
+                solution approximation
+
+    @param[in,out]
+    r           magmaDoubleComplex*
+                residual
+
+    @param[out]
+    h           magmaDoubleComplex*
+                preconditioned residual
+
+    @param[out]
+    nom         double*
+                nom = r' * r
+
+    @param[out]
+    gamma       magmaDoubleComplex*
+                gamma = r' * h
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" void
+magma_zjcgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *diag,
+    const magmaDoubleComplex *d,
+    const magmaDoubleComplex *z,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magmaDoubleComplex *h,
+    double *nom,
+    magmaDoubleComplex *gamma,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    double partial_nom[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    magmaDoubleComplex partial_gamma[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        double sum = 0.0;
+        MAGMA_ZMERGE_DOTC_INIT( re, im );
+        #if defined(PRECISION_z) || defined(PRECISION_c)
+        #pragma omp simd reduction(+:sum,re,im)
+        #else
+        #pragma omp simd reduction(+:sum,re)
+        #endif
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            magmaDoubleComplex ri = r[i] - alpha * z[i];
+            magmaDoubleComplex hi = diag[i] * ri;
+            x[i] = x[i] + alpha * d[i];
+            r[i] = ri;
+            h[i] = hi;
+            sum += MAGMA_Z_REAL(ri) * MAGMA_Z_REAL(ri)
+                 + MAGMA_Z_IMAG(ri) * MAGMA_Z_IMAG(ri);
+            MAGMA_ZMERGE_DOTC( re, im, ri, hi );
+        }
+        partial_nom[c] = sum;
+        partial_gamma[c] = MAGMA_ZMERGE_SUM( re, im );
+    }
+    *nom = 0.0;
+    *gamma = MAGMA_Z_ZERO;
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        *nom += partial_nom[c];
+        *gamma += partial_gamma[c];
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the search direction update, the first SpMV and its dot
+    product of the BiCGSTAB on the CPU:
+
+    p = r + beta * ( p - omega * v )
+    v = A * p
+    rrv = rr' * v
+
+    For A in CSR, this is one parallel sweep. Otherwise, the update and
+    the dot product are OpenMP vector kernels around magma_z_spmv.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                system matrix on the CPU
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in]
+    omega       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    r           magma_z_matrix
+                residual
+
+    @param[in]
+    rr          magma_z_matrix
+                shadow residual
+
+    @param[in,out]
+    p           magma_z_matrix
+                search direction
+
+    @param[in,out]
+    v           magma_z_matrix
+                v = A * p
+
+    @param[out]
+    rrv         magmaDoubleComplex*
+                rrv = rr' * v
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zbicgmerge_spmv1_cpu(
+    magma_z_matrix A,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex omega,
+    magma_z_matrix r,
+    magma_z_matrix rr,
+    magma_z_matrix p,
+    magma_z_matrix v,
+    magmaDoubleComplex *rrv,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    magmaDoubleComplex partial[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    magmaDoubleComplex c_one = MAGMA_Z_ONE, c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex *rv = r.val, *rrval = rr.val;
+    magmaDoubleComplex *pv = p.val, *vv = v.val;
+
+    if ( ! magma_zmerge_fused_cpu( A ) ) {
+        magma_zbicgstab_1_cpu( n, 1, beta, omega, rv, vv, pv, queue );
+        CHECK( magma_z_spmv( c_one, A, p, c_zero, v, queue ));
+        *rrv = magma_zdotc_cpu( n, rrval, vv, queue );
+        goto cleanup;
+    }
+
+    #pragma omp parallel if( chunks > 1 )
+    {
+        #pragma omp for schedule(static)
+        for( magma_int_t c=0; c < chunks; c++ ) {
+            magma_int_t end = min( n, (c+1)*len );
+            #pragma omp simd
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                pv[i] = rv[i] + beta * ( pv[i] - omega * vv[i] );
+            }
+        }
+        // implicit barrier: the SpMV reads all of p, and overwrites v
+        #pragma omp for schedule(static)
+        for( magma_int_t c=0; c < chunks; c++ ) {
+            magma_int_t end = min( n, (c+1)*len );
+            MAGMA_ZMERGE_DOTC_INIT( re, im );
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                magmaDoubleComplex vi = magma_zmerge_rowdot_cpu(
+                    A.row[i], A.row[i+1], A.val, A.col, pv );
+                vv[i] = vi;
+                MAGMA_ZMERGE_DOTC( re, im, rrval[i], vi );
+            }
+            partial[c] = MAGMA_ZMERGE_SUM( re, im );
+        }
+    }
+    *rrv = c_zero;
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        *rrv += partial[c];
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the intermediate residual update, the second SpMV and its dot
+    products of the BiCGSTAB on the CPU:
+
+    s = r - alpha * v
+    t = A * s
+    ts = t' * s
+    tt = t' * t
+
+    For A in CSR, this is one parallel sweep. Otherwise, the update and
+    the dot products are OpenMP vector kernels around magma_z_spmv.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                system matrix on the CPU
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    r           magma_z_matrix
+                residual
+
+    @param[in]
+    v           magma_z_matrix
+                v = A * p
+
+    @param[out]
+    s           magma_z_matrix
+                s = r - alpha * v
+
+    @param[out]
+    t           magma_z_matrix
+                t = A * s
+
+    @param[out]
+    ts          magmaDoubleComplex*
+                ts = t' * s
+
+    @param[out]
+    tt          magmaDoubleComplex*
+                tt = t' * t
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zbicgmerge_spmv2_cpu(
+    magma_z_matrix A,
+    magmaDoubleComplex alpha,
+    magma_z_matrix r,
+    magma_z_matrix v,
+    magma_z_matrix s,
+    magma_z_matrix t,
+    magmaDoubleComplex *ts,
+    magmaDoubleComplex *tt,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    magmaDoubleComplex partial_ts[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    double partial_tt[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    magmaDoubleComplex c_one = MAGMA_Z_ONE, c_zero = MAGMA_Z_ZERO;
+    double sum_tt = 0.0;
+    const magmaDoubleComplex *rv = r.val, *vv = v.val;
+    magmaDoubleComplex *sv = s.val, *tv = t.val;
+
+    if ( ! magma_zmerge_fused_cpu( A ) ) {
+        magma_zbicgstab_2_cpu( n, 1, alpha, rv, vv, sv, queue );
+        CHECK( magma_z_spmv( c_one, A, s, c_zero, t, queue ));
+        *ts = magma_zdotc_cpu( n, tv, sv, queue );
+        *tt = magma_zdotc_cpu( n, tv, tv, queue );
+        goto cleanup;
+    }
+
+    #pragma omp parallel if( chunks > 1 )
+    {
+        #pragma omp for schedule(static)
+        for( magma_int_t c=0; c < chunks; c++ ) {
+            magma_int_t end = min( n, (c+1)*len );
+            #pragma omp simd
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                sv[i] = rv[i] - alpha * vv[i];
+            }
+        }
+        // implicit barrier: the SpMV reads all of s
+        #pragma omp for schedule(static)
+        for( magma_int_t c=0; c < chunks; c++ ) {
+            magma_int_t end = min( n, (c+1)*len );
+            double sum = 0.0;
+            MAGMA_ZMERGE_DOTC_INIT( re, im );
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                magmaDoubleComplex ti = magma_zmerge_rowdot_cpu(
+                    A.row[i], A.row[i+1], A.val, A.col, sv );
+                tv[i] = ti;
+                MAGMA_ZMERGE_DOTC( re, im, ti, sv[i] );
+                sum += MAGMA_Z_REAL(ti) * MAGMA_Z_REAL(ti)
+                     + MAGMA_Z_IMAG(ti) * MAGMA_Z_IMAG(ti);
+            }
+            partial_ts[c] = MAGMA_ZMERGE_SUM( re, im );
+            partial_tt[c] = sum;
+        }
+    }
+    *ts = c_zero;
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        *ts += partial_ts[c];
+        sum_tt += partial_tt[c];
+    }
+    *tt = MAGMA_Z_MAKE( sum_tt, 0.0 );
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the solution and residual update of the BiCGSTAB on the CPU,
+    and computes the dot products of the next iteration from the new
+    residual:
+
+    x = x + alpha * p + omega * s
+    r = s - omega * t
+    rho = rr' * r
+    nom = r' * r
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    omega       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    rr          const magmaDoubleComplex*
+                shadow residual
+
+    @param[in]
+    p           const magmaDoubleComplex*
+                search direction
+
+    @param[in]
+    s           const magmaDoubleComplex*
+                intermediate residual
+
+    @param[in]
+    t           const magmaDoubleComplex*
+                t = A * s
+
+    @param[in,out]
+    x           magmaDoubleComplex*
+                solution approximation
+
+    @param[out]
+    r           magmaDoubleComplex*
+                residual
+
+    @param[out]
+    rho         magmaDoubleComplex*
+                rho = rr' * r
+
+    @param[out]
+    nom         double*
+                nom = r' * r
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" void
+magma_zbicgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex omega,
+    const magmaDoubleComplex *rr,
+    const magmaDoubleComplex *p,
+    const magmaDoubleComplex *s,
+    const magmaDoubleComplex *t,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magmaDoubleComplex *rho,
+    double *nom,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    magmaDoubleComplex partial_rho[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+    double partial_nom[ MAGMA_SPARSE_CPU_MAXCHUNKS ];
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        double sum = 0.0;
+        MAGMA_ZMERGE_DOTC_INIT( re, im );
+        #if defined(PRECISION_z) || defined(PRECISION_c)
+        #pragma omp simd reduction(+:sum,re,im)
+        #else
+        #pragma omp simd reduction(+:sum,re)
+        #endif
+        for( magma_int_t i=c*len; i < end; i++ ) {
+            magmaDoubleComplex ri = s[i] - omega * t[i];
+            x[i] = x[i] + alpha * p[i] + omega * s[i];
+            r[i] = ri;
+            MAGMA_ZMERGE_DOTC( re, im, rr[i], ri );
+            sum += MAGMA_Z_REAL(ri) * MAGMA_Z_REAL(ri)
+                 + MAGMA_Z_IMAG(ri) * MAGMA_Z_IMAG(ri);
+        }
+        partial_rho[c] = MAGMA_ZMERGE_SUM( re, im );
+        partial_nom[c] = sum;
+    }
+    *rho = MAGMA_Z_ZERO;
+    *nom = 0.0;
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        *rho += partial_rho[c];
+        *nom += partial_nom[c];
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Merges the vector updates of the pipelined CG on the CPU into one
+    sweep:
+
+    z = nv + beta * z       q = m + beta * q
+    s = w  + beta * s       p = u + beta * p
+    x = x + alpha * p       r = r - alpha * s
+    u = u - alpha * q       w = w - alpha * z
+
+    Unlike the other kernels of this file, it does not compute the dot
+    products of the next iteration: the pipelined CG computes them with
+    magma_zdotc_start_cpu, overlapped with the preconditioner and SpMV.
+    Without preconditioner, u = r, m = w and q = s: u, m and q are then
+    passed as NULL and only the remaining vectors are updated.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                vector length
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in]
+    m           const magmaDoubleComplex*
+                m = M^(-1) w, or NULL
+
+    @param[in]
+    nv          const magmaDoubleComplex*
+                nv = A m
+
+    @param[in,out]
+    x           magmaDoubleComplex*
+                solution approximation
+
+    @param[in,out]
+    r           magmaDoubleComplex*
+                residual
+
+    @param[in,out]
+    u           magmaDoubleComplex*
+                preconditioned residual, or NULL
+
+    @param[in,out]
+    w           magmaDoubleComplex*
+                w = A u
+
+    @param[in,out]
+    z           magmaDoubleComplex*
+                z = A q
+
+    @param[in,out]
+    q           magmaDoubleComplex*
+                q = M^(-1) s, or NULL
+
+    @param[in,out]
+    s           magmaDoubleComplex*
+                s = A p
+
+    @param[in,out]
+    p           magmaDoubleComplex*
+                search direction
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgegpuk
+    ********************************************************************/
+
+extern "C" void
+magma_zpipecg_update_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex beta,
+    const magmaDoubleComplex *m,
+    const magmaDoubleComplex *nv,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magmaDoubleComplex *u,
+    magmaDoubleComplex *w,
+    magmaDoubleComplex *z,
+    magmaDoubleComplex *q,
+    magmaDoubleComplex *s,
+    magmaDoubleComplex *p,
+    magma_queue_t queue )
+{
+    magma_int_t len;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t end = min( n, (c+1)*len );
+        if ( u != NULL ) {
+            #pragma omp simd
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                magmaDoubleComplex zi = nv[i] + beta * z[i];
+                magmaDoubleComplex qi = m[i]  + beta * q[i];
+                magmaDoubleComplex si = w[i]  + beta * s[i];
+                magmaDoubleComplex pi = u[i]  + beta * p[i];
+                x[i] = x[i] + alpha * pi;
+                r[i] = r[i] - alpha * si;
+                u[i] = u[i] - alpha * qi;
+                w[i] = w[i] - alpha * zi;
+                z[i] = zi;
+                q[i] = qi;
+                s[i] = si;
+                p[i] = pi;
+            }
+        } else {
+            #pragma omp simd
+            for( magma_int_t i=c*len; i < end; i++ ) {
+                magmaDoubleComplex zi = nv[i] + beta * z[i];
+                magmaDoubleComplex si = w[i]  + beta * s[i];
+                magmaDoubleComplex pi = r[i]  + beta * p[i];
+                x[i] = x[i] + alpha * pi;
+                r[i] = r[i] - alpha * si;
+                w[i] = w[i] - alpha * zi;
+                z[i] = zi;
+                s[i] = si;
+                p[i] = pi;
+            }
+        }
+    }
+}
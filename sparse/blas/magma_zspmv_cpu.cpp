@@ -0,0 +1,1958 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+#include <stdint.h>
+#include <string.h>
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PRECISION_z
+
+// rows (or slices) processed together by the column-major kernels
+#define MAGMA_SPMV_CPU_BLOCK 256
+
+// vectors processed together by the SpMM kernels
+#define MAGMA_SPMM_CPU_VECS 64
+
+// real values per entry of the reduced-precision copy lval
+#if defined(PRECISION_z) || defined(PRECISION_c)
+#define MAGMA_LVAL_PER_ENTRY 2
+#else
+#define MAGMA_LVAL_PER_ENTRY 1
+#endif
+
+
+/*
+    First row of part `part' when the rows 0..n-1 with pointer array ptr
+    are split into `parts' pieces holding about the same number of nonzeros.
+*/
+static magma_int_t
+magma_zspmv_split_cpu(
+    magma_int_t n,
+    const magma_index_t *ptr,
+    magma_int_t parts,
+    magma_int_t part )
+{
+    if ( part <= 0 )
+        return 0;
+    if ( part >= parts )
+        return n;
+
+    int64_t target = (int64_t) (ptr[n] - ptr[0]) * part / parts + ptr[0];
+    magma_int_t lo = 0, hi = n;
+    // first row whose pointer reaches the target
+    while ( lo < hi ) {
+        magma_int_t mid = lo + (hi - lo) / 2;
+        if ( ptr[mid] < target )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+/*
+    Dot product of one CSR row with x.
+*/
+static inline magmaDoubleComplex
+magma_zspmv_rowdot_cpu(
+    magma_index_t start,
+    magma_index_t end,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re = 0.0, im = 0.0;
+    #pragma omp simd reduction(+:re,im)
+    for( magma_index_t j=start; j < end; j++ ) {
+        magmaDoubleComplex a = val[j];
+        magmaDoubleComplex b = x[ col[j] ];
+        re += MAGMA_Z_REAL(a) * MAGMA_Z_REAL(b) - MAGMA_Z_IMAG(a) * MAGMA_Z_IMAG(b);
+        im += MAGMA_Z_REAL(a) * MAGMA_Z_IMAG(b) + MAGMA_Z_IMAG(a) * MAGMA_Z_REAL(b);
+    }
+    return MAGMA_Z_MAKE( re, im );
+#else
+    magmaDoubleComplex dot = MAGMA_Z_ZERO;
+    #pragma omp simd reduction(+:dot)
+    for( magma_index_t j=start; j < end; j++ ) {
+        dot += val[j] * x[ col[j] ];
+    }
+    return dot;
+#endif
+}
+
+
+/*
+    acc[r] = sum_k val[k*ld+r] * x[col[k*ld+r]] for r < rows, the inner
+    kernel of the column-major formats (ELL and the SELL-P slices).
+    Consecutive rows are contiguous in memory, so the loop over r vectorizes.
+*/
+static inline void
+magma_zspmv_colmajor_cpu(
+    magma_int_t rows,
+    magma_int_t cols,
+    magma_int_t ld,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *acc )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re[ MAGMA_SPMV_CPU_BLOCK ], im[ MAGMA_SPMV_CPU_BLOCK ];
+    for( magma_int_t r=0; r < rows; r++ ) {
+        re[r] = 0.0;
+        im[r] = 0.0;
+    }
+    for( magma_int_t k=0; k < cols; k++ ) {
+        const magmaDoubleComplex *v = val + k*ld;
+        const magma_index_t *c = col + k*ld;
+        #pragma omp simd
+        for( magma_int_t r=0; r < rows; r++ ) {
+            magmaDoubleComplex a = v[r];
+            magmaDoubleComplex b = x[ c[r] ];
+            re[r] += MAGMA_Z_REAL(a) * MAGMA_Z_REAL(b) - MAGMA_Z_IMAG(a) * MAGMA_Z_IMAG(b);
+            im[r] += MAGMA_Z_REAL(a) * MAGMA_Z_IMAG(b) + MAGMA_Z_IMAG(a) * MAGMA_Z_REAL(b);
+        }
+    }
+    for( magma_int_t r=0; r < rows; r++ ) {
+        acc[r] = MAGMA_Z_MAKE( re[r], im[r] );
+    }
+#else
+    for( magma_int_t r=0; r < rows; r++ ) {
+        acc[r] = MAGMA_Z_ZERO;
+    }
+    for( magma_int_t k=0; k < cols; k++ ) {
+        const magmaDoubleComplex *v = val + k*ld;
+        const magma_index_t *c = col + k*ld;
+        #pragma omp simd
+        for( magma_int_t r=0; r < rows; r++ ) {
+            acc[r] += v[r] * x[ c[r] ];
+        }
+    }
+#endif
+}
+
+
+/*
+    dot[v] = sum_k val[start+k*stride] * x[ col[start+k*stride]*ldx + v ]
+    for v < vecs and k < count, the inner kernel of the SpMM routines.
+    The vectors of a row-major block are contiguous in memory, so every
+    nonzero is read once per block of vectors and the loop over v vectorizes.
+*/
+static inline void
+magma_zspmm_rowdot_cpu(
+    magma_index_t start,
+    magma_int_t count,
+    magma_int_t stride,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magma_int_t ldx,
+    magma_int_t vecs,
+    magmaDoubleComplex *dot )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re[ MAGMA_SPMM_CPU_VECS ], im[ MAGMA_SPMM_CPU_VECS ];
+    for( magma_int_t v=0; v < vecs; v++ ) {
+        re[v] = 0.0;
+        im[v] = 0.0;
+    }
+    for( magma_int_t k=0; k < count; k++ ) {
+        magmaDoubleComplex a = val[ start + k*stride ];
+        const magmaDoubleComplex *b = x + (int64_t) col[ start + k*stride ] * ldx;
+        #pragma omp simd
+        for( magma_int_t v=0; v < vecs; v++ ) {
+            re[v] += MAGMA_Z_REAL(a) * MAGMA_Z_REAL(b[v]) - MAGMA_Z_IMAG(a) * MAGMA_Z_IMAG(b[v]);
+            im[v] += MAGMA_Z_REAL(a) * MAGMA_Z_IMAG(b[v]) + MAGMA_Z_IMAG(a) * MAGMA_Z_REAL(b[v]);
+        }
+    }
+    for( magma_int_t v=0; v < vecs; v++ ) {
+        dot[v] = MAGMA_Z_MAKE( re[v], im[v] );
+    }
+#else
+    for( magma_int_t v=0; v < vecs; v++ ) {
+        dot[v] = MAGMA_Z_ZERO;
+    }
+    for( magma_int_t k=0; k < count; k++ ) {
+        magmaDoubleComplex a = val[ start + k*stride ];
+        const magmaDoubleComplex *b = x + (int64_t) col[ start + k*stride ] * ldx;
+        #pragma omp simd
+        for( magma_int_t v=0; v < vecs; v++ ) {
+            dot[v] += a * b[v];
+        }
+    }
+#endif
+}
+
+
+/*
+    y = alpha * dot + beta * y, without reading y if beta is zero.
+*/
+static inline void
+magma_zspmv_update_cpu(
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex dot,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    if ( MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO ) )
+        *y = alpha * dot;
+    else
+        *y = alpha * dot + beta * (*y);
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is CSR. The rows are split among the OpenMP threads such
+    that every thread handles about the same number of nonzeros.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in CSR
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of A in CSR
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in CSR
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel
+    {
+        magma_int_t nthreads = 1, tid = 0;
+        #ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+        #endif
+        magma_int_t start = magma_zspmv_split_cpu( m, rowptr, nthreads, tid );
+        magma_int_t end = magma_zspmv_split_cpu( m, rowptr, nthreads, tid+1 );
+        for( magma_int_t i=start; i < end; i++ ) {
+            magmaDoubleComplex dot = magma_zspmv_rowdot_cpu(
+                rowptr[i], rowptr[i+1], val, colind, x );
+            magma_zspmv_update_cpu( alpha, dot, beta, &y[i] );
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes Y = alpha *  A *  X + beta * Y on the CPU for
+    num_vecs vectors. Input format is CSR. X is stored row-major
+    (entry v of row j in x[ j*num_vecs + v ]), Y is stored column-major
+    (entry v of row i in y[ i + v*m ]), as for magma_zmgesellpmv.
+    Every row of A is read once per block of 64 vectors.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    num_vecs    magma_int_t
+                number of vectors
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in CSR
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of A in CSR
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in CSR
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vectors x (row-major)
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vectors y (column-major)
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel
+    {
+        magma_int_t nthreads = 1, tid = 0;
+        #ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+        #endif
+        magma_int_t start = magma_zspmv_split_cpu( m, rowptr, nthreads, tid );
+        magma_int_t end = magma_zspmv_split_cpu( m, rowptr, nthreads, tid+1 );
+        magmaDoubleComplex dot[ MAGMA_SPMM_CPU_VECS ];
+        for( magma_int_t i=start; i < end; i++ ) {
+            for( magma_int_t v0=0; v0 < num_vecs; v0 += MAGMA_SPMM_CPU_VECS ) {
+                magma_int_t vecs = min( MAGMA_SPMM_CPU_VECS, num_vecs - v0 );
+                magma_zspmm_rowdot_cpu( rowptr[i], rowptr[i+1] - rowptr[i], 1,
+                                        val, colind, x + v0, num_vecs, vecs, dot );
+                for( magma_int_t v=0; v < vecs; v++ ) {
+                    magma_zspmv_update_cpu( alpha, dot[v], beta,
+                                            &y[ i + (int64_t) (v0+v)*m ] );
+                }
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is ELLPACKT (row-major, also used for ELLD): row i is
+    stored in val[ i*nnz_per_row ... (i+1)*nnz_per_row-1 ]. Padding entries
+    have a negative column index.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    nnz_per_row magma_int_t
+                number of elements in the longest row
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in ELLPACKT
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in ELLPACKT
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgeellmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t nnz_per_row,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < m; i++ ) {
+        magma_index_t start = i*nnz_per_row;
+        magma_index_t end = start + nnz_per_row;
+        // the padding sits at the end of the row
+        while ( end > start && colind[end-1] < 0 ) {
+            end--;
+        }
+        // ELLD may leave the diagonal slot empty
+        if ( end > start && colind[start] < 0 ) {
+            start++;
+        }
+        magmaDoubleComplex dot = magma_zspmv_rowdot_cpu( start, end, val, colind, x );
+        magma_zspmv_update_cpu( alpha, dot, beta, &y[i] );
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is ELL (column-major): entry k of row i is stored in
+    val[ k*m + i ].
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    nnz_per_row magma_int_t
+                number of elements in the longest row
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in ELL
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in ELL
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgeelltmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t nnz_per_row,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t blocks = magma_ceildiv( m, MAGMA_SPMV_CPU_BLOCK );
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel for
+    for( magma_int_t b=0; b < blocks; b++ ) {
+        magmaDoubleComplex acc[ MAGMA_SPMV_CPU_BLOCK ];
+        magma_int_t row0 = b*MAGMA_SPMV_CPU_BLOCK;
+        magma_int_t rows = min( MAGMA_SPMV_CPU_BLOCK, m - row0 );
+        magma_zspmv_colmajor_cpu( rows, nnz_per_row, m,
+                                  val + row0, colind + row0, x, acc );
+        for( magma_int_t r=0; r < rows; r++ ) {
+            magma_zspmv_update_cpu( alpha, acc[r], beta, &y[row0+r] );
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is ELLRT: row i is stored in val[ i*L ... ] with
+    L = nnz_per_row rounded up to a multiple of alignment, and holds
+    rowlength[i] entries.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    nnz_per_row magma_int_t
+                number of elements in the longest row
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in ELLRT
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in ELLRT
+
+    @param[in]
+    rowlength   magmaIndex_ptr
+                number of nonzeros in each row
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    alignment   magma_int_t
+                alignment of the rows in ELLRT
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgeellrtmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t nnz_per_row,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowlength,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_int_t alignment,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t ld = magma_roundup( nnz_per_row, max( alignment, 1 ) );
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < m; i++ ) {
+        magma_index_t start = i*ld;
+        magmaDoubleComplex dot = magma_zspmv_rowdot_cpu(
+            start, start + rowlength[i], val, colind, x );
+        magma_zspmv_update_cpu( alpha, dot, beta, &y[i] );
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is SELLP: the rows are grouped into slices of blocksize
+    rows, every slice is stored column-major starting at rowptr[slice].
+    The slices are split among the OpenMP threads according to their
+    padded size, and the rows of a slice are processed with SIMD.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    blocksize   magma_int_t
+                number of rows in one SELLP slice (at most 256)
+
+    @param[in]
+    slices      magma_int_t
+                number of slices in matrix
+
+    @param[in]
+    alignment   magma_int_t
+                number of threads assigned to one row (unused on the CPU)
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in SELLP
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in SELLP
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of SELLP
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowptr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans || blocksize > MAGMA_SPMV_CPU_BLOCK ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel
+    {
+        magma_int_t nthreads = 1, tid = 0;
+        #ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+        #endif
+        magma_int_t start = magma_zspmv_split_cpu( slices, rowptr, nthreads, tid );
+        magma_int_t end = magma_zspmv_split_cpu( slices, rowptr, nthreads, tid+1 );
+        magmaDoubleComplex acc[ MAGMA_SPMV_CPU_BLOCK ];
+        for( magma_int_t s=start; s < end; s++ ) {
+            magma_int_t row0 = s*blocksize;
+            magma_int_t rows = min( blocksize, m - row0 );
+            magma_int_t cols = (rowptr[s+1] - rowptr[s]) / blocksize;
+            // the padding rows of the last slice are zero, skip them
+            magma_zspmv_colmajor_cpu( rows, cols, blocksize,
+                val + rowptr[s], colind + rowptr[s], x, acc );
+            for( magma_int_t r=0; r < rows; r++ ) {
+                magma_zspmv_update_cpu( alpha, acc[r], beta, &y[row0+r] );
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes Y = alpha *  A *  X + beta * Y on the CPU for
+    num_vecs vectors. Input format is SELLP. X is stored row-major
+    (entry v of row j in x[ j*num_vecs + v ]), Y is stored column-major
+    (entry v of row i in y[ i + v*m ]), as for magma_zmgesellpmv.
+    The slices are split among the OpenMP threads according to their
+    padded size.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    num_vecs    magma_int_t
+                number of vectors
+
+    @param[in]
+    blocksize   magma_int_t
+                number of rows in one SELLP slice
+
+    @param[in]
+    slices      magma_int_t
+                number of slices in matrix
+
+    @param[in]
+    alignment   magma_int_t
+                number of threads assigned to one row (unused on the CPU)
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in SELLP
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in SELLP
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of SELLP
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vectors x (row-major)
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vectors y (column-major)
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowptr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel
+    {
+        magma_int_t nthreads = 1, tid = 0;
+        #ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+        #endif
+        magma_int_t start = magma_zspmv_split_cpu( slices, rowptr, nthreads, tid );
+        magma_int_t end = magma_zspmv_split_cpu( slices, rowptr, nthreads, tid+1 );
+        magmaDoubleComplex dot[ MAGMA_SPMM_CPU_VECS ];
+        for( magma_int_t s=start; s < end; s++ ) {
+            magma_int_t row0 = s*blocksize;
+            magma_int_t rows = min( blocksize, m - row0 );
+            magma_int_t cols = (rowptr[s+1] - rowptr[s]) / blocksize;
+            // row r of the slice is strided by blocksize
+            for( magma_int_t r=0; r < rows; r++ ) {
+                for( magma_int_t v0=0; v0 < num_vecs; v0 += MAGMA_SPMM_CPU_VECS ) {
+                    magma_int_t vecs = min( MAGMA_SPMM_CPU_VECS, num_vecs - v0 );
+                    magma_zspmm_rowdot_cpu( rowptr[s] + r, cols, blocksize,
+                                            val, colind, x + v0, num_vecs, vecs, dot );
+                    for( magma_int_t v=0; v < vecs; v++ ) {
+                        magma_zspmv_update_cpu( alpha, dot[v], beta,
+                                                &y[ row0 + r + (int64_t) (v0+v)*m ] );
+                    }
+                }
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/*
+    Bit flag of element i in lane `lane' of a CSR5 tile: set if the element
+    starts a new row. The first packet holds y_offset and scansum_offset in
+    its leading bit_all_offset bits, followed by the first flags.
+*/
+static inline magma_int_t
+magma_zcsr5_bitflag_cpu(
+    const magma_uindex_t *desc,
+    int lane,
+    int i,
+    int bit_all_offset )
+{
+    const int bit_bitflag = 32 - bit_all_offset;
+    if ( i < bit_bitflag )
+        return ( desc[ lane ] >> (31 - bit_all_offset - i) ) & 0x1;
+    int ly = 1 + (i - bit_bitflag) / 32;
+    int norm_i = 31 & (i - bit_bitflag);
+    return ( desc[ ly*MAGMA_CSR5_OMEGA + lane ] >> (31 - norm_i) ) & 0x1;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    The input format is CSR5 (val (tile-wise column-major),
+                              row_pointer,
+                              col (tile-wise column-major),
+                              tile_pointer,
+                              tile_desc).
+
+    The tiles are distributed among the OpenMP threads. Inside a tile, the
+    products are formed with SIMD in the transposed tile layout, then a
+    segmented sum driven by the bit flags of the tile descriptor adds them
+    to y. The partial sum of the row a tile starts in goes to the
+    calibrator and is added afterwards. The tail tile is processed in CSR.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    p           magma_int_t
+                number of tiles in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    sigma       magma_int_t
+                sigma in A in CSR5 (at most 32)
+
+    @param[in]
+    bit_y_offset magma_int_t
+                 bit_y_offset in A in CSR5
+
+    @param[in]
+    bit_scansum_offset  magma_int_t
+                        bit_scansum_offset in A in CSR5
+
+    @param[in]
+    num_packet  magma_int_t
+                num_packet in A in CSR5
+
+    @param[in]
+    tile_ptr    magmaUIndex_ptr
+                tilepointer of A in CSR5
+
+    @param[in]
+    tile_desc   magmaUIndex_ptr
+                tiledescriptor of A in CSR5
+
+    @param[in]
+    tile_desc_offset_ptr   magmaIndex_ptr
+                           tiledescriptor_offsetpointer of A in CSR5
+
+    @param[in]
+    tile_desc_offset       magmaIndex_ptr
+                           tiledescriptor_offset of A in CSR5
+
+    @param[in]
+    calibrator  magmaDoubleComplex_ptr
+                calibrator of A in CSR5 (workspace of size p)
+
+    @param[in]
+    tail_tile_start   magma_int_t
+                      start of the last tile in A
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in CSR5
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of A in CSR
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in CSR5
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsr5mv_cpu(
+    magma_trans_t           transA,
+    magma_int_t             m,
+    magma_int_t             n,
+    magma_int_t             p,
+    magmaDoubleComplex      alpha,
+    magma_int_t             sigma,
+    magma_int_t             bit_y_offset,
+    magma_int_t             bit_scansum_offset,
+    magma_int_t             num_packet,
+    magmaUIndex_ptr         tile_ptr,
+    magmaUIndex_ptr         tile_desc,
+    magmaIndex_ptr          tile_desc_offset_ptr,
+    magmaIndex_ptr          tile_desc_offset,
+    magmaDoubleComplex_ptr  calibrator,
+    magma_int_t             tail_tile_start,
+    magmaDoubleComplex_ptr  val,
+    magmaIndex_ptr          rowptr,
+    magmaIndex_ptr          colind,
+    magmaDoubleComplex_ptr  x,
+    magmaDoubleComplex      beta,
+    magmaDoubleComplex_ptr  y,
+    magma_queue_t           queue )
+{
+    magma_int_t info = 0;
+    const int bit_all_offset = bit_y_offset + bit_scansum_offset;
+    const magma_int_t tile_size = MAGMA_CSR5_OMEGA * sigma;
+
+    if ( transA != MagmaNoTrans || sigma > 32 || calibrator == NULL ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    // phase 1. y = beta * y
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < m; i++ ) {
+        if ( MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO ) )
+            y[i] = MAGMA_Z_ZERO;
+        else
+            y[i] = beta * y[i];
+    }
+    if ( p < 1 ) {
+        goto cleanup;
+    }
+
+    // phase 2. all complete tiles; the tail tile p-1 is handled in CSR
+    #pragma omp parallel
+    {
+        magmaDoubleComplex prod[ MAGMA_CSR5_OMEGA * 32 ];
+        #pragma omp for schedule(static)
+        for( magma_int_t par_id=0; par_id < p-1; par_id++ ) {
+            const magmaDoubleComplex *tval = val + par_id*tile_size;
+            const magma_index_t *tcol = colind + par_id*tile_size;
+            const magma_uindex_t *desc = tile_desc
+                                     + par_id*MAGMA_CSR5_OMEGA*num_packet;
+
+            #pragma omp simd
+            for( magma_int_t idx=0; idx < tile_size; idx++ ) {
+                prod[idx] = alpha * tval[idx] * x[ tcol[idx] ];
+            }
+
+            magmaDoubleComplex sum = MAGMA_Z_ZERO;
+            if ( tile_ptr[par_id] == tile_ptr[par_id+1] ) {
+                // fast track: the whole tile belongs to one row
+                for( magma_int_t idx=0; idx < tile_size; idx++ ) {
+                    sum += prod[idx];
+                }
+                calibrator[par_id] = sum;
+                continue;
+            }
+
+            const bool empty_rows = (tile_ptr[par_id] >> 31) & 0x1;
+            const magma_index_t row_start = tile_ptr[par_id] & 0x7FFFFFFF;
+            const magma_index_t offset_pointer = empty_rows
+                                        ? tile_desc_offset_ptr[par_id] : 0;
+            magma_index_t segment = 0;
+            // lane l holds the consecutive elements l*sigma ... l*sigma+sigma-1
+            for( int lane=0; lane < MAGMA_CSR5_OMEGA; lane++ ) {
+                for( int i=0; i < sigma; i++ ) {
+                    if ( (lane || i)
+                         && magma_zcsr5_bitflag_cpu( desc, lane, i, bit_all_offset ) ) {
+                        if ( segment == 0 ) {
+                            calibrator[par_id] = sum;
+                        } else {
+                            magma_index_t row = empty_rows
+                                ? row_start + 1 + tile_desc_offset[offset_pointer + segment-1]
+                                : row_start + segment;
+                            y[row] += sum;
+                        }
+                        segment++;
+                        sum = MAGMA_Z_ZERO;
+                    }
+                    sum += prod[ i*MAGMA_CSR5_OMEGA + lane ];
+                }
+            }
+            if ( segment == 0 ) {
+                calibrator[par_id] = sum;
+            } else {
+                magma_index_t row = empty_rows
+                    ? row_start + 1 + tile_desc_offset[offset_pointer + segment-1]
+                    : row_start + segment;
+                y[row] += sum;
+            }
+        }
+    }
+
+    // phase 3. calibrate: the first partial row of every tile
+    for( magma_int_t par_id=0; par_id < p-1; par_id++ ) {
+        y[ tile_ptr[par_id] & 0x7FFFFFFF ] += calibrator[par_id];
+    }
+
+    // phase 4. tail tile in CSR
+    #pragma omp parallel for
+    for( magma_int_t row=tail_tile_start; row < m; row++ ) {
+        magma_index_t start = ( row == tail_tile_start )
+                              ? (p-1)*tile_size : rowptr[row];
+        magmaDoubleComplex dot = magma_zspmv_rowdot_cpu(
+            start, rowptr[row+1], val, colind, x );
+        y[row] += alpha * dot;
+    }
+
+cleanup:
+    return info;
+}
+
+
+/*
+    Real value k of a reduced-precision value array (see magma_zmlag2c_cpu),
+    widened to double.
+*/
+static inline double
+magma_zspmv_lpval_cpu(
+    const float *lval,
+    int64_t k )
+{
+    return (double) lval[k];
+}
+
+static inline double
+magma_zspmv_lpval_cpu(
+    const unsigned short *lval,
+    int64_t k )
+{
+    // bfloat16 is the upper half of a float
+    uint32_t u = ((uint32_t) lval[k]) << 16;
+    float f;
+    memcpy( &f, &u, sizeof(f) );
+    return (double) f;
+}
+
+
+/*
+    magma_zspmv_rowdot_cpu for reduced-precision values, accumulating in
+    double.
+*/
+template< typename L >
+static inline magmaDoubleComplex
+magma_zspmv_rowdot_mixed_cpu(
+    magma_index_t start,
+    magma_index_t end,
+    const L *lval,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re = 0.0, im = 0.0;
+    #pragma omp simd reduction(+:re,im)
+    for( magma_index_t j=start; j < end; j++ ) {
+        double ar = magma_zspmv_lpval_cpu( lval, 2*(int64_t) j );
+        double ai = magma_zspmv_lpval_cpu( lval, 2*(int64_t) j+1 );
+        magmaDoubleComplex b = x[ col[j] ];
+        re += ar * MAGMA_Z_REAL(b) - ai * MAGMA_Z_IMAG(b);
+        im += ar * MAGMA_Z_IMAG(b) + ai * MAGMA_Z_REAL(b);
+    }
+    return MAGMA_Z_MAKE( re, im );
+#else
+    double dot = 0.0;
+    #pragma omp simd reduction(+:dot)
+    for( magma_index_t j=start; j < end; j++ ) {
+        dot += magma_zspmv_lpval_cpu( lval, j ) * x[ col[j] ];
+    }
+    return (magmaDoubleComplex) dot;
+#endif
+}
+
+
+/*
+    magma_zspmv_colmajor_cpu for reduced-precision values, accumulating in
+    double. lval points to the first value of the slice.
+*/
+template< typename L >
+static inline void
+magma_zspmv_colmajor_mixed_cpu(
+    magma_int_t rows,
+    magma_int_t cols,
+    magma_int_t ld,
+    const L *lval,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *acc )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re[ MAGMA_SPMV_CPU_BLOCK ], im[ MAGMA_SPMV_CPU_BLOCK ];
+    for( magma_int_t r=0; r < rows; r++ ) {
+        re[r] = 0.0;
+        im[r] = 0.0;
+    }
+    for( magma_int_t k=0; k < cols; k++ ) {
+        const L *v = lval + 2*(int64_t) k*ld;
+        const magma_index_t *c = col + k*ld;
+        #pragma omp simd
+        for( magma_int_t r=0; r < rows; r++ ) {
+            double ar = magma_zspmv_lpval_cpu( v, 2*r );
+            double ai = magma_zspmv_lpval_cpu( v, 2*r+1 );
+            magmaDoubleComplex b = x[ c[r] ];
+            re[r] += ar * MAGMA_Z_REAL(b) - ai * MAGMA_Z_IMAG(b);
+            im[r] += ar * MAGMA_Z_IMAG(b) + ai * MAGMA_Z_REAL(b);
+        }
+    }
+    for( magma_int_t r=0; r < rows; r++ ) {
+        acc[r] = MAGMA_Z_MAKE( re[r], im[r] );
+    }
+#else
+    double sum[ MAGMA_SPMV_CPU_BLOCK ];
+    for( magma_int_t r=0; r < rows; r++ ) {
+        sum[r] = 0.0;
+    }
+    for( magma_int_t k=0; k < cols; k++ ) {
+        const L *v = lval + (int64_t) k*ld;
+        const magma_index_t *c = col + k*ld;
+        #pragma omp simd
+        for( magma_int_t r=0; r < rows; r++ ) {
+            sum[r] += magma_zspmv_lpval_cpu( v, r ) * x[ c[r] ];
+        }
+    }
+    for( magma_int_t r=0; r < rows; r++ ) {
+        acc[r] = (magmaDoubleComplex) sum[r];
+    }
+#endif
+}
+
+
+template< typename L >
+static void
+magma_zgecsrmv_mixed_kernel_cpu(
+    magma_int_t m,
+    magmaDoubleComplex alpha,
+    const L *lval,
+    const magma_index_t *rowptr,
+    const magma_index_t *colind,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    #pragma omp parallel
+    {
+        magma_int_t nthreads = 1, tid = 0;
+        #ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+        #endif
+        magma_int_t start = magma_zspmv_split_cpu( m, rowptr, nthreads, tid );
+        magma_int_t end = magma_zspmv_split_cpu( m, rowptr, nthreads, tid+1 );
+        for( magma_int_t i=start; i < end; i++ ) {
+            magmaDoubleComplex dot = magma_zspmv_rowdot_mixed_cpu(
+                rowptr[i], rowptr[i+1], lval, colind, x );
+            magma_zspmv_update_cpu( alpha, dot, beta, &y[i] );
+        }
+    }
+}
+
+
+template< typename L >
+static void
+magma_zgesellpmv_mixed_kernel_cpu(
+    magma_int_t m,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magmaDoubleComplex alpha,
+    const L *lval,
+    const magma_index_t *colind,
+    const magma_index_t *rowptr,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    #pragma omp parallel
+    {
+        magma_int_t nthreads = 1, tid = 0;
+        #ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+        #endif
+        magma_int_t start = magma_zspmv_split_cpu( slices, rowptr, nthreads, tid );
+        magma_int_t end = magma_zspmv_split_cpu( slices, rowptr, nthreads, tid+1 );
+        magmaDoubleComplex acc[ MAGMA_SPMV_CPU_BLOCK ];
+        for( magma_int_t s=start; s < end; s++ ) {
+            magma_int_t row0 = s*blocksize;
+            magma_int_t rows = min( blocksize, m - row0 );
+            magma_int_t cols = (rowptr[s+1] - rowptr[s]) / blocksize;
+            magma_zspmv_colmajor_mixed_cpu( rows, cols, blocksize,
+                lval + MAGMA_LVAL_PER_ENTRY*(int64_t) rowptr[s],
+                colind + rowptr[s], x, acc );
+            for( magma_int_t r=0; r < rows; r++ ) {
+                magma_zspmv_update_cpu( alpha, acc[r], beta, &y[row0+r] );
+            }
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is CSR with the values in reduced precision, as attached
+    by magma_zmlag2c_cpu (bits = 32) or magma_zmlag2bf_cpu (bits = 16).
+    The values are widened when loaded and the products are accumulated
+    in double, so only the memory traffic for the values is reduced.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    bits        magma_int_t
+                bits per real value in lval: 32 or 16
+
+    @param[in]
+    lval        const void*
+                array containing the reduced-precision values of A in CSR
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of A in CSR
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in CSR
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsrmv_mixed_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magma_int_t bits,
+    const void *lval,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    } else if ( bits == 32 ) {
+        magma_zgecsrmv_mixed_kernel_cpu( m, alpha, (const float*) lval,
+            rowptr, colind, x, beta, y );
+    } else if ( bits == 16 ) {
+        magma_zgecsrmv_mixed_kernel_cpu( m, alpha, (const unsigned short*) lval,
+            rowptr, colind, x, beta, y );
+    } else {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+    }
+
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is SELLP with the values in reduced precision, as attached
+    by magma_zmlag2c_cpu (bits = 32) or magma_zmlag2bf_cpu (bits = 16).
+    The products are accumulated in double.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    blocksize   magma_int_t
+                number of rows in one SELLP slice (at most 256)
+
+    @param[in]
+    slices      magma_int_t
+                number of slices in matrix
+
+    @param[in]
+    alignment   magma_int_t
+                number of threads assigned to one row (unused on the CPU)
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    bits        magma_int_t
+                bits per real value in lval: 32 or 16
+
+    @param[in]
+    lval        const void*
+                array containing the reduced-precision values of A in SELLP
+
+    @param[in]
+    colind      magmaIndex_ptr
+                columnindices of A in SELLP
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of SELLP
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgesellpmv_mixed_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magma_int_t bits,
+    const void *lval,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowptr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans || blocksize > MAGMA_SPMV_CPU_BLOCK ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    } else if ( bits == 32 ) {
+        magma_zgesellpmv_mixed_kernel_cpu( m, blocksize, slices, alpha,
+            (const float*) lval, colind, rowptr, x, beta, y );
+    } else if ( bits == 16 ) {
+        magma_zgesellpmv_mixed_kernel_cpu( m, blocksize, slices, alpha,
+            (const unsigned short*) lval, colind, rowptr, x, beta, y );
+    } else {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+    }
+
+    return info;
+}
+
+
+/*
+    Entry k of a full precision value array, or of a reduced-precision one
+    as attached by magma_zmlag2c_cpu.
+*/
+static inline magmaDoubleComplex
+magma_zspmv_entry_cpu(
+    const magmaDoubleComplex *val,
+    int64_t k )
+{
+    return val[k];
+}
+
+template< typename L >
+static inline magmaDoubleComplex
+magma_zspmv_entry_cpu(
+    const L *lval,
+    int64_t k )
+{
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    return MAGMA_Z_MAKE( magma_zspmv_lpval_cpu( lval, 2*k ),
+                         magma_zspmv_lpval_cpu( lval, 2*k+1 ));
+#else
+    return (magmaDoubleComplex) magma_zspmv_lpval_cpu( lval, k );
+#endif
+}
+
+
+/*
+    Dot product of one CSRDELTA chunk with x: the columns are
+    base + off[k] for k < count, the values start at val[start].
+    The offsets are widened in the vectorized loop.
+*/
+template< typename T, typename V >
+static inline magmaDoubleComplex
+magma_zspmv_deltadot_cpu(
+    magma_int_t count,
+    const T *off,
+    magma_index_t base,
+    const V *val,
+    int64_t start,
+    const magmaDoubleComplex *x )
+{
+    const magmaDoubleComplex *xb = x + base;
+#if defined(PRECISION_z) || defined(PRECISION_c)
+    double re = 0.0, im = 0.0;
+    #pragma omp simd reduction(+:re,im)
+    for( magma_int_t k=0; k < count; k++ ) {
+        magmaDoubleComplex a = magma_zspmv_entry_cpu( val, start+k );
+        magmaDoubleComplex b = xb[ off[k] ];
+        re += MAGMA_Z_REAL(a) * MAGMA_Z_REAL(b) - MAGMA_Z_IMAG(a) * MAGMA_Z_IMAG(b);
+        im += MAGMA_Z_REAL(a) * MAGMA_Z_IMAG(b) + MAGMA_Z_IMAG(a) * MAGMA_Z_REAL(b);
+    }
+    return MAGMA_Z_MAKE( re, im );
+#else
+    double dot = 0.0;
+    #pragma omp simd reduction(+:dot)
+    for( magma_int_t k=0; k < count; k++ ) {
+        dot += magma_zspmv_entry_cpu( val, start+k ) * xb[ off[k] ];
+    }
+    return (magmaDoubleComplex) dot;
+#endif
+}
+
+
+template< typename V >
+static void
+magma_zgecsrdeltamv_kernel_cpu(
+    magma_int_t m,
+    magmaDoubleComplex alpha,
+    const V *val,
+    const magma_index_t *rowptr,
+    const magma_index_t *delta_ptr,
+    const magma_uindex_t *delta_desc,
+    const magma_index_t *delta_base,
+    const unsigned char *delta_col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    #pragma omp parallel
+    {
+        magma_int_t nthreads = 1, tid = 0;
+        #ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        tid = omp_get_thread_num();
+        #endif
+        magma_int_t start = magma_zspmv_split_cpu( m, rowptr, nthreads, tid );
+        magma_int_t end = magma_zspmv_split_cpu( m, rowptr, nthreads, tid+1 );
+        for( magma_int_t i=start; i < end; i++ ) {
+            magmaDoubleComplex dot = MAGMA_Z_ZERO;
+            for( magma_int_t c=delta_ptr[i]; c < delta_ptr[i+1]; c++ ) {
+                int64_t first = rowptr[i] + (int64_t) (c - delta_ptr[i]) * MAGMA_CSRDELTA_CHUNK;
+                magma_int_t count = min( (int64_t) MAGMA_CSRDELTA_CHUNK, rowptr[i+1] - first );
+                const unsigned char *chunk = delta_col + 8 * (size_t) (delta_desc[c] >> 2);
+                switch ( delta_desc[c] & 3 ) {
+                    case 0:
+                        dot += magma_zspmv_deltadot_cpu( count, chunk,
+                            delta_base[i], val, first, x );
+                        break;
+                    case 1:
+                        dot += magma_zspmv_deltadot_cpu( count, (const unsigned short*) chunk,
+                            delta_base[i], val, first, x );
+                        break;
+                    default:
+                        dot += magma_zspmv_deltadot_cpu( count, (const magma_uindex_t*) chunk,
+                            delta_base[i], val, first, x );
+                        break;
+                }
+            }
+            magma_zspmv_update_cpu( alpha, dot, beta, &y[i] );
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is CSRDELTA (see magma_zmconvert): the column indices are
+    stored per chunk of MAGMA_CSRDELTA_CHUNK nonzeros as 8, 16 or 32 bit
+    offsets to the smallest column of the row. The rows are split among
+    the OpenMP threads by their number of nonzeros.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex_ptr
+                array containing values of A in CSRDELTA
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of A
+
+    @param[in]
+    delta_ptr   magmaIndex_ptr
+                first chunk of each row
+
+    @param[in]
+    delta_desc  magmaUIndex_ptr
+                chunk descriptors (offset into delta_col and width)
+
+    @param[in]
+    delta_base  magmaIndex_ptr
+                smallest column of each row
+
+    @param[in]
+    delta_col   unsigned char*
+                packed column offsets
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsrdeltamv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr delta_ptr,
+    magmaUIndex_ptr delta_desc,
+    magmaIndex_ptr delta_base,
+    unsigned char *delta_col,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    } else {
+        magma_zgecsrdeltamv_kernel_cpu( m, alpha, val, rowptr,
+            delta_ptr, delta_desc, delta_base, delta_col, x, beta, y );
+    }
+
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is CSRDELTA with the values in reduced precision, as
+    attached by magma_zmlag2c_cpu (bits = 32) or magma_zmlag2bf_cpu
+    (bits = 16). The products are accumulated in double.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A (only MagmaNoTrans)
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    bits        magma_int_t
+                bits per real value in lval: 32 or 16
+
+    @param[in]
+    lval        const void*
+                array containing the reduced-precision values of A
+
+    @param[in]
+    rowptr      magmaIndex_ptr
+                rowpointer of A
+
+    @param[in]
+    delta_ptr   magmaIndex_ptr
+                first chunk of each row
+
+    @param[in]
+    delta_desc  magmaUIndex_ptr
+                chunk descriptors (offset into delta_col and width)
+
+    @param[in]
+    delta_base  magmaIndex_ptr
+                smallest column of each row
+
+    @param[in]
+    delta_col   unsigned char*
+                packed column offsets
+
+    @param[in]
+    x           magmaDoubleComplex_ptr
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex_ptr
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsrdeltamv_mixed_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magma_int_t bits,
+    const void *lval,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr delta_ptr,
+    magmaUIndex_ptr delta_desc,
+    magmaIndex_ptr delta_base,
+    unsigned char *delta_col,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( transA != MagmaNoTrans ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    } else if ( bits == 32 ) {
+        magma_zgecsrdeltamv_kernel_cpu( m, alpha, (const float*) lval, rowptr,
+            delta_ptr, delta_desc, delta_base, delta_col, x, beta, y );
+    } else if ( bits == 16 ) {
+        magma_zgecsrdeltamv_kernel_cpu( m, alpha, (const unsigned short*) lval, rowptr,
+            delta_ptr, delta_desc, delta_base, delta_col, x, beta, y );
+    } else {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+    }
+
+    return info;
+}
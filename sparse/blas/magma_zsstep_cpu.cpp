@@ -0,0 +1,305 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+#include <math.h>
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+
+/**
+    Purpose
+    -------
+
+    Computes the thin QR factorization V = Q * R of a tall and skinny block
+    of vectors on the CPU with TSQR (tall-skinny QR), as used by the s-step
+    solvers to orthogonalize a block of s basis vectors with one reduction.
+
+    The rows are split into the chunks of magma_sparse_cpu_chunks. Each
+    chunk is factored independently with Householder QR, the small R
+    factors of the chunks are stacked and factored once more, and the
+    explicit Q is formed chunk by chunk from the local reflectors and the
+    corresponding rows of the Q factor of the stacked R factors. As the
+    chunks only depend on n, the result is the same for any number of
+    OpenMP threads.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                number of rows of V
+
+    @param[in]
+    k           magma_int_t
+                number of columns of V, k <= n
+
+    @param[in,out]
+    V           magmaDoubleComplex*
+                on entry, the n-by-k block V;
+                on exit, the n-by-k block Q with orthonormal columns
+
+    @param[in]
+    ldv         magma_int_t
+                leading dimension of V
+
+    @param[out]
+    R           magmaDoubleComplex*
+                k-by-k upper triangular factor R
+
+    @param[in]
+    ldr         magma_int_t
+                leading dimension of R
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_ztsqr_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magmaDoubleComplex *V,
+    magma_int_t ldv,
+    magmaDoubleComplex *R,
+    magma_int_t ldr,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magmaDoubleComplex *tau = NULL, *work = NULL, *S = NULL, *stau = NULL, *swork = NULL;
+    magmaDoubleComplex lwork_query;
+    magma_int_t len, lwork, lquery = -1, iinfo = 0;
+    magma_int_t chunks = magma_sparse_cpu_chunks( n, &len );
+    // the R factors of the chunks are stacked in an ldS-by-k matrix
+    magma_int_t ldS = chunks*k;
+
+    if ( k == 0 ) {
+        return info;
+    }
+    if ( k > n ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    CHECK( magma_zmalloc_cpu( &tau,  chunks*k ));
+    CHECK( magma_zmalloc_cpu( &work, chunks*k ));
+    CHECK( magma_zmalloc_cpu( &S,    ldS*k ));
+    CHECK( magma_zmalloc_cpu( &stau, k ));
+
+    // local QR factorization of each chunk, R factors are stacked in S
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t m = min( n, (c+1)*len ) - c*len;
+        magma_int_t r = min( m, k );
+        magma_int_t lw = k, linfo = 0;
+        magmaDoubleComplex *Vc = V + c*len;
+        lapackf77_zgeqrf( &m, &k, Vc, &ldv, tau+c*k, work+c*k, &lw, &linfo );
+        for( magma_int_t j=0; j < k; j++ ) {
+            for( magma_int_t i=0; i < k; i++ ) {
+                S[ j*ldS + c*k + i ] = ( i <= j && i < r ) ? Vc[ j*ldv + i ] : MAGMA_Z_ZERO;
+            }
+        }
+    }
+
+    // QR factorization of the stacked R factors
+    lapackf77_zgeqrf( &ldS, &k, S, &ldS, stau, &lwork_query, &lquery, &iinfo );
+    lwork = (magma_int_t) MAGMA_Z_REAL( lwork_query );
+    lapackf77_zungqr( &ldS, &k, &k, S, &ldS, stau, &lwork_query, &lquery, &iinfo );
+    lwork = max( lwork, (magma_int_t) MAGMA_Z_REAL( lwork_query ));
+    lwork = max( lwork, k );
+    CHECK( magma_zmalloc_cpu( &swork, lwork ));
+    lapackf77_zgeqrf( &ldS, &k, S, &ldS, stau, swork, &lwork, &iinfo );
+    for( magma_int_t j=0; j < k; j++ ) {
+        for( magma_int_t i=0; i < k; i++ ) {
+            R[ j*ldr + i ] = ( i <= j ) ? S[ j*ldS + i ] : MAGMA_Z_ZERO;
+        }
+    }
+    lapackf77_zungqr( &ldS, &k, &k, S, &ldS, stau, swork, &lwork, &iinfo );
+    if ( iinfo != 0 ) {
+        info = MAGMA_ERR;
+        goto cleanup;
+    }
+
+    // Q = diag( Q_c ) * Q_S, formed row by row inside each chunk
+    #pragma omp parallel for schedule(static) if( chunks > 1 )
+    for( magma_int_t c=0; c < chunks; c++ ) {
+        magma_int_t m = min( n, (c+1)*len ) - c*len;
+        magma_int_t r = min( m, k );
+        magma_int_t linfo = 0;
+        magmaDoubleComplex *Vc = V + c*len;
+        magmaDoubleComplex *row = work + c*k;
+        const magmaDoubleComplex *Sc = S + c*k;
+        // explicit local Q_c, m-by-r
+        lapackf77_zung2r( &m, &r, &r, Vc, &ldv, tau+c*k, row, &linfo );
+        for( magma_int_t i=0; i < m; i++ ) {
+            for( magma_int_t j=0; j < k; j++ ) {
+                magmaDoubleComplex sum = MAGMA_Z_ZERO;
+                for( magma_int_t p=0; p < r; p++ ) {
+                    sum += Vc[ p*ldv + i ] * Sc[ j*ldS + p ];
+                }
+                row[j] = sum;
+            }
+            for( magma_int_t j=0; j < k; j++ ) {
+                Vc[ j*ldv + i ] = row[j];
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( tau );
+    magma_free_cpu( work );
+    magma_free_cpu( S );
+    magma_free_cpu( stau );
+    magma_free_cpu( swork );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the shifts of a Newton basis for the s-step solvers on the CPU.
+    The shifts are the eigenvalues (Ritz values) of the m-by-m upper
+    Hessenberg matrix H, in Leja order: the first shift is the Ritz value of
+    largest modulus, and each further shift maximizes the product of the
+    distances to the shifts chosen before. If there are fewer distinct Ritz
+    values than s, the sequence is repeated.
+    In real precisions, only the real parts of the Ritz values are used, so
+    the basis stays real.
+
+    Arguments
+    ---------
+
+    @param[in]
+    m           magma_int_t
+                dimension of H
+
+    @param[in]
+    H           const magmaDoubleComplex*
+                m-by-m upper Hessenberg matrix, e.g. from the Arnoldi or
+                Lanczos process
+
+    @param[in]
+    ldh         magma_int_t
+                leading dimension of H
+
+    @param[in]
+    s           magma_int_t
+                number of shifts
+
+    @param[out]
+    theta       magmaDoubleComplex*
+                array of length s with the shifts
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_znewtonshifts_cpu(
+    magma_int_t m,
+    const magmaDoubleComplex *H,
+    magma_int_t ldh,
+    magma_int_t s,
+    magmaDoubleComplex *theta,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magmaDoubleComplex *Hc = NULL, *ev = NULL, *work = NULL, z;
+    double *wr = NULL, *wi = NULL;
+    magma_int_t *used = NULL;
+    magma_int_t ione = 1, lwork = max( 1, m ), iinfo = 0, count = 0;
+
+    for( magma_int_t j=0; j < s; j++ ) {
+        theta[j] = MAGMA_Z_ZERO;
+    }
+    if ( m < 1 ) {
+        return info;
+    }
+
+    CHECK( magma_zmalloc_cpu( &Hc, m*m ));
+    CHECK( magma_zmalloc_cpu( &ev, m ));
+    CHECK( magma_zmalloc_cpu( &work, lwork ));
+    CHECK( magma_imalloc_cpu( &used, m ));
+    CHECK( magma_dmalloc_cpu( &wr, m ));
+    CHECK( magma_dmalloc_cpu( &wi, m ));
+    for( magma_int_t j=0; j < m; j++ ) {
+        for( magma_int_t i=0; i < m; i++ ) {
+            Hc[ j*m + i ] = ( i <= j+1 ) ? H[ j*ldh + i ] : MAGMA_Z_ZERO;
+        }
+        used[j] = 0;
+    }
+
+    // Ritz values
+    #if defined(PRECISION_z) || defined(PRECISION_c)
+    lapackf77_zhseqr( "E", "N", &m, &ione, &m, Hc, &m, ev, &z, &ione,
+                      work, &lwork, &iinfo );
+    #else
+    lapackf77_zhseqr( "E", "N", &m, &ione, &m, Hc, &m, wr, wi, &z, &ione,
+                      work, &lwork, &iinfo );
+    for( magma_int_t j=0; j < m; j++ ) {
+        ev[j] = MAGMA_Z_MAKE( wr[j], 0.0 );
+    }
+    #endif
+    if ( iinfo != 0 ) {
+        // QR iteration did not converge, keep the monomial basis
+        info = MAGMA_ERR;
+        goto cleanup;
+    }
+
+    // Leja ordering, on the logarithms to avoid overflow
+    for( count=0; count < min( s, m ); count++ ) {
+        magma_int_t best = -1;
+        double bestval = -INFINITY;
+        for( magma_int_t i=0; i < m; i++ ) {
+            double val = 0.0;
+            if ( used[i] ) {
+                continue;
+            }
+            if ( count == 0 ) {
+                val = MAGMA_Z_ABS( ev[i] );
+            } else {
+                for( magma_int_t j=0; j < count; j++ ) {
+                    val += log( MAGMA_Z_ABS( ev[i] - theta[j] ));
+                }
+            }
+            if ( val > bestval ) {
+                bestval = val;
+                best = i;
+            }
+        }
+        // only duplicates of chosen shifts are left
+        if ( best < 0 || bestval == -INFINITY ) {
+            break;
+        }
+        used[best] = 1;
+        theta[count] = ev[best];
+    }
+    for( magma_int_t j=count; j < s && count > 0; j++ ) {
+        theta[j] = theta[ j % count ];
+    }
+
+cleanup:
+    magma_free_cpu( Hc );
+    magma_free_cpu( ev );
+    magma_free_cpu( work );
+    magma_free_cpu( used );
+    magma_free_cpu( wr );
+    magma_free_cpu( wi );
+    return info;
+}
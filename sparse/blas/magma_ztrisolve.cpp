@@ -10,9 +10,15 @@
        @precisions normal z -> s d c
 */
 #include "magma_trisolve.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define PRECISION_z
 
+// below this size the host solve runs without a parallel region
+#define MAGMA_TRISOLVE_CPU_SERIAL 2048
+
 /* For hipSPARSE, they use a separate complex type than for hipBLAS */
 #if defined(MAGMA_HAVE_HIP)
   #ifdef PRECISION_z
@@ -22,8 +28,191 @@
   #endif
 #endif
 
+/*
+    Host analysis: computes the level of every row of the (transposed)
+    triangular matrix, sorts the rows by level, and stores them level by level
+    with the diagonal split off. Entries outside the triangle are ignored.
+*/
+static magma_int_t
+magma_ztrisolve_analysis_cpu(
+    magma_z_matrix M,
+    magma_solve_info_t *solve_info,
+    bool upper_triangular,
+    bool transpose,
+    magma_queue_t queue)
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix hM={Magma_CSR}, MT={Magma_CSR}, A={Magma_CSR};
+    magma_index_t *level = NULL, *next = NULL;
+    magma_index_t *level_ptr = NULL, *perm = NULL, *row = NULL, *col = NULL;
+    magmaDoubleComplex *val = NULL, *diag = NULL;
+    magma_int_t n, num_levels = 0;
+    bool upper = upper_triangular;
+
+    if (M.storage_type != Magma_CSR) {
+        CHECK(magma_zmconvert(M, &hM, M.storage_type, Magma_CSR, queue));
+        A = hM;
+    } else {
+        A = M;
+        A.mapping = NULL;
+    }
+    if (transpose) {
+        CHECK(magma_zmtranspose_cpu(A, &MT, queue));
+        A = MT;
+        upper = !upper;
+    }
+    n = A.num_rows;
+
+    CHECK(magma_index_malloc_cpu(&level, n));
+    CHECK(magma_index_malloc_cpu(&next, n+1));
+    CHECK(magma_index_malloc_cpu(&perm, n));
+    CHECK(magma_index_malloc_cpu(&row, n+1));
+    CHECK(magma_zmalloc_cpu(&diag, n));
+
+    // the level of a row is one more than the highest level it depends on
+    for (magma_int_t ii = 0; ii < n; ii++) {
+        magma_int_t i = upper ? n-1-ii : ii;
+        magma_index_t lev = 0;
+        for (magma_int_t j = A.row[i]; j < A.row[i+1]; j++) {
+            magma_index_t c = A.col[j];
+            if ((upper && c > i) || (!upper && c < i)) {
+                lev = max(lev, level[c]+1);
+            }
+        }
+        level[i] = lev;
+        num_levels = max(num_levels, (magma_int_t) lev+1);
+    }
+
+    // counting sort of the rows by level, ascending within a level
+    CHECK(magma_index_malloc_cpu(&level_ptr, num_levels+1));
+    for (magma_int_t l = 0; l < num_levels+1; l++) {
+        level_ptr[l] = 0;
+    }
+    for (magma_int_t i = 0; i < n; i++) {
+        level_ptr[level[i]+1]++;
+    }
+    for (magma_int_t l = 0; l < num_levels; l++) {
+        level_ptr[l+1] += level_ptr[l];
+        next[l] = level_ptr[l];
+    }
+    for (magma_int_t i = 0; i < n; i++) {
+        perm[next[level[i]]++] = i;
+    }
+
+    // level-contiguous copy of the strictly triangular part
+    #pragma omp parallel for
+    for (magma_int_t k = 0; k < n; k++) {
+        magma_index_t i = perm[k], cnt = 0;
+        for (magma_int_t j = A.row[i]; j < A.row[i+1]; j++) {
+            magma_index_t c = A.col[j];
+            cnt += ((upper && c > i) || (!upper && c < i)) ? 1 : 0;
+        }
+        row[k+1] = cnt;
+    }
+    row[0] = 0;
+    CHECK(magma_zmatrix_createrowptr(n, row, queue));
+    CHECK(magma_index_malloc_cpu(&col, row[n]));
+    CHECK(magma_zmalloc_cpu(&val, row[n]));
+
+    #pragma omp parallel for
+    for (magma_int_t k = 0; k < n; k++) {
+        magma_index_t i = perm[k], el = row[k];
+        diag[k] = MAGMA_Z_ZERO;
+        for (magma_int_t j = A.row[i]; j < A.row[i+1]; j++) {
+            magma_index_t c = A.col[j];
+            if ((upper && c > i) || (!upper && c < i)) {
+                col[el] = c;
+                val[el] = A.val[j];
+                el++;
+            } else if (c == i) {
+                diag[k] = A.val[j];
+            }
+        }
+    }
+
+    solve_info->num_rows = n;
+    solve_info->num_levels = num_levels;
+    solve_info->level_ptr = level_ptr;
+    solve_info->perm = perm;
+    solve_info->row = row;
+    solve_info->col = col;
+    solve_info->val = val;
+    solve_info->diag = diag;
+    level_ptr = perm = row = col = NULL;
+    val = diag = NULL;
+
+cleanup:
+    magma_free_cpu(level);
+    magma_free_cpu(next);
+    magma_free_cpu(level_ptr);
+    magma_free_cpu(perm);
+    magma_free_cpu(row);
+    magma_free_cpu(col);
+    magma_free_cpu(val);
+    magma_free_cpu(diag);
+    magma_zmfree(&hM, queue);
+    magma_zmfree(&MT, queue);
+    return info;
+}
+
+
+/*
+    Host solve: the levels are processed in order, the rows of a level in
+    parallel, with one barrier per level. b and x are column-major and may
+    hold several right-hand sides; x may alias b.
+*/
+static magma_int_t
+magma_ztrisolve_cpu(
+    magma_solve_info_t solve_info,
+    bool unit_diagonal,
+    magma_z_matrix b,
+    magma_z_matrix x,
+    magma_queue_t queue)
+{
+    magma_int_t n = solve_info.num_rows;
+    magma_int_t num_rhs = b.num_cols;
+    magma_int_t ldb = b.num_rows, ldx = x.num_rows;
+    const magma_index_t *level_ptr = solve_info.level_ptr;
+    const magma_index_t *perm = solve_info.perm;
+    const magma_index_t *row = solve_info.row;
+    const magma_index_t *col = solve_info.col;
+    const magmaDoubleComplex *val = (const magmaDoubleComplex*) solve_info.val;
+    const magmaDoubleComplex *diag = (const magmaDoubleComplex*) solve_info.diag;
+    magmaDoubleComplex *bval = b.val, *xval = x.val;
+
+    if (solve_info.perm == NULL || b.memory_location != Magma_CPU
+        || x.memory_location != Magma_CPU) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    #pragma omp parallel if(n > MAGMA_TRISOLVE_CPU_SERIAL)
+    for (magma_int_t lev = 0; lev < solve_info.num_levels; lev++) {
+        #pragma omp for schedule(static)
+        for (magma_int_t k = level_ptr[lev]; k < level_ptr[lev+1]; k++) {
+            magma_index_t i = perm[k];
+            for (magma_int_t v = 0; v < num_rhs; v++) {
+                const magmaDoubleComplex *xv = xval + v*ldx;
+                magmaDoubleComplex sum = bval[i + v*ldb];
+                for (magma_int_t j = row[k]; j < row[k+1]; j++) {
+                    sum -= val[j] * xv[col[j]];
+                }
+                xval[i + v*ldx] = unit_diagonal ? sum : sum / diag[k];
+            }
+        }
+    }
+
+    return MAGMA_SUCCESS;
+}
+
+
 magma_int_t magma_ztrisolve_analysis(magma_z_matrix M, magma_solve_info_t *solve_info, bool upper_triangular, bool unit_diagonal, bool transpose, magma_queue_t queue)
 {
+    if (M.memory_location == Magma_CPU) {
+        return magma_ztrisolve_analysis_cpu(M, solve_info, upper_triangular,
+                                            transpose, queue);
+    }
+
     magma_int_t info = 0;
 
     cusparseHandle_t cusparseHandle = NULL;
@@ -116,6 +305,10 @@ cleanup:
 
 magma_int_t magma_ztrisolve(magma_z_matrix M, magma_solve_info_t solve_info, bool upper_triangular, bool unit_diagonal, bool transpose, magma_z_matrix b, magma_z_matrix x, magma_queue_t queue)
 {
+    if (M.memory_location == Magma_CPU) {
+        return magma_ztrisolve_cpu(solve_info, unit_diagonal, b, x, queue);
+    }
+
     magma_int_t info = 0;
 
     cusparseHandle_t cusparseHandle = NULL;
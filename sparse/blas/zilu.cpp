@@ -512,7 +512,10 @@ magma_zcumilugeneratesolverinfo(
     
     magma_z_matrix hA={Magma_CSR}, hL={Magma_CSR}, hU={Magma_CSR};
     
-    if (precond->L.memory_location != Magma_DEV ){
+    // rebuild the factors from M unless they are already set up, on the
+    // device or, for the host solves, on the CPU
+    if (precond->L.memory_location != Magma_DEV &&
+        precond->L.memory_location != Magma_CPU ){
         CHECK( magma_zmtransfer( precond->M, &hA,
         precond->M.memory_location, Magma_CPU, queue ));
 
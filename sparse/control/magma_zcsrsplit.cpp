@@ -66,7 +66,11 @@ magma_zcsrsplit(
     magma_zmfree( D, queue );
     magma_zmfree( R, queue );
     D->ownership = MagmaTrue;
+    D->mapping = NULL;
+    D->lval = NULL;
     R->ownership = MagmaTrue;
+    R->mapping = NULL;
+    R->lval = NULL;
     D->val = NULL;
     D->col = NULL;
     D->row = NULL;
@@ -9,6 +9,7 @@
        @author Hartwig Anzt
 */
 #include "magmasparse_internal.h"
+#include "magmasparse_mmio.h"
 
 #include "../blas/magma_trisolve.h"
 
@@ -25,6 +26,10 @@
     Free the memory of a magma_z_matrix.
     Note, this routine performs a magma_queue_sync on the queue passed
     to it prior to freeing any memory.
+    A matrix loaded with magma_z_csr_binary releases its file mapping.
+    The mapping is not reference-counted: only the handle returned by
+    magma_z_csr_binary may be freed. Shallow copies (struct assignments)
+    must set mapping to NULL, or must not be freed.
 
 
     Arguments
@@ -84,6 +89,19 @@ magma_zmfree(
             A->num_cols = 0;
             A->nnz = 0; A->true_nnz = 0;
         }
+        if ( A->storage_type == Magma_CSRDELTA ) {
+            if (A->ownership) {
+                magma_free_cpu( A->val );
+                magma_free_cpu( A->row );
+                magma_free_cpu( A->delta_col );
+                magma_free_cpu( A->delta_desc );
+                magma_free_cpu( A->delta_ptr );
+                magma_free_cpu( A->delta_base );
+            }
+            A->num_rows = 0;
+            A->num_cols = 0;
+            A->nnz = 0; A->true_nnz = 0;
+        }
         if ( A->storage_type == Magma_CSR5 ) {
             if (A->ownership) {
                 magma_free_cpu( A->val );
@@ -186,6 +204,24 @@ magma_zmfree(
         A->dtile_desc_offset = NULL;
         A->calibrator = NULL;
         A->dcalibrator = NULL;
+        A->delta_col = NULL;
+        A->delta_desc = NULL;
+        A->delta_ptr = NULL;
+        A->delta_base = NULL;
+        // reduced-precision copy of val for the host SpMV
+        if ( A->lval != NULL ) {
+            if (A->ownership) {
+                magma_free_cpu( A->lval );
+            }
+            A->lval = NULL;
+            A->lval_bits = 0;
+        }
+        // arrays loaded by magma_z_csr_binary point into a file mapping
+        if ( A->mapping != NULL ) {
+            mm_unmap_file( (mm_mapped_file*) A->mapping );
+            magma_free_cpu( A->mapping );
+            A->mapping = NULL;
+        }
     }
 
     if ( A->memory_location == Magma_DEV ) {
@@ -449,6 +485,7 @@ magma_zmfree(
     Free a preconditioner.
     Note, this routine performs a magma_queue_sync on the queue passed
     to it prior to freeing any memory.
+    A matrix loaded with magma_z_csr_binary releases its file mapping.
 
     Arguments
     ---------
@@ -738,6 +775,54 @@ magma_zprecondfree(
         magma_free( precond_par->U_dgraphindegree_bak );
         precond_par->U_dgraphindegree_bak = NULL;
     }
+    if ( precond_par->RA.val != NULL ) {
+        magma_free_cpu( precond_par->RA.val );
+        precond_par->RA.val = NULL;
+    }
+    if ( precond_par->RA.col != NULL ) {
+        magma_free_cpu( precond_par->RA.col );
+        precond_par->RA.col = NULL;
+    }
+    if ( precond_par->RA.row != NULL ) {
+        magma_free_cpu( precond_par->RA.row );
+        precond_par->RA.row = NULL;
+    }
+    if ( precond_par->RA.rowidx != NULL ) {
+        magma_free_cpu( precond_par->RA.rowidx );
+        precond_par->RA.rowidx = NULL;
+    }
+    if ( precond_par->RL.val != NULL ) {
+        magma_free_cpu( precond_par->RL.val );
+        precond_par->RL.val = NULL;
+    }
+    if ( precond_par->RL.col != NULL ) {
+        magma_free_cpu( precond_par->RL.col );
+        precond_par->RL.col = NULL;
+    }
+    if ( precond_par->RL.row != NULL ) {
+        magma_free_cpu( precond_par->RL.row );
+        precond_par->RL.row = NULL;
+    }
+    if ( precond_par->RUT.val != NULL ) {
+        magma_free_cpu( precond_par->RUT.val );
+        precond_par->RUT.val = NULL;
+    }
+    if ( precond_par->RUT.col != NULL ) {
+        magma_free_cpu( precond_par->RUT.col );
+        precond_par->RUT.col = NULL;
+    }
+    if ( precond_par->RUT.row != NULL ) {
+        magma_free_cpu( precond_par->RUT.row );
+        precond_par->RUT.row = NULL;
+    }
+    if ( precond_par->RA_map != NULL ) {
+        magma_free_cpu( precond_par->RA_map );
+        precond_par->RA_map = NULL;
+    }
+    if ( precond_par->RUT_map != NULL ) {
+        magma_free_cpu( precond_par->RUT_map );
+        precond_par->RUT_map = NULL;
+    }
 
     precond_par->solver = Magma_NONE;
     
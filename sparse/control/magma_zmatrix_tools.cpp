@@ -807,132 +807,6 @@ cleanup:
 }
 
 
-/***************************************************************************//**
-    Purpose
-    -------
-    Transposes a matrix that already contains rowidx. The idea is to use a 
-    linked list.
-
-    Arguments
-    ---------
-
-    @param[in]
-    A           magma_z_matrix
-                Matrix to transpose.
-                
-    @param[out]
-    B           magma_z_matrix*
-                Transposed matrix.
-
-    @param[in]
-    queue       magma_queue_t
-                Queue to execute in.
-
-    @ingroup magmasparse_zaux
-*******************************************************************************/
-
-extern "C" magma_int_t
-magma_zcsrcoo_transpose(
-    magma_z_matrix A,
-    magma_z_matrix *B,
-    magma_queue_t queue)
-{
-    magma_int_t info = 0;
-    magma_index_t *linked_list;
-    magma_index_t *row_ptr;
-    magma_index_t *last_rowel;
-    
-    magma_int_t el_per_block, num_threads=1;
-    
-    B->storage_type = A.storage_type;
-    B->memory_location = A.memory_location;
-    
-    B->num_rows = A.num_rows;
-    B->num_cols = A.num_cols;
-    B->nnz      = A.nnz;
-    
-    CHECK(magma_index_malloc_cpu(&linked_list, A.nnz));
-    CHECK(magma_index_malloc_cpu(&row_ptr, A.num_rows+1));
-    CHECK(magma_index_malloc_cpu(&last_rowel, A.num_rows+1));
-    CHECK(magma_index_malloc_cpu(&B->row, A.num_rows+1));
-    CHECK(magma_index_malloc_cpu(&B->rowidx, A.nnz));
-    CHECK(magma_index_malloc_cpu(&B->col, A.nnz));
-    CHECK(magma_zmalloc_cpu(&B->val, A.nnz));
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-    
-    #pragma omp parallel for
-    for (magma_int_t i=0; i<A.num_rows; i++) {
-        row_ptr[i] = -1;
-    }
-    #pragma omp parallel for
-    for (magma_int_t i=0; i<A.num_rows+1; i++) {
-        B->row[i] = 0;
-    }
-    
-    el_per_block = magma_ceildiv(A.num_rows, num_threads);
-
-    #pragma omp parallel
-    {
-#ifdef _OPENMP
-    magma_int_t id = omp_get_thread_num();
-#else
-    magma_int_t id = 0;
-#endif
-        for (magma_int_t i=0; i<A.nnz; i++) {
-            magma_index_t row = A.col[ i ];
-            if((row < (id+1)*el_per_block) && (row >=(id)*el_per_block)) {
-                if(row_ptr[row] == -1) {
-                    row_ptr[ row ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                } else {
-                    linked_list[ last_rowel[ row ] ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                }
-                B->row[row+1] = B->row[row+1] + 1;
-            }
-        }
-    }
-    
-    // new rowptr
-    B->row[0]=0;   
-    magma_zmatrix_createrowptr(B->num_rows, B->row, queue);
-    
-
-    assert(B->row[B->num_rows] == A.nnz);
-    
-    #pragma omp parallel for
-    for (magma_int_t row=0; row<A.num_rows; row++) {
-        magma_int_t el = row_ptr[row];
-        if(el>-1) {
-            
-            for (magma_int_t i=B->row[row]; i<B->row[row+1]; i++) {
-                // assert(A.col[el] == row);
-                B->val[i] = A.val[el];
-                B->col[i] = A.rowidx[el];
-                B->rowidx[i] = row;
-                el = linked_list[el];
-            }
-        }
-    }
-    
-cleanup:
-    magma_free_cpu(row_ptr);
-    magma_free_cpu(last_rowel);
-    magma_free_cpu(linked_list);
-    return info;
-}
-
-
-
 /***************************************************************************//**
     Purpose
     -------
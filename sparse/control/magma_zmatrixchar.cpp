@@ -8,10 +8,18 @@
        @precisions normal z -> s d c
        @author Hartwig Anzt
 */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
 #include "magmasparse_internal.h"
 
 #define THRESHOLD 10e-99
 
+// ELL is only considered if it stores at most this many entries per nonzero
+#define MAGMA_FORMAT_TUNE_MAXPAD 3.0
+
 
 
 /**
@@ -180,3 +188,458 @@ cleanup:
     magma_free( &dim );
     return info;
 }
+
+
+/* splitmix64 finalizer, used to hash the sparsity pattern. */
+static inline uint64_t
+magma_zformat_hash( uint64_t x )
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = ( x ^ (x >> 30) ) * 0xbf58476d1ce4e5b9ULL;
+    x = ( x ^ (x >> 27) ) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+/* Names of the formats the tuner chooses from, used in the cache file. */
+static const magma_storage_t magma_zformat_list[4] =
+    { Magma_CSR, Magma_ELL, Magma_SELLP, Magma_CSR5 };
+static const char *magma_zformat_names[4] =
+    { "CSR", "ELL", "SELLP", "CSR5" };
+
+
+/* Looks up the decision for (fingerprint, location) in the cache file.
+   Every line reads
+       fingerprint location format blocksize alignment t_csr t_ell t_sellp t_csr5
+   and later lines override earlier ones. Returns 1 on a hit. */
+static int
+magma_zformat_cache_read(
+    const char *cachefile,
+    magma_location_t location,
+    magma_format_tuning *t )
+{
+    FILE *fp = fopen( cachefile, "r" );
+    char line[256], loc[8], fmt[8];
+    unsigned long long fp_key;
+    long long bs, al;
+    real_Double_t tm[4];
+    int hit = 0;
+
+    if ( fp == NULL ) {
+        return 0;
+    }
+    while ( fgets( line, sizeof(line), fp ) != NULL ) {
+        if ( sscanf( line, "%llx %7s %7s %lld %lld %le %le %le %le",
+                     &fp_key, loc, fmt, &bs, &al,
+                     &tm[0], &tm[1], &tm[2], &tm[3] ) != 9 ) {
+            continue;
+        }
+        if ( fp_key != (unsigned long long) t->fingerprint ||
+             strcmp( loc, location == Magma_CPU ? "CPU" : "DEV" ) != 0 ) {
+            continue;
+        }
+        for( int f=0; f < 4; f++ ) {
+            if ( strcmp( fmt, magma_zformat_names[f] ) == 0 ) {
+                t->format = magma_zformat_list[f];
+                t->blocksize = bs;
+                t->alignment = al;
+                for( int k=0; k < 4; k++ ) {
+                    t->time[k] = tm[k];
+                }
+                hit = 1;
+            }
+        }
+    }
+    fclose( fp );
+    return hit;
+}
+
+
+/* Appends the decision in t to the cache file. */
+static void
+magma_zformat_cache_write(
+    const char *cachefile,
+    magma_location_t location,
+    const magma_format_tuning *t )
+{
+    FILE *fp = fopen( cachefile, "a" );
+    const char *fmt = "CSR";
+
+    if ( fp == NULL ) {
+        printf("%% warning: cannot write format cache %s.\n", cachefile );
+        return;
+    }
+    for( int f=0; f < 4; f++ ) {
+        if ( t->format == magma_zformat_list[f] ) {
+            fmt = magma_zformat_names[f];
+        }
+    }
+    fprintf( fp, "%016llx %s %s %lld %lld %.6e %.6e %.6e %.6e\n",
+             (unsigned long long) t->fingerprint,
+             location == Magma_CPU ? "CPU" : "DEV", fmt,
+             (long long) t->blocksize, (long long) t->alignment,
+             t->time[0], t->time[1], t->time[2], t->time[3] );
+    fclose( fp );
+}
+
+
+/* Row length statistics, diameter, ELL and SELL-P padding and the
+   fingerprint of a CSR matrix on the CPU. */
+static magma_int_t
+magma_zformat_statistics(
+    magma_z_matrix A,
+    magma_format_tuning *t )
+{
+    magma_int_t info = 0;
+    magma_index_t *slicemax = NULL;
+    const magma_int_t n = A.num_rows;
+    const double nnz = (double) A.nnz;
+    real_Double_t sum = 0.0, sumsq = 0.0;
+    magma_int_t maxrow = 0, diam = 0;
+    uint64_t h = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+:sum,sumsq,h) reduction(max:maxrow,diam)
+    for( magma_int_t i=0; i < n; i++ ) {
+        magma_int_t len = A.row[i+1] - A.row[i];
+        sum += (double) len;
+        sumsq += (double) len * (double) len;
+        if ( len > maxrow )
+            maxrow = len;
+        h += magma_zformat_hash( ((uint64_t) i << 32) ^ (uint64_t) len );
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            magma_int_t d = i - A.col[j];
+            d = ( d < 0 ) ? -d : d;
+            if ( d > diam )
+                diam = d;
+            h += magma_zformat_hash( ((uint64_t) j << 32) ^ (uint64_t) A.col[j] );
+        }
+    }
+    h ^= magma_zformat_hash( (uint64_t) A.num_rows );
+    h = magma_zformat_hash( h ^ magma_zformat_hash( (uint64_t) A.num_cols << 1 ) );
+    h = magma_zformat_hash( h ^ (uint64_t) sizeof(magmaDoubleComplex) );
+
+    t->fingerprint = h;
+    t->row_mean = ( n > 0 ) ? sum / n : 0.0;
+    t->row_var = ( n > 0 ) ? max( sumsq / n - t->row_mean * t->row_mean, 0.0 ) : 0.0;
+    t->max_nnz_row = maxrow;
+    t->diameter = diam;
+    t->ell_padding = ( nnz > 0 ) ? (double) n * maxrow / nnz : 1.0;
+
+    // stored entries of SELL-P: every slice is padded to its longest row,
+    // rounded up to the alignment
+    CHECK( magma_index_malloc_cpu( &slicemax, magma_ceildiv( n, 8 ) + 1 ));
+    for( magma_int_t b=0; b < MAGMA_FORMAT_TUNE_BLOCKSIZES; b++ ) {
+        magma_int_t C = t->sellp_blocksize[b];
+        magma_int_t slices = magma_ceildiv( n, C );
+        #pragma omp parallel for schedule(static)
+        for( magma_int_t s=0; s < slices; s++ ) {
+            magma_index_t m = 0;
+            for( magma_int_t i=s*C; i < min( (s+1)*C, n ); i++ ) {
+                m = max( m, A.row[i+1] - A.row[i] );
+            }
+            slicemax[s] = m;
+        }
+        for( magma_int_t a=0; a < MAGMA_FORMAT_TUNE_ALIGNMENTS; a++ ) {
+            magma_int_t al = t->sellp_alignment[a];
+            real_Double_t stored = 0.0;
+            // the GPU kernel uses blocksize*alignment threads per thread block
+            if ( C * al > 1024 ) {
+                t->sellp_padding[b][a] = 0.0;
+                continue;
+            }
+            #pragma omp parallel for schedule(static) reduction(+:stored)
+            for( magma_int_t s=0; s < slices; s++ ) {
+                stored += (double) C * magma_roundup( slicemax[s], al );
+            }
+            t->sellp_padding[b][a] = ( nnz > 0 ) ? stored / nnz : 1.0;
+        }
+    }
+
+cleanup:
+    magma_free_cpu( slicemax );
+    return info;
+}
+
+
+/* Picks the format with the least predicted memory traffic per SpMV.
+   The matrix is streamed once in every format; irregular row lengths
+   cost CSR extra (load imbalance on the CPU, divergent warps on the GPU),
+   CSR5 pays a small constant overhead for its tile descriptors, ELL and
+   SELL-P pay for their padding. */
+static void
+magma_zformat_predict(
+    magma_z_matrix A,
+    magma_location_t location,
+    magma_format_tuning *t )
+{
+    const double vs = sizeof(magmaDoubleComplex);
+    const double is = sizeof(magma_index_t);
+    const double n = A.num_rows;
+    const double nnz = A.nnz;
+    double cv = ( t->row_mean > 0 ) ? sqrt( t->row_var ) / t->row_mean : 0.0;
+    double cost[4], vec, csr;
+
+    cv = min( cv, 10.0 );
+    // y is written once; x is read once if the band of columns touched by
+    // neighbouring rows stays in cache, otherwise roughly once per nonzero
+    vec = n * vs + ( t->diameter * vs <= 4.0e6 ? A.num_cols * vs : 0.5 * nnz * vs );
+
+    csr = nnz * (vs + is) + (n + 1) * is;
+    if ( location == Magma_CPU ) {
+        cost[0] = csr * ( 1.0 + 0.1 * cv ) + vec;
+    } else {
+        cost[0] = csr * ( 1.2 + 0.25 * cv ) + vec;
+    }
+    cost[1] = ( t->ell_padding <= MAGMA_FORMAT_TUNE_MAXPAD ) ?
+              t->ell_padding * nnz * (vs + is) + vec : -1.0;
+    cost[3] = csr * 1.1 + vec;
+
+    // SELL-P: least padding; among (nearly) equal choices prefer wide
+    // alignment on the GPU, where it spreads a row over several threads,
+    // and no alignment on the CPU
+    double best = -1.0;
+    for( magma_int_t b=0; b < MAGMA_FORMAT_TUNE_BLOCKSIZES; b++ ) {
+        for( magma_int_t a=0; a < MAGMA_FORMAT_TUNE_ALIGNMENTS; a++ ) {
+            double p = t->sellp_padding[b][a];
+            if ( p <= 0.0 ) {
+                continue;
+            }
+            bool better = ( best < 0.0 || p < 0.98 * best );
+            bool tie = ( best >= 0.0 && p <= 1.02 * best && !better );
+            if ( tie ) {
+                better = ( location == Magma_CPU ) ?
+                         t->sellp_alignment[a] < t->alignment :
+                         t->sellp_alignment[a] > t->alignment;
+            }
+            if ( better ) {
+                best = p;
+                t->blocksize = t->sellp_blocksize[b];
+                t->alignment = t->sellp_alignment[a];
+            }
+        }
+    }
+    cost[2] = best * nnz * (vs + is) + ( magma_ceildiv( A.num_rows, t->blocksize ) + 1 ) * is + vec;
+
+    magma_int_t pick = 0;
+    for( magma_int_t f=1; f < 4; f++ ) {
+        if ( cost[f] >= 0.0 && cost[f] < cost[pick] ) {
+            pick = f;
+        }
+    }
+    t->format = magma_zformat_list[pick];
+}
+
+
+/* Converts A to format, moves it to location and returns the average
+   time of trials SpMVs after one warmup SpMV. */
+static magma_int_t
+magma_zformat_trial(
+    magma_z_matrix A,
+    magma_storage_t format,
+    magma_int_t blocksize,
+    magma_int_t alignment,
+    magma_location_t location,
+    magma_int_t trials,
+    real_Double_t *time,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_z_matrix hB={Magma_CSR}, dB={Magma_CSR}, x={Magma_CSR}, y={Magma_CSR};
+    magmaDoubleComplex one = MAGMA_Z_ONE, zero = MAGMA_Z_ZERO;
+    real_Double_t start, end;
+
+    hB.blocksize = blocksize;
+    hB.alignment = alignment;
+    CHECK( magma_zmconvert( A, &hB, Magma_CSR, format, queue ));
+    CHECK( magma_zmtransfer( hB, &dB, Magma_CPU, location, queue ));
+    CHECK( magma_zvinit( &x, location, A.num_cols, 1, one, queue ));
+    CHECK( magma_zvinit( &y, location, A.num_rows, 1, zero, queue ));
+
+    // warmup
+    CHECK( magma_z_spmv( one, dB, x, zero, y, queue ));
+    start = magma_sync_wtime( queue );
+    for( magma_int_t k=0; k < trials; k++ ) {
+        CHECK( magma_z_spmv( one, dB, x, zero, y, queue ));
+    }
+    end = magma_sync_wtime( queue );
+    *time = (end - start) / trials;
+
+cleanup:
+    magma_zmfree( &hB, queue );
+    magma_zmfree( &dB, queue );
+    magma_zmfree( &x, queue );
+    magma_zmfree( &y, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Selects the SpMV format for matrix A among CSR, ELL, SELL-P and CSR5.
+
+    The row length mean, variance and maximum, the diameter, and the padding
+    of ELL and of SELL-P for slice sizes 8, 16, 32, 64 and alignments
+    1, 4, 8, 16, 32 are gathered in one parallel pass. From these a
+    memory-traffic model predicts the best format.
+    If trials > 0, every candidate (ELL only if it pads to at most three
+    times nnz) is converted and timed over trials SpMVs at location, and
+    the fastest one is taken.
+
+    If cachefile is not NULL, the decision is looked up under the fingerprint
+    of the matrix (dimensions, sparsity pattern, value size) and location
+    first, and measured decisions are appended to it, so repeated runs skip
+    the trials. The values of A do not enter the fingerprint.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix in CSR on the CPU
+
+    @param[in]
+    location    magma_location_t
+                where the SpMV will run: Magma_CPU or Magma_DEV
+
+    @param[in]
+    trials      magma_int_t
+                timed SpMVs per candidate; 0 uses the model only
+
+    @param[in]
+    cachefile   const char*
+                decision cache, or NULL
+
+    @param[out]
+    tuning      magma_format_tuning*
+                statistics and decision
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmselect_format(
+    magma_z_matrix A,
+    magma_location_t location,
+    magma_int_t trials,
+    const char *cachefile,
+    magma_format_tuning *tuning,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    static const magma_int_t bs[MAGMA_FORMAT_TUNE_BLOCKSIZES] = { 8, 16, 32, 64 };
+    static const magma_int_t al[MAGMA_FORMAT_TUNE_ALIGNMENTS] = { 1, 4, 8, 16, 32 };
+
+    if ( A.memory_location != Magma_CPU || A.storage_type != Magma_CSR ) {
+        printf("error: format selection needs a CSR matrix on the CPU.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    memset( tuning, 0, sizeof(magma_format_tuning) );
+    for( magma_int_t b=0; b < MAGMA_FORMAT_TUNE_BLOCKSIZES; b++ ) {
+        tuning->sellp_blocksize[b] = bs[b];
+    }
+    for( magma_int_t a=0; a < MAGMA_FORMAT_TUNE_ALIGNMENTS; a++ ) {
+        tuning->sellp_alignment[a] = al[a];
+    }
+    tuning->format = Magma_CSR;
+    tuning->blocksize = 32;
+    tuning->alignment = 1;
+    CHECK( magma_zformat_statistics( A, tuning ));
+
+    if ( cachefile != NULL &&
+         magma_zformat_cache_read( cachefile, location, tuning ) ) {
+        tuning->cached = 1;
+        goto cleanup;
+    }
+
+    magma_zformat_predict( A, location, tuning );
+
+    if ( trials > 0 && A.nnz > 0 ) {
+        magma_int_t pick = -1;
+        for( magma_int_t f=0; f < 4; f++ ) {
+            if ( magma_zformat_list[f] == Magma_ELL &&
+                 tuning->ell_padding > MAGMA_FORMAT_TUNE_MAXPAD ) {
+                continue;
+            }
+            CHECK( magma_zformat_trial( A, magma_zformat_list[f],
+                        tuning->blocksize, tuning->alignment, location,
+                        trials, &tuning->time[f], queue ));
+            if ( pick < 0 || tuning->time[f] < tuning->time[pick] ) {
+                pick = f;
+            }
+        }
+        tuning->format = magma_zformat_list[pick];
+        if ( cachefile != NULL ) {
+            magma_zformat_cache_write( cachefile, location, tuning );
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Converts the CSR matrix A into the format selected by
+    magma_zmselect_format for SpMVs at location. B stays on the CPU.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix in CSR on the CPU
+
+    @param[out]
+    B           magma_z_matrix*
+                A in the selected format
+
+    @param[in]
+    location    magma_location_t
+                where the SpMV will run: Magma_CPU or Magma_DEV
+
+    @param[in]
+    trials      magma_int_t
+                timed SpMVs per candidate; 0 uses the model only
+
+    @param[in]
+    cachefile   const char*
+                decision cache, or NULL
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmconvert_auto(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_location_t location,
+    magma_int_t trials,
+    const char *cachefile,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_format_tuning tuning;
+
+    CHECK( magma_zmselect_format( A, location, trials, cachefile, &tuning, queue ));
+    B->blocksize = tuning.blocksize;
+    B->alignment = tuning.alignment;
+    CHECK( magma_zmconvert( A, B, Magma_CSR, tuning.format, queue ));
+
+cleanup:
+    return info;
+}
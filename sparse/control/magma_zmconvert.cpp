@@ -9,6 +9,9 @@
        @author Hartwig Anzt
 */
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <cuda.h>  // for CUDA_VERSION
 
@@ -140,11 +143,130 @@ cleanup:
 }
 
 
+/**
+    Purpose
+    -------
+
+    Computes the row lengths of a CSR matrix in parallel and returns the
+    maximum row length.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                CSR matrix on the CPU
+
+    @param[out]
+    length      magma_index_t*
+                array of size A.num_rows, row lengths of A
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+static magma_index_t
+magma_zcsr_rowlength_cpu(
+    magma_z_matrix A,
+    magma_index_t *length )
+{
+    magma_index_t maxrowlength = 0;
+
+    #pragma omp parallel
+    {
+        magma_index_t localmax = 0;
+        #pragma omp for nowait
+        for( magma_int_t i=0; i < A.num_rows; i++ ) {
+            length[i] = A.row[i+1]-A.row[i];
+            if (length[i] > localmax)
+                localmax = length[i];
+        }
+        #pragma omp critical
+        {
+            if (localmax > maxrowlength)
+                maxrowlength = localmax;
+        }
+    }
+    return maxrowlength;
+}
+
+
+/**
+    Purpose
+    -------
+
+    In-place inclusive prefix sum of an index array, computed in parallel:
+    every thread scans a contiguous part, then adds the sum of all
+    preceding parts. The result is the same as that of the serial scan.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of x
+
+    @param[in,out]
+    x           magma_index_t*
+                on exit, x[i] = x[0] + ... + x[i]
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" void
+magma_zindex_scan_cpu(
+    magma_int_t n,
+    magma_index_t *x )
+{
+    magma_int_t num_threads = 1;
+    magma_index_t partial[ 1024+1 ];
+
+#ifdef _OPENMP
+    #pragma omp parallel
+    {
+        num_threads = omp_get_max_threads();
+    }
+#endif
+    num_threads = min( num_threads, (magma_int_t) 1024 );
+    // not worth the synchronization for short arrays
+    if ( n < 16*1024 || num_threads == 1 ) {
+        for( magma_int_t i=1; i < n; i++ )
+            x[i] += x[i-1];
+        return;
+    }
+    magma_int_t chunk = magma_ceildiv( n, num_threads );
+
+    partial[0] = 0;
+    #pragma omp parallel for num_threads(num_threads)
+    for( magma_int_t t=0; t < num_threads; t++ ) {
+        magma_int_t end = min( n, (t+1)*chunk );
+        for( magma_int_t i=t*chunk+1; i < end; i++ )
+            x[i] += x[i-1];
+        partial[t+1] = ( t*chunk < end ) ? x[end-1] : 0;
+    }
+    for( magma_int_t t=1; t <= num_threads; t++ )
+        partial[t] += partial[t-1];
+    #pragma omp parallel for num_threads(num_threads)
+    for( magma_int_t t=1; t < num_threads; t++ ) {
+        magma_int_t end = min( n, (t+1)*chunk );
+        for( magma_int_t i=t*chunk; i < end; i++ )
+            x[i] += partial[t];
+    }
+}
+
+
 /**
     Purpose
     -------
 
     Converter between different sparse storage formats.
+    The CPU conversions from CSR to ELL, ELLPACKT, ELLD, ELLRT, SELLP, and
+    CSR5 run in parallel using OpenMP; the result does not depend on the
+    number of threads.
+    
+    CSRDELTA (CPU only) keeps row and val of CSR and replaces col by the
+    smallest column of each row (delta_base) and the offsets to it. The
+    offsets of a row are stored in chunks of MAGMA_CSRDELTA_CHUNK nonzeros
+    with 8 or 16 bits per offset, or 32 bits for chunks with larger jumps.
 
     Arguments
     ---------
@@ -199,6 +321,12 @@ magma_zmconvert(
     // make sure the target structure is empty
     magma_zmfree( B, queue );
     B->ownership = MagmaTrue;
+    B->mapping = NULL;
+    B->lval = NULL;
+    B->delta_col = NULL;
+    B->delta_desc = NULL;
+    B->delta_ptr = NULL;
+    B->delta_base = NULL;
 
     B->val = NULL;
     B->col = NULL;
@@ -248,10 +376,12 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
 
+                #pragma omp parallel for
                 for( magma_int_t i=0; i < A.nnz; i++) {
                     B->val[i] = A.val[i];
                     B->col[i] = A.col[i];
                 }
+                #pragma omp parallel for
                 for( magma_int_t i=0; i < A.num_rows+1; i++) {
                     B->row[i] = A.row[i];
                 }
@@ -455,31 +585,29 @@ magma_zmconvert(
                 B->max_nnz_row = A.max_nnz_row;
                 B->diameter = A.diameter;
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
+                magma_index_t maxrowlength=0;
                 CHECK( magma_index_malloc_cpu( &length, A.num_rows));
 
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
-                }
+                maxrowlength = magma_zcsr_rowlength_cpu( A, length );
                 //printf( "Conversion to ELLPACK with %d elements per row: ",
                                                                 // maxrowlength );
                 //fflush(stdout);
                 CHECK( magma_zmalloc_cpu( &B->val, maxrowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->col, maxrowlength*A.num_rows ));
 
-                for( i=0; i < (maxrowlength*A.num_rows); i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] =  -1;
-                }
-                for( i=0; i < A.num_rows; i++ ) {
+                // every row is one contiguous chunk: fill it, then pad it
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
                     magma_int_t offset = 0;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
+                    for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
                         B->val[i*maxrowlength+offset] = A.val[j];
                         B->col[i*maxrowlength+offset] = A.col[j];
                         offset++;
                     }
+                    for( ; offset < maxrowlength; offset++ ) {
+                        B->val[i*maxrowlength+offset] = MAGMA_Z_MAKE(0., 0.);
+                        B->col[i*maxrowlength+offset] = -1;
+                    }
                 }
                 B->max_nnz_row = maxrowlength;
             }
@@ -497,32 +625,29 @@ magma_zmconvert(
                 B->diameter = A.diameter;
 
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
+                magma_index_t maxrowlength=0;
                 CHECK( magma_index_malloc_cpu( &length, A.num_rows));
 
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
-                }
+                maxrowlength = magma_zcsr_rowlength_cpu( A, length );
                 //printf( "Conversion to ELL with %d elements per row: ",
                                                                // maxrowlength );
                 //fflush(stdout);
                 CHECK( magma_zmalloc_cpu( &B->val, maxrowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->col, maxrowlength*A.num_rows ));
 
-                for( i=0; i < (maxrowlength*A.num_rows); i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] = 0;
-                }
-
-                for( i=0; i < A.num_rows; i++ ) {
+                // column-major: row i owns the entries i + offset*num_rows
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
                     magma_int_t offset = 0;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
+                    for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
                         B->val[offset*A.num_rows+i] = A.val[j];
                         B->col[offset*A.num_rows+i] = A.col[j];
                         offset++;
                     }
+                    for( ; offset < maxrowlength; offset++ ) {
+                        B->val[offset*A.num_rows+i] = MAGMA_Z_MAKE(0., 0.);
+                        B->col[offset*A.num_rows+i] = 0;
+                    }
                 }
                 B->max_nnz_row = maxrowlength;
                 //printf( "done\n" );
@@ -541,13 +666,25 @@ magma_zmconvert(
                 B->diameter = A.diameter;
 
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
+                magma_index_t maxrowlength=0;
                 CHECK( magma_index_malloc_cpu( &length, A.num_rows));
 
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
+                maxrowlength = magma_zcsr_rowlength_cpu( A, length );
+                // slot 0 is reserved for the diagonal: a full row without
+                // one would spill into the next row, so widen by one
+                magma_int_t nodiag = 0;
+                #pragma omp parallel for reduction(+:nodiag)
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    if ( length[i] == maxrowlength ) {
+                        magma_int_t hasdiag = 0;
+                        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+                            hasdiag |= ( A.col[j] == i );
+                        }
+                        nodiag += !hasdiag;
+                    }
+                }
+                if ( nodiag > 0 ) {
+                    maxrowlength++;
                 }
                 //printf( "Conversion to ELL with %d elements per row: ",
                                                                // maxrowlength );
@@ -555,15 +692,14 @@ magma_zmconvert(
                 CHECK( magma_zmalloc_cpu( &B->val, maxrowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->col, maxrowlength*A.num_rows ));
 
-
-                for( i=0; i < (maxrowlength*A.num_rows); i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] =  -1;
-                }
-
-                for( i=0; i < A.num_rows; i++ ) {
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    for( magma_int_t k=0; k < maxrowlength; k++ ) {
+                        B->val[i*maxrowlength+k] = MAGMA_Z_MAKE(0., 0.);
+                        B->col[i*maxrowlength+k] = -1;
+                    }
                     magma_int_t offset = 1;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
+                    for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
                         if ( A.col[j] == i ) { // diagonal case
                             B->val[i*maxrowlength] = A.val[j];
                             B->col[i*maxrowlength] = A.col[j];
@@ -590,14 +726,10 @@ magma_zmconvert(
                 B->diameter = A.diameter;
 
                 // conversion
-                magma_index_t i, j, maxrowlength=0;
+                magma_index_t maxrowlength=0;
                 CHECK( magma_index_malloc_cpu( &length, A.num_rows));
 
-                for( i=0; i < A.num_rows; i++ ) {
-                    length[i] = A.row[i+1]-A.row[i];
-                    if (length[i] > maxrowlength)
-                        maxrowlength = length[i];
-                }
+                maxrowlength = magma_zcsr_rowlength_cpu( A, length );
 
                 //printf( "Conversion to ELLRT with %d elements per row: ",
                 //                                                   maxrowlength );
@@ -609,19 +741,19 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->col, rowlength*A.num_rows ));
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows ));
 
-                for( i=0; i < rowlength*A.num_rows; i++) {
-                    B->val[i] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[i] =  0;
-                }
-
-                for( i=0; i < A.num_rows; i++ ) {
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
                     magma_int_t offset = 0;
-                    for( j=A.row[i]; j < A.row[i+1]; j++ ) {
+                    for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
                         B->val[i*rowlength+offset] = A.val[j];
                         B->col[i*rowlength+offset] = A.col[j];
                         offset++;
                     }
-                    B->row[i] = A.row[i+1] - A.row[i];
+                    for( ; offset < rowlength; offset++ ) {
+                        B->val[i*rowlength+offset] = MAGMA_Z_MAKE(0., 0.);
+                        B->col[i*rowlength+offset] = 0;
+                    }
+                    B->row[i] = length[i];
                 }
                 B->max_nnz_row = maxrowlength;
                 //printf( "done\n" );
@@ -655,32 +787,39 @@ magma_zmconvert(
                 magma_int_t C = B->blocksize;
                 magma_int_t slices = ( A.num_rows+C-1)/(C);
                 B->numblocks = slices;
-                magma_int_t alignedlength, alignment = B->alignment;
+                magma_int_t alignment = B->alignment;
+                magma_index_t maxalignedlength = 0;
                 // conversion
-                magma_index_t i, j, k, maxrowlength=0;
-                CHECK( magma_index_malloc_cpu( &length, C));
                 // B-row points to the start of each slice
                 CHECK( magma_index_malloc_cpu( &B->row, slices+1 ));
 
-
+                // padded length of every slice, then a prefix sum over the slices
                 B->row[0] = 0;
-                for( i=0; i < slices; i++ ) {
-                    maxrowlength = 0;
-                    for(j=0; j < C; j++) {
-                        if (i*C+j < A.num_rows) {
-                            length[j] = A.row[i*C+j+1]-A.row[i*C+j];
-                        }
-                        else
-                            length[j]=0;
-                        if (length[j] > maxrowlength) {
-                            maxrowlength = length[j];
+                #pragma omp parallel
+                {
+                    magma_index_t localmax = 0;
+                    #pragma omp for nowait
+                    for( magma_int_t i=0; i < slices; i++ ) {
+                        magma_index_t maxrowlength = 0;
+                        for( magma_int_t j=0; j < C && i*C+j < A.num_rows; j++ ) {
+                            magma_index_t len = A.row[i*C+j+1]-A.row[i*C+j];
+                            if (len > maxrowlength) {
+                                maxrowlength = len;
+                            }
                         }
+                        magma_index_t alignedlength = magma_roundup( maxrowlength, alignment );
+                        B->row[i+1] = alignedlength * C;
+                        if ( alignedlength > localmax )
+                            localmax = alignedlength;
+                    }
+                    #pragma omp critical
+                    {
+                        if ( localmax > maxalignedlength )
+                            maxalignedlength = localmax;
                     }
-                    alignedlength = magma_roundup( maxrowlength, alignment );
-                    B->row[i+1] = B->row[i] + alignedlength * C;
-                    if ( alignedlength > B->max_nnz_row )
-                        B->max_nnz_row = alignedlength;
                 }
+                magma_zindex_scan_cpu( slices+1, B->row );
+                B->max_nnz_row = maxalignedlength;
                 B->nnz = B->row[slices];
                 //printf( "Conversion to SELLC with %d slices of size %d and"
                 //       " %d nonzeros.\n", slices, C, B->nnz );
@@ -689,18 +828,18 @@ magma_zmconvert(
                 CHECK( magma_zmalloc_cpu( &B->val, B->row[slices] ));
                 CHECK( magma_index_malloc_cpu( &B->col, B->row[slices] ));
 
-                // zero everything
-                for( i=0; i < B->row[slices]; i++ ) {
-                    B->val[ i ] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[ i ] =  0;
-                }
-                // fill in values
-                for( i=0; i < slices; i++ ) {
-                    for(j=0; j < C; j++) {
+                // zero and fill every slice
+                #pragma omp parallel for schedule(dynamic,64)
+                for( magma_int_t i=0; i < slices; i++ ) {
+                    for( magma_int_t k=B->row[i]; k < B->row[i+1]; k++ ) {
+                        B->val[ k ] = MAGMA_Z_MAKE(0., 0.);
+                        B->col[ k ] = 0;
+                    }
+                    for( magma_int_t j=0; j < C; j++ ) {
                         magma_int_t line = i*C+j;
                         magma_int_t offset = 0;
                         if ( line < A.num_rows) {
-                            for( k=A.row[line]; k < A.row[line+1]; k++ ) {
+                            for( magma_int_t k=A.row[line]; k < A.row[line+1]; k++ ) {
                                 B->val[ B->row[i] + j +offset*C ] = A.val[k];
                                 B->col[ B->row[i] + j +offset*C ] = A.col[k];
                                 offset++;
@@ -764,6 +903,7 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
 
+                #pragma omp parallel for
                 for( magma_int_t i=0; i < A.num_rows+1; i++) {
                     B->row[i] = A.row[i];
                 }
@@ -814,12 +954,14 @@ magma_zmconvert(
                 //printf("sigma = %i, p = %i\n", B->csr5_sigma, B->csr5_p);
                 // malloc the newly added arrays for CSR5
                 CHECK( magma_uindex_malloc_cpu( &B->tile_ptr, B->csr5_p+1 ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p+1; i++) {
                     B->tile_ptr[i] = 0;
                 }
 
                 CHECK( magma_uindex_malloc_cpu( &B->tile_desc,
                           B->csr5_p * MAGMA_CSR5_OMEGA * B->csr5_num_packets ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p * MAGMA_CSR5_OMEGA
                                         * B->csr5_num_packets; i++) {
                     B->tile_desc[i] = 0;
@@ -827,12 +969,14 @@ magma_zmconvert(
 
 
                 CHECK( magma_zmalloc_cpu( &B->calibrator, B->csr5_p ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p; i++) {
                     B->calibrator[i] = MAGMA_Z_MAKE(0., 0.);
                 }
 
                 CHECK( magma_index_malloc_cpu( &B->tile_desc_offset_ptr,
                                                B->csr5_p+1 ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p+1; i++) {
                     B->tile_desc_offset_ptr[i] = 0;
                 }
@@ -841,6 +985,7 @@ magma_zmconvert(
                 // convert csr data to csr5 data (3 steps)
                 // step 1 generate tile pointer
                 // step 1.1 binary search row pointer
+                #pragma omp parallel for
                 for (magma_index_t global_id = 0; global_id <= B->csr5_p;
                      global_id++)
                 {
@@ -867,6 +1012,10 @@ magma_zmconvert(
                 }
                 
                 // step 1.2 check empty rows
+                // flag the tiles first: marking a tile changes the start of
+                // the tile before it, which may still be checked by another thread
+                CHECK( magma_index_malloc_cpu( &length, B->csr5_p ));
+                #pragma omp parallel for
                 for (magma_index_t group_id = 0; group_id < B->csr5_p; group_id++) {
                     int dirty = 0;
                 
@@ -875,20 +1024,24 @@ magma_zmconvert(
                     start = (start << 1) >> 1;
                     stop  = (stop << 1) >> 1;
                 
-                    if (start == stop)
-                        continue;
-                
-                    for (magma_uindex_t row_idx = start; row_idx <= stop; row_idx++) {
-                        if (B->row[row_idx] == B->row[row_idx+1]) {
-                            dirty = 1;
-                            break;
+                    if (start != stop) {
+                        // the last tile ends at num_rows, which has no row
+                        for (magma_uindex_t row_idx = start;
+                             row_idx <= stop && row_idx < (magma_uindex_t) B->num_rows;
+                             row_idx++) {
+                            if (B->row[row_idx] == B->row[row_idx+1]) {
+                                dirty = 1;
+                                break;
+                            }
                         }
                     }
-                
-                    if (dirty) {
-                        start |= sizeof(magma_uindex_t) == 4
+                    length[group_id] = dirty;
+                }
+                #pragma omp parallel for
+                for (magma_index_t group_id = 0; group_id < B->csr5_p; group_id++) {
+                    if (length[group_id]) {
+                        B->tile_ptr[group_id] |= sizeof(magma_uindex_t) == 4
                                            ? 0x80000000 : 0x8000000000000000;
-                        B->tile_ptr[group_id] = start;
                     }
                 }
                 B->csr5_tail_tile_start = (B->tile_ptr[B->csr5_p-1] << 1) >> 1;
@@ -899,6 +1052,8 @@ magma_zmconvert(
                                      + B->csr5_bit_scansum_offset;
                 
                 //generate_tile_descriptor_s1_kernel
+                // every tile only sets bits in its own descriptor
+                #pragma omp parallel for
                 for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
                     const magma_index_t row_start = B->tile_ptr[par_id]
                                                     & 0x7FFFFFFF;
@@ -927,8 +1082,15 @@ magma_zmconvert(
                 }
                 
                 //generate_tile_descriptor_s2_kernel
-                int num_thread = 1; //omp_get_max_threads();
+                int num_thread = 1;
+                int empty_tiles = 0;
                 magma_index_t *s_segn_scan_all, *s_present_all;
+                #ifdef _OPENMP
+                #pragma omp parallel
+                {
+                    num_thread = omp_get_max_threads();
+                }
+                #endif
                 
                 CHECK( magma_index_malloc_cpu( &s_segn_scan_all,
                                            2 * MAGMA_CSR5_OMEGA * num_thread ));
@@ -946,9 +1108,13 @@ magma_zmconvert(
                 
                 //const int bit_all_offset = bit_y_offset + bit_scansum_offset;
                 
-                //#pragma omp parallel for
+                #pragma omp parallel for reduction(+:empty_tiles)
                 for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
-                    int tid = 0; //omp_get_thread_num();
+                    #ifdef _OPENMP
+                    int tid = omp_get_thread_num();
+                    #else
+                    int tid = 0;
+                    #endif
                     int *s_segn_scan = &s_segn_scan_all[tid * 2
                                                         * MAGMA_CSR5_OMEGA];
                     int *s_present = &s_present_all[tid * 2
@@ -1022,7 +1188,7 @@ magma_zmconvert(
                     if (with_empty_rows) {
                         B->tile_desc_offset_ptr[par_id]
                             = s_segn_scan[MAGMA_CSR5_OMEGA];
-                        B->tile_desc_offset_ptr[B->csr5_p] = 1;
+                        empty_tiles++;
                     }
                 
                     //#pragma simd
@@ -1054,6 +1220,9 @@ magma_zmconvert(
                 
                 magma_free_cpu(s_segn_scan_all);
                 magma_free_cpu(s_present_all);
+                if (empty_tiles > 0) {
+                    B->tile_desc_offset_ptr[B->csr5_p] = 1;
+                }
                 
                 if (B->tile_desc_offset_ptr[B->csr5_p]) {
                     //scan_single(B->tile_desc_offset_ptr, p+1);
@@ -1078,7 +1247,7 @@ magma_zmconvert(
                     //err = generate_tile_descriptor_offset
                     const int bit_bitflag = 32 - bit_all_offset;
                 
-                    //#pragma omp parallel for
+                    #pragma omp parallel for
                     for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
                         bool with_empty_rows = (B->tile_ptr[par_id] >> 31)&0x1;
                         if (!with_empty_rows)
@@ -1176,7 +1345,7 @@ magma_zmconvert(
                 }
                 
                 // step 3. transpose column_index and value arrays
-                //#pragma omp parallel for
+                #pragma omp parallel for
                 for (int par_id = 0; par_id < B->csr5_p; par_id++) {
                     // if this is fast track tile, do not transpose it
                     if (B->tile_ptr[par_id] == B->tile_ptr[par_id + 1]) {
@@ -1214,6 +1383,90 @@ magma_zmconvert(
                 //printf( "done\n" );
             }
 
+            // CSR to CSRDELTA
+            else if ( new_format == Magma_CSRDELTA ) {
+                // fill in information for B
+                B->storage_type = Magma_CSRDELTA;
+                B->memory_location = A.memory_location;
+                B->fill_mode = A.fill_mode;
+                B->num_rows = A.num_rows; B->true_nnz = A.true_nnz;
+                B->num_cols = A.num_cols;
+                B->nnz = A.nnz;
+                B->max_nnz_row = A.max_nnz_row;
+                B->diameter = A.diameter;
+
+                CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
+                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
+                CHECK( magma_index_malloc_cpu( &B->delta_base, A.num_rows ));
+                CHECK( magma_index_malloc_cpu( &B->delta_ptr, A.num_rows+1 ));
+
+                // smallest column and number of chunks of each row
+                B->delta_ptr[0] = 0;
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    magma_index_t base = ( A.row[i] < A.row[i+1] ) ? A.col[ A.row[i] ] : 0;
+                    for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+                        base = min( base, A.col[j] );
+                    }
+                    B->delta_base[i] = base;
+                    B->delta_ptr[i+1] = magma_ceildiv( A.row[i+1] - A.row[i], MAGMA_CSRDELTA_CHUNK );
+                }
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows+1; i++) {
+                    B->row[i] = A.row[i];
+                }
+                magma_zindex_scan_cpu( A.num_rows+1, B->delta_ptr );
+                magma_int_t numchunks = B->delta_ptr[ A.num_rows ];
+
+                // width code of each chunk: 0 (8 bit), 1 (16 bit), 2 (32 bit),
+                // and its size in 8-byte units, so all chunks stay aligned
+                CHECK( magma_uindex_malloc_cpu( &B->delta_desc, numchunks ));
+                CHECK( magma_index_malloc_cpu( &length, numchunks+1 ));
+                length[0] = 0;
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    for( magma_int_t c=B->delta_ptr[i]; c < B->delta_ptr[i+1]; c++ ) {
+                        magma_int_t start = A.row[i] + (c - B->delta_ptr[i]) * MAGMA_CSRDELTA_CHUNK;
+                        magma_int_t end = min( start + MAGMA_CSRDELTA_CHUNK, A.row[i+1] );
+                        magma_index_t maxoff = 0;
+                        for( magma_int_t j=start; j < end; j++ ) {
+                            maxoff = max( maxoff, A.col[j] - B->delta_base[i] );
+                        }
+                        magma_uindex_t width = ( maxoff < 256 ) ? 0 : ( maxoff < 65536 ) ? 1 : 2;
+                        B->delta_desc[c] = width;
+                        length[c+1] = magma_ceildiv( (end - start) << width, 8 );
+                    }
+                }
+                magma_zindex_scan_cpu( numchunks+1, length );
+                if ( length[ numchunks ] >= (1 << 30) ) {
+                    printf("error: matrix too large for CSRDELTA.\n");
+                    info = MAGMA_ERR_NOT_SUPPORTED;
+                    goto cleanup;
+                }
+                CHECK( magma_malloc_cpu( (void**) &B->delta_col, 8 * (size_t) length[ numchunks ] ));
+
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    for( magma_int_t c=B->delta_ptr[i]; c < B->delta_ptr[i+1]; c++ ) {
+                        magma_int_t start = A.row[i] + (c - B->delta_ptr[i]) * MAGMA_CSRDELTA_CHUNK;
+                        magma_int_t end = min( start + MAGMA_CSRDELTA_CHUNK, A.row[i+1] );
+                        void *chunk = B->delta_col + 8 * (size_t) length[c];
+                        magma_uindex_t width = B->delta_desc[c];
+                        B->delta_desc[c] = ((magma_uindex_t) length[c] << 2) | width;
+                        for( magma_int_t j=start; j < end; j++ ) {
+                            magma_uindex_t off = A.col[j] - B->delta_base[i];
+                            if ( width == 0 )
+                                ((unsigned char*) chunk)[ j-start ] = (unsigned char) off;
+                            else if ( width == 1 )
+                                ((unsigned short*) chunk)[ j-start ] = (unsigned short) off;
+                            else
+                                ((magma_uindex_t*) chunk)[ j-start ] = off;
+                            B->val[j] = A.val[j];
+                        }
+                    }
+                }
+            }
+
             else {
                 printf("error: format not supported.\n");
                 info = MAGMA_ERR_NOT_SUPPORTED;
@@ -1617,6 +1870,48 @@ magma_zmconvert(
                 magma_zmfree( &dB, queue );
             }
 
+            // CSRDELTA to CSR
+            else if ( old_format == Magma_CSRDELTA ) {
+                // fill in information for B
+                B->storage_type = Magma_CSR;
+                B->memory_location = A.memory_location;
+                B->fill_mode = A.fill_mode;
+                B->num_rows = A.num_rows; B->true_nnz = A.true_nnz;
+                B->num_cols = A.num_cols;
+                B->nnz = A.nnz;
+                B->max_nnz_row = A.max_nnz_row;
+                B->diameter = A.diameter;
+
+                CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
+                CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
+                CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
+
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows+1; i++) {
+                    B->row[i] = A.row[i];
+                }
+                #pragma omp parallel for
+                for( magma_int_t i=0; i < A.num_rows; i++ ) {
+                    for( magma_int_t c=A.delta_ptr[i]; c < A.delta_ptr[i+1]; c++ ) {
+                        magma_int_t start = A.row[i] + (c - A.delta_ptr[i]) * MAGMA_CSRDELTA_CHUNK;
+                        magma_int_t end = min( start + MAGMA_CSRDELTA_CHUNK, A.row[i+1] );
+                        const void *chunk = A.delta_col + 8 * (size_t) (A.delta_desc[c] >> 2);
+                        magma_uindex_t width = A.delta_desc[c] & 3;
+                        for( magma_int_t j=start; j < end; j++ ) {
+                            magma_uindex_t off;
+                            if ( width == 0 )
+                                off = ((const unsigned char*) chunk)[ j-start ];
+                            else if ( width == 1 )
+                                off = ((const unsigned short*) chunk)[ j-start ];
+                            else
+                                off = ((const magma_uindex_t*) chunk)[ j-start ];
+                            B->col[j] = A.delta_base[i] + off;
+                            B->val[j] = A.val[j];
+                        }
+                    }
+                }
+            }
+
             else {
                 printf("error: format not supported.\n");
                 //magmablasSetKernelStream( queue );
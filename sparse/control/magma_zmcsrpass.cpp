@@ -80,6 +80,8 @@ magma_zcsrset(
     A->row = row;
     A->fill_mode = MagmaFull;
     A->ownership = MagmaFalse;
+    A->mapping = NULL;
+    A->lval = NULL;
 
     return MAGMA_SUCCESS;
 }
@@ -79,6 +79,8 @@ magma_zcsrset_gpu(
     A->dcol = col;
     A->drow = row;
     A->ownership = MagmaFalse;
+    A->mapping = NULL;
+    A->lval = NULL;
 
     return MAGMA_SUCCESS;
 }
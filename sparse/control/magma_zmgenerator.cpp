@@ -8,7 +8,19 @@
        @precisions normal z -> s d c
        @author Hartwig Anzt
 */
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <climits>
+#include <algorithm>
+
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PRECISION_z
 
 
 /**
@@ -135,22 +147,567 @@ cleanup:
 
 
 
+
+
+/* Stencil of a synthetic matrix: the offsets of the neighbours in the
+   order of increasing column index (z slowest, x fastest) and the
+   coupling weight of each neighbour. */
+typedef struct magma_zmgen_stencil
+{
+    int64_t nx, ny, nz;
+    int64_t tx, ty, tz;         // sum of the 1D neighbourhood widths per dimension
+    magma_int_t box;            // 1: all points of the 3x3(x3) box, 0: star
+    magma_int_t noffsets;
+    int dx[27], dy[27], dz[27];
+    double w[27];
+    double contrast;
+    double shift;
+    double *cx, *cy, *cz;       // cos( pi*t/n ) for t = -1, ..., 2n-1, or NULL
+} magma_zmgen_stencil;
+
+
+/* Width 1 + (i > 0) + (i < n-1) of the 1D neighbourhood of grid point i. */
+static inline int64_t
+magma_zmgen_width( int64_t i, int64_t n )
+{
+    return 1 + (i > 0) + (i < n-1);
+}
+
+
+/* Sum of the 1D neighbourhood widths of the grid points 0, ..., i-1. */
+static inline int64_t
+magma_zmgen_prefix( int64_t i, int64_t n )
+{
+    return i + (i > 0 ? i-1 : 0) + (i < n-1 ? i : n-1);
+}
+
+
+/* Position of the first nonzero of grid row (x,y,z) in closed form;
+   (0,0,nz) gives the number of nonzeros of the matrix. */
+static inline int64_t
+magma_zmgen_offset(
+    const magma_zmgen_stencil *S,
+    int64_t x,
+    int64_t y,
+    int64_t z )
+{
+    const int64_t nx = S->nx, ny = S->ny, nz = S->nz;
+
+    if ( S->box ) {
+        return magma_zmgen_prefix( z, nz ) * S->ty * S->tx
+             + magma_zmgen_width( z, nz ) * ( magma_zmgen_prefix( y, ny ) * S->tx
+             + magma_zmgen_width( y, ny ) * magma_zmgen_prefix( x, nx ) );
+    }
+    // one diagonal entry per row plus the neighbours in x, y, and z
+    return x + nx*( y + ny*z )
+         + ( y + ny*z ) * ( S->tx - nx ) + magma_zmgen_prefix( x, nx ) - x
+         + z * nx * ( S->ty - ny ) + nx * ( magma_zmgen_prefix( y, ny ) - y )
+         + x * ( magma_zmgen_width( y, ny ) - 1 )
+         + nx * ny * ( magma_zmgen_prefix( z, nz ) - z )
+         + ( y*nx + x ) * ( magma_zmgen_width( z, nz ) - 1 );
+}
+
+
+/* Coupling of grid point (x,y,z) with its neighbour k, evaluated at the
+   midpoint of the two. */
+static inline double
+magma_zmgen_coupling(
+    const magma_zmgen_stencil *S,
+    int64_t x,
+    int64_t y,
+    int64_t z,
+    magma_int_t k )
+{
+    if ( S->cx == NULL ) {
+        return S->w[k];
+    }
+    return S->w[k] * exp( S->contrast
+        * S->cx[ 2*x + S->dx[k] + 1 ]
+        * S->cy[ 2*y + S->dy[k] + 1 ]
+        * S->cz[ 2*z + S->dz[k] + 1 ] );
+}
+
+
+static void
+magma_zmgen_stencil_free( magma_zmgen_stencil *S )
+{
+    magma_free_cpu( S->cx );
+    magma_free_cpu( S->cy );
+    magma_free_cpu( S->cz );
+    S->cx = S->cy = S->cz = NULL;
+}
+
+
+/* Sets up the stencil of gen; fails for graph generators. */
+static magma_int_t
+magma_zmgen_stencil_init(
+    magma_matrix_generator gen,
+    magma_zmgen_stencil *S )
+{
+    magma_int_t info = 0;
+    magma_int_t dim;
+    int64_t n[3];
+    double **table[3] = { &S->cx, &S->cy, &S->cz };
+
+    S->cx = S->cy = S->cz = NULL;
+    switch ( gen.stencil ) {
+        case 5:  dim = 2; S->box = 0; break;
+        case 9:  dim = 2; S->box = 1; break;
+        case 7:  dim = 3; S->box = 0; break;
+        case 27: dim = 3; S->box = 1; break;
+        default: return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    if ( gen.nx < 1 || gen.ny < 1 || ( dim == 3 && gen.nz < 1 ) ) {
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    S->nx = gen.nx;
+    S->ny = gen.ny;
+    S->nz = ( dim == 3 ) ? gen.nz : 1;
+    S->tx = magma_zmgen_prefix( S->nx, S->nx );
+    S->ty = magma_zmgen_prefix( S->ny, S->ny );
+    S->tz = magma_zmgen_prefix( S->nz, S->nz );
+    S->contrast = gen.contrast;
+    S->shift = gen.shift;
+
+    S->noffsets = 0;
+    for( int dz = ( dim == 3 ? -1 : 0 ); dz <= ( dim == 3 ? 1 : 0 ); dz++ ) {
+        for( int dy = -1; dy <= 1; dy++ ) {
+            for( int dx = -1; dx <= 1; dx++ ) {
+                int m = abs( dx ) + abs( dy ) + abs( dz );
+                if ( ! S->box && m > 1 ) {
+                    continue;
+                }
+                magma_int_t k = S->noffsets++;
+                S->dx[k] = dx;
+                S->dy[k] = dy;
+                S->dz[k] = dz;
+                // diagonal neighbours couple with the mean weight of their directions
+                S->w[k] = ( m == 0 ) ? 0.0 :
+                    ( abs( dx )*gen.hx + abs( dy )*gen.hy + abs( dz )*gen.hz ) / m;
+            }
+        }
+    }
+
+    if ( gen.contrast != 0.0 ) {
+        n[0] = S->nx;
+        n[1] = S->ny;
+        n[2] = S->nz;
+        for( magma_int_t d=0; d < 3; d++ ) {
+            CHECK( magma_dmalloc_cpu( table[d], 2*n[d]+1 ));
+            for( int64_t t=-1; t < 2*n[d]; t++ ) {
+                (*table[d])[ t+1 ] = cos( 3.14159265358979323846 * t / n[d] );
+            }
+        }
+    }
+
+cleanup:
+    if ( info != 0 ) {
+        magma_zmgen_stencil_free( S );
+    }
+    return info;
+}
+
+
+/* Fills rows first_row, ..., last_row-1 of a stencil matrix, see
+   magma_zmgenerate_rows. Each row is written by the thread that owns it
+   in a static schedule, which also places the pages (first touch). */
+static void
+magma_zmgen_stencil_rows(
+    const magma_zmgen_stencil *S,
+    magma_int_t first_row,
+    magma_int_t last_row,
+    magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val )
+{
+    const int64_t nx = S->nx, ny = S->ny, nz = S->nz;
+    const int64_t plane = nx*ny;
+    int64_t base = magma_zmgen_offset( S, first_row % nx, (first_row / nx) % ny,
+                                       first_row / plane );
+
+    #pragma omp parallel for schedule(static)
+    for( magma_int_t r=first_row; r < last_row; r++ ) {
+        int64_t x = r % nx, y = (r / nx) % ny, z = r / plane;
+        int64_t j = magma_zmgen_offset( S, x, y, z ) - base;
+        row[ r-first_row ] = (magma_index_t) j;
+        if ( col == NULL ) {
+            continue;
+        }
+        // Dirichlet boundary: couplings to points outside the grid
+        // still add to the diagonal
+        double diag = S->shift;
+        int64_t jdiag = j;
+        for( magma_int_t k=0; k < S->noffsets; k++ ) {
+            int64_t xk = x + S->dx[k], yk = y + S->dy[k], zk = z + S->dz[k];
+            if ( xk == x && yk == y && zk == z ) {
+                jdiag = j;
+                col[ j++ ] = (magma_index_t) r;
+                continue;
+            }
+            double a = magma_zmgen_coupling( S, x, y, z, k );
+            diag += a;
+            if ( xk >= 0 && xk < nx && yk >= 0 && yk < ny && zk >= 0 && zk < nz ) {
+                col[ j ] = (magma_index_t) ( xk + nx*( yk + ny*zk ) );
+                val[ j ] = MAGMA_Z_MAKE( -a, 0.0 );
+                j++;
+            }
+        }
+        val[ jdiag ] = MAGMA_Z_MAKE( diag, 0.0 );
+    }
+    row[ last_row-first_row ] = (magma_index_t) ( magma_zmgen_offset( S,
+        last_row % nx, (last_row / nx) % ny, last_row / plane ) - base );
+}
+
+
+/* splitmix64 finalizer, used as a counter-based random number generator. */
+static inline uint64_t
+magma_zmgen_hash( uint64_t x )
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = ( x ^ (x >> 30) ) * 0xbf58476d1ce4e5b9ULL;
+    x = ( x ^ (x >> 27) ) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+/* Random weight in [0.5, 1.5) of the edge {i,j}. */
+static inline double
+magma_zmgen_edge_weight( uint64_t seed, int64_t i, int64_t j )
+{
+    uint64_t lo = (uint64_t) ( i < j ? i : j );
+    uint64_t hi = (uint64_t) ( i < j ? j : i );
+    uint64_t h = magma_zmgen_hash( seed ^ magma_zmgen_hash( (lo << 32) | hi ) );
+    return 0.5 + (double) (h >> 11) * ( 1.0 / 9007199254740992.0 );
+}
+
+
+/* Weighted Laplacian of a random graph on gen.nx vertices: every vertex
+   draws gen.degree neighbours, the edges are symmetrized, and repeated
+   edges and self loops are dropped. There is no closed form for the row
+   pointer, so the rows are counted, filled, and compacted in parallel. */
+static magma_int_t
+magma_zmgen_graph(
+    magma_matrix_generator gen,
+    magma_int_t *num_rows,
+    magma_int_t *nnz,
+    magma_int_t *max_nnz_row,
+    magma_index_t **rowptr,
+    magma_index_t **colind,
+    magmaDoubleComplex **values,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    const int64_t n = gen.nx, k = gen.degree;
+    magma_index_t *cnt = NULL, *tmp = NULL, *len = NULL;
+    magma_index_t *row = NULL, *col = NULL;
+    magmaDoubleComplex *val = NULL;
+    magma_index_t maxrow = 0;
+    uint64_t seed = magma_zmgen_hash( (uint64_t) gen.seed );
+
+    if ( n < 1 || k < 0 ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+    if ( n * (2*k+1) > (int64_t) INT_MAX ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    // count the diagonal, the drawn edges, and their mirror images
+    CHECK( magma_index_malloc_cpu( &cnt, n+1 ));
+    cnt[0] = 0;
+    #pragma omp parallel for schedule(static)
+    for( int64_t i=0; i < n; i++ ) {
+        cnt[ i+1 ] = 1;
+    }
+    #pragma omp parallel for schedule(static)
+    for( int64_t i=0; i < n; i++ ) {
+        for( int64_t t=0; t < k; t++ ) {
+            int64_t j = magma_zmgen_hash( seed ^ (uint64_t) ( i*k + t ) ) % (uint64_t) n;
+            if ( j != i ) {
+                #pragma omp atomic
+                cnt[ i+1 ]++;
+                #pragma omp atomic
+                cnt[ j+1 ]++;
+            }
+        }
+    }
+    magma_zindex_scan_cpu( n+1, cnt );
+
+    CHECK( magma_index_malloc_cpu( &tmp, cnt[n] ));
+    CHECK( magma_index_malloc_cpu( &len, n ));
+    #pragma omp parallel for schedule(static)
+    for( int64_t i=0; i < n; i++ ) {
+        tmp[ cnt[i] ] = (magma_index_t) i;
+        len[i] = cnt[i] + 1;
+    }
+    #pragma omp parallel for schedule(static)
+    for( int64_t i=0; i < n; i++ ) {
+        for( int64_t t=0; t < k; t++ ) {
+            int64_t j = magma_zmgen_hash( seed ^ (uint64_t) ( i*k + t ) ) % (uint64_t) n;
+            if ( j != i ) {
+                magma_index_t p, q;
+                #pragma omp atomic capture
+                p = len[i]++;
+                tmp[p] = (magma_index_t) j;
+                #pragma omp atomic capture
+                q = len[j]++;
+                tmp[q] = (magma_index_t) i;
+            }
+        }
+    }
+    // sort the rows and drop repeated edges
+    #pragma omp parallel for schedule(dynamic,1024) reduction(max:maxrow)
+    for( int64_t i=0; i < n; i++ ) {
+        std::sort( tmp + cnt[i], tmp + cnt[i+1] );
+        len[i] = (magma_index_t) ( std::unique( tmp + cnt[i], tmp + cnt[i+1] ) - ( tmp + cnt[i] ));
+        maxrow = max( maxrow, len[i] );
+    }
+
+    CHECK( magma_index_malloc_cpu( &row, n+1 ));
+    row[0] = 0;
+    #pragma omp parallel for schedule(static)
+    for( int64_t i=0; i < n; i++ ) {
+        row[ i+1 ] = len[i];
+    }
+    magma_zindex_scan_cpu( n+1, row );
+    CHECK( magma_index_malloc_cpu( &col, row[n] ));
+    CHECK( magma_zmalloc_cpu( &val, row[n] ));
+    #pragma omp parallel for schedule(static)
+    for( int64_t i=0; i < n; i++ ) {
+        double diag = gen.shift;
+        magma_index_t jdiag = row[i];
+        for( magma_index_t e=0; e < len[i]; e++ ) {
+            magma_index_t j = tmp[ cnt[i] + e ];
+            col[ row[i] + e ] = j;
+            if ( j == i ) {
+                jdiag = row[i] + e;
+            } else {
+                double w = magma_zmgen_edge_weight( seed, i, j );
+                val[ row[i] + e ] = MAGMA_Z_MAKE( -w, 0.0 );
+                diag += w;
+            }
+        }
+        val[ jdiag ] = MAGMA_Z_MAKE( diag, 0.0 );
+    }
+
+    *num_rows = n;
+    *nnz = row[n];
+    *max_nnz_row = maxrow;
+    *rowptr = row;
+    *colind = col;
+    *values = val;
+    row = NULL;
+    col = NULL;
+    val = NULL;
+
+cleanup:
+    magma_free_cpu( cnt );
+    magma_free_cpu( tmp );
+    magma_free_cpu( len );
+    magma_free_cpu( row );
+    magma_free_cpu( col );
+    magma_free_cpu( val );
+    return info;
+}
+
+
 /**
     Purpose
     -------
 
-    Generate a 27-point stencil for a 3D FD discretization.
+    Returns the dimension and the number of nonzeros of the stencil
+    matrix described by gen without generating it. The row offsets of
+    stencil matrices are known in closed form, which magma_zmgenerate_rows
+    and magma_zwrite_csr_generator use to fill or write any row block
+    independently. Random graph Laplacians (gen.stencil = 0) have no
+    closed form and return MAGMA_ERR_NOT_SUPPORTED.
 
     Arguments
     ---------
 
     @param[in]
-    n           magma_int_t
-                number of rows
+    gen         magma_matrix_generator
+                description of the matrix, see magma_zmgenerate
+
+    @param[out]
+    num_rows    magma_int_t*
+                number of rows (and columns)
+
+    @param[out]
+    nnz         int64_t*
+                number of nonzeros
+
+    @param[out]
+    max_nnz_row magma_int_t*
+                maximum number of nonzeros in a row
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmgenerate_size(
+    magma_matrix_generator gen,
+    magma_int_t *num_rows,
+    int64_t *nnz,
+    magma_int_t *max_nnz_row,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_zmgen_stencil S;
+    int64_t n;
+    const int64_t index_max = INT_MAX;
+
+    if ( gen.stencil == 0 ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    // only the sizes are needed, skip the coefficient tables
+    gen.contrast = 0.0;
+    CHECK( magma_zmgen_stencil_init( gen, &S ));
+
+    n = S.nx * S.ny * S.nz;
+    *nnz = magma_zmgen_offset( &S, 0, 0, S.nz );
+    if ( n >= index_max || *nnz > index_max ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    *num_rows = (magma_int_t) n;
+    if ( S.box ) {
+        *max_nnz_row = min( S.nx, 3 ) * min( S.ny, 3 ) * min( S.nz, 3 );
+    } else {
+        *max_nnz_row = min( S.nx, 3 ) + min( S.ny, 3 ) + min( S.nz, 3 ) - 2;
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Generates the row block first_row, ..., last_row-1 of the stencil
+    matrix described by gen, see magma_zmgenerate. The rows are filled in
+    parallel; the row pointer is relative to the block, i.e.,
+    row[0] = 0 and row[last_row-first_row] is the number of nonzeros in
+    the block. If col and val are NULL, only row is computed, so the
+    caller can allocate col and val for the block.
+    Random graph Laplacians are not supported, see magma_zmgenerate_size.
+
+    Arguments
+    ---------
+
+    @param[in]
+    gen         magma_matrix_generator
+                description of the matrix
+
+    @param[in]
+    first_row   magma_int_t
+                first row of the block
+
+    @param[in]
+    last_row    magma_int_t
+                one past the last row of the block
+
+    @param[out]
+    row         magma_index_t*
+                row pointer of the block, last_row-first_row+1 entries
+
+    @param[out]
+    col         magma_index_t*
+                column indices of the block, or NULL
+
+    @param[out]
+    val         magmaDoubleComplex*
+                values of the block, or NULL
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmgenerate_rows(
+    magma_matrix_generator gen,
+    magma_int_t first_row,
+    magma_int_t last_row,
+    magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_zmgen_stencil S = { 0 };
+    magma_int_t num_rows, max_nnz_row;
+    int64_t nnz;
+
+    CHECK( magma_zmgenerate_size( gen, &num_rows, &nnz, &max_nnz_row, queue ));
+    if ( first_row < 0 || first_row > last_row || last_row > num_rows
+        || ( (col == NULL) != (val == NULL) ) ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+    CHECK( magma_zmgen_stencil_init( gen, &S ));
+    magma_zmgen_stencil_rows( &S, first_row, last_row, row, col, val );
+
+cleanup:
+    magma_zmgen_stencil_free( &S );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Generates a synthetic symmetric test matrix in CSR format on the CPU,
+    directly and in parallel:
+
+    - gen.stencil = 5 or 9: 2D 5-point or 9-point stencil on a
+      gen.nx x gen.ny grid,
+    - gen.stencil = 7 or 27: 3D 7-point or 27-point stencil on a
+      gen.nx x gen.ny x gen.nz grid,
+    - gen.stencil = 0: weighted Laplacian of a random graph with gen.nx
+      vertices, where each vertex draws gen.degree neighbours.
+
+    Stencil rows are numbered lexicographically with x fastest and use
+    Dirichlet boundary conditions. The coupling in direction x is gen.hx
+    (likewise for y and z; diagonal neighbours use the mean of their
+    directions), multiplied by the coefficient exp(gen.contrast*s) with
+    s = cos(2 pi x/nx) cos(2 pi y/ny) cos(2 pi z/nz) taken at the midpoint
+    between the two grid points. The off-diagonal entries are the negative
+    couplings, the diagonal is their sum including the couplings to points
+    outside the grid, plus gen.shift. With unit weights and no contrast,
+    the 5-point and 27-point stencils have the diagonal 4 and 26.
+
+    The row offsets of stencils are computed in closed form, so every row
+    is generated independently by the thread that first touches its
+    memory. The graph Laplacian has edge weights in [0.5, 1.5) and is
+    singular unless gen.shift > 0.
+
+    Arguments
+    ---------
+
+    @param[in]
+    gen         magma_matrix_generator
+                description of the matrix, see magma_zmgenerate_parse
 
     @param[out]
     A           magma_z_matrix*
                 matrix to generate
+
     @param[in]
     queue       magma_queue_t
                 Queue to execute in.
@@ -160,98 +717,234 @@ cleanup:
 
 extern "C"
 magma_int_t
-magma_zm_27stencil(
-    magma_int_t n,
+magma_zmgenerate(
+    magma_matrix_generator gen,
     magma_z_matrix *A,
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    
-    magma_int_t i,j,k;
-    magma_z_matrix hA={Magma_CSR};
 
-    
-    // generate matrix of desired structure and size (3d 27-point stencil)
-    magma_int_t nn = n*n*n;
-    magma_int_t offdiags = 13;
-    magma_index_t *diag_offset=NULL;
-    magmaDoubleComplex *diag_vals=NULL;
-    CHECK( magma_zmalloc_cpu( &diag_vals, offdiags+1 ));
-    CHECK( magma_index_malloc_cpu( &diag_offset, offdiags+1 ));
-
-    diag_offset[0] = 0;
-    diag_offset[1] = 1;
-    diag_offset[2] = n-1;
-    diag_offset[3] = n;
-    diag_offset[4] = n+1;
-    diag_offset[5] = n*n-n-1;
-    diag_offset[6] = n*n-n;
-    diag_offset[7] = n*n-n+1;
-    diag_offset[8] = n*n-1;
-    diag_offset[9] = n*n;
-    diag_offset[10] = n*n+1;
-    diag_offset[11] = n*n+n-1;
-    diag_offset[12] = n*n+n;
-    diag_offset[13] = n*n+n+1;
-
-    diag_vals[0] = MAGMA_Z_MAKE( 26.0, 0.0 );
-    diag_vals[1] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[2] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[3] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[4] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[5] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[6] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[7] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[8] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[9] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[10] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[11] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[12] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    diag_vals[13] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    CHECK( magma_zmgenerator( nn, offdiags, diag_offset, diag_vals, &hA, queue ));
-
-    // now set some entries to zero (boundary...)
-    for( i=0; i < n*n; i++ ) {
-        for( j=0; j < n; j++ ) {
-            magma_index_t row = i*n+j;
-            for( k=hA.row[row]; k<hA.row[row+1]; k++) {
-                if ((hA.col[k] == row-1 ||
-                    hA.col[k] == row-n-1 ||
-                    hA.col[k] == row+n-1 ||
-                    hA.col[k] == row-n*n+n-1 ||
-                    hA.col[k] == row+n*n-n-1 ||
-                    hA.col[k] == row-n*n-1 ||
-                    hA.col[k] == row+n*n-1 ||
-                    hA.col[k] == row-n*n-n-1 ||
-                    hA.col[k] == row+n*n+n-1 ) && (row+1)%n == 1 )
-                        
-                        hA.val[k] = MAGMA_Z_MAKE( 0.0, 0.0 );
-    
-                if ((hA.col[k] == row+1 ||
-                    hA.col[k] == row-n+1 ||
-                    hA.col[k] == row+n+1 ||
-                    hA.col[k] == row-n*n+n+1 ||
-                    hA.col[k] == row+n*n-n+1 ||
-                    hA.col[k] == row-n*n+1 ||
-                    hA.col[k] == row+n*n+1 ||
-                    hA.col[k] == row-n*n-n+1 ||
-                    hA.col[k] == row+n*n+n+1 ) && (row)%n ==n-1 )
-                        
-                        hA.val[k] = MAGMA_Z_MAKE( 0.0, 0.0 );
-            }
-        }
+    magma_int_t num_rows = 0, max_nnz_row = 0;
+    int64_t nnz = 0;
+    magma_int_t graph_nnz = 0;
+    magma_index_t *row = NULL, *col = NULL;
+    magmaDoubleComplex *val = NULL;
+
+    if ( gen.stencil == 0 ) {
+        CHECK( magma_zmgen_graph( gen, &num_rows, &graph_nnz, &max_nnz_row,
+                                  &row, &col, &val, queue ));
+        nnz = graph_nnz;
+    } else {
+        CHECK( magma_zmgenerate_size( gen, &num_rows, &nnz, &max_nnz_row, queue ));
+        CHECK( magma_index_malloc_cpu( &row, num_rows+1 ));
+        CHECK( magma_index_malloc_cpu( &col, nnz ));
+        CHECK( magma_zmalloc_cpu( &val, nnz ));
+        CHECK( magma_zmgenerate_rows( gen, 0, num_rows, row, col, val, queue ));
     }
-    hA.true_nnz = hA.nnz;
-    if (A->ownership) {
+
+    if ( A->ownership ) {
         magma_zmfree( A, queue );
     }
+    A->storage_type = Magma_CSR;
+    A->memory_location = Magma_CPU;
+    A->sym = Magma_SYMMETRIC;
+    A->diagorder_type = Magma_VALUE;
+    A->fill_mode = MagmaFull;
+    A->num_rows = num_rows;
+    A->num_cols = num_rows;
+    A->nnz = (magma_int_t) nnz;
+    A->true_nnz = A->nnz;
+    A->max_nnz_row = max_nnz_row;
+    A->row = row;
+    A->col = col;
+    A->val = val;
+    A->rowidx = NULL;
+    A->blockinfo = NULL;
+    A->diag = NULL;
+    A->list = NULL;
+    A->delta_col = NULL;
+    A->delta_desc = NULL;
+    A->delta_ptr = NULL;
+    A->delta_base = NULL;
     A->ownership = MagmaTrue;
-    CHECK( magma_zmconvert( hA, A, Magma_CSR, Magma_CSR, queue ));
+    A->mapping = NULL;
+    A->lval = NULL;
+    row = NULL;
+    col = NULL;
+    val = NULL;
+
+cleanup:
+    magma_free_cpu( row );
+    magma_free_cpu( col );
+    magma_free_cpu( val );
+    return info;
+}
+
+
+/* Compares the key of a "key=value" token of length len with name. */
+static inline bool
+magma_zmgen_key( const char *token, size_t len, const char *name )
+{
+    return len == strlen( name ) && strncmp( token, name, len ) == 0;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Parses a generator description of the form
+    "type,key=value,key=value,...", where type is one of
+    5pt, 9pt (2D stencils), 7pt, 27pt (3D stencils), or graph, and the
+    keys are
+
+    - n:        grid points per dimension, or vertices of the graph
+    - nx, ny, nz: grid points per dimension
+    - hx, hy, hz: coupling weight per direction (default 1)
+    - contrast: contrast of the variable coefficient (default 0)
+    - shift:    added to the diagonal (default 0)
+    - degree:   neighbours drawn per vertex (graph, default 8)
+    - seed:     seed of the random graph (default 0)
+
+    For example, "27pt,n=400,hz=0.01" is an anisotropic 27-point stencil
+    on a 400^3 grid with 1.7e9 nonzeros.
+    The testers accept the description after the GENERATE keyword.
+
+    Arguments
+    ---------
+
+    @param[in]
+    spec        const char*
+                generator description
+
+    @param[out]
+    gen         magma_matrix_generator*
+                generator
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmgenerate_parse(
+    const char *spec,
+    magma_matrix_generator *gen,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    const char *p = spec;
+    size_t len = strcspn( p, "," );
+
+    memset( gen, 0, sizeof(magma_matrix_generator) );
+    gen->hx = gen->hy = gen->hz = 1.0;
+    gen->degree = 8;
+
+    if ( magma_zmgen_key( p, len, "5pt" ) ) {
+        gen->stencil = 5;
+    } else if ( magma_zmgen_key( p, len, "9pt" ) ) {
+        gen->stencil = 9;
+    } else if ( magma_zmgen_key( p, len, "7pt" ) ) {
+        gen->stencil = 7;
+    } else if ( magma_zmgen_key( p, len, "27pt" ) ) {
+        gen->stencil = 27;
+    } else if ( magma_zmgen_key( p, len, "graph" ) ) {
+        gen->stencil = 0;
+    } else {
+        printf( "%% error: unknown generator '%.*s'\n", (int) len, p );
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+
+    while ( p[len] == ',' ) {
+        p += len + 1;
+        len = strcspn( p, "," );
+        const char *eq = (const char*) memchr( p, '=', len );
+        if ( eq == NULL ) {
+            printf( "%% error: expected key=value in generator, got '%.*s'\n", (int) len, p );
+            info = MAGMA_ERR_ILLEGAL_VALUE;
+            goto cleanup;
+        }
+        size_t klen = eq - p;
+        if ( magma_zmgen_key( p, klen, "n" ) ) {
+            gen->nx = gen->ny = gen->nz = atoi( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "nx" ) ) {
+            gen->nx = atoi( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "ny" ) ) {
+            gen->ny = atoi( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "nz" ) ) {
+            gen->nz = atoi( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "hx" ) ) {
+            gen->hx = atof( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "hy" ) ) {
+            gen->hy = atof( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "hz" ) ) {
+            gen->hz = atof( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "contrast" ) ) {
+            gen->contrast = atof( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "shift" ) ) {
+            gen->shift = atof( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "degree" ) ) {
+            gen->degree = atoi( eq+1 );
+        } else if ( magma_zmgen_key( p, klen, "seed" ) ) {
+            gen->seed = atoi( eq+1 );
+        } else {
+            printf( "%% error: unknown generator key '%.*s'\n", (int) klen, p );
+            info = MAGMA_ERR_ILLEGAL_VALUE;
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Generate a 27-point stencil for a 3D FD discretization.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                number of grid points per dimension
+
+    @param[out]
+    A           magma_z_matrix*
+                matrix to generate
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zm_27stencil(
+    magma_int_t n,
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_matrix_generator gen;
+    memset( &gen, 0, sizeof(gen) );
+    gen.stencil = 27;
+    gen.nx = gen.ny = gen.nz = n;
+    gen.hx = gen.hy = gen.hz = 1.0;
+
+    CHECK( magma_zmgenerate( gen, A, queue ));
 
 cleanup:
-    magma_free_cpu( diag_vals );
-    magma_free_cpu( diag_offset );
-    magma_zmfree( &hA, queue );
     return info;
 }
 
@@ -268,7 +961,7 @@ cleanup:
 
     @param[in]
     n           magma_int_t
-                number of rows
+                number of grid points per dimension
 
     @param[out]
     A           magma_z_matrix*
@@ -288,61 +981,23 @@ magma_zm_5stencil(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    
-    magma_int_t i,j,k;
-    magma_z_matrix hA={Magma_CSR};
-    
-    // generate matrix of desired structure and size (2d 5-point stencil)
-    magma_int_t nn = n*n;
-    magma_int_t offdiags = 2;
-    magma_index_t *diag_offset=NULL;
-    magmaDoubleComplex *diag_vals=NULL;
-    CHECK( magma_zmalloc_cpu( &diag_vals, offdiags+1 ));
-    CHECK( magma_index_malloc_cpu( &diag_offset, offdiags+1 ));
-    
-    magma_zmfree( A, queue );
-    A->ownership = MagmaTrue;
-    diag_offset[0] = 0;
-    diag_offset[1] = 1;
-    diag_offset[2] = n;
-    
-    #define COMPLEX
-    
-    #ifdef COMPLEX
-        // complex case
-        diag_vals[0] = MAGMA_Z_MAKE( 4.0, 4.0 );
-        diag_vals[1] = MAGMA_Z_MAKE( -1.0, -1.0 );
-        diag_vals[2] = MAGMA_Z_MAKE( -1.0, -1.0 );
-        
-    #else
-        // real case
-        diag_vals[0] = MAGMA_Z_MAKE( 4.0, 0.0 );
-        diag_vals[1] = MAGMA_Z_MAKE( -1.0, 0.0 );
-        diag_vals[2] = MAGMA_Z_MAKE( -1.0, 0.0 );
-    #endif
-    CHECK( magma_zmgenerator( nn, offdiags, diag_offset, diag_vals, &hA, queue ));
-
-    // now set some entries to zero (boundary...)
-    for( i=0; i<n; i++ ) {
-        for( j=0; j<n; j++ ) {
-            magma_index_t row = i*n+j;
-            for( k=hA.row[row]; k<hA.row[row+1]; k++) {
-                if ((hA.col[k] == row-1 ) && (row+1)%n == 1 )
-                    hA.val[k] = MAGMA_Z_MAKE( 0.0, 0.0 );
-    
-                if ((hA.col[k] == row+1 ) && (row)%n ==n-1 )
-                    hA.val[k] = MAGMA_Z_MAKE( 0.0, 0.0 );
-            }
-        }
+
+    magma_matrix_generator gen;
+    memset( &gen, 0, sizeof(gen) );
+    gen.stencil = 5;
+    gen.nx = gen.ny = n;
+    gen.hx = gen.hy = 1.0;
+
+    CHECK( magma_zmgenerate( gen, A, queue ));
+
+    #if defined(PRECISION_z) || defined(PRECISION_c)
+    // complex case: diagonal 4+4i, off-diagonals -1-1i
+    #pragma omp parallel for schedule(static)
+    for( magma_int_t i=0; i < A->nnz; i++ ) {
+        A->val[i] = MAGMA_Z_MAKE( MAGMA_Z_REAL( A->val[i] ), MAGMA_Z_REAL( A->val[i] ));
     }
+    #endif
 
-    CHECK( magma_zmconvert( hA, A, Magma_CSR, Magma_CSR, queue ));
-    magma_zmcsrcompressor( A, queue );
-    A->true_nnz = A->nnz;
-    
 cleanup:
-    magma_free_cpu( diag_vals );
-    magma_free_cpu( diag_offset );
-    magma_zmfree( &hA, queue );
     return info;
 }
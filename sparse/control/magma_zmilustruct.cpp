@@ -12,7 +12,17 @@
 //  in this file, many routines are taken from
 //  the IO functions provided by MatrixMarket
 
+#include <algorithm>
+#include <vector>
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// rows handed out to a thread at once in the parallel symbolic ILU
+#define MAGMA_SYMBILU_ROWS 16
+// minimum size (in indices) of the row storage chunks
+#define MAGMA_SYMBILU_CHUNK 65536
 
 
 /******************************************************************************
@@ -238,6 +248,320 @@ cleanup:
 
 
 
+/*
+// one attempt at row i of the parallel symbolic ILU
+// Returns -1 and stores the L and U pattern of the row (U with levels) if all
+// rows it depends on are finished, otherwise returns the first unfinished row
+// it hit.
+*/
+static magma_int_t
+magma_zsymbolic_ilu_row(
+    const magma_int_t i,
+    const magma_int_t round,
+    const magma_int_t levfill,
+    const magma_int_t n,
+    const magma_index_t *ia,
+    const magma_index_t *ja,
+    magma_index_t *donelev,
+    magma_index_t **lrow,
+    magma_index_t **urow,
+    magma_index_t *llen,
+    magma_index_t *ulen,
+    magma_index_t *lnklst,
+    magma_index_t *curlev,
+    magma_index_t *iwork,
+    magma_index_t **pool,
+    magma_int_t *poolleft,
+    magma_int_t chunksize,
+    std::vector<magma_index_t*> *chunks,
+    magma_int_t *rowinfo )
+{
+    magma_int_t len = ia[i+1] - ia[i];
+    magma_int_t first = n, next, j, nl = 0, nu = 0;
+    
+    /* copy column indices of row into workspace and sort them */
+    for (j=0; j<len; j++)
+        iwork[j] = ja[ia[i]+j];
+    magma_zshell_sort(len, iwork);
+    
+    /* construct implied linked list for row */
+    if (len > 0) {
+        first = iwork[0];
+        for (j=0; j<=len-2; j++) {
+            lnklst[iwork[j]] = iwork[j+1];
+            curlev[iwork[j]] = 0;
+        }
+        lnklst[iwork[len-1]] = n;
+        curlev[iwork[len-1]] = 0;
+    }
+    
+    /* merge with rows in U */
+    next = first;
+    while (levfill > 0 && next < i) {
+        magma_int_t oldlst = next;
+        magma_int_t nxtlst = lnklst[next];
+        magma_int_t row = next;
+        magma_int_t ii, lev;
+        
+        #pragma omp atomic read
+        lev = donelev[row];
+        if (lev > round) {
+            return row;
+        }
+        #pragma omp flush
+        
+        const magma_index_t *ucol = urow[row];
+        const magma_index_t *ulev = urow[row] + ulen[row];
+        
+        /* scan row */
+        for (ii=1; ii<ulen[row]; /*nop*/) {
+            if (ucol[ii] < nxtlst) {
+                /* new fill-in */
+                magma_int_t newlev = curlev[row] + ulev[ii] + 1;
+                if (newlev <= levfill) {
+                    lnklst[oldlst]  = ucol[ii];
+                    lnklst[ucol[ii]] = nxtlst;
+                    oldlst = ucol[ii];
+                    curlev[ucol[ii]] = newlev;
+                }
+                ii++;
+            }
+            else if (ucol[ii] == nxtlst) {
+                magma_int_t newlev;
+                oldlst = nxtlst;
+                nxtlst = lnklst[oldlst];
+                newlev = curlev[row] + ulev[ii] + 1;
+                curlev[ucol[ii]] = min( curlev[ucol[ii]], newlev );
+                ii++;
+            }
+            else /* (ucol[ii] > nxtlst) */ {
+                oldlst = nxtlst;
+                nxtlst = lnklst[oldlst];
+            }
+        }
+        next = lnklst[next];
+    }
+    
+    /* count the pattern of L and U */
+    for (next = first; next < i; next = lnklst[next])
+        nl++;
+    if (next != i) {
+        printf("ILU structurally singular.\n");
+    }
+    for (/* next */; next < n; next = lnklst[next])
+        nu++;
+    
+    /* gather it into the row storage: L columns, U columns, U levels */
+    if (nl+2*nu > *poolleft) {
+        *poolleft = max( chunksize, nl+2*nu );
+        if (magma_index_malloc_cpu( pool, *poolleft ) != MAGMA_SUCCESS) {
+            *rowinfo = MAGMA_ERR_HOST_ALLOC;
+            *poolleft = 0;
+            nl = 0;
+            nu = 0;
+        } else {
+            #pragma omp critical (magma_symbilu_chunks)
+            chunks->push_back( *pool );
+        }
+    }
+    lrow[i] = *pool;
+    urow[i] = *pool + nl;
+    llen[i] = nl;
+    ulen[i] = nu;
+    *pool += nl+2*nu;
+    *poolleft -= nl+2*nu;
+    nl = 0;
+    for (next = first; next < i && llen[i] > 0; next = lnklst[next])
+        lrow[i][nl++] = next;
+    nu = 0;
+    for (/* next */; next < n && ulen[i] > 0; next = lnklst[next]) {
+        urow[i][nu] = next;
+        urow[i][nu+ulen[i]] = curlev[next];
+        nu++;
+    }
+    return -1;
+}
+
+
+/*
+// parallel symbolic level ILU
+// Same level-of-fill rule as magma_zsymbolic_ilu, but independent rows are
+// processed concurrently. Row i depends on the rows of U that belong to the
+// columns of its L part, which are only known once row i is done, so the
+// level sets of this dependency graph are peeled off in rounds: all candidate
+// rows are attempted in increasing order, a row whose dependencies are all
+// finished completes, the others are queued on the row that blocked them and
+// become candidates again in the round after it completed. Nothing waits, and
+// for levfill = 0 or a single thread all rows complete in the first round.
+// The patterns are kept per row in chunks sized by a fill estimate and only
+// grown on demand; jal and jau are allocated with the exact size at the end.
+*/
+static magma_int_t
+magma_zsymbolic_ilu_par(
+    const magma_int_t levfill,
+    const magma_int_t n,
+    magma_int_t *nzl,
+    magma_int_t *nzu,
+    const magma_index_t *ia,
+    const magma_index_t *ja,
+    magma_index_t *ial,
+    magma_index_t **jal,
+    magma_index_t *iau,
+    magma_index_t **jau,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    
+    magma_index_t **lrow=NULL, **urow=NULL;
+    magma_index_t *llen=NULL, *ulen=NULL, *donelev=NULL;
+    magma_index_t *cand=NULL, *cnext=NULL, *head=NULL, *wnext=NULL, *finished=NULL;
+    std::vector<magma_index_t*> chunks;
+    magma_int_t ncand = n, nnext = 0, ncompl = 0;
+    magma_int_t num_threads = 1, chunksize;
+    
+    CHECK( magma_malloc_cpu( (void**)&lrow, n*sizeof(magma_index_t*) ));
+    CHECK( magma_malloc_cpu( (void**)&urow, n*sizeof(magma_index_t*) ));
+    CHECK( magma_index_malloc_cpu( &llen, n ));
+    CHECK( magma_index_malloc_cpu( &ulen, n ));
+    CHECK( magma_index_malloc_cpu( &donelev, n ));
+    CHECK( magma_index_malloc_cpu( &cand, n ));
+    CHECK( magma_index_malloc_cpu( &cnext, n ));
+    CHECK( magma_index_malloc_cpu( &head, n ));
+    CHECK( magma_index_malloc_cpu( &wnext, n ));
+    CHECK( magma_index_malloc_cpu( &finished, n ));
+    
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    // fill estimate: pattern of A plus one layer of fill per level,
+    // U part stored with its levels
+    chunksize = max( (magma_int_t) MAGMA_SYMBILU_CHUNK,
+                     2*ia[n]*(levfill+1)/num_threads );
+    
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<n; i++ ){
+        donelev[i] = n;
+        head[i] = -1;
+        cand[i] = i;
+        llen[i] = 0;
+        ulen[i] = 0;
+    }
+    
+    #pragma omp parallel
+    {
+        magma_index_t *lnklst=NULL, *curlev=NULL, *iwork=NULL;
+        magma_index_t *pool=NULL;
+        magma_int_t poolleft = 0, rowinfo = 0;
+        
+        if( magma_index_malloc_cpu( &lnklst, n ) != MAGMA_SUCCESS ||
+            magma_index_malloc_cpu( &curlev, n ) != MAGMA_SUCCESS ||
+            magma_index_malloc_cpu( &iwork, n ) != MAGMA_SUCCESS ){
+            rowinfo = MAGMA_ERR_HOST_ALLOC;
+        }
+        
+        for( magma_int_t round=0; ncand > 0; round++ ){
+            // attempt all candidates, the completed ones form level set round
+            #pragma omp for schedule(dynamic,MAGMA_SYMBILU_ROWS)
+            for( magma_int_t c=0; c<ncand; c++ ){
+                magma_int_t i = cand[c], blocker = -1, pos;
+                if( rowinfo == 0 ){
+                    blocker = magma_zsymbolic_ilu_row( i, round, levfill, n, 
+                        ia, ja, donelev, lrow, urow, llen, ulen, 
+                        lnklst, curlev, iwork, &pool, &poolleft, chunksize, 
+                        &chunks, &rowinfo );
+                } else {
+                    lrow[i] = NULL;
+                    urow[i] = NULL;
+                }
+                if( blocker < 0 ){
+                    #pragma omp atomic capture
+                    pos = ncompl++;
+                    finished[pos] = i;
+                    #pragma omp flush
+                    #pragma omp atomic write
+                    donelev[i] = round;
+                } else {
+                    #pragma omp atomic capture
+                    { pos = head[blocker]; head[blocker] = i; }
+                    wnext[i] = pos;
+                }
+            }
+            // rows waiting on a completed row are the next candidates
+            #pragma omp for schedule(dynamic,MAGMA_SYMBILU_ROWS)
+            for( magma_int_t c=0; c<ncompl; c++ ){
+                for( magma_int_t w=head[finished[c]]; w != -1; w=wnext[w] ){
+                    magma_int_t pos;
+                    #pragma omp atomic capture
+                    pos = nnext++;
+                    cnext[pos] = w;
+                }
+            }
+            #pragma omp single
+            {
+                std::sort( cnext, cnext+nnext );
+                magma_index_t *tmp = cand;
+                cand = cnext;
+                cnext = tmp;
+                ncand = nnext;
+                nnext = 0;
+                ncompl = 0;
+            }
+        }
+        if( rowinfo != 0 ){
+            #pragma omp critical (magma_symbilu_chunks)
+            info = rowinfo;
+        }
+        magma_free_cpu( lnklst );
+        magma_free_cpu( curlev );
+        magma_free_cpu( iwork );
+    }
+    if( info != 0 ){
+        goto cleanup;
+    }
+    
+    /* compress the rows into the L and U structure */
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<n; i++ ){
+        ial[i+1] = llen[i];
+        iau[i+1] = ulen[i];
+    }
+    ial[0] = 0;
+    iau[0] = 0;
+    CHECK( magma_zmatrix_createrowptr( n, ial, queue ));
+    CHECK( magma_zmatrix_createrowptr( n, iau, queue ));
+    *nzl = ial[n];
+    *nzu = iau[n];
+    CHECK( magma_index_malloc_cpu( jal, *nzl ));
+    CHECK( magma_index_malloc_cpu( jau, *nzu ));
+    
+    #pragma omp parallel for schedule(dynamic,1024)
+    for( magma_int_t i=0; i<n; i++ ){
+        for( magma_int_t j=0; j<llen[i]; j++ )
+            (*jal)[ial[i]+j] = lrow[i][j];
+        for( magma_int_t j=0; j<ulen[i]; j++ )
+            (*jau)[iau[i]+j] = urow[i][j];
+    }
+    
+cleanup:
+    for( size_t c=0; c<chunks.size(); c++ ){
+        magma_free_cpu( chunks[c] );
+    }
+    magma_free_cpu( lrow );
+    magma_free_cpu( urow );
+    magma_free_cpu( llen );
+    magma_free_cpu( ulen );
+    magma_free_cpu( donelev );
+    magma_free_cpu( cand );
+    magma_free_cpu( cnext );
+    magma_free_cpu( head );
+    magma_free_cpu( wnext );
+    magma_free_cpu( finished );
+    
+    return info;
+}
+
+
+
 /******************************************************************************
  *
  * MEX function
@@ -334,29 +658,29 @@ magma_zsymbilu(
         CHECK( magma_zmconvert( B, L, Magma_CSR, Magma_CSR , queue));
         CHECK( magma_zmconvert( B, U, Magma_CSR, Magma_CSR, queue ));
 
-        magma_int_t num_lnnz = (levels > 0 ) ? B.nnz/2*(2*levels+50) : B.nnz;
-        magma_int_t num_unnz = (levels > 0 ) ? B.nnz/2*(2*levels+50) : B.nnz;
+        magma_int_t num_lnnz = 0;
+        magma_int_t num_unnz = 0;
 
         magma_free_cpu( L->col );
         magma_free_cpu( U->col );
-        CHECK( magma_index_malloc_cpu( &L->col, num_lnnz ));
-        CHECK( magma_index_malloc_cpu( &U->col, num_unnz ));
+        L->col = NULL;
+        U->col = NULL;
 
-        magma_zsymbolic_ilu( levels, A->num_rows, &num_lnnz, &num_unnz, B.row, B.col,
-                                            L->row, L->col, U->row, U->col );
+        CHECK( magma_zsymbolic_ilu_par( levels, A->num_rows, &num_lnnz, &num_unnz, 
+                    B.row, B.col, L->row, &L->col, U->row, &U->col, queue ));
         L->nnz = num_lnnz;
         U->nnz = num_unnz;
         magma_free_cpu( L->val );
         magma_free_cpu( U->val );
         CHECK( magma_zmalloc_cpu( &L->val, L->nnz ));
         CHECK( magma_zmalloc_cpu( &U->val, U->nnz ));
-        for( magma_int_t i=0; i<L->nnz; i++ )
-            L->val[i] = MAGMA_Z_MAKE( 0.0, 0.0 );
-
-        for( magma_int_t i=0; i<U->nnz; i++ )
-            U->val[i] = MAGMA_Z_MAKE( 0.0, 0.0 );
-        // take the original values (scaled) as initial guess for L
+        // take the original values (scaled) as initial guess for L and U
+        #pragma omp parallel for
         for(magma_int_t i=0; i<L->num_rows; i++){
+            for(magma_int_t k=L->row[i]; k<L->row[i+1]; k++)
+                L->val[k] = MAGMA_Z_MAKE( 0.0, 0.0 );
+            for(magma_int_t k=U->row[i]; k<U->row[i+1]; k++)
+                U->val[k] = MAGMA_Z_MAKE( 0.0, 0.0 );
             for(magma_int_t j=B.row[i]; j<B.row[i+1]; j++){
                 magma_index_t lcol = B.col[j];
                 for(magma_int_t k=L->row[i]; k<L->row[i+1]; k++){
@@ -364,13 +688,6 @@ magma_zsymbilu(
                         L->val[k] =  B.val[j];
                     }
                 }
-            }
-        }
-
-        // take the original values (scaled) as initial guess for U
-        for(magma_int_t i=0; i<U->num_rows; i++){
-            for(magma_int_t j=B.row[i]; j<B.row[i+1]; j++){
-                magma_index_t lcol = B.col[j];
                 for(magma_int_t k=U->row[i]; k<U->row[i+1]; k++){
                     if( U->col[k] == lcol ){
                         U->val[k] =  B.val[j];
@@ -386,9 +703,14 @@ magma_zsymbilu(
         CHECK( magma_zmalloc_cpu( &A->val, L->nnz+U->nnz ));
         A->nnz = L->nnz+U->nnz;
         
-        magma_int_t z = 0;
+        #pragma omp parallel for
+        for(magma_int_t i=0; i<A->num_rows+1; i++){
+            A->row[i] = L->row[i] + U->row[i];
+        }
+        // copy the pattern and reset the values of A to the original entries
+        #pragma omp parallel for
         for(magma_int_t i=0; i<A->num_rows; i++){
-            A->row[i] = z;
+            magma_int_t z = A->row[i];
             for(magma_int_t j=L->row[i]; j<L->row[i+1]; j++){
                 A->col[z] = L->col[j];
                 A->val[z] = L->val[j];
@@ -399,10 +721,6 @@ magma_zsymbilu(
                 A->val[z] = U->val[j];
                 z++;
             }
-        }
-        A->row[A->num_rows] = z;
-        // reset the values of A to the original entries
-        for(magma_int_t i=0; i<A->num_rows; i++){
             for(magma_int_t j=A_copy.row[i]; j<A_copy.row[i+1]; j++){
                 magma_index_t lcol = A_copy.col[j];
                 for(magma_int_t k=A->row[i]; k<A->row[i+1]; k++){
@@ -14,11 +14,17 @@
 //  the IO functions provided by MatrixMarket
 
 #include <algorithm>
+#include <climits>
 #include <vector>
 #include <utility>  // pair
 
 #include "magmasparse_internal.h"
 #include "magmasparse_mmio.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PRECISION_z
 
 
 /**
@@ -348,6 +354,324 @@ cleanup:
 }
 
 
+/* Fills the binary header of a CPU CSR matrix; only the dimensions and
+   properties of B are used, not its arrays. */
+static void
+magma_zcsr_binary_header(
+    magma_z_matrix B,
+    magma_sparse_binary_header *h )
+{
+    int64_t row_bytes, col_bytes, val_bytes;
+
+    memset( h, 0, sizeof(*h) );
+    memcpy( h->magic, MAGMA_SPARSE_BINARY_MAGIC, sizeof(h->magic) );
+    h->version        = MAGMA_SPARSE_BINARY_VERSION;
+    h->endian         = MAGMA_SPARSE_BINARY_ENDIAN;
+    h->value_size     = sizeof(magmaDoubleComplex);
+    #if defined(PRECISION_z) || defined(PRECISION_c)
+    h->num_components = 2;
+    #else
+    h->num_components = 1;
+    #endif
+    h->index_size     = sizeof(magma_index_t);
+    h->storage_type   = B.storage_type;
+    h->sym            = B.sym;
+    h->fill_mode      = B.fill_mode;
+    h->diagorder_type = B.diagorder_type;
+    h->num_rows       = B.num_rows;
+    h->num_cols       = B.num_cols;
+    h->nnz            = B.nnz;
+    h->true_nnz       = B.true_nnz;
+    h->max_nnz_row    = B.max_nnz_row;
+    h->diameter       = B.diameter;
+
+    row_bytes = (B.num_rows+1) * (int64_t) sizeof(magma_index_t);
+    col_bytes = B.nnz * (int64_t) sizeof(magma_index_t);
+    val_bytes = B.nnz * (int64_t) sizeof(magmaDoubleComplex);
+    #define MAGMA_BINARY_ALIGN_UP( x ) \
+        ( ((x) + MAGMA_SPARSE_BINARY_ALIGN - 1) / MAGMA_SPARSE_BINARY_ALIGN * MAGMA_SPARSE_BINARY_ALIGN )
+    h->row_offset = MAGMA_BINARY_ALIGN_UP( (int64_t) sizeof(*h) );
+    h->col_offset = MAGMA_BINARY_ALIGN_UP( h->row_offset + row_bytes );
+    h->val_offset = MAGMA_BINARY_ALIGN_UP( h->col_offset + col_bytes );
+    h->file_size  = h->val_offset + val_bytes;
+    #undef MAGMA_BINARY_ALIGN_UP
+}
+
+
+/**
+    Purpose
+    -------
+
+    Writes the header and the 64 byte aligned row, col, and val arrays of
+    a CPU CSR matrix to an open file, see magma_sparse_binary_header.
+    Used by magma_zwrite_csr_binary and magma_z_csr_mtx_stream_open.
+
+    Arguments
+    ---------
+
+    @param[in]
+    B           magma_z_matrix
+                CSR matrix on the CPU
+
+    @param[in]
+    fp          FILE*
+                file opened for binary writing
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+static magma_int_t
+magma_zcsr_binary_fwrite(
+    magma_z_matrix B,
+    FILE *fp )
+{
+    magma_sparse_binary_header h;
+    char pad[ MAGMA_SPARSE_BINARY_ALIGN ] = { 0 };
+    int64_t row_bytes, col_bytes, val_bytes;
+
+    magma_zcsr_binary_header( B, &h );
+    row_bytes = (B.num_rows+1) * (int64_t) sizeof(magma_index_t);
+    col_bytes = B.nnz * (int64_t) sizeof(magma_index_t);
+    val_bytes = B.nnz * (int64_t) sizeof(magmaDoubleComplex);
+
+    if ( fwrite( &h, sizeof(h), 1, fp ) != 1
+      || fwrite( pad, 1, h.row_offset - sizeof(h), fp ) != size_t(h.row_offset - sizeof(h))
+      || fwrite( B.row, 1, row_bytes, fp ) != size_t(row_bytes)
+      || fwrite( pad, 1, h.col_offset - h.row_offset - row_bytes, fp )
+            != size_t(h.col_offset - h.row_offset - row_bytes)
+      || fwrite( B.col, 1, col_bytes, fp ) != size_t(col_bytes)
+      || fwrite( pad, 1, h.val_offset - h.col_offset - col_bytes, fp )
+            != size_t(h.val_offset - h.col_offset - col_bytes)
+      || fwrite( B.val, 1, val_bytes, fp ) != size_t(val_bytes) )
+    {
+        return MAGMA_ERR;
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Writes a matrix to a file in the native MAGMA-sparse binary CSR
+    format, see magma_sparse_binary_header. The row, col, and val arrays
+    are stored with 64 byte alignment so that magma_z_csr_binary can use
+    them in place.
+    Matrices that are not in CSR format or not located on the CPU are
+    converted to CSR on the CPU before writing.
+    The file is specific to the precision, index size, and byte order
+    of the MAGMA build that wrote it.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                matrix to write out
+
+    @param[in]
+    filename    const char*
+                output-filename of the binary matrix
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zwrite_csr_binary(
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    FILE *fp = NULL;
+    magma_z_matrix A_CPU={Magma_CSR}, A_CSR={Magma_CSR};
+    magma_z_matrix B={Magma_CSR};
+
+    if ( A.memory_location == Magma_CPU &&
+        ( A.storage_type == Magma_CSR  || A.storage_type == Magma_CSRL ||
+          A.storage_type == Magma_CSRU || A.storage_type == Magma_CSRD ) ) {
+        B = A;
+        B.mapping = NULL;
+    } else {
+        CHECK( magma_zmtransfer( A, &A_CPU, A.memory_location, Magma_CPU, queue ));
+        CHECK( magma_zmconvert( A_CPU, &A_CSR, A_CPU.storage_type, Magma_CSR, queue ));
+        B = A_CSR;
+    }
+
+    printf("%% Writing sparse matrix to file (%s):", filename);
+    fflush(stdout);
+
+    fp = fopen( filename, "wb" );
+    if ( fp == NULL ) {
+        printf("\n%% error writing matrix: file exists or missing write permission\n");
+        info = -1;
+        goto cleanup;
+    }
+    if ( magma_zcsr_binary_fwrite( B, fp ) != MAGMA_SUCCESS ) {
+        printf("\n%% error: writing matrix failed\n");
+        info = MAGMA_ERR;
+        goto cleanup;
+    }
+    if ( fclose( fp ) != 0 ) {
+        fp = NULL;
+        printf("\n%% error: writing matrix failed\n");
+        info = MAGMA_ERR;
+        goto cleanup;
+    }
+    fp = NULL;
+    printf(" done\n");
+
+cleanup:
+    if ( fp != NULL ) {
+        fclose( fp );
+    }
+    magma_zmfree( &A_CPU, queue );
+    magma_zmfree( &A_CSR, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Loads a matrix written by magma_zwrite_csr_binary.
+
+    The file is memory-mapped (private, copy-on-write) and A->row, A->col,
+    and A->val point directly into the mapping, so no data is read or
+    copied up front. A->ownership is MagmaFalse and the mapping is kept in
+    A->mapping; magma_zmfree releases the mapping instead of freeing the
+    arrays. Modifying the arrays is allowed and never changes the file.
+    Only A itself may be freed: a shallow copy of A shares the mapping, and
+    has to set mapping to NULL before it is passed to magma_zmfree.
+
+    Arguments
+    ---------
+
+    @param[out]
+    A           magma_z_matrix*
+                matrix in magma sparse matrix format
+
+    @param[in]
+    filename    const char*
+                filename of the binary matrix
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_z_csr_binary(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    mm_mapped_file *mf = NULL;
+    magma_sparse_binary_header h;
+    int64_t row_bytes, col_bytes, val_bytes;
+    magma_index_t *row;
+
+    // make sure the target structure is empty
+    magma_zmfree( A, queue );
+
+    CHECK( magma_malloc_cpu( (void**) &mf, sizeof(mm_mapped_file) ));
+    if ( mm_map_file( filename, 1, mf ) != 0 ) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    if ( mf->size < sizeof(h) ) {
+        printf("%% Invalid MAGMA binary matrix file %s\n", filename);
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    memcpy( &h, mf->data, sizeof(h) );
+
+    if ( memcmp( h.magic, MAGMA_SPARSE_BINARY_MAGIC, sizeof(h.magic) ) != 0 ) {
+        printf("%% Invalid MAGMA binary matrix file %s\n", filename);
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    if ( h.version    != MAGMA_SPARSE_BINARY_VERSION
+      || h.endian     != MAGMA_SPARSE_BINARY_ENDIAN
+      || h.value_size != (int32_t) sizeof(magmaDoubleComplex)
+      || h.index_size != (int32_t) sizeof(magma_index_t)
+    #if defined(PRECISION_z) || defined(PRECISION_c)
+      || h.num_components != 2
+    #else
+      || h.num_components != 1
+    #endif
+       )
+    {
+        printf("%% Sorry, %s was written by an incompatible MAGMA build "
+               "(version %d, %d byte values, %d byte indices).\n",
+               filename, int(h.version), int(h.value_size), int(h.index_size) );
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    row_bytes = (h.num_rows+1) * (int64_t) sizeof(magma_index_t);
+    col_bytes = h.nnz * (int64_t) sizeof(magma_index_t);
+    val_bytes = h.nnz * (int64_t) sizeof(magmaDoubleComplex);
+    if ( h.num_rows < 0 || h.num_cols < 0 || h.nnz < 0
+      || h.file_size != (int64_t) mf->size
+      || h.row_offset % MAGMA_SPARSE_BINARY_ALIGN != 0
+      || h.col_offset % MAGMA_SPARSE_BINARY_ALIGN != 0
+      || h.val_offset % MAGMA_SPARSE_BINARY_ALIGN != 0
+      || h.row_offset < (int64_t) sizeof(h)
+      || h.row_offset + row_bytes > h.file_size
+      || h.col_offset + col_bytes > h.file_size
+      || h.val_offset + val_bytes > h.file_size )
+    {
+        printf("%% Corrupt or truncated MAGMA binary matrix file %s\n", filename);
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    row = (magma_index_t*) (mf->data + h.row_offset);
+    if ( row[0] != 0 || row[h.num_rows] > h.nnz ) {
+        printf("%% Corrupt or truncated MAGMA binary matrix file %s\n", filename);
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+
+    A->storage_type    = (magma_storage_t) h.storage_type;
+    A->memory_location = Magma_CPU;
+    A->sym             = (magma_symmetry_t) h.sym;
+    A->fill_mode       = (magma_uplo_t) h.fill_mode;
+    A->diagorder_type  = (magma_diagorder_t) h.diagorder_type;
+    A->num_rows        = h.num_rows;
+    A->num_cols        = h.num_cols;
+    A->nnz             = h.nnz;
+    A->true_nnz        = h.true_nnz;
+    A->max_nnz_row     = h.max_nnz_row;
+    A->diameter        = h.diameter;
+    A->row             = row;
+    A->col             = (magma_index_t*) (mf->data + h.col_offset);
+    A->val             = (magmaDoubleComplex*) (mf->data + h.val_offset);
+    A->ownership       = MagmaFalse;
+    A->mapping         = mf;
+    mf = NULL;
+
+cleanup:
+    if ( mf != NULL ) {
+        mm_unmap_file( mf );
+        magma_free_cpu( mf );
+    }
+    return info;
+}
+
+
 /**
     Purpose
     -------
@@ -494,7 +818,7 @@ magma_zwrite_csr_mtx(
         // TODO what's the difference between i (or i+1) and rowindex?
         magma_index_t i=0, j=0, rowindex=1;
                 
-        for(i=0; i < B.num_rows; i++) {
+        for(i=0; i < A.num_rows; i++) {
             magma_index_t rowtemp1 = A.row[i];
             magma_index_t rowtemp2 = A.row[i+1];
             for(j=0; j < rowtemp2 - rowtemp1; j++) {
@@ -516,6 +840,224 @@ cleanup:
 }
 
 
+// nonzeros generated and written at a time by magma_zwrite_csr_generator
+#define MAGMA_GENERATOR_BLOCK_NNZ  (1 << 20)
+// upper bound on the length of one Matrix Market line written for an entry
+#define MAGMA_GENERATOR_MTX_LINE   96
+
+
+/* fwrite that fails unless all bytes are written. */
+static magma_int_t
+magma_zfwrite_all(
+    const void *ptr,
+    size_t bytes,
+    FILE *fp )
+{
+    return ( fwrite( ptr, 1, bytes, fp ) == bytes ) ? MAGMA_SUCCESS : MAGMA_ERR;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Generates the matrix described by gen (see magma_zmgenerate) and
+    writes it to a file without holding the whole matrix in memory.
+    Stencil matrices are generated in parallel in row blocks of about
+    2^20 nonzeros, which are written as soon as they are complete; as the
+    row offsets are known in closed form, the binary container is written
+    sequentially, generating every block once for the col and once for
+    the val section. Random graph Laplacians are generated in memory
+    first and then written with magma_zwrite_csr_binary or
+    magma_zwrite_csr_mtx.
+
+    A filename ending in ".mtx" is written in Matrix Market format
+    (coordinate, general), any other name in the binary CSR container
+    read by magma_z_csr_binary.
+
+    Arguments
+    ---------
+
+    @param[in]
+    gen         magma_matrix_generator
+                description of the matrix
+
+    @param[in]
+    filename    const char*
+                output-filename
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zwrite_csr_generator(
+    magma_matrix_generator gen,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    FILE *fp = NULL;
+    magma_z_matrix A={Magma_CSR};
+    magma_sparse_binary_header h;
+    char pad[ MAGMA_SPARSE_BINARY_ALIGN ] = { 0 };
+    magma_index_t *row = NULL, *col = NULL;
+    magmaDoubleComplex *val = NULL;
+    char *text = NULL;
+    size_t *text_len = NULL;
+    magma_int_t num_rows = 0, max_nnz_row = 1, block_rows, num_threads = 1;
+    int64_t nnz = 0, base;
+    size_t len = strlen( filename );
+    bool mtx = ( len >= 4 && strcmp( filename + len - 4, ".mtx" ) == 0 );
+
+    if ( gen.stencil == 0 ) {
+        // no closed form for the row pointer, the matrix is needed as a whole
+        CHECK( magma_zmgenerate( gen, &A, queue ));
+        if ( mtx ) {
+            CHECK( magma_zwrite_csr_mtx( A, MagmaRowMajor, filename, queue ));
+        } else {
+            CHECK( magma_zwrite_csr_binary( A, filename, queue ));
+        }
+        goto cleanup;
+    }
+
+    CHECK( magma_zmgenerate_size( gen, &num_rows, &nnz, &max_nnz_row, queue ));
+    block_rows = max( 1, MAGMA_GENERATOR_BLOCK_NNZ / max_nnz_row );
+    block_rows = min( block_rows, num_rows );
+    CHECK( magma_index_malloc_cpu( &row, block_rows+1 ));
+    CHECK( magma_index_malloc_cpu( &col, block_rows*max_nnz_row ));
+    CHECK( magma_zmalloc_cpu( &val, block_rows*max_nnz_row ));
+
+    printf("%% Writing sparse matrix to file (%s):", filename);
+    fflush(stdout);
+
+    fp = fopen( filename, mtx ? "w" : "wb" );
+    if ( fp == NULL ) {
+        printf("\n%% error writing matrix: file exists or missing write permission\n");
+        info = -1;
+        goto cleanup;
+    }
+
+    if ( mtx ) {
+        #ifdef _OPENMP
+        num_threads = omp_get_max_threads();
+        #endif
+        CHECK( magma_malloc_cpu( (void**) &text,
+               block_rows * max_nnz_row * (size_t) MAGMA_GENERATOR_MTX_LINE ));
+        CHECK( magma_malloc_cpu( (void**) &text_len, num_threads * sizeof(size_t) ));
+        #if defined(PRECISION_z) || defined(PRECISION_c)
+        fprintf( fp, "%%%%MatrixMarket matrix coordinate complex general\n" );
+        #else
+        fprintf( fp, "%%%%MatrixMarket matrix coordinate real general\n" );
+        #endif
+        fprintf( fp, "%lld %lld %lld\n",
+                 (long long) num_rows, (long long) num_rows, (long long) nnz );
+        for( magma_int_t first=0; first < num_rows; first += block_rows ) {
+            magma_int_t nrows = min( block_rows, num_rows - first );
+            magma_int_t chunk = magma_ceildiv( nrows, num_threads );
+            CHECK( magma_zmgenerate_rows( gen, first, first+nrows, row, col, val, queue ));
+            // every thread prints its rows into the part of the buffer
+            // that corresponds to their nonzeros
+            #pragma omp parallel for num_threads(num_threads) schedule(static,1)
+            for( magma_int_t t=0; t < num_threads; t++ ) {
+                magma_int_t r0 = min( t*chunk, nrows ), r1 = min( r0+chunk, nrows );
+                char *out = text + row[r0] * (size_t) MAGMA_GENERATOR_MTX_LINE;
+                size_t n = 0;
+                for( magma_int_t r=r0; r < r1; r++ ) {
+                    for( magma_index_t j=row[r]; j < row[r+1]; j++ ) {
+                        #if defined(PRECISION_z) || defined(PRECISION_c)
+                        n += snprintf( out + n, MAGMA_GENERATOR_MTX_LINE, "%lld %lld %.16g %.16g\n",
+                                       (long long) (first+r+1), (long long) (col[j]+1),
+                                       MAGMA_Z_REAL( val[j] ), MAGMA_Z_IMAG( val[j] ));
+                        #else
+                        n += snprintf( out + n, MAGMA_GENERATOR_MTX_LINE, "%lld %lld %.16g\n",
+                                       (long long) (first+r+1), (long long) (col[j]+1),
+                                       MAGMA_Z_REAL( val[j] ));
+                        #endif
+                    }
+                }
+                text_len[t] = n;
+            }
+            for( magma_int_t t=0; t < num_threads; t++ ) {
+                CHECK( magma_zfwrite_all(
+                       text + row[ min( t*chunk, nrows ) ] * (size_t) MAGMA_GENERATOR_MTX_LINE,
+                       text_len[t], fp ));
+            }
+        }
+    }
+    else {
+        A.num_rows       = num_rows;
+        A.num_cols       = num_rows;
+        A.nnz            = (magma_int_t) nnz;
+        A.true_nnz       = A.nnz;
+        A.max_nnz_row    = max_nnz_row;
+        A.sym            = Magma_SYMMETRIC;
+        A.fill_mode      = MagmaFull;
+        A.diagorder_type = Magma_VALUE;
+        magma_zcsr_binary_header( A, &h );
+        CHECK( magma_zfwrite_all( &h, sizeof(h), fp ));
+        CHECK( magma_zfwrite_all( pad, h.row_offset - sizeof(h), fp ));
+
+        // row pointer: shift the block-relative offsets by the preceding blocks
+        base = 0;
+        for( magma_int_t first=0; first < num_rows; first += block_rows ) {
+            magma_int_t nrows = min( block_rows, num_rows - first );
+            CHECK( magma_zmgenerate_rows( gen, first, first+nrows, row, NULL, NULL, queue ));
+            #pragma omp parallel for schedule(static)
+            for( magma_int_t r=0; r < nrows; r++ ) {
+                row[r] += (magma_index_t) base;
+            }
+            CHECK( magma_zfwrite_all( row, nrows * sizeof(magma_index_t), fp ));
+            base += row[ nrows ];
+        }
+        row[0] = (magma_index_t) base;
+        CHECK( magma_zfwrite_all( row, sizeof(magma_index_t), fp ));
+        CHECK( magma_zfwrite_all( pad, h.col_offset - h.row_offset
+                                  - (num_rows+1) * (int64_t) sizeof(magma_index_t), fp ));
+
+        for( magma_int_t first=0; first < num_rows; first += block_rows ) {
+            magma_int_t nrows = min( block_rows, num_rows - first );
+            CHECK( magma_zmgenerate_rows( gen, first, first+nrows, row, col, val, queue ));
+            CHECK( magma_zfwrite_all( col, row[ nrows ] * sizeof(magma_index_t), fp ));
+        }
+        CHECK( magma_zfwrite_all( pad, h.val_offset - h.col_offset
+                                  - nnz * (int64_t) sizeof(magma_index_t), fp ));
+
+        for( magma_int_t first=0; first < num_rows; first += block_rows ) {
+            magma_int_t nrows = min( block_rows, num_rows - first );
+            CHECK( magma_zmgenerate_rows( gen, first, first+nrows, row, col, val, queue ));
+            CHECK( magma_zfwrite_all( val, row[ nrows ] * sizeof(magmaDoubleComplex), fp ));
+        }
+    }
+
+    info = ( fclose( fp ) == 0 ) ? MAGMA_SUCCESS : MAGMA_ERR;
+    fp = NULL;
+    if ( info == 0 ) {
+        printf(" done\n");
+    }
+
+cleanup:
+    if ( fp != NULL ) {
+        fclose( fp );
+    }
+    if ( info == MAGMA_ERR && gen.stencil != 0 ) {
+        printf("\n%% error: writing matrix failed\n");
+    }
+    magma_free_cpu( row );
+    magma_free_cpu( col );
+    magma_free_cpu( val );
+    magma_free_cpu( text );
+    magma_free_cpu( text_len );
+    magma_zmfree( &A, queue );
+    return info;
+}
+
+
 /**
     Purpose
     -------
@@ -917,20 +1459,51 @@ cleanup:
     Purpose
     -------
 
-    Reads in a matrix stored in coo format from a Matrix Market (.mtx)
-    file and converts it into CSR format. It duplicates the off-diagonal
-    entries in the symmetric case.
+    Reads the coordinate section of a Matrix Market (.mtx) file into COO
+    arrays. The file is memory-mapped, the coordinate section is split at
+    line boundaries, and the chunks are parsed concurrently. Numbers are
+    parsed with mm_parse_index/mm_parse_value, which return the same
+    values as fscanf.
 
     Arguments
     ---------
 
-    @param[out]
-    A           magma_z_matrix*
-                matrix in magma sparse matrix format
-
     @param[in]
     filename    const char*
                 filname of the mtx matrix
+
+    @param[out]
+    matcode     MM_typecode*
+                Matrix Market type of the file
+
+    @param[out]
+    num_rows    magma_index_t*
+                number of rows
+
+    @param[out]
+    num_cols    magma_index_t*
+                number of columns
+
+    @param[out]
+    nnz         magma_index_t*
+                number of entries stored in the file
+
+    @param[out]
+    coo_row     magma_index_t**
+                row indices (0-based), allocated on the CPU
+
+    @param[out]
+    coo_col     magma_index_t**
+                column indices (0-based), allocated on the CPU
+
+    @param[out]
+    coo_val     magmaDoubleComplex**
+                values, allocated on the CPU
+
+    @param[out]
+    zeros       magma_int_t*
+                1 if the file contains explicit zeros (real/integer only)
+
     @param[in]
     queue       magma_queue_t
                 Queue to execute in.
@@ -938,273 +1511,403 @@ cleanup:
     @ingroup magmasparse_zaux
     ********************************************************************/
 
-extern "C"
-magma_int_t
-magma_z_csr_mtx(
-    magma_z_matrix *A,
+static magma_int_t
+magma_zmtx_read_coo(
     const char *filename,
+    MM_typecode *matcode,
+    magma_index_t *num_rows,
+    magma_index_t *num_cols,
+    magma_index_t *nnz,
+    magma_index_t **coo_row,
+    magma_index_t **coo_col,
+    magmaDoubleComplex **coo_val,
+    magma_int_t *zeros,
     magma_queue_t queue )
 {
     char buffer[ 1024 ];
     magma_int_t info = 0;
 
-    int csr_compressor = 0;       // checks for zeros in original file
-    
-    magma_z_matrix B={Magma_CSR};
+    FILE *fid = NULL;
+    mm_mapped_file mf = { NULL, 0, 0 };
+    size_t *bounds = NULL;
+    magma_int_t *chunk_start = NULL;
+    magma_int_t nchunks = 1, total = 0, errors = 0, has_zeros = 0;
+    size_t offset = 0;
+    int values_per_line = 0;
+
+    *coo_row = NULL;
+    *coo_col = NULL;
+    *coo_val = NULL;
+    *zeros = 0;
 
-    magma_index_t *coo_col = NULL;
-    magma_index_t *coo_row = NULL;
-    magmaDoubleComplex *coo_val = NULL;
-    magmaDoubleComplex *new_val = NULL;
-    magma_index_t* new_row = NULL;
-    magma_index_t* new_col = NULL;
-    magma_int_t hermitian = 0;
-    
-    // make sure the target structure is empty
-    magma_zmfree( A, queue );
-    A->ownership = MagmaTrue;
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
-    
-    FILE *fid = NULL;
-    MM_typecode matcode;
     fid = fopen(filename, "r");
-    
     if (fid == NULL) {
         printf("%% Unable to open file %s\n", filename);
         info = MAGMA_ERR_NOT_FOUND;
         goto cleanup;
     }
-    
+
     printf("%% Reading sparse matrix from file (%s):", filename);
     fflush(stdout);
-    
-    if (mm_read_banner(fid, &matcode) != 0) {
-        printf("\n%% Could not process Matrix Market banner: %s.\n", matcode);
+
+    if (mm_read_banner(fid, matcode) != 0) {
+        printf("\n%% Could not process Matrix Market banner: %s.\n", *matcode);
         info = MAGMA_ERR_NOT_SUPPORTED;
         goto cleanup;
     }
-    
-    if (!mm_is_valid(matcode)) {
+
+    if (!mm_is_valid(*matcode)) {
         printf("\n%% Invalid Matrix Market file.\n");
         info = MAGMA_ERR_NOT_SUPPORTED;
         goto cleanup;
     }
-    
-    if ( ! ( ( mm_is_real(matcode)    ||
-               mm_is_integer(matcode) ||
-               mm_is_pattern(matcode) ||
-               mm_is_complex(matcode) ) &&
-             mm_is_coordinate(matcode)  &&
-             mm_is_sparse(matcode) ) )
+
+    if ( ! ( ( mm_is_real(*matcode)    ||
+               mm_is_integer(*matcode) ||
+               mm_is_pattern(*matcode) ||
+               mm_is_complex(*matcode) ) &&
+             mm_is_coordinate(*matcode)  &&
+             mm_is_sparse(*matcode) ) )
     {
-        mm_snprintf_typecode( buffer, sizeof(buffer), matcode );
+        mm_snprintf_typecode( buffer, sizeof(buffer), *matcode );
         printf("\n%% Sorry, MAGMA-sparse does not support Market Market type: [%s]\n", buffer );
         printf("%% Only real-valued or pattern coordinate matrices are supported.\n");
         info = MAGMA_ERR_NOT_SUPPORTED;
         goto cleanup;
     }
 
-    magma_index_t num_rows, num_cols, num_nonzeros;
-    if (mm_read_mtx_crd_size(fid, &num_rows, &num_cols, &num_nonzeros) != 0) {
+    if (mm_read_mtx_crd_size(fid, num_rows, num_cols, nnz) != 0) {
         info = MAGMA_ERR_UNKNOWN;
         goto cleanup;
     }
-    
-    A->storage_type    = Magma_CSR;
-    A->memory_location = Magma_CPU;
-    A->num_rows        = num_rows;
-    A->num_cols        = num_cols;
-    A->nnz             = num_nonzeros;
-    A->fill_mode       = MagmaFull;
-    
-    CHECK( magma_index_malloc_cpu( &coo_col, A->nnz ) );
-    CHECK( magma_index_malloc_cpu( &coo_row, A->nnz ) );
-    CHECK( magma_zmalloc_cpu( &coo_val, A->nnz ) );
+    // the coordinate section starts right after the size line
+    offset = (size_t) ftell(fid);
+    fclose(fid);
+    fid = NULL;
 
-    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf \n", &ROW, &COL, &VAL);
-            if ( VAL == 0 )
-                csr_compressor = 1;
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, 0.);
-        }
-    } else if (mm_is_pattern(matcode) ) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            
-            fscanf(fid, " %d %d \n", &ROW, &COL );
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( 1.0, 0.);
-        }
-    } else if (mm_is_complex(matcode) ){
-        for (magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL, VALC;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf %lf\n", &ROW, &COL, &VAL, &VALC);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, VALC);
-        }
-        // printf(" ...successfully read complex matrix... ");
+    if ( mm_is_pattern(*matcode) ) {
+        values_per_line = 0;
+    } else if ( mm_is_real(*matcode) || mm_is_integer(*matcode) ) {
+        values_per_line = 1;
     } else {
-        printf("\n%% Unrecognized data type\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
+        values_per_line = 2;
+    }
+
+    if (mm_map_file(filename, 0, &mf) != 0) {
+        printf("\n%% Unable to map file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
         goto cleanup;
     }
-    fclose(fid);
-    fid = NULL;
-    printf(" done. Converting to CSR:");
-    fflush(stdout);
-    
-    A->sym = Magma_GENERAL;
+    if ( offset > mf.size ) {
+        offset = mf.size;
+    }
 
+    CHECK( magma_index_malloc_cpu( coo_row, *nnz ) );
+    CHECK( magma_index_malloc_cpu( coo_col, *nnz ) );
+    CHECK( magma_zmalloc_cpu( coo_val, *nnz ) );
 
-    if( mm_is_hermitian(matcode) ) {
-        hermitian = 1;
+#ifdef _OPENMP
+    #pragma omp parallel
+    {
+        nchunks = omp_get_max_threads();
     }
-    if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) { 
-                                        // duplicate off diagonal entries
-        printf("\n%% Detected symmetric case.");
-        A->sym = Magma_SYMMETRIC;
-        magma_index_t off_diagonals = 0;
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            if (coo_row[i] != coo_col[i])
-                ++off_diagonals;
+    // a few chunks per thread even out uneven line lengths
+    nchunks *= 4;
+#endif
+    CHECK( magma_malloc_cpu( (void**) &bounds, (nchunks+1)*sizeof(size_t) ));
+    CHECK( magma_malloc_cpu( (void**) &chunk_start, (nchunks+1)*sizeof(magma_int_t) ));
+    mm_split_lines( mf.data, offset, mf.size, nchunks, bounds );
+
+    // pass 1: count the entry lines in each chunk
+    #pragma omp parallel for schedule(dynamic,1)
+    for( magma_int_t c=0; c < nchunks; c++ ){
+        const char *p   = mf.data + bounds[c];
+        const char *end = mf.data + bounds[c+1];
+        magma_int_t count = 0;
+        while( p < end ){
+            const char *q = mm_skip_blanks( p, end );
+            if( q < end && *q != '\n' && *q != '%' )
+                count++;
+            p = mm_next_line( q, end );
         }
-        magma_index_t true_nonzeros = 2*off_diagonals + (A->nnz - off_diagonals);
-        
-        //printf("%% total number of nonzeros: %d\n%%", int(A->nnz));
+        chunk_start[c] = count;
+    }
+    for( magma_int_t c=0; c < nchunks; c++ ){
+        magma_int_t count = chunk_start[c];
+        chunk_start[c] = total;
+        total += count;
+    }
+    if ( total < *nnz ) {
+        printf("\n%% Premature end of file: found %d of %d entries.\n",
+               int(total), int(*nnz));
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
 
-        CHECK( magma_index_malloc_cpu( &new_row, true_nonzeros ));
-        CHECK( magma_index_malloc_cpu( &new_col, true_nonzeros ));
-        CHECK( magma_zmalloc_cpu( &new_val, true_nonzeros ));
-        
-        magma_index_t ptr = 0;
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            if (coo_row[i] != coo_col[i]) {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-                new_col[ptr] = coo_row[i];
-                new_row[ptr] = coo_col[i];
-                new_val[ptr] = (hermitian == 0) ? coo_val[i] : conj(coo_val[i]);
-                ptr++;
-            } else {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
+    // pass 2: parse the chunks into their slots of the COO arrays
+    #pragma omp parallel for schedule(dynamic,1) reduction(+:errors,has_zeros)
+    for( magma_int_t c=0; c < nchunks; c++ ){
+        const char *p   = mf.data + bounds[c];
+        const char *end = mf.data + bounds[c+1];
+        magma_int_t i = chunk_start[c];
+        while( p < end && i < *nnz ){
+            const char *q = mm_skip_blanks( p, end );
+            p = mm_next_line( q, end );
+            if( q == end || *q == '\n' || *q == '%' )
+                continue;
+            magma_index_t ROW = 0, COL = 0;
+            real_Double_t VAL = 1.0, VALC = 0.0;  // always read in a double and convert later if necessary
+            q = mm_parse_index( q, p, &ROW );
+            if( q != NULL ) q = mm_parse_index( q, p, &COL );
+            if( q != NULL && values_per_line > 0 ) q = mm_parse_value( q, p, &VAL );
+            if( q != NULL && values_per_line > 1 ) q = mm_parse_value( q, p, &VALC );
+            if( q == NULL || ROW < 1 || ROW > *num_rows || COL < 1 || COL > *num_cols ){
+                errors++;
+                ROW = COL = 1;
             }
+            if( values_per_line == 1 && VAL == 0 )
+                has_zeros = 1;
+            (*coo_row)[i] = ROW - 1;
+            (*coo_col)[i] = COL - 1;
+            (*coo_val)[i] = MAGMA_Z_MAKE( VAL, VALC );
+            i++;
         }
-        
-        magma_free_cpu(coo_row);
-        magma_free_cpu(coo_col);
-        magma_free_cpu(coo_val);
+    }
+    if ( errors > 0 ) {
+        printf("\n%% Could not parse %d entries of %s.\n", int(errors), filename);
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    *zeros = ( has_zeros > 0 ) ? 1 : 0;
 
-        coo_row = new_row;
-        coo_col = new_col;
-        coo_val = new_val;
-        A->nnz = true_nonzeros;
-        //printf("total number of nonzeros: %d\n", A->nnz);
-    } // end symmetric case
-    
-    CHECK( magma_zmalloc_cpu( &A->val, A->nnz ));
-    CHECK( magma_index_malloc_cpu( &A->col, A->nnz ));
-    CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ));
-    
-    // original code from Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (A->row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < A->nnz; i++)
-        (A->row)[coo_row[i]]++;
-        
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (A->row)[i];
-        (A->row)[i] = cumsum;
-        cumsum += temp;
+cleanup:
+    if ( fid != NULL ) {
+        fclose( fid );
+        fid = NULL;
     }
-    (A->row)[num_rows] = A->nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < A->nnz; i++) {
-        magma_index_t row_ = coo_row[i];
-        magma_index_t dest = (A->row)[row_];
-        (A->col)[dest] = coo_col[i];
-        (A->val)[dest] = coo_val[i];
-        (A->row)[row_]++;
-    }    
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
-    coo_row = NULL;
-    coo_col = NULL;
-    coo_val = NULL;
+    mm_unmap_file( &mf );
+    magma_free_cpu( bounds );
+    magma_free_cpu( chunk_start );
+    if ( info != 0 ) {
+        magma_free_cpu( *coo_row );
+        magma_free_cpu( *coo_col );
+        magma_free_cpu( *coo_val );
+        *coo_row = NULL;
+        *coo_col = NULL;
+        *coo_val = NULL;
+    }
+    return info;
+}
 
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp    = (A->row)[i];
-        (A->row)[i] = last;
-        last        = temp;
+
+/**
+    Purpose
+    -------
+
+    Converts COO triplets into CSR with sorted column indices using a
+    parallel counting sort. If duplicate is set, each off-diagonal entry
+    (i,j) is additionally stored as (j,i), conjugated if hermitian is set.
+
+    Entries are first bucketed by row block (one block per thread), then
+    each thread sorts its block by row. Both steps are stable, so entries
+    appear in every row in the same order as in the file (mirrored entries
+    directly after their originals), and the subsequent column sort is
+    stable as well. The output is therefore independent of the number of
+    threads.
+
+    The COO arrays are freed once they are no longer needed, to keep the
+    peak memory at one COO and one CSR copy of the expanded matrix.
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_index_t
+                number of rows
+
+    @param[in]
+    nnz         magma_index_t
+                number of COO entries
+
+    @param[in,out]
+    coo_row     magma_index_t**
+                row indices; freed on exit
+
+    @param[in,out]
+    coo_col     magma_index_t**
+                column indices; freed on exit
+
+    @param[in,out]
+    coo_val     magmaDoubleComplex**
+                values; freed on exit
+
+    @param[in]
+    duplicate   magma_int_t
+                duplicate the off-diagonal entries
+
+    @param[in]
+    hermitian   magma_int_t
+                conjugate the duplicated entries
+
+    @param[out]
+    A           magma_z_matrix*
+                row, col, val and nnz are set
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+static magma_int_t
+magma_zmcoo2csr_sorted(
+    magma_index_t num_rows,
+    magma_index_t nnz,
+    magma_index_t **coo_row,
+    magma_index_t **coo_col,
+    magmaDoubleComplex **coo_val,
+    magma_int_t duplicate,
+    magma_int_t hermitian,
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_index_t *trow = NULL, *tcol = NULL;
+    magmaDoubleComplex *tval = NULL;
+    magma_int_t *offsets = NULL, *block_start = NULL;
+    magma_int_t num_threads = 1, rows_per_block, chunk, true_nonzeros = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel
+    {
+        num_threads = omp_get_max_threads();
     }
-    (A->row)[A->num_rows] = A->nnz;
-    
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < A->num_rows; ++k) {
-        int kk  = (A->row)[k];
-        int len = (A->row)[k+1] - (A->row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (A->col)[kk+i], (A->val)[kk+i] );
+#endif
+    rows_per_block = max( 1, magma_ceildiv( num_rows, num_threads ) );
+    chunk = magma_ceildiv( nnz, num_threads );
+
+    // offsets[ t*num_threads + b ]: entries of COO chunk t that go to row block b
+    CHECK( magma_malloc_cpu( (void**) &offsets, num_threads*num_threads*sizeof(magma_int_t) ));
+    CHECK( magma_malloc_cpu( (void**) &block_start, (num_threads+1)*sizeof(magma_int_t) ));
+
+    #pragma omp parallel for
+    for( magma_int_t t=0; t < num_threads; t++ ){
+        magma_int_t *cnt = offsets + t*num_threads;
+        for( magma_int_t b=0; b < num_threads; b++ )
+            cnt[b] = 0;
+        magma_int_t end = min( nnz, (t+1)*chunk );
+        for( magma_int_t i=t*chunk; i < end; i++ ){
+            magma_index_t r = (*coo_row)[i], c = (*coo_col)[i];
+            cnt[ r/rows_per_block ]++;
+            if( duplicate && r != c )
+                cnt[ c/rows_per_block ]++;
         }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (A->col)[kk+i] = rowval[i].first;
-            (A->val)[kk+i] = rowval[i].second;
+    }
+    for( magma_int_t b=0; b < num_threads; b++ ){
+        block_start[b] = true_nonzeros;
+        for( magma_int_t t=0; t < num_threads; t++ ){
+            magma_int_t tmp = offsets[ t*num_threads + b ];
+            offsets[ t*num_threads + b ] = true_nonzeros;
+            true_nonzeros += tmp;
+        }
+    }
+    block_start[num_threads] = true_nonzeros;
+
+    CHECK( magma_index_malloc_cpu( &trow, true_nonzeros ));
+    CHECK( magma_index_malloc_cpu( &tcol, true_nonzeros ));
+    CHECK( magma_zmalloc_cpu( &tval, true_nonzeros ));
+
+    // scatter into the row blocks, preserving the order within each block
+    #pragma omp parallel for
+    for( magma_int_t t=0; t < num_threads; t++ ){
+        magma_int_t *dst = offsets + t*num_threads;
+        magma_int_t end = min( nnz, (t+1)*chunk );
+        for( magma_int_t i=t*chunk; i < end; i++ ){
+            magma_index_t r = (*coo_row)[i], c = (*coo_col)[i];
+            magma_int_t k = dst[ r/rows_per_block ]++;
+            trow[k] = r;
+            tcol[k] = c;
+            tval[k] = (*coo_val)[i];
+            if( duplicate && r != c ){
+                k = dst[ c/rows_per_block ]++;
+                trow[k] = c;
+                tcol[k] = r;
+                tval[k] = (hermitian == 0) ? (*coo_val)[i] : conj((*coo_val)[i]);
+            }
         }
     }
+    magma_free_cpu( *coo_row );
+    magma_free_cpu( *coo_col );
+    magma_free_cpu( *coo_val );
+    *coo_row = NULL;
+    *coo_col = NULL;
+    *coo_val = NULL;
+
+    A->nnz = true_nonzeros;
+    CHECK( magma_zmalloc_cpu( &A->val, A->nnz ));
+    CHECK( magma_index_malloc_cpu( &A->col, A->nnz ));
+    CHECK( magma_index_malloc_cpu( &A->row, num_rows+1 ));
+
+    // each thread turns its row block into CSR
+    #pragma omp parallel for
+    for( magma_int_t b=0; b < num_threads; b++ ){
+        magma_int_t rstart = min( num_rows, b*rows_per_block );
+        magma_int_t rend   = min( num_rows, (b+1)*rows_per_block );
+        std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
+
+        for( magma_int_t r=rstart; r < rend; r++ )
+            A->row[r] = 0;
+        for( magma_int_t k=block_start[b]; k < block_start[b+1]; k++ )
+            A->row[ trow[k] ]++;
+        magma_int_t cumsum = block_start[b];
+        for( magma_int_t r=rstart; r < rend; r++ ){
+            magma_index_t temp = A->row[r];
+            A->row[r] = cumsum;
+            cumsum += temp;
+        }
+        // original code from Nathan Bell and Michael Garland
+        for( magma_int_t k=block_start[b]; k < block_start[b+1]; k++ ){
+            magma_index_t dest = A->row[ trow[k] ]++;
+            A->col[dest] = tcol[k];
+            A->val[dest] = tval[k];
+        }
+        magma_int_t last = block_start[b];
+        for( magma_int_t r=rstart; r < rend; r++ ){
+            magma_index_t temp = A->row[r];
+            A->row[r] = last;
+            last = temp;
+        }
 
-    if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
-        //printf("removing zeros: ");
-        CHECK( magma_zmtransfer( *A, &B, Magma_CPU, Magma_CPU, queue ));
-        CHECK( magma_z_csr_compressor(
-            &(A->val), &(A->row), &(A->col),
-            &B.val, &B.row, &B.col, &B.num_rows, queue ));
-        B.nnz = B.row[num_rows];
-        //printf(" remaining nonzeros:%d ", B.nnz);
-        magma_free_cpu( A->val );
-        magma_free_cpu( A->row );
-        magma_free_cpu( A->col );
-        *A = {Magma_CSR};
-        CHECK( magma_zmtransfer( B, A, Magma_CPU, Magma_CPU, queue ));
-        //printf("done.\n");
+        // sort column indices within each row; stable for duplicates
+        for( magma_int_t r=rstart; r < rend; r++ ){
+            magma_int_t kk  = A->row[r];
+            magma_int_t len = ( r+1 < rend ? A->row[r+1] : last ) - kk;
+            bool sorted = true;
+            for( magma_int_t i=1; i < len && sorted; ++i )
+                sorted = ( A->col[kk+i-1] <= A->col[kk+i] );
+            if( sorted )
+                continue;
+            rowval.resize( len );
+            for( magma_int_t i=0; i < len; ++i ){
+                rowval[i] = std::make_pair( A->col[kk+i], A->val[kk+i] );
+            }
+            std::stable_sort( rowval.begin(), rowval.end(), compare_first );
+            for( magma_int_t i=0; i < len; ++i ){
+                A->col[kk+i] = rowval[i].first;
+                A->val[kk+i] = rowval[i].second;
+            }
+        }
     }
-    A->true_nnz = A->nnz;
-    printf(" done.\n");
+    A->row[num_rows] = A->nnz;
+
 cleanup:
-    if ( fid != NULL ) {
-        fclose( fid );
-        fid = NULL;
-    }
-    magma_zmfree( &B, queue );
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
+    magma_free_cpu( trow );
+    magma_free_cpu( tcol );
+    magma_free_cpu( tval );
+    magma_free_cpu( offsets );
+    magma_free_cpu( block_start );
     return info;
 }
 
@@ -1213,9 +1916,12 @@ cleanup:
     Purpose
     -------
 
-    Reads in a SYMMETRIC matrix stored in coo format from a Matrix Market (.mtx)
-    file and converts it into CSR format. It does not duplicate the off-diagonal
-    entries!
+    Reads in a matrix stored in coo format from a Matrix Market (.mtx)
+    file and converts it into CSR format. It duplicates the off-diagonal
+    entries in the symmetric case.
+
+    The file is memory-mapped and parsed in parallel, see
+    magma_zmtx_read_coo and magma_zmcoo2csr_sorted.
 
     Arguments
     ---------
@@ -1236,194 +1942,157 @@ cleanup:
 
 extern "C"
 magma_int_t
-magma_z_csr_mtxsymm(
+magma_z_csr_mtx(
     magma_z_matrix *A,
     const char *filename,
     magma_queue_t queue )
 {
-    char buffer[ 1024 ];
     magma_int_t info = 0;
-    
+
+    magma_int_t csr_compressor = 0;       // checks for zeros in original file
+
     magma_z_matrix B={Magma_CSR};
-        
-    int csr_compressor = 0;       // checks for zeros in original file
-    
-    magma_index_t *coo_col=NULL, *coo_row=NULL;
-    magmaDoubleComplex *coo_val=NULL;
 
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
-    
-    FILE *fid = NULL;
-    MM_typecode matcode;
-    fid = fopen(filename, "r");
-    
+    magma_index_t *coo_col = NULL;
+    magma_index_t *coo_row = NULL;
+    magmaDoubleComplex *coo_val = NULL;
+    magma_int_t hermitian = 0, duplicate = 0;
+    magma_index_t num_rows, num_cols, num_nonzeros;
+    MM_typecode matcode;
+
+    // make sure the target structure is empty
     magma_zmfree( A, queue );
     A->ownership = MagmaTrue;
-    if (fid == NULL) {
-        printf("%% Unable to open file %s\n", filename);
-        info = MAGMA_ERR_NOT_FOUND;
-        goto cleanup;
-    }
-    
-    printf("%% Reading sparse matrix from file (%s):", filename);
+    A->mapping = NULL;
+    A->lval = NULL;
+
+    CHECK( magma_zmtx_read_coo( filename, &matcode, &num_rows, &num_cols,
+        &num_nonzeros, &coo_row, &coo_col, &coo_val, &csr_compressor, queue ));
+
+    A->storage_type    = Magma_CSR;
+    A->memory_location = Magma_CPU;
+    A->num_rows        = num_rows;
+    A->num_cols        = num_cols;
+    A->nnz             = num_nonzeros;
+    A->fill_mode       = MagmaFull;
+
+    printf(" done. Converting to CSR:");
     fflush(stdout);
 
-    if (mm_read_banner(fid, &matcode) != 0) {
-        printf(" Could not process Matrix Market banner: %s.\n", matcode);
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
+    A->sym = Magma_GENERAL;
+
+    if( mm_is_hermitian(matcode) ) {
+        hermitian = 1;
     }
-    
-    if (!mm_is_valid(matcode)) {
-        printf(" Invalid Matrix Market file.\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
+    if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) {
+                                        // duplicate off diagonal entries
+        printf("\n%% Detected symmetric case.");
+        A->sym = Magma_SYMMETRIC;
+        duplicate = 1;
     }
-    
-    if ( ! ( ( mm_is_real(matcode) ||
-               mm_is_integer(matcode) ||
-               mm_is_pattern(matcode) ||
-               mm_is_complex(matcode) ) &&
-             mm_is_coordinate(matcode)  &&
-             mm_is_sparse(matcode) ) )
-    {
-        mm_snprintf_typecode( buffer, sizeof(buffer), matcode );
-        printf("\n%% Sorry, MAGMA-sparse does not support Market Market type: [%s]\n", buffer );
-        printf("%% Only real-valued or pattern coordinate matrices are supported.\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
+
+    CHECK( magma_zmcoo2csr_sorted( num_rows, num_nonzeros,
+        &coo_row, &coo_col, &coo_val, duplicate, hermitian, A, queue ));
+
+    if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
+        //printf("removing zeros: ");
+        CHECK( magma_zmtransfer( *A, &B, Magma_CPU, Magma_CPU, queue ));
+        CHECK( magma_z_csr_compressor(
+            &(A->val), &(A->row), &(A->col),
+            &B.val, &B.row, &B.col, &B.num_rows, queue ));
+        B.nnz = B.row[num_rows];
+        //printf(" remaining nonzeros:%d ", B.nnz);
+        magma_free_cpu( A->val );
+        magma_free_cpu( A->row );
+        magma_free_cpu( A->col );
+        *A = {Magma_CSR};
+        CHECK( magma_zmtransfer( B, A, Magma_CPU, Magma_CPU, queue ));
+        //printf("done.\n");
     }
-    
+    A->true_nnz = A->nnz;
+    printf(" done.\n");
+cleanup:
+    magma_zmfree( &B, queue );
+    magma_free_cpu(coo_row);
+    magma_free_cpu(coo_col);
+    magma_free_cpu(coo_val);
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Reads in a SYMMETRIC matrix stored in coo format from a Matrix Market (.mtx)
+    file and converts it into CSR format. It does not duplicate the off-diagonal
+    entries!
+
+    The file is memory-mapped and parsed in parallel, see
+    magma_zmtx_read_coo and magma_zmcoo2csr_sorted.
+
+    Arguments
+    ---------
+
+    @param[out]
+    A           magma_z_matrix*
+                matrix in magma sparse matrix format
+
+    @param[in]
+    filename    const char*
+                filname of the mtx matrix
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_z_csr_mtxsymm(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix B={Magma_CSR};
+
+    magma_int_t csr_compressor = 0;       // checks for zeros in original file
+
+    magma_index_t *coo_col=NULL, *coo_row=NULL;
+    magmaDoubleComplex *coo_val=NULL;
     magma_index_t num_rows, num_cols, num_nonzeros;
-    if (mm_read_mtx_crd_size(fid, &num_rows, &num_cols, &num_nonzeros) != 0) {
-        info = MAGMA_ERR_UNKNOWN;
-        goto cleanup;
-    }
-    
+    MM_typecode matcode;
+
+    magma_zmfree( A, queue );
+    A->ownership = MagmaTrue;
+    A->mapping = NULL;
+    A->lval = NULL;
+
+    CHECK( magma_zmtx_read_coo( filename, &matcode, &num_rows, &num_cols,
+        &num_nonzeros, &coo_row, &coo_col, &coo_val, &csr_compressor, queue ));
+
     A->storage_type    = Magma_CSR;
     A->memory_location = Magma_CPU;
     A->num_rows        = num_rows;
     A->num_cols        = num_cols;
     A->nnz             = num_nonzeros;
     A->fill_mode       = MagmaFull;
-  
-    CHECK( magma_index_malloc_cpu( &coo_col, A->nnz ) );
-    CHECK( magma_index_malloc_cpu( &coo_row, A->nnz ) );
-    CHECK( magma_zmalloc_cpu( &coo_val, A->nnz ) );
-    
-    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf \n", &ROW, &COL, &VAL);
-            if ( VAL == 0 )
-                csr_compressor = 1;
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, 0.);
-        }
-    } else if (mm_is_pattern(matcode) ) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            
-            fscanf(fid, " %d %d \n", &ROW, &COL);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( 1.0, 0.);
-        }
-    } else if (mm_is_complex(matcode) ){
-        for (magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL, VALC;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf %lf\n", &ROW, &COL, &VAL, &VALC);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, VALC);
-        }
-        // printf(" ...successfully read complex matrix... ");
-    } else {
-        printf("Unrecognized data type\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        // TODO goto cleanup?
-    }
-    
-    fclose(fid);
-    fid = NULL;
+
     printf(" done. Converting to CSR:");
     fflush(stdout);
-    
+
     A->sym = Magma_GENERAL;
 
-    if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) { 
+    if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) {
             // do not duplicate off diagonal entries!
         A->sym = Magma_SYMMETRIC;
     } // end symmetric case
-    
-    CHECK( magma_index_malloc_cpu( &A->col, A->nnz ) );
-    CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ) );
-    CHECK( magma_zmalloc_cpu( &A->val, A->nnz ) );
 
-    // original code from  Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (A->row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < A->nnz; i++)
-        (A->row)[coo_row[i]]++;
-    
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (A->row)[i];
-        (A->row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (A->row)[num_rows] = A->nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < A->nnz; i++) {
-        magma_index_t row_  = coo_row[i];
-        magma_index_t dest = (A->row)[row_];
-        (A->col)[dest] = coo_col[i];
-        (A->val)[dest] = coo_val[i];
-        (A->row)[row_]++;
-    }
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
-    coo_row = NULL;
-    coo_col = NULL;
-    coo_val = NULL;
-    
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp    = (A->row)[i];
-        (A->row)[i] = last;
-        last        = temp;
-    }
-    
-    (A->row)[A->num_rows]=A->nnz;
-    
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < A->num_rows; ++k) {
-        int kk  = (A->row)[k];
-        int len = (A->row)[k+1] - (A->row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (A->col)[kk+i], (A->val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (A->col)[kk+i] = rowval[i].first;
-            (A->val)[kk+i] = rowval[i].second;
-        }
-    }
+    CHECK( magma_zmcoo2csr_sorted( num_rows, num_nonzeros,
+        &coo_row, &coo_col, &coo_val, 0, 0, A, queue ));
 
     if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
         //printf("removing zeros: ");
@@ -1442,16 +2111,667 @@ magma_z_csr_mtxsymm(
         //printf("done.\n");
     }
     A->true_nnz = A->nnz;
-    
+
     printf(" done.\n");
 cleanup:
-    if ( fid != NULL ) {
-        fclose( fid );
-        fid = NULL;
-    }
     magma_zmfree( &B, queue );
     magma_free_cpu(coo_row);
     magma_free_cpu(coo_col);
     magma_free_cpu(coo_val);
     return info;
 }
+
+
+/**
+    Purpose
+    -------
+
+    Entry of the temporary per-block COO files of
+    magma_z_csr_mtx_stream_open.
+*/
+typedef struct magma_zmtx_triplet
+{
+    magma_index_t row;
+    magma_index_t col;
+    magmaDoubleComplex val;
+} magma_zmtx_triplet;
+
+// bytes of the coordinate section parsed at once in the scatter pass;
+// bounds the host memory needed besides the row counts and one row block
+#ifndef MAGMA_MTX_STREAM_WINDOW
+#define MAGMA_MTX_STREAM_WINDOW  (size_t(1) << 28)
+#endif
+
+
+/**
+    Purpose
+    -------
+
+    Parses the coordinate line [q, end) of a Matrix Market file into
+    1-based indices and a value. Pattern entries get the value 1.
+    Returns 1 for a valid entry, 0 otherwise.
+*/
+static inline int
+magma_zmtx_parse_entry(
+    const char *q,
+    const char *end,
+    int values_per_line,
+    magma_index_t num_rows,
+    magma_index_t num_cols,
+    magma_index_t *ROW,
+    magma_index_t *COL,
+    real_Double_t *VAL,
+    real_Double_t *VALC )
+{
+    *ROW = 0;
+    *COL = 0;
+    *VAL = 1.0;
+    *VALC = 0.0;
+    q = mm_parse_index( q, end, ROW );
+    if( q != NULL ) q = mm_parse_index( q, end, COL );
+    if( q != NULL && values_per_line > 0 ) q = mm_parse_value( q, end, VAL );
+    if( q != NULL && values_per_line > 1 ) q = mm_parse_value( q, end, VALC );
+    return ( q != NULL && *ROW >= 1 && *ROW <= num_rows
+                       && *COL >= 1 && *COL <= num_cols );
+}
+
+
+/**
+    Purpose
+    -------
+
+    File name of the COO scratch file (ext "coo") or CSR shard (ext "bin")
+    of row block b.
+*/
+static void
+magma_zmtx_stream_name(
+    char *name,
+    size_t len,
+    const char *prefix,
+    magma_int_t b,
+    const char *ext )
+{
+    snprintf( name, len, "%s.%lld.%s", prefix, (long long) b, ext );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Splits a Matrix Market (.mtx) file into row blocks stored as binary CSR
+    shards on disk, without ever holding the whole matrix in memory.
+    The blocks are then handed out one at a time by
+    magma_z_csr_mtx_stream_next.
+
+    The memory-mapped file is read twice. The first pass counts the
+    entries of every row and splits the rows into blocks of at most
+    block_nnz nonzeros (a block exceeds this only if a single row does).
+    The second pass parses the file in windows of bounded size and appends
+    each entry to the COO scratch file of its block. Finally every block
+    is converted to CSR with sorted column indices and written as
+    <prefix>.<block>.bin in the format of magma_zwrite_csr_binary.
+    Symmetric and hermitian files are expanded, and explicit zeros of
+    real-valued files are removed, so that the concatenated blocks equal
+    the matrix returned by magma_z_csr_mtx.
+
+    Host memory is bounded by one row count per row, the largest row block,
+    and a window of the file.
+
+    Arguments
+    ---------
+
+    @param[out]
+    S           magma_mtx_stream*
+                row-block stream, release with magma_z_csr_mtx_stream_close
+
+    @param[in]
+    filename    const char*
+                filname of the mtx matrix
+
+    @param[in]
+    prefix      const char*
+                file name prefix of the shards, e.g., a directory on
+                scratch storage followed by a base name;
+                if NULL, filename is used
+
+    @param[in]
+    block_nnz   magma_int_t
+                target number of nonzeros per row block
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_z_csr_mtx_stream_open(
+    magma_mtx_stream *S,
+    const char *filename,
+    const char *prefix,
+    magma_int_t block_nnz,
+    magma_queue_t queue )
+{
+    char buffer[ 1024 ], name[ 1024 ];
+    magma_int_t info = 0;
+
+    FILE *fid = NULL, *fp = NULL;
+    MM_typecode matcode;
+    mm_mapped_file mf = { NULL, 0, 0 };
+    magma_z_matrix B={Magma_CSR};
+    size_t offset = 0, *wbounds = NULL, *bounds = NULL;
+    long long m = 0, n = 0, nz = 0;
+    int values_per_line = 0, duplicate = 0, hermitian = 0;
+    magma_int_t nchunks = 1, nwindows = 1, nblocks = 0;
+    int64_t entries = 0, errors = 0, expanded = 0, bnnz = 0, cap = 0;
+    magma_index_t *row_nnz = NULL;
+    int64_t *chunk_cap = NULL, *chunk_len = NULL, *bucket = NULL;
+    magma_zmtx_triplet *trip = NULL, *sorted = NULL;
+    magma_index_t *coo_row = NULL, *coo_col = NULL;
+    magmaDoubleComplex *coo_val = NULL;
+
+    S->prefix = NULL;
+    S->num_rows = 0;
+    S->num_cols = 0;
+    S->nnz = 0;
+    S->sym = Magma_GENERAL;
+    S->num_blocks = 0;
+    S->block_start = NULL;
+    S->current = 0;
+
+    if ( block_nnz <= 0 ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+    if ( prefix == NULL ) {
+        prefix = filename;
+    }
+    CHECK( magma_malloc_cpu( (void**) &S->prefix, strlen(prefix)+1 ));
+    strcpy( S->prefix, prefix );
+
+    fid = fopen(filename, "r");
+    if (fid == NULL) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+
+    printf("%% Streaming sparse matrix from file (%s):", filename);
+    fflush(stdout);
+
+    if (mm_read_banner(fid, &matcode) != 0) {
+        printf("\n%% Could not process Matrix Market banner: %s.\n", matcode);
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    if ( ! ( mm_is_valid(matcode) &&
+             ( mm_is_real(matcode)    ||
+               mm_is_integer(matcode) ||
+               mm_is_pattern(matcode) ||
+               mm_is_complex(matcode) ) &&
+             mm_is_coordinate(matcode)  &&
+             mm_is_sparse(matcode) ) )
+    {
+        mm_snprintf_typecode( buffer, sizeof(buffer), matcode );
+        printf("\n%% Sorry, MAGMA-sparse does not support Market Market type: [%s]\n", buffer );
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    // size line; read with 64-bit counts, the number of entries of
+    // out-of-core matrices may exceed the index type
+    do {
+        if ( fgets( buffer, sizeof(buffer), fid ) == NULL ) {
+            info = MAGMA_ERR_UNKNOWN;
+            goto cleanup;
+        }
+    } while ( buffer[0] == '%' );
+    if ( sscanf( buffer, "%lld %lld %lld", &m, &n, &nz ) != 3
+        || m < 0 || n < 0 || nz < 0
+        || m > INT_MAX
+        || n > INT_MAX )
+    {
+        printf("\n%% Invalid size line in %s.\n", filename);
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    offset = (size_t) ftell(fid);
+    fclose(fid);
+    fid = NULL;
+
+    if ( mm_is_pattern(matcode) ) {
+        values_per_line = 0;
+    } else if ( mm_is_real(matcode) || mm_is_integer(matcode) ) {
+        values_per_line = 1;
+    } else {
+        values_per_line = 2;
+    }
+    if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) {
+        duplicate = 1;
+        S->sym = Magma_SYMMETRIC;
+    }
+    hermitian = mm_is_hermitian(matcode) ? 1 : 0;
+    S->num_rows = m;
+    S->num_cols = n;
+
+    if (mm_map_file(filename, 0, &mf) != 0) {
+        printf("\n%% Unable to map file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    if ( offset > mf.size ) {
+        offset = mf.size;
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel
+    {
+        nchunks = omp_get_max_threads();
+    }
+    nchunks *= 4;
+#endif
+    nwindows = max( (magma_int_t) 1,
+        (magma_int_t) ((mf.size - offset + MAGMA_MTX_STREAM_WINDOW - 1) / MAGMA_MTX_STREAM_WINDOW) );
+    CHECK( magma_malloc_cpu( (void**) &wbounds, (nwindows+1)*sizeof(size_t) ));
+    CHECK( magma_malloc_cpu( (void**) &bounds, (nchunks+1)*sizeof(size_t) ));
+    CHECK( magma_malloc_cpu( (void**) &chunk_cap, (nchunks+1)*sizeof(int64_t) ));
+    CHECK( magma_malloc_cpu( (void**) &chunk_len, nchunks*sizeof(int64_t) ));
+    CHECK( magma_index_malloc_cpu( &row_nnz, max( (long long) 1, m ) ));
+
+    // pass 1: count the entries of every row
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < m; i++ ){
+        row_nnz[i] = 0;
+    }
+    mm_split_lines( mf.data, offset, mf.size, nchunks, bounds );
+    #pragma omp parallel for schedule(dynamic,1) reduction(+:entries,errors)
+    for( magma_int_t c=0; c < nchunks; c++ ){
+        const char *p   = mf.data + bounds[c];
+        const char *end = mf.data + bounds[c+1];
+        while( p < end ){
+            const char *q = mm_skip_blanks( p, end );
+            p = mm_next_line( q, end );
+            if( q == end || *q == '\n' || *q == '%' )
+                continue;
+            magma_index_t ROW, COL;
+            real_Double_t VAL, VALC;
+            entries++;
+            if( ! magma_zmtx_parse_entry( q, p, values_per_line, m, n,
+                                          &ROW, &COL, &VAL, &VALC ) ){
+                errors++;
+                continue;
+            }
+            if( values_per_line == 1 && VAL == 0 )
+                continue;
+            #pragma omp atomic
+            row_nnz[ROW-1]++;
+            if( duplicate && ROW != COL ){
+                #pragma omp atomic
+                row_nnz[COL-1]++;
+            }
+        }
+    }
+    if ( errors > 0 || entries != nz ) {
+        printf("\n%% Could not parse %s: found %lld valid of %lld entries, expected %lld.\n",
+               filename, (long long) (entries - errors), (long long) entries, nz );
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+
+    // split the rows into blocks of at most block_nnz nonzeros
+    for( int pass=0; pass < 2; pass++ ){
+        nblocks = 0;
+        bnnz = 0;
+        for( magma_int_t i=0; i < m; i++ ){
+            if( i == 0 || ( bnnz > 0 && bnnz + row_nnz[i] > block_nnz ) ){
+                if( pass == 1 )
+                    S->block_start[nblocks] = i;
+                nblocks++;
+                bnnz = 0;
+            }
+            bnnz += row_nnz[i];
+        }
+        if( pass == 0 ){
+            CHECK( magma_index_malloc_cpu( &S->block_start, nblocks+1 ));
+        }
+    }
+    S->block_start[nblocks] = m;
+    S->num_blocks = nblocks;
+    CHECK( magma_malloc_cpu( (void**) &bucket, (nchunks*nblocks+1)*sizeof(int64_t) ));
+
+    // start with empty scratch files
+    for( magma_int_t b=0; b < nblocks; b++ ){
+        magma_zmtx_stream_name( name, sizeof(name), S->prefix, b, "coo" );
+        fp = fopen( name, "wb" );
+        if ( fp == NULL ) {
+            printf("\n%% Unable to create %s\n", name);
+            info = MAGMA_ERR;
+            goto cleanup;
+        }
+        fclose( fp );
+        fp = NULL;
+    }
+
+    // pass 2: scatter the entries of each window of the file
+    // into the scratch files of their row blocks
+    mm_split_lines( mf.data, offset, mf.size, nwindows, wbounds );
+    for( magma_int_t w=0; w < nwindows; w++ ){
+        mm_split_lines( mf.data, wbounds[w], wbounds[w+1], nchunks, bounds );
+
+        #pragma omp parallel for schedule(dynamic,1)
+        for( magma_int_t c=0; c < nchunks; c++ ){
+            const char *p   = mf.data + bounds[c];
+            const char *end = mf.data + bounds[c+1];
+            int64_t count = 0;
+            while( p < end ){
+                const char *q = mm_skip_blanks( p, end );
+                if( q < end && *q != '\n' && *q != '%' )
+                    count++;
+                p = mm_next_line( q, end );
+            }
+            chunk_cap[c] = count * (duplicate+1);
+        }
+        cap = 0;
+        for( magma_int_t c=0; c < nchunks; c++ ){
+            int64_t tmp = chunk_cap[c];
+            chunk_cap[c] = cap;
+            cap += tmp;
+        }
+        chunk_cap[nchunks] = cap;
+        CHECK( magma_malloc_cpu( (void**) &trip, max( (int64_t) 1, cap )*sizeof(magma_zmtx_triplet) ));
+        CHECK( magma_malloc_cpu( (void**) &sorted, max( (int64_t) 1, cap )*sizeof(magma_zmtx_triplet) ));
+
+        // parse each chunk into its slot and count the entries per block
+        #pragma omp parallel for schedule(dynamic,1)
+        for( magma_int_t c=0; c < nchunks; c++ ){
+            const char *p   = mf.data + bounds[c];
+            const char *end = mf.data + bounds[c+1];
+            magma_zmtx_triplet *t = trip + chunk_cap[c];
+            int64_t k = 0;
+            while( p < end ){
+                const char *q = mm_skip_blanks( p, end );
+                p = mm_next_line( q, end );
+                if( q == end || *q == '\n' || *q == '%' )
+                    continue;
+                magma_index_t ROW, COL;
+                real_Double_t VAL, VALC;
+                magma_zmtx_parse_entry( q, p, values_per_line, m, n,
+                                        &ROW, &COL, &VAL, &VALC );
+                if( values_per_line == 1 && VAL == 0 )
+                    continue;
+                t[k].row = ROW-1;
+                t[k].col = COL-1;
+                t[k].val = MAGMA_Z_MAKE( VAL, VALC );
+                k++;
+                if( duplicate && ROW != COL ){
+                    t[k].row = COL-1;
+                    t[k].col = ROW-1;
+                    t[k].val = hermitian ? MAGMA_Z_CONJ( t[k-1].val ) : t[k-1].val;
+                    k++;
+                }
+            }
+            chunk_len[c] = k;
+            int64_t *cnt = bucket + c*nblocks;
+            for( magma_int_t b=0; b < nblocks; b++ )
+                cnt[b] = 0;
+            for( int64_t i=0; i < k; i++ ){
+                magma_index_t b = std::upper_bound( S->block_start, S->block_start + nblocks,
+                                                    t[i].row ) - S->block_start - 1;
+                cnt[b]++;
+            }
+        }
+
+        // stable bucket sort by block, blocks outer, chunks inner
+        expanded = 0;
+        for( magma_int_t b=0; b < nblocks; b++ ){
+            for( magma_int_t c=0; c < nchunks; c++ ){
+                int64_t tmp = bucket[ c*nblocks + b ];
+                bucket[ c*nblocks + b ] = expanded;
+                expanded += tmp;
+            }
+        }
+        #pragma omp parallel for schedule(dynamic,1)
+        for( magma_int_t c=0; c < nchunks; c++ ){
+            const magma_zmtx_triplet *t = trip + chunk_cap[c];
+            int64_t *pos = bucket + c*nblocks;
+            for( int64_t i=0; i < chunk_len[c]; i++ ){
+                magma_index_t b = std::upper_bound( S->block_start, S->block_start + nblocks,
+                                                    t[i].row ) - S->block_start - 1;
+                sorted[ pos[b]++ ] = t[i];
+            }
+        }
+        // after the scatter, bucket[ c*nblocks + b ] is the end of chunk c in
+        // block b; the last chunk gives the end of the block
+        for( magma_int_t b=0; b < nblocks; b++ ){
+            int64_t first = ( b == 0 ) ? 0 : bucket[ (nchunks-1)*nblocks + b-1 ];
+            int64_t last  = bucket[ (nchunks-1)*nblocks + b ];
+            if ( last == first )
+                continue;
+            magma_zmtx_stream_name( name, sizeof(name), S->prefix, b, "coo" );
+            fp = fopen( name, "ab" );
+            if ( fp == NULL
+                || fwrite( sorted + first, sizeof(magma_zmtx_triplet), last - first, fp )
+                        != size_t(last - first) )
+            {
+                printf("\n%% Unable to write %s\n", name);
+                info = MAGMA_ERR;
+                goto cleanup;
+            }
+            fclose( fp );
+            fp = NULL;
+        }
+        magma_free_cpu( trip );
+        magma_free_cpu( sorted );
+        trip = NULL;
+        sorted = NULL;
+    }
+    mm_unmap_file( &mf );
+
+    printf(" done. Writing %lld row blocks:", (long long) nblocks);
+    fflush(stdout);
+
+    // convert every block to CSR and store it as binary shard
+    for( magma_int_t b=0; b < nblocks; b++ ){
+        magma_index_t r0 = S->block_start[b], r1 = S->block_start[b+1];
+        bnnz = 0;
+        for( magma_index_t i=r0; i < r1; i++ )
+            bnnz += row_nnz[i];
+        S->nnz += bnnz;
+
+        CHECK( magma_malloc_cpu( (void**) &trip, max( (int64_t) 1, bnnz )*sizeof(magma_zmtx_triplet) ));
+        CHECK( magma_index_malloc_cpu( &coo_row, max( (int64_t) 1, bnnz ) ));
+        CHECK( magma_index_malloc_cpu( &coo_col, max( (int64_t) 1, bnnz ) ));
+        CHECK( magma_zmalloc_cpu( &coo_val, max( (int64_t) 1, bnnz ) ));
+        magma_zmtx_stream_name( name, sizeof(name), S->prefix, b, "coo" );
+        fp = fopen( name, "rb" );
+        if ( fp == NULL
+            || fread( trip, sizeof(magma_zmtx_triplet), bnnz, fp ) != size_t(bnnz) )
+        {
+            printf("\n%% Unable to read %s\n", name);
+            info = MAGMA_ERR;
+            goto cleanup;
+        }
+        fclose( fp );
+        fp = NULL;
+        remove( name );
+
+        #pragma omp parallel for
+        for( int64_t i=0; i < bnnz; i++ ){
+            coo_row[i] = trip[i].row - r0;
+            coo_col[i] = trip[i].col;
+            coo_val[i] = trip[i].val;
+        }
+        magma_free_cpu( trip );
+        trip = NULL;
+
+        B.storage_type    = Magma_CSR;
+        B.memory_location = Magma_CPU;
+        B.num_rows        = r1 - r0;
+        B.num_cols        = n;
+        B.fill_mode       = MagmaFull;
+        B.sym             = Magma_GENERAL;
+        B.ownership       = MagmaTrue;
+        CHECK( magma_zmcoo2csr_sorted( B.num_rows, bnnz,
+            &coo_row, &coo_col, &coo_val, 0, 0, &B, queue ));
+        B.true_nnz = B.nnz;
+
+        magma_zmtx_stream_name( name, sizeof(name), S->prefix, b, "bin" );
+        fp = fopen( name, "wb" );
+        if ( fp == NULL ) {
+            info = MAGMA_ERR;
+        } else {
+            info = magma_zcsr_binary_fwrite( B, fp );
+            if ( fclose( fp ) != 0 )
+                info = MAGMA_ERR;
+            fp = NULL;
+        }
+        if ( info != 0 ) {
+            printf("\n%% Unable to write %s\n", name);
+            goto cleanup;
+        }
+        magma_zmfree( &B, queue );
+    }
+
+    printf(" done.\n");
+
+cleanup:
+    if ( fid != NULL ) {
+        fclose( fid );
+    }
+    if ( fp != NULL ) {
+        fclose( fp );
+    }
+    mm_unmap_file( &mf );
+    magma_zmfree( &B, queue );
+    magma_free_cpu( wbounds );
+    magma_free_cpu( bounds );
+    magma_free_cpu( chunk_cap );
+    magma_free_cpu( chunk_len );
+    magma_free_cpu( bucket );
+    magma_free_cpu( row_nnz );
+    magma_free_cpu( trip );
+    magma_free_cpu( sorted );
+    magma_free_cpu( coo_row );
+    magma_free_cpu( coo_col );
+    magma_free_cpu( coo_val );
+    if ( info != 0 ) {
+        magma_z_csr_mtx_stream_close( S, queue );
+    }
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Returns the next row block of a stream opened with
+    magma_z_csr_mtx_stream_open, and advances the stream.
+
+    The block is a CSR matrix with the rows
+    S->block_start[b] ... S->block_start[b+1]-1 of the whole matrix and
+    all its columns (column indices are global). It is memory-mapped from
+    its shard, see magma_z_csr_binary; the previous contents of A are
+    freed, so a loop can pass the same matrix for every block.
+    Once all blocks have been returned, A is empty (A->num_rows = 0).
+    Setting S->current resets or repositions the stream.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    S           magma_mtx_stream*
+                row-block stream
+
+    @param[out]
+    A           magma_z_matrix*
+                row block
+
+    @param[out]
+    row_offset  magma_index_t*
+                global index of the first row of the block
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_z_csr_mtx_stream_next(
+    magma_mtx_stream *S,
+    magma_z_matrix *A,
+    magma_index_t *row_offset,
+    magma_queue_t queue )
+{
+    char name[ 1024 ];
+    magma_int_t info = 0;
+
+    if ( S->current < 0 || S->current >= S->num_blocks ) {
+        magma_zmfree( A, queue );
+        *row_offset = S->num_rows;
+        goto cleanup;
+    }
+    magma_zmtx_stream_name( name, sizeof(name), S->prefix, S->current, "bin" );
+    CHECK( magma_z_csr_binary( A, name, queue ));
+    *row_offset = S->block_start[ S->current ];
+    S->current++;
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Removes the shards of a stream opened with magma_z_csr_mtx_stream_open
+    and frees the stream. Blocks that are still in use stay valid until
+    they are freed, as their mappings keep the data alive.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    S           magma_mtx_stream*
+                row-block stream
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_z_csr_mtx_stream_close(
+    magma_mtx_stream *S,
+    magma_queue_t queue )
+{
+    char name[ 1024 ];
+
+    if ( S->prefix != NULL ) {
+        for( magma_int_t b=0; b < S->num_blocks; b++ ){
+            magma_zmtx_stream_name( name, sizeof(name), S->prefix, b, "coo" );
+            remove( name );
+            magma_zmtx_stream_name( name, sizeof(name), S->prefix, b, "bin" );
+            remove( name );
+        }
+    }
+    magma_free_cpu( S->prefix );
+    magma_free_cpu( S->block_start );
+    S->prefix = NULL;
+    S->block_start = NULL;
+    S->num_blocks = 0;
+    S->num_rows = 0;
+    S->num_cols = 0;
+    S->nnz = 0;
+    S->current = 0;
+    return MAGMA_SUCCESS;
+}
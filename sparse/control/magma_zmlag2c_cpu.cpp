@@ -0,0 +1,230 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <stdint.h>
+#include <string.h>
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+// real values per entry of val
+#if defined(PRECISION_z) || defined(PRECISION_c)
+#define MAGMA_LVAL_PER_ENTRY 2
+#else
+#define MAGMA_LVAL_PER_ENTRY 1
+#endif
+
+
+/*
+    Number of entries of val that the reduced-precision copy covers,
+    -1 if the format is not supported by the mixed precision host SpMV.
+*/
+static magma_int_t
+magma_zmlag_length_cpu(
+    magma_z_matrix A )
+{
+    if ( A.storage_type == Magma_CSR   ||
+         A.storage_type == Magma_CUCSR ||
+         A.storage_type == Magma_CSRD  ||
+         A.storage_type == Magma_CSRL  ||
+         A.storage_type == Magma_CSRU  ||
+         A.storage_type == Magma_CSRDELTA ) {
+        return A.nnz;
+    } else if ( A.storage_type == Magma_SELLP ) {
+        return A.row[ A.numblocks ];
+    }
+    return -1;
+}
+
+
+/*
+    Rounds a float to the nearest bfloat16 (ties to even); NaN stays NaN.
+*/
+static inline unsigned short
+magma_zmlag2bf_round(
+    float f )
+{
+    uint32_t u;
+    memcpy( &u, &f, sizeof(u) );
+    if ( (u & 0x7fffffff) > 0x7f800000 ) {
+        return (unsigned short) ((u >> 16) | 0x0040);
+    }
+    u += 0x7fff + ((u >> 16) & 1);
+    return (unsigned short) (u >> 16);
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Attaches a single precision copy of the values of A (A->lval,
+    A->lval_bits = 32). The host SpMV of CSR and SELL-P matrices then reads
+    the single precision values and accumulates in the precision of A.
+    The copy is a snapshot: after changing A->val, call the routine again.
+    Like the other arrays, it is released by magma_zmfree if A->ownership
+    is set.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    A           magma_z_matrix*
+                matrix in CSR, CSRDELTA or SELL-P format on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmlag2c_cpu(
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_int_t len = magma_zmlag_length_cpu( *A );
+    float *lval = NULL;
+
+    if ( A->memory_location != Magma_CPU || len < 0 ) {
+        printf("error: format not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( magma_smalloc_cpu( &lval, MAGMA_LVAL_PER_ENTRY*len ));
+    #pragma omp parallel for
+    for( magma_int_t k=0; k < len; k++ ) {
+        #if defined(PRECISION_z) || defined(PRECISION_c)
+        lval[2*k]   = (float) MAGMA_Z_REAL( A->val[k] );
+        lval[2*k+1] = (float) MAGMA_Z_IMAG( A->val[k] );
+        #else
+        lval[k] = (float) A->val[k];
+        #endif
+    }
+
+    magma_free_cpu( A->lval );
+    A->lval = lval;
+    A->lval_bits = 32;
+    lval = NULL;
+
+cleanup:
+    magma_free_cpu( lval );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Attaches a bfloat16 copy of the values of A (A->lval, A->lval_bits = 16),
+    used by the host SpMV like the single precision copy of
+    magma_zmlag2c_cpu. With 8 significant bits, this is meant for
+    preconditioner matrices such as the ISAI factors.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    A           magma_z_matrix*
+                matrix in CSR, CSRDELTA or SELL-P format on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmlag2bf_cpu(
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_int_t len = magma_zmlag_length_cpu( *A );
+    unsigned short *lval = NULL;
+
+    if ( A->memory_location != Magma_CPU || len < 0 ) {
+        printf("error: format not supported.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( magma_malloc_cpu( (void**) &lval, MAGMA_LVAL_PER_ENTRY*len*sizeof(unsigned short) ));
+    #pragma omp parallel for
+    for( magma_int_t k=0; k < len; k++ ) {
+        #if defined(PRECISION_z) || defined(PRECISION_c)
+        lval[2*k]   = magma_zmlag2bf_round( (float) MAGMA_Z_REAL( A->val[k] ));
+        lval[2*k+1] = magma_zmlag2bf_round( (float) MAGMA_Z_IMAG( A->val[k] ));
+        #else
+        lval[k] = magma_zmlag2bf_round( (float) A->val[k] );
+        #endif
+    }
+
+    magma_free_cpu( A->lval );
+    A->lval = lval;
+    A->lval_bits = 16;
+    lval = NULL;
+
+cleanup:
+    magma_free_cpu( lval );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Attaches the reduced-precision copy of the values selected by bits:
+    32 (single, magma_zmlag2c_cpu) or 16 (bfloat16, magma_zmlag2bf_cpu).
+    For bits = 0 nothing is done.
+
+    Arguments
+    ---------
+
+    @param[in]
+    bits        magma_int_t
+                0, 32 or 16
+
+    @param[in,out]
+    A           magma_z_matrix*
+                matrix in CSR, CSRDELTA or SELL-P format on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zmlag_cpu(
+    magma_int_t bits,
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    if ( bits == 32 ) {
+        return magma_zmlag2c_cpu( A, queue );
+    } else if ( bits == 16 ) {
+        return magma_zmlag2bf_cpu( A, queue );
+    } else if ( bits == 0 ) {
+        return MAGMA_SUCCESS;
+    }
+    return MAGMA_ERR_ILLEGAL_VALUE;
+}
@@ -0,0 +1,902 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+
+*/
+#include <algorithm>
+#include <utility>  // pair
+#include <vector>
+
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// subgraphs of at most this size are not bisected further
+#define MAGMA_ND_LEAFSIZE 64
+
+// maximum number of sweeps in the pseudo-peripheral node search
+#define MAGMA_PERIPHERAL_SWEEPS 8
+
+
+/*
+    Builds the adjacency structure of the graph of A + A^T without the
+    diagonal: the neighbors of vertex i are adj[ ptr[i] ... ptr[i+1]-1 ],
+    sorted by index and without duplicates.
+*/
+static magma_int_t
+magma_zmreorder_graph(
+    magma_z_matrix A,
+    magma_index_t **ptr,
+    magma_index_t **adj,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+
+    magma_index_t *gptr = NULL, *gadj = NULL, *cadj = NULL;
+    magma_index_t *pos = NULL, *len = NULL;
+
+    CHECK( magma_index_malloc_cpu( &pos, n+1 ));
+    CHECK( magma_index_malloc_cpu( &len, n ));
+
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n+1; i++ ) {
+        pos[i] = 0;
+    }
+    // every off-diagonal entry (i,j) is stored in row i and in row j
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n; i++ ) {
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            magma_index_t col = A.col[j];
+            if ( col != i ) {
+                #pragma omp atomic
+                pos[i+1]++;
+                #pragma omp atomic
+                pos[col+1]++;
+            }
+        }
+    }
+    for( magma_int_t i=0; i < n; i++ ) {
+        pos[i+1] += pos[i];
+    }
+    CHECK( magma_index_malloc_cpu( &gadj, pos[n] ));
+    CHECK( magma_index_malloc_cpu( &gptr, n+1 ));
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n+1; i++ ) {
+        gptr[i] = pos[i];
+    }
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n; i++ ) {
+        for( magma_int_t j=A.row[i]; j < A.row[i+1]; j++ ) {
+            magma_index_t col = A.col[j], p;
+            if ( col != i ) {
+                #pragma omp atomic capture
+                p = pos[i]++;
+                gadj[p] = col;
+                #pragma omp atomic capture
+                p = pos[col]++;
+                gadj[p] = i;
+            }
+        }
+    }
+
+    // sort every list and remove the duplicates of symmetric entries
+    #pragma omp parallel for schedule(dynamic,256)
+    for( magma_int_t i=0; i < n; i++ ) {
+        magma_index_t start = gptr[i], end = gptr[i+1];
+        magma_index_t l = 0;
+        if ( end > start ) {
+            std::sort( gadj + start, gadj + end );
+            l = 1;
+            for( magma_index_t j=start+1; j < end; j++ ) {
+                if ( gadj[j] != gadj[start+l-1] ) {
+                    gadj[start+l] = gadj[j];
+                    l++;
+                }
+            }
+        }
+        len[i] = l;
+    }
+    pos[0] = 0;
+    for( magma_int_t i=0; i < n; i++ ) {
+        pos[i+1] = pos[i] + len[i];
+    }
+    CHECK( magma_index_malloc_cpu( &cadj, pos[n] ));
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n; i++ ) {
+        for( magma_index_t j=0; j < len[i]; j++ ) {
+            cadj[ pos[i]+j ] = gadj[ gptr[i]+j ];
+        }
+    }
+
+    *ptr = pos;
+    *adj = cadj;
+    pos = NULL;
+    cadj = NULL;
+
+cleanup:
+    magma_free_cpu( gptr );
+    magma_free_cpu( gadj );
+    magma_free_cpu( cadj );
+    magma_free_cpu( pos );
+    magma_free_cpu( len );
+    return info;
+}
+
+
+/*
+    Breadth-first search from root through the vertices v with
+    label[v] == lab and level[v] < 0. The visited vertices are written to q
+    in the order of their discovery, their distance from root to level.
+    If sorted is set, the neighbors of a vertex are queued by increasing
+    degree (Cuthill-McKee). Returns the number of visited vertices.
+*/
+static magma_int_t
+magma_zmreorder_bfs(
+    magma_index_t root,
+    const magma_index_t *ptr,
+    const magma_index_t *adj,
+    const magma_index_t *label,
+    magma_index_t lab,
+    magma_index_t *level,
+    magma_index_t *q,
+    magma_int_t sorted,
+    magma_int_t *nlevels )
+{
+    magma_int_t head = 0, tail = 1;
+    q[0] = root;
+    level[root] = 0;
+    while ( head < tail ) {
+        magma_index_t v = q[head++];
+        magma_int_t first = tail;
+        for( magma_index_t j=ptr[v]; j < ptr[v+1]; j++ ) {
+            magma_index_t w = adj[j], lw;
+            // labels of other subgraphs may be updated concurrently
+            #pragma omp atomic read
+            lw = label[w];
+            if ( lw == lab && level[w] < 0 ) {
+                level[w] = level[v] + 1;
+                q[tail++] = w;
+            }
+        }
+        if ( sorted ) {
+            for( magma_int_t k=first+1; k < tail; k++ ) {
+                magma_index_t w = q[k];
+                magma_index_t dw = ptr[w+1] - ptr[w];
+                magma_int_t l = k;
+                while ( l > first && ptr[q[l-1]+1] - ptr[q[l-1]] > dw ) {
+                    q[l] = q[l-1];
+                    l--;
+                }
+                q[l] = w;
+            }
+        }
+    }
+    *nlevels = level[ q[tail-1] ] + 1;
+    return tail;
+}
+
+
+/*
+    George-Liu search for a pseudo-peripheral vertex of the subgraph
+    containing root: restart the search from a vertex of minimum degree
+    in the last level as long as the number of levels grows.
+    On return, q and level hold the level structure rooted in the returned
+    vertex, with cnt vertices in nlevels levels.
+*/
+static magma_index_t
+magma_zmreorder_peripheral(
+    magma_index_t root,
+    const magma_index_t *ptr,
+    const magma_index_t *adj,
+    const magma_index_t *label,
+    magma_index_t lab,
+    magma_index_t *level,
+    magma_index_t *q,
+    magma_int_t *cnt,
+    magma_int_t *nlevels )
+{
+    magma_int_t nlevels_new;
+    *cnt = magma_zmreorder_bfs( root, ptr, adj, label, lab, level, q, 0, nlevels );
+    for( magma_int_t sweep=0; sweep < MAGMA_PERIPHERAL_SWEEPS; sweep++ ) {
+        magma_index_t x = q[*cnt-1];
+        for( magma_int_t k=*cnt-1; k >= 0 && level[q[k]] == *nlevels-1; k-- ) {
+            if ( ptr[q[k]+1] - ptr[q[k]] < ptr[x+1] - ptr[x] )
+                x = q[k];
+        }
+        for( magma_int_t k=0; k < *cnt; k++ ) {
+            level[ q[k] ] = -1;
+        }
+        *cnt = magma_zmreorder_bfs( x, ptr, adj, label, lab,
+                                    level, q, 0, &nlevels_new );
+        root = x;
+        // x is as eccentric as the previous root, stop if it is not more
+        if ( nlevels_new <= *nlevels )
+            break;
+        *nlevels = nlevels_new;
+    }
+    return root;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the reverse Cuthill-McKee ordering of the graph of A + A^T.
+    Every connected component is traversed breadth-first from a
+    pseudo-peripheral vertex, the neighbors of a vertex are visited by
+    increasing degree. The matrix P A P^T with P given by perm typically
+    has a much smaller bandwidth than A.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix (CSR on the CPU, square)
+
+    @param[out]
+    perm        magma_index_t**
+                permutation: row i of P A P^T is row perm[i] of A
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmrcm(
+    magma_z_matrix A,
+    magma_index_t **perm,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+    magma_int_t maxdeg = 0, k = 0, next = 0;
+
+    magma_index_t *ptr = NULL, *adj = NULL, *label = NULL, *level = NULL;
+    magma_index_t *bydeg = NULL, *count = NULL, *p = NULL;
+
+    if ( A.memory_location != Magma_CPU || A.storage_type != Magma_CSR
+         || A.num_rows != A.num_cols ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( magma_zmreorder_graph( A, &ptr, &adj, queue ));
+    CHECK( magma_index_malloc_cpu( &label, n ));
+    CHECK( magma_index_malloc_cpu( &level, n ));
+    CHECK( magma_index_malloc_cpu( &bydeg, n ));
+    CHECK( magma_index_malloc_cpu( &p, n ));
+
+    #pragma omp parallel for reduction(max:maxdeg)
+    for( magma_int_t i=0; i < n; i++ ) {
+        label[i] = 0;
+        level[i] = -1;
+        maxdeg = max( maxdeg, ptr[i+1] - ptr[i] );
+    }
+
+    // vertices by increasing degree, the start vertices of the components
+    CHECK( magma_index_malloc_cpu( &count, maxdeg+2 ));
+    for( magma_int_t d=0; d < maxdeg+2; d++ ) {
+        count[d] = 0;
+    }
+    for( magma_int_t i=0; i < n; i++ ) {
+        count[ ptr[i+1] - ptr[i] + 1 ]++;
+    }
+    for( magma_int_t d=0; d < maxdeg+1; d++ ) {
+        count[d+1] += count[d];
+    }
+    for( magma_int_t i=0; i < n; i++ ) {
+        bydeg[ count[ ptr[i+1] - ptr[i] ]++ ] = i;
+    }
+
+    while ( k < n ) {
+        while ( label[ bydeg[next] ] != 0 ) {
+            next++;
+        }
+        magma_int_t nlevels, cnt;
+        magma_index_t root = magma_zmreorder_peripheral( bydeg[next], ptr, adj,
+                                    label, 0, level, p+k, &cnt, &nlevels );
+        for( magma_int_t l=k; l < k+cnt; l++ ) {
+            level[ p[l] ] = -1;
+        }
+        cnt = magma_zmreorder_bfs( root, ptr, adj, label, 0,
+                                   level, p+k, 1, &nlevels );
+        for( magma_int_t l=k; l < k+cnt; l++ ) {
+            label[ p[l] ] = -1;
+            level[ p[l] ] = -1;
+        }
+        k += cnt;
+    }
+
+    // reverse
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n/2; i++ ) {
+        magma_index_t tmp = p[i];
+        p[i] = p[n-1-i];
+        p[n-1-i] = tmp;
+    }
+
+    *perm = p;
+    p = NULL;
+
+cleanup:
+    magma_free_cpu( ptr );
+    magma_free_cpu( adj );
+    magma_free_cpu( label );
+    magma_free_cpu( level );
+    magma_free_cpu( bydeg );
+    magma_free_cpu( count );
+    magma_free_cpu( p );
+    return info;
+}
+
+
+/*
+    Nested dissection of the subgraph v[start ... start+n-1], whose vertices
+    carry the label start. The subgraph is split along the median level of a
+    level structure rooted in a pseudo-peripheral vertex; the two halves
+    are ordered first, the separating level last. Disconnected subgraphs
+    are split into their components. The halves are processed as OpenMP
+    tasks, q[start ... start+n-1] is the workspace of this subgraph.
+*/
+static void
+magma_zmnd_dissect(
+    magma_index_t *v,
+    magma_int_t start,
+    magma_int_t n,
+    const magma_index_t *ptr,
+    const magma_index_t *adj,
+    magma_index_t *label,
+    magma_index_t *level,
+    magma_index_t *q,
+    magma_queue_t queue )
+{
+    magma_index_t lab = start;
+    magma_index_t *vs = v + start, *qs = q + start;
+    magma_int_t nlevels, cnt;
+
+    if ( n <= MAGMA_ND_LEAFSIZE ) {
+        std::sort( vs, vs + n );
+        return;
+    }
+
+    magma_index_t root = vs[0];
+    for( magma_int_t k=1; k < n; k++ ) {
+        if ( ptr[vs[k]+1] - ptr[vs[k]] < ptr[root+1] - ptr[root] )
+            root = vs[k];
+    }
+    root = magma_zmreorder_peripheral( root, ptr, adj, label, lab,
+                                       level, qs, &cnt, &nlevels );
+
+    if ( cnt < n ) {
+        // disconnected: order the components one after the other
+        magma_int_t next = 0;
+        while ( cnt < n ) {
+            while ( level[ vs[next] ] >= 0 ) {
+                next++;
+            }
+            cnt += magma_zmreorder_bfs( vs[next], ptr, adj, label, lab,
+                                        level, qs+cnt, 0, &nlevels );
+        }
+        magma_int_t first = 0;
+        for( magma_int_t k=0; k < n; k++ ) {
+            vs[k] = qs[k];
+            // a new component starts at level 0
+            if ( level[qs[k]] == 0 && k > 0 ) {
+                for( magma_int_t l=first; l < k; l++ ) {
+                    #pragma omp atomic write
+                    label[ vs[l] ] = start + first;
+                }
+                first = k;
+            }
+        }
+        for( magma_int_t l=first; l < n; l++ ) {
+            #pragma omp atomic write
+            label[ vs[l] ] = start + first;
+        }
+        for( magma_int_t k=0; k < n; k++ ) {
+            level[ vs[k] ] = -1;
+        }
+        first = 0;
+        for( magma_int_t k=1; k <= n; k++ ) {
+            if ( k == n || label[ vs[k] ] != label[ vs[first] ] ) {
+                magma_int_t size = k - first, sub = start + first;
+                #pragma omp task if( size > 16*MAGMA_ND_LEAFSIZE )
+                magma_zmnd_dissect( v, sub, size, ptr, adj, label, level, q, queue );
+                first = k;
+            }
+        }
+        return;
+    }
+
+    if ( nlevels < 3 ) {
+        for( magma_int_t k=0; k < n; k++ ) {
+            level[ qs[k] ] = -1;
+        }
+        std::sort( vs, vs + n );
+        return;
+    }
+
+    // separator: the first level that reaches half of the vertices
+    magma_int_t sep = 1;
+    for( magma_int_t k=0; k < n; k++ ) {
+        if ( 2*(k+1) >= n ) {
+            sep = level[ qs[k] ];
+            break;
+        }
+    }
+    sep = max( 1, min( sep, nlevels-2 ));
+
+    magma_int_t nleft = 0, nright = 0;
+    for( magma_int_t k=0; k < n; k++ ) {
+        magma_index_t l = level[ qs[k] ];
+        if ( l < sep )
+            nleft++;
+        else if ( l > sep )
+            nright++;
+    }
+    magma_int_t il = 0, ir = nleft, is = nleft + nright;
+    for( magma_int_t k=0; k < n; k++ ) {
+        magma_index_t w = qs[k];
+        magma_index_t l = level[w];
+        level[w] = -1;
+        if ( l < sep ) {
+            vs[il++] = w;
+        } else if ( l > sep ) {
+            vs[ir++] = w;
+            #pragma omp atomic write
+            label[w] = start + nleft;
+        } else {
+            vs[is++] = w;
+            #pragma omp atomic write
+            label[w] = -1;
+        }
+    }
+    std::sort( vs + nleft + nright, vs + n );
+
+    #pragma omp task if( nleft > 16*MAGMA_ND_LEAFSIZE )
+    magma_zmnd_dissect( v, start, nleft, ptr, adj, label, level, q, queue );
+    #pragma omp task if( nright > 16*MAGMA_ND_LEAFSIZE )
+    magma_zmnd_dissect( v, start+nleft, nright, ptr, adj, label, level, q, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes a nested dissection ordering of the graph of A + A^T by
+    recursive graph bisection: the vertices are split by the median level
+    of a breadth-first level structure, the two halves are ordered first
+    (recursively, in parallel) and the separator last. This limits the
+    fill-in of incomplete factorizations and exposes parallelism in the
+    factors.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix (CSR on the CPU, square)
+
+    @param[out]
+    perm        magma_index_t**
+                permutation: row i of P A P^T is row perm[i] of A
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmnd(
+    magma_z_matrix A,
+    magma_index_t **perm,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+
+    magma_index_t *ptr = NULL, *adj = NULL, *label = NULL, *level = NULL;
+    magma_index_t *q = NULL, *p = NULL;
+
+    if ( A.memory_location != Magma_CPU || A.storage_type != Magma_CSR
+         || A.num_rows != A.num_cols ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( magma_zmreorder_graph( A, &ptr, &adj, queue ));
+    CHECK( magma_index_malloc_cpu( &label, n ));
+    CHECK( magma_index_malloc_cpu( &level, n ));
+    CHECK( magma_index_malloc_cpu( &q, n ));
+    CHECK( magma_index_malloc_cpu( &p, n ));
+
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n; i++ ) {
+        label[i] = 0;
+        level[i] = -1;
+        p[i] = i;
+    }
+
+    #pragma omp parallel
+    #pragma omp single
+    magma_zmnd_dissect( p, 0, n, ptr, adj, label, level, q, queue );
+
+    *perm = p;
+    p = NULL;
+
+cleanup:
+    magma_free_cpu( ptr );
+    magma_free_cpu( adj );
+    magma_free_cpu( label );
+    magma_free_cpu( level );
+    magma_free_cpu( q );
+    magma_free_cpu( p );
+    return info;
+}
+
+
+static inline bool
+magma_zmreorder_colless(
+    const std::pair<magma_index_t, magmaDoubleComplex> &a,
+    const std::pair<magma_index_t, magmaDoubleComplex> &b )
+{
+    return a.first < b.first;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Applies a symmetric permutation: B = P A P^T, i.e. row i of B is row
+    perm[i] of A with the column indices renumbered accordingly. The rows
+    are permuted in parallel and sorted by column index.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix (CSR on the CPU, square)
+
+    @param[in]
+    perm        magma_index_t*
+                permutation, e.g. from magma_zmrcm or magma_zmnd
+
+    @param[out]
+    B           magma_z_matrix*
+                permuted matrix (CSR on the CPU)
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmpermute(
+    magma_z_matrix A,
+    magma_index_t *perm,
+    magma_z_matrix *B,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = A.num_rows;
+
+    magma_index_t *invperm = NULL;
+
+    if ( A.memory_location != Magma_CPU || A.storage_type != Magma_CSR
+         || A.num_rows != A.num_cols ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    magma_zmfree( B, queue );
+    B->ownership = MagmaTrue;
+    B->mapping = NULL;
+    B->lval = NULL;
+    B->storage_type = Magma_CSR;
+    B->memory_location = Magma_CPU;
+    B->fill_mode = MagmaFull;
+    B->sym = A.sym;
+    B->num_rows = A.num_rows;
+    B->num_cols = A.num_cols;
+    B->nnz = A.nnz;
+    B->true_nnz = A.nnz;
+
+    CHECK( magma_index_malloc_cpu( &invperm, n ));
+    CHECK( magma_index_malloc_cpu( &B->row, n+1 ));
+    CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
+    CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
+
+    #pragma omp parallel for
+    for( magma_int_t i=0; i < n; i++ ) {
+        invperm[ perm[i] ] = i;
+        B->row[i+1] = A.row[ perm[i]+1 ] - A.row[ perm[i] ];
+    }
+    B->row[0] = 0;
+    for( magma_int_t i=0; i < n; i++ ) {
+        B->row[i+1] += B->row[i];
+    }
+
+    #pragma omp parallel
+    {
+        std::vector< std::pair<magma_index_t, magmaDoubleComplex> > entries;
+        #pragma omp for schedule(dynamic,256)
+        for( magma_int_t i=0; i < n; i++ ) {
+            magma_index_t start = A.row[ perm[i] ], end = A.row[ perm[i]+1 ];
+            entries.resize( end - start );
+            for( magma_index_t j=start; j < end; j++ ) {
+                entries[j-start].first = invperm[ A.col[j] ];
+                entries[j-start].second = A.val[j];
+            }
+            std::sort( entries.begin(), entries.end(), magma_zmreorder_colless );
+            for( magma_index_t j=0; j < end-start; j++ ) {
+                B->col[ B->row[i]+j ] = entries[j].first;
+                B->val[ B->row[i]+j ] = entries[j].second;
+            }
+        }
+    }
+
+cleanup:
+    if ( info != 0 ) {
+        magma_zmfree( B, queue );
+    }
+    magma_free_cpu( invperm );
+    return info;
+}
+
+
+/*
+    y = P x (inverse = 0) or y = P^T x (inverse = 1) for every vector in x.
+    x and y may be the same object.
+*/
+static magma_int_t
+magma_zvpermute_template(
+    magma_z_matrix x,
+    magma_index_t *perm,
+    magma_int_t inverse,
+    magma_z_matrix *y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magmaDoubleComplex *tmp = NULL;
+    magma_z_matrix hx={Magma_CSR}, hy={Magma_CSR};
+
+    if ( x.memory_location == Magma_CPU ) {
+        magma_int_t n = x.num_rows, nvecs = x.num_cols;
+        // stride between consecutive rows and consecutive vectors
+        magma_int_t ldr = ( x.major == MagmaRowMajor ) ? nvecs : 1;
+        magma_int_t ldv = ( x.major == MagmaRowMajor ) ? 1 : n;
+
+        CHECK( magma_zmalloc_cpu( &tmp, n*nvecs ));
+        #pragma omp parallel for
+        for( magma_int_t i=0; i < n; i++ ) {
+            magma_int_t to = inverse ? perm[i] : i;
+            magma_int_t from = inverse ? i : perm[i];
+            for( magma_int_t k=0; k < nvecs; k++ ) {
+                tmp[ to*ldr + k*ldv ] = x.val[ from*ldr + k*ldv ];
+            }
+        }
+        magma_zmfree( y, queue );
+        *y = x;
+        y->ownership = MagmaTrue;
+        y->mapping = NULL;
+        y->lval = NULL;
+        y->val = tmp;
+        tmp = NULL;
+    }
+    else {
+        CHECK( magma_zmtransfer( x, &hx, x.memory_location, Magma_CPU, queue ));
+        CHECK( magma_zvpermute_template( hx, perm, inverse, &hy, queue ));
+        magma_zmfree( y, queue );
+        CHECK( magma_zmtransfer( hy, y, Magma_CPU, x.memory_location, queue ));
+    }
+
+cleanup:
+    magma_free_cpu( tmp );
+    magma_zmfree( &hx, queue );
+    magma_zmfree( &hy, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Permutes a (multi-)vector consistently with magma_zmpermute:
+    row i of y is row perm[i] of x. x and y may be the same object.
+
+    Arguments
+    ---------
+
+    @param[in]
+    x           magma_z_matrix
+                input vector
+
+    @param[in]
+    perm        magma_index_t*
+                permutation (on the CPU)
+
+    @param[out]
+    y           magma_z_matrix*
+                permuted vector
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zvpermute(
+    magma_z_matrix x,
+    magma_index_t *perm,
+    magma_z_matrix *y,
+    magma_queue_t queue )
+{
+    return magma_zvpermute_template( x, perm, 0, y, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Reverts magma_zvpermute: row perm[i] of y is row i of x, e.g. to map
+    the solution of the reordered system back to the original numbering.
+    x and y may be the same object.
+
+    Arguments
+    ---------
+
+    @param[in]
+    x           magma_z_matrix
+                input vector
+
+    @param[in]
+    perm        magma_index_t*
+                permutation (on the CPU)
+
+    @param[out]
+    y           magma_z_matrix*
+                vector in the original ordering
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zvunpermute(
+    magma_z_matrix x,
+    magma_index_t *perm,
+    magma_z_matrix *y,
+    magma_queue_t queue )
+{
+    return magma_zvpermute_template( x, perm, 1, y, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Reorders a matrix symmetrically with reverse Cuthill-McKee or nested
+    dissection. Matrices in other formats or in device memory are
+    converted to CSR on the CPU and back.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    A           magma_z_matrix*
+                input/output matrix
+
+    @param[in]
+    reordering  magma_reorder_t
+                reordering type (Magma_NOREORDER, Magma_RCM, Magma_ND)
+
+    @param[out]
+    perm        magma_index_t**
+                if not NULL, returns the permutation (on the CPU) for use in
+                magma_zvpermute and magma_zvunpermute; NULL if the
+                matrix was not reordered. Free with magma_free_cpu.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmreorder(
+    magma_z_matrix *A,
+    magma_reorder_t reordering,
+    magma_index_t **perm,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_index_t *p = NULL;
+    magma_z_matrix hA={Magma_CSR}, CSRA={Magma_CSR}, B={Magma_CSR};
+
+    if ( perm != NULL ) {
+        *perm = NULL;
+    }
+    if ( A->num_rows != A->num_cols && reordering != Magma_NOREORDER ) {
+        printf("%% warning: non-square matrix.\n");
+        printf("%% Fallback: no reordering.\n");
+        reordering = Magma_NOREORDER;
+    }
+    if ( reordering == Magma_NOREORDER ) {
+        goto cleanup;
+    }
+
+    if ( A->memory_location == Magma_CPU && A->storage_type == Magma_CSR ) {
+        if ( reordering == Magma_RCM ) {
+            CHECK( magma_zmrcm( *A, &p, queue ));
+        }
+        else if ( reordering == Magma_ND ) {
+            CHECK( magma_zmnd( *A, &p, queue ));
+        }
+        else {
+            printf( "%%error: reordering not supported.\n" );
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        CHECK( magma_zmpermute( *A, p, &B, queue ));
+        magma_zmfree( A, queue );
+        *A = B;
+        B.val = NULL;
+        B.row = NULL;
+        B.col = NULL;
+    }
+    else {
+        magma_storage_t A_storage = A->storage_type;
+        magma_location_t A_location = A->memory_location;
+        CHECK( magma_zmtransfer( *A, &hA, A->memory_location, Magma_CPU, queue ));
+        CHECK( magma_zmconvert( hA, &CSRA, hA.storage_type, Magma_CSR, queue ));
+
+        CHECK( magma_zmreorder( &CSRA, reordering, &p, queue ));
+
+        magma_zmfree( &hA, queue );
+        magma_zmfree( A, queue );
+        CHECK( magma_zmconvert( CSRA, &hA, Magma_CSR, A_storage, queue ));
+        CHECK( magma_zmtransfer( hA, A, Magma_CPU, A_location, queue ));
+    }
+
+    if ( perm != NULL ) {
+        *perm = p;
+        p = NULL;
+    }
+
+cleanup:
+    magma_free_cpu( p );
+    magma_zmfree( &hA, queue );
+    magma_zmfree( &CSRA, queue );
+    magma_zmfree( &B, queue );
+    return info;
+}
@@ -57,6 +57,8 @@ magma_zmtransfer(
     // make sure the target structure is empty
     magma_zmfree( B, queue );
     B->ownership = MagmaTrue;
+    B->mapping = NULL;
+    B->lval = NULL;
 
     // Initialize bufsize to -1; buf is not allocated; cuSparse handle is not created
     //B->bufsize = -1;
@@ -86,6 +88,10 @@ magma_zmtransfer(
     B->dtile_desc_offset = NULL;
     B->calibrator = NULL;
     B->dcalibrator = NULL;
+    B->delta_col = NULL;
+    B->delta_desc = NULL;
+    B->delta_ptr = NULL;
+    B->delta_base = NULL;
     
 
     // first case: copy matrix from host to device
@@ -366,6 +372,11 @@ magma_zmtransfer(
             // data transfer
             magma_zsetvector( A.num_rows * A.num_cols, A.val, 1, B->dval, 1, queue );
         }
+        //CSRDELTA-type: the compressed indices are only read on the CPU
+        else if ( A.storage_type == Magma_CSRDELTA ) {
+            printf("error: format not supported on the device, convert to CSR first.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
     }
 
     // second case: copy matrix from host to host
@@ -723,6 +734,56 @@ magma_zmtransfer(
                 B->val[i] = A.val[i];
             }
         }
+        //CSRDELTA-type
+        else if ( A.storage_type == Magma_CSRDELTA ) {
+            // fill in information for B
+            B->storage_type = A.storage_type;
+            B->memory_location = Magma_CPU;
+            B->sym = A.sym;
+            B->diagorder_type = A.diagorder_type;
+            B->fill_mode = A.fill_mode;
+            B->num_rows = A.num_rows;
+            B->num_cols = A.num_cols;
+            B->nnz = A.nnz; B->true_nnz = A.true_nnz;
+            B->max_nnz_row = A.max_nnz_row;
+            B->diameter = A.diameter;
+            magma_int_t numchunks = A.delta_ptr[ A.num_rows ];
+            // the chunks are stored in order, the last one ends delta_col
+            size_t bytes = 0;
+            for( magma_int_t i=A.num_rows-1; i >= 0 && bytes == 0; i-- ) {
+                if ( A.delta_ptr[i] < A.delta_ptr[i+1] ) {
+                    magma_uindex_t last = A.delta_desc[ numchunks-1 ];
+                    magma_int_t count = A.row[i+1] - A.row[i]
+                                        - (numchunks-1 - A.delta_ptr[i]) * MAGMA_CSRDELTA_CHUNK;
+                    bytes = 8 * ((size_t) (last >> 2) + magma_ceildiv( count << (last & 3), 8 ));
+                }
+            }
+            // memory allocation
+            CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
+            CHECK( magma_index_malloc_cpu( &B->row, A.num_rows + 1 ));
+            CHECK( magma_index_malloc_cpu( &B->delta_base, A.num_rows ));
+            CHECK( magma_index_malloc_cpu( &B->delta_ptr, A.num_rows + 1 ));
+            CHECK( magma_uindex_malloc_cpu( &B->delta_desc, numchunks ));
+            CHECK( magma_malloc_cpu( (void**) &B->delta_col, bytes ));
+            // data transfer
+            #pragma omp parallel for
+            for( magma_int_t i=0; i<A.nnz; i++ ) {
+                B->val[i] = A.val[i];
+            }
+            #pragma omp parallel for
+            for( magma_int_t i=0; i<A.num_rows; i++ ) {
+                B->row[i] = A.row[i];
+                B->delta_ptr[i] = A.delta_ptr[i];
+                B->delta_base[i] = A.delta_base[i];
+            }
+            B->row[A.num_rows] = A.row[A.num_rows];
+            B->delta_ptr[A.num_rows] = A.delta_ptr[A.num_rows];
+            #pragma omp parallel for
+            for( magma_int_t i=0; i<numchunks; i++ ) {
+                B->delta_desc[i] = A.delta_desc[i];
+            }
+            memcpy( B->delta_col, A.delta_col, bytes );
+        }
     }
 
     // third case: copy matrix from device to host
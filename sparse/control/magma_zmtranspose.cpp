@@ -295,6 +295,8 @@ magma_z_cucsrtranspose(
         B->nnz             = A.nnz;
         B->true_nnz = A.true_nnz;
         B->ownership = MagmaTrue;
+        B->mapping = NULL;
+        B->lval = NULL;
         if ( A.fill_mode == MagmaFull ) {
             B->fill_mode = MagmaFull;
         }
@@ -405,6 +407,8 @@ magma_zmtransposeconjugate(
         B->nnz             = A.nnz;
         B->true_nnz = A.true_nnz;
         B->ownership = MagmaTrue;
+        B->mapping = NULL;
+        B->lval = NULL;
         if ( A.fill_mode == MagmaFull ) {
             B->fill_mode = MagmaFull;
         }
@@ -10,112 +10,150 @@
 
 */
 #include <cstdlib>
+#include <algorithm>
 #include "magmasparse_internal.h"
-
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 /**
+ * Parallel scatter-based transpose engine shared by all CPU transposes.
+ *
+ * The nonzeros of A are split into nnz-balanced contiguous blocks, one per
+ * thread. Every block counts its columns into a private histogram; a column
+ * sweep turns the histograms into per-block write offsets and the row
+ * pointer of B. Each block then scatters its entries into slots no other
+ * block touches. As the blocks are ordered and each walks its rows in order,
+ * the column indices of B come out sorted without a post-sort.
+ *
+ * If rowidx is NULL the row of an entry is taken from A.row, otherwise from
+ * rowidx (the element order then has to be row-major for sorted output).
+ * B->row, B->col and B->val have to be allocated with n+1, A.nnz, and A.nnz
+ * elements, B->rowidx is filled with the new row index if not NULL.
+ *
  * op(from[i], to[i]);
  */
 template <typename Operator>
 inline magma_int_t
-magma_z_mtrans_template(
-    magma_z_matrix A, 
+magma_z_mtrans_scatter(
+    magma_z_matrix A,
+    const magma_index_t *rowidx,
+    magma_int_t n,
     magma_z_matrix *B,
     Operator op,
     magma_queue_t queue )
 {
     magma_int_t info = 0;
     
-    magma_index_t *linked_list;
-    magma_index_t *row_ptr;
-    magma_index_t *last_rowel;
-    
-    // magma_int_t num_threads;
-    // magma_int_t el_per_block;
-    magma_zmfree( B, queue );
-    B->ownership = MagmaTrue;
+    magma_index_t *hist = NULL;
+    magma_int_t num_threads = 1, parts;
+    magma_int_t nnz = A.nnz;
     
-    B->storage_type = A.storage_type;
-    B->memory_location = A.memory_location;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    // keep the histograms in the order of the matrix size
+    parts = max( (magma_int_t) 1, min( num_threads, 4*(nnz+n)/(n+1) ) );
     
-    B->num_rows = A.num_rows;
-    B->num_cols = A.num_cols;
-    B->nnz      = A.nnz;
+    CHECK( magma_index_malloc_cpu( &hist, parts*(n+1) ));
     
-    CHECK( magma_index_malloc_cpu( &linked_list, A.nnz ));
-    CHECK( magma_index_malloc_cpu( &row_ptr, A.num_rows ));
-    CHECK( magma_index_malloc_cpu( &last_rowel, A.num_rows ));
-    CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &B->rowidx, A.nnz ));
-    CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
-    CHECK( magma_zmalloc_cpu( &B->val, A.nnz ) );
-    
-    magma_free_cpu( A.rowidx );
-    
-    CHECK( magma_zmatrix_addrowindex(&A, queue) );
-    
-    //#pragma omp parallel
-    // {
-    //     num_threads = omp_get_max_threads();
-    // }
-    
-    //#pragma omp parallel for
-    for( magma_int_t i=0; i<A.num_rows; i++ ){
-        row_ptr[i] = -1;
+    // column histogram of every block
+    #pragma omp parallel for schedule(static,1)
+    for( magma_int_t p=0; p<parts; p++ ){
+        magma_index_t *h = hist + p*(n+1);
+        magma_int_t lo = (magma_int_t)( (int64_t) nnz*p/parts );
+        magma_int_t hi = (magma_int_t)( (int64_t) nnz*(p+1)/parts );
+        for( magma_int_t c=0; c<n; c++ ){
+            h[c] = 0;
+        }
+        for( magma_int_t k=lo; k<hi; k++ ){
+            h[ A.col[k] ]++;
+        }
     }
-    //#pragma omp parallel for
-    for( magma_int_t i=0; i<A.num_rows+1; i++ ){
-        B->row[i] = 0;
+    
+    // exclusive offsets of every block within its column
+    #pragma omp parallel for
+    for( magma_int_t c=0; c<n; c++ ){
+        magma_index_t sum = 0;
+        for( magma_int_t p=0; p<parts; p++ ){
+            magma_index_t cnt = hist[ p*(n+1)+c ];
+            hist[ p*(n+1)+c ] = sum;
+            sum += cnt;
+        }
+        B->row[c+1] = sum;
     }
+    B->row[0] = 0;
+    CHECK( magma_zmatrix_createrowptr( n, B->row, queue ));
     
-    //el_per_block = magma_ceildiv( A.num_rows, num_threads );
-
-    //#pragma omp parallel
-    {
-        // magma_int_t id = omp_get_thread_num();
-        for(magma_int_t i=0; i<A.nnz; i++ ){
-            magma_index_t row = A.col[ i ];
-            //if( (row < (id+1)*el_per_block) && (row >=(id)*el_per_block)  ){
-            {
-                if( row_ptr[row] == -1 ){
-                    row_ptr[ row ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                } else {
-                    linked_list[ last_rowel[ row ] ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
+    // conflict-free scatter
+    #pragma omp parallel for schedule(static,1)
+    for( magma_int_t p=0; p<parts; p++ ){
+        magma_index_t *h = hist + p*(n+1);
+        magma_int_t lo = (magma_int_t)( (int64_t) nnz*p/parts );
+        magma_int_t hi = (magma_int_t)( (int64_t) nnz*(p+1)/parts );
+        magma_int_t row = 0;
+        if( rowidx == NULL ){
+            row = std::upper_bound( A.row, A.row+A.num_rows+1, 
+                                    (magma_index_t) lo ) - A.row - 1;
+        }
+        for( magma_int_t k=lo; k<hi; k++ ){
+            if( rowidx == NULL ){
+                while( A.row[row+1] <= k ){
+                    row++;
                 }
-                B->row[row+1] = B->row[row+1] + 1;
+            } else {
+                row = rowidx[k];
+            }
+            magma_index_t c = A.col[k];
+            magma_index_t el = B->row[c] + h[c]++;
+            op(A.val[k], B->val[el]);
+            B->col[el] = row;
+            if( B->rowidx != NULL ){
+                B->rowidx[el] = c;
             }
         }
     }
     
-    // new rowptr
-    B->row[0]=0;   
-    magma_zmatrix_createrowptr( B->num_rows, B->row, queue );
-    
+cleanup:
+    magma_free_cpu( hist );
+    return info;
+}
+
 
-    assert( B->row[B->num_rows] == A.nnz );
+/**
+ * CSR transpose of A into B, B gets A.num_cols rows.
+ */
+template <typename Operator>
+inline magma_int_t
+magma_z_mtrans_template(
+    magma_z_matrix A, 
+    magma_z_matrix *B,
+    Operator op,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
     
-    //#pragma omp parallel for
-    for( magma_int_t row=0; row<A.num_rows; row++){
-        magma_int_t el = row_ptr[row];
-        if( el>-1 ) {
-            for( magma_int_t i=B->row[row]; i<B->row[row+1]; i++ ){
-                op(A.val[el], B->val[i]);
-                B->col[i] = A.rowidx[el];
-                el = linked_list[el];
-            }
-        }
-    }
+    magma_zmfree( B, queue );
+    B->ownership = MagmaTrue;
+    B->mapping = NULL;
+    B->lval = NULL;
+    
+    B->storage_type = A.storage_type;
+    B->memory_location = A.memory_location;
+    
+    B->num_rows = A.num_cols;
+    B->num_cols = A.num_rows;
+    B->nnz      = A.nnz;
+    
+    B->rowidx = NULL;
+    CHECK( magma_index_malloc_cpu( &B->row, B->num_rows+1 ));
+    CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
+    CHECK( magma_zmalloc_cpu( &B->val, A.nnz ) );
+    
+    CHECK( magma_z_mtrans_scatter( A, NULL, B->num_rows, B, op, queue ));
     
 cleanup:
-    magma_free_cpu( row_ptr );
-    magma_free_cpu( last_rowel );
-    magma_free_cpu( linked_list );
-    magma_free_cpu( A.rowidx );
     return info;
 }
 
@@ -276,3 +314,56 @@ cleanup:
 }
 
 
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Transposes a matrix that already contains rowidx. The entries are read
+    in storage order using rowidx, the row pointer of A is not accessed.
+    B gets the row pointer, rowidx, and (for row-major ordered A) sorted 
+    column indices.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                Matrix to transpose.
+                
+    @param[out]
+    B           magma_z_matrix*
+                Transposed matrix.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zcsrcoo_transpose(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_queue_t queue)
+{
+    magma_int_t info = 0;
+    
+    B->storage_type = A.storage_type;
+    B->memory_location = A.memory_location;
+    
+    B->num_rows = A.num_rows;
+    B->num_cols = A.num_cols;
+    B->nnz      = A.nnz;
+    
+    CHECK(magma_index_malloc_cpu(&B->row, A.num_rows+1));
+    CHECK(magma_index_malloc_cpu(&B->rowidx, A.nnz));
+    CHECK(magma_index_malloc_cpu(&B->col, A.nnz));
+    CHECK(magma_zmalloc_cpu(&B->val, A.nnz));
+    
+    CHECK(magma_z_mtrans_scatter(A, A.rowidx, B->num_rows, B, cpy, queue));
+    
+cleanup:
+    return info;
+}
@@ -51,16 +51,13 @@ magma_zparic_sweep(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    int i, j;
-
-
     magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
-    int il, iu, jl, ju;
 
     #pragma omp parallel for
     for (int k=0; k < A.nnz; k++) {
-        i = A.rowidx[k];
-        j = A.col[k];
+        int i = A.rowidx[k];
+        int j = A.col[k];
+        int il, iu, jl, ju;
 
         magmaDoubleComplex s, sp;
         s =  A.val[k];
@@ -128,16 +125,15 @@ magma_zparic_sweep_sync(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    int i, j;
-    int il, iu, jl, ju;
     magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
     magmaDoubleComplex *L_new_val = NULL, *val_swap = NULL;
     CHECK( magma_zmalloc_cpu( &L_new_val, L->nnz ));
     
     #pragma omp parallel for
     for (int k=0; k < A.nnz; k++) {
-        i = A.rowidx[k];
-        j = A.col[k];
+        int i = A.rowidx[k];
+        int j = A.col[k];
+        int il, iu, jl, ju;
         
         magmaDoubleComplex s, sp;
         s =  A.val[k];
@@ -177,3 +173,219 @@ cleanup:
     
     return info;
 }
+
+
+/*
+    One in-place sweep over the nonzeros begin..end-1 of A, returns the sum of
+    the squared residuals seen before the updates.
+*/
+static double
+magma_zparic_sweep_block(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_int_t begin,
+    magma_int_t end )
+{
+    double local = 0.0;
+    for (magma_int_t k=begin; k < end; k++) {
+        magma_index_t i = A.rowidx[k];
+        magma_index_t j = A.col[k];
+        magma_int_t il = L->row[i];
+        magma_int_t iu = L->row[j];
+        magmaDoubleComplex s = A.val[k];
+        magmaDoubleComplex sp = MAGMA_Z_ZERO;
+
+        while (il < L->row[i+1] && iu < L->row[j+1])
+        {
+            sp = MAGMA_Z_ZERO;
+            magma_index_t jl = L->col[il];
+            magma_index_t ju = L->col[iu];
+
+            // avoid branching
+            sp = ( jl == ju ) ? L->val[il] * L->val[iu] : sp;
+            s = ( jl == ju ) ? s-sp : s;
+            il = ( jl <= ju ) ? il+1 : il;
+            iu = ( jl >= ju ) ? iu+1 : iu;
+        }
+        // before undoing the last operation, s is the residual
+        local += MAGMA_Z_REAL( s * MAGMA_Z_CONJ( s ) );
+        s += sp;
+
+        if ( i > j )      // modify l entry
+            L->val[il-1] =  s / L->val[L->row[j+1]-1];
+        else {            // modify u entry
+            L->val[iu-1] = MAGMA_Z_MAKE( sqrt( fabs( MAGMA_Z_REAL(s) )), 0.0 );
+        }
+    }
+    return local;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    This function runs asynchronous ParIC sweeps without global
+    synchronization, see magma_zparilu_sweep_async. Every thread keeps
+    updating its block of nonzeros in place and tracks the local nonlinear
+    residual A - LL^T. All threads stop as soon as the sum of the published
+    local residuals, all measured after the last notable change of the
+    factor, drops below rtol * ||A||_F, or once every thread has done
+    maxsweeps sweeps.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                System matrix in COO.
+
+    @param[in,out]
+    L           magma_z_matrix*
+                Current approximation for the lower triangular factor
+                The format is sorted CSR.
+
+    @param[in]
+    maxsweeps   magma_int_t
+                Number of sweeps after which a thread may stop without
+                convergence.
+
+    @param[in]
+    rtol        double
+                Relative tolerance for the nonlinear residual.
+
+    @param[out]
+    sweeps      magma_int_t*
+                Largest number of sweeps done by one thread.
+
+    @param[out]
+    res         double*
+                Estimate of ||A - LL^T||_F / ||A||_F on the pattern of A.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+*******************************************************************************/
+
+
+extern "C" magma_int_t
+magma_zparic_sweep_async(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_int_t maxsweeps,
+    double rtol,
+    magma_int_t *sweeps,
+    double *res,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t num_threads = 1, converged = 0, finished = 0, maxdone = 0;
+    magma_int_t epoch = 0;
+    double nrmA = 0.0, sum = 0.0, tol;
+    double *partres = NULL;
+    magma_int_t *partepoch = NULL;
+
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    CHECK( magma_dmalloc_cpu( &partres, num_threads ));
+    CHECK( magma_imalloc_cpu( &partepoch, num_threads ));
+    for (magma_int_t t=0; t < num_threads; t++) {
+        partres[t] = -1.0; // nothing reported yet
+        partepoch[t] = -1;
+    }
+
+    #pragma omp parallel for reduction(+:nrmA)
+    for (magma_int_t k=0; k < A.nnz; k++) {
+        nrmA += MAGMA_Z_REAL( A.val[k] * MAGMA_Z_CONJ( A.val[k] ) );
+    }
+    tol = rtol * rtol * nrmA;
+
+    #pragma omp parallel reduction(max:maxdone)
+    {
+        magma_int_t nthreads = 1, t = 0;
+#ifdef _OPENMP
+        nthreads = omp_get_num_threads();
+        t = omp_get_thread_num();
+#endif
+        magma_int_t begin = t * A.nnz / nthreads;
+        magma_int_t end = (t+1) * A.nnz / nthreads;
+
+        for (magma_int_t sweep=0; maxsweeps > 0; sweep++) {
+            magma_int_t stop, done, start, now, oldest;
+            double local, global = 0.0;
+            #pragma omp atomic read seq_cst
+            start = epoch;
+            local = magma_zparic_sweep_block( A, L, begin, end );
+            maxdone = sweep+1;
+
+            // A sweep that still changed its block notably starts a new
+            // epoch: the residuals published in sweeps that started before
+            // it may be stale, as they did not see the new values.
+            if ( local > tol / nthreads ) {
+                #pragma omp atomic seq_cst
+                epoch++;
+            }
+            #pragma omp atomic write seq_cst
+            partres[t] = local;
+            #pragma omp atomic write seq_cst
+            partepoch[t] = start;
+            oldest = start;
+            for (magma_int_t q=0; q < nthreads; q++) {
+                double r;
+                magma_int_t e;
+                #pragma omp atomic read seq_cst
+                e = partepoch[q];
+                #pragma omp atomic read seq_cst
+                r = partres[q];
+                if ( r < 0.0 ) {
+                    global = -1.0;
+                    break;
+                }
+                oldest = ( e < oldest ) ? e : oldest;
+                global += r;
+            }
+            #pragma omp atomic read seq_cst
+            now = epoch;
+            // converged only if all residuals are from the current epoch
+            if ( global >= 0.0 && global <= tol && oldest == now ) {
+                #pragma omp atomic write
+                converged = 1;
+            }
+            // A thread that used up its sweeps keeps going while the others
+            // are still updating.
+            if ( sweep+1 == maxsweeps ) {
+                #pragma omp atomic
+                finished++;
+            }
+            #pragma omp atomic read
+            stop = converged;
+            #pragma omp atomic read
+            done = finished;
+            if ( stop || ( sweep+1 >= maxsweeps && done == nthreads ) ) {
+                break;
+            }
+        }
+
+        // Threads leave the loop at different times, so the blocks of the
+        // first ones may not have seen the last updates of the others.
+        // After the only barrier, every thread does one more sweep.
+        #pragma omp barrier
+        if ( maxsweeps > 0 ) {
+            partres[t] = magma_zparic_sweep_block( A, L, begin, end );
+            maxdone = maxdone+1;
+        }
+    }
+
+    for (magma_int_t t=0; t < num_threads; t++) {
+        sum += ( partres[t] > 0.0 ) ? partres[t] : 0.0;
+    }
+    *sweeps = maxdone;
+    *res = ( nrmA > 0.0 ) ? sqrt( sum / nrmA ) : 0.0;
+
+cleanup:
+    magma_free_cpu( partres );
+    magma_free_cpu( partepoch );
+    return info;
+}
@@ -1141,8 +1141,8 @@ cleanup:
 /***************************************************************************//**
     Purpose
     -------
-    Transposes a matrix that already contains rowidx. The idea is to use a 
-    linked list.
+    Transposes a matrix that already contains rowidx. Same as 
+    magma_zcsrcoo_transpose.
 
     Arguments
     ---------
@@ -1168,98 +1168,7 @@ magma_zparilut_transpose(
     magma_z_matrix *B,
     magma_queue_t queue )
 {
-    magma_int_t info = 0;
-    magma_index_t *linked_list;
-    magma_index_t *row_ptr;
-    magma_index_t *last_rowel;
-    
-    magma_int_t el_per_block, num_threads=1;
-    
-    B->storage_type = A.storage_type;
-    B->memory_location = A.memory_location;
-    
-    B->num_rows = A.num_rows;
-    B->num_cols = A.num_cols;
-    B->nnz      = A.nnz;
-    
-    CHECK( magma_index_malloc_cpu( &linked_list, A.nnz ));
-    CHECK( magma_index_malloc_cpu( &row_ptr, A.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &last_rowel, A.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
-    CHECK( magma_index_malloc_cpu( &B->rowidx, A.nnz ));
-    CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
-    CHECK( magma_zmalloc_cpu( &B->val, A.nnz ) );
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-    
-    #pragma omp parallel for
-    for( magma_int_t i=0; i<A.num_rows; i++ ){
-        row_ptr[i] = -1;
-    }
-    #pragma omp parallel for
-    for( magma_int_t i=0; i<A.num_rows+1; i++ ){
-        B->row[i] = 0;
-    }
-    
-    el_per_block = magma_ceildiv( A.num_rows, num_threads );
-
-    #pragma omp parallel
-    {
-#ifdef _OPENMP
-    magma_int_t id = omp_get_thread_num();
-#else
-    magma_int_t id = 0;
-#endif
-        for(magma_int_t i=0; i<A.nnz; i++ ){
-            magma_index_t row = A.col[ i ];
-            if( (row < (id+1)*el_per_block) && (row >=(id)*el_per_block)  ){
-                if( row_ptr[row] == -1 ){
-                    row_ptr[ row ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                } else {
-                    linked_list[ last_rowel[ row ] ] = i;
-                    linked_list[ i ] = 0;
-                    last_rowel[ row ] = i;
-                }
-                B->row[row+1] = B->row[row+1] + 1;
-            }
-        }
-    }
-    
-    // new rowptr
-    B->row[0]=0;   
-    magma_zmatrix_createrowptr( B->num_rows, B->row, queue );
-    
-
-    assert( B->row[B->num_rows] == A.nnz );
-    
-    #pragma omp parallel for
-    for( magma_int_t row=0; row<A.num_rows; row++){
-        magma_int_t el = row_ptr[row];
-        if( el>-1 ) {
-            
-            for( magma_int_t i=B->row[row]; i<B->row[row+1]; i++ ){
-                // assert(A.col[el] == row);
-                B->val[i] = A.val[el];
-                B->col[i] = A.rowidx[el];
-                B->rowidx[i] = row;
-                el = linked_list[el];
-            }
-        }
-    }
-    
-cleanup:
-    magma_free_cpu( row_ptr );
-    magma_free_cpu( last_rowel );
-    magma_free_cpu( linked_list );
-    return info;
+    return magma_zcsrcoo_transpose( A, B, queue );
 }
 
 
@@ -4579,22 +4488,14 @@ magma_zparilut_set_thrs_randomselect(
     magma_int_t info = 0;
     
     magma_int_t size =  LU->nnz;
-    const magma_int_t incx = 1;
-    // copy as we may change the elements
-    magmaDoubleComplex *val=NULL;
-    CHECK( magma_zmalloc_cpu( &val, size ));
     assert( size > num_rm );
-    blasf77_zcopy(&size, LU->val, &incx, val, &incx );
     if( order == 0 ){
-        magma_zselectrandom( val, size, num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[num_rm]);
+        CHECK( magma_zsampleselect_cpu( size, num_rm, LU->val, thrs, queue ));
     } else {
-         magma_zselectrandom( val, size, size-num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
+        CHECK( magma_zsampleselect_cpu( size, size-num_rm, LU->val, thrs, queue ));
     }
 
 cleanup:
-    magma_free_cpu( val );
     return info;
 }
 
@@ -4647,22 +4548,14 @@ magma_zparilut_set_thrs_L_scaled(
     magma_int_t info = 0;
     
     magma_int_t size =  L->nnz;
-    const magma_int_t incx = 1;
-    // copy as we may change the elements
-    magmaDoubleComplex *val=NULL;
-    CHECK( magma_zmalloc_cpu( &val, size ));
     assert( size > num_rm );
-    blasf77_zcopy(&size, L->val, &incx, val, &incx );
     if( order == 0 ){
-        magma_zselectrandom( val, size, num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[num_rm]);
+        CHECK( magma_zsampleselect_cpu( size, num_rm, L->val, thrs, queue ));
     } else {
-         magma_zselectrandom( val, size, size-num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
+        CHECK( magma_zsampleselect_cpu( size, size-num_rm, L->val, thrs, queue ));
     }
 
 cleanup:
-    magma_free_cpu( val );
     return info;
 }
 
@@ -4711,41 +4604,14 @@ magma_zparilut_set_thrs_randomselect_approx2(
     magma_int_t info = 0;
     
     magma_int_t size =  LU->nnz;
-    const magma_int_t incx = 1;
-    magma_int_t incy = 1;
-    // magma_int_t nz_copy = LU->nnz;
-    // copy as we may change the elements
-    magmaDoubleComplex *val=NULL;
-    magma_int_t subset = num_rm *10;
-    if(LU->nnz <=subset){
-        CHECK( magma_zmalloc_cpu( &val, size ));
-        assert( size > num_rm );
-        blasf77_zcopy(&size, LU->val, &incx, val, &incx );
-        if( order == 0 ){
-            magma_zselectrandom( val, size, num_rm, queue );
-            *thrs = MAGMA_Z_ABS(val[num_rm]);
-        } else {
-             magma_zselectrandom( val, size, size-num_rm, queue );
-            *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
-        }
+    assert( size > num_rm );
+    if( order == 0 ){
+        CHECK( magma_zsampleselect_approx_cpu( size, num_rm, LU->val, thrs, queue ));
     } else {
-        incy = LU->nnz/subset;
-        size = subset;
-        magma_int_t num_rm_loc = 10;
-        assert( size > num_rm_loc );
-        CHECK( magma_zmalloc_cpu( &val, size ));
-        blasf77_zcopy(&size, LU->val, &incy, val, &incx );
-        if( order == 0 ){
-            magma_zselectrandom( val, size, num_rm_loc, queue );
-            *thrs = MAGMA_Z_ABS(val[num_rm_loc]);
-        } else {
-             magma_zselectrandom( val, size, size-num_rm_loc, queue );
-            *thrs = MAGMA_Z_ABS(val[size-num_rm_loc]);  
-        }
+        CHECK( magma_zsampleselect_approx_cpu( size, size-num_rm, LU->val, thrs, queue ));
     }
 
 cleanup:
-    magma_free_cpu( val );
     return info;
 }
 
@@ -4791,70 +4657,14 @@ magma_zparilut_set_thrs_randomselect_approx(
     magma_int_t info = 0;
     
     magma_int_t size =  LU->nnz;
-    const magma_int_t incx = 1;
-    //magma_int_t incy = 1;
-    //magma_int_t nz_copy = LU->nnz;
-    magma_int_t num_threads = 1;
-    magma_int_t el_per_block;
-    //magma_int_t num_rm_loc;
-    magmaDoubleComplex *dthrs;
-    magmaDoubleComplex *val;
-    
-
-    if( LU->nnz <= 680){
-       CHECK( magma_zparilut_set_thrs_randomselect(
-           num_rm,
-           LU,
-           order,
-           thrs,
-           queue ) );
+    assert( size > num_rm );
+    if( order == 0 ){
+        CHECK( magma_zsampleselect_approx_cpu( size, num_rm, LU->val, thrs, queue ));
     } else {
-        CHECK( magma_zmalloc_cpu( &val, size ));
-        blasf77_zcopy(&size, LU->val, &incx, val, &incx );
-        assert( size > num_rm );
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-        num_threads = 272;
-        CHECK( magma_zmalloc_cpu( &dthrs, num_threads ));
-        
-        
-        el_per_block = magma_ceildiv( LU->nnz, num_threads );
-        
-        #pragma omp parallel for
-        for( magma_int_t i=0; i<num_threads; i++ ){
-            magma_int_t start = min(i*el_per_block, size);
-            magma_int_t end = min((i+1)*el_per_block,LU->nnz);
-            magma_int_t loc_nz = end-start;
-            magma_int_t loc_rm = (int) (num_rm)/num_threads;
-            if( i == num_threads-1){
-                loc_rm = (int) (loc_nz * num_rm)/size;
-            }
-            if( loc_nz > loc_rm ){
-            if( order == 0 ){
-                magma_zselectrandom( val+start, loc_nz, loc_rm, queue );
-                dthrs[i] = val[start+loc_rm];
-            } else {
-                 magma_zselectrandom( val+start, loc_nz, loc_nz-loc_rm, queue );
-                dthrs[i] = val[start+loc_nz-loc_rm];  
-            }
-        }
-            
-        }
-        
-        // compute the median
-        magma_zselectrandom( dthrs, num_threads, (num_threads+1)/2, queue);
-        
-        *thrs = MAGMA_Z_ABS(dthrs[(num_threads+1)/2]);
+        CHECK( magma_zsampleselect_approx_cpu( size, size-num_rm, LU->val, thrs, queue ));
     }
+
 cleanup:
-    magma_free_cpu( val );
-    magma_free_cpu( dthrs );
     return info;
 }
 
@@ -4902,19 +4712,22 @@ magma_zparilut_set_thrs_randomselect_factors(
     magma_int_t info = 0;
     
     magma_int_t size =  L->nnz+U->nnz;
-    const magma_int_t incx = 1;
-    // copy as we may change the elements
+    // both factors in one array
     magmaDoubleComplex *val=NULL;
     CHECK( magma_zmalloc_cpu( &val, size ));
     assert( size > num_rm );
-    blasf77_zcopy(&L->nnz, L->val, &incx, val, &incx );
-    blasf77_zcopy(&U->nnz, U->val, &incx, val+L->nnz, &incx );
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<L->nnz; i++ ){
+        val[i] = L->val[i];
+    }
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<U->nnz; i++ ){
+        val[L->nnz+i] = U->val[i];
+    }
     if( order == 0 ){
-        magma_zselectrandom( val, size, num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[num_rm]);
+        CHECK( magma_zsampleselect_cpu( size, num_rm, val, thrs, queue ));
     } else {
-         magma_zselectrandom( val, size, size-num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
+        CHECK( magma_zsampleselect_cpu( size, size-num_rm, val, thrs, queue ));
     }
 
 cleanup:
@@ -12,9 +12,19 @@
 //  in this file, many routines are taken from
 //  the IO functions provided by MatrixMarket
 
+#include <algorithm>
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #define SWAP(a, b)  { tmp = a; a = b; b = tmp; }
 
+// host sample-select: sample size, number of buckets (fits an unsigned char
+// oracle), and the size below which the rank is selected directly
+#define MAGMA_SAMPLESELECT_SAMPLES 1024
+#define MAGMA_SAMPLESELECT_BUCKETS 256
+#define MAGMA_SAMPLESELECT_BASECASE 4096
+
 
 magma_int_t
 magma_zpartition( 
@@ -227,3 +237,276 @@ magma_zselectrandom(
     }
     return info;
 }
+
+
+
+/*
+    Host sample-select on the magnitudes in a (size m), returns the element of
+    rank k. Per level: equally spaced samples are sorted and give the bucket
+    splitters, every thread builds a histogram of its part and remembers the
+    bucket of each element, and only the bucket containing rank k is
+    collected for the next level. In approximate mode the bucket boundary
+    closest to rank k is returned after the first level.
+    a and tmp are used as ping-pong buffers, tmp is allocated with the size
+    of the first bucket.
+*/
+static magma_int_t
+magma_zsampleselect_abs_cpu(
+    double *a,
+    magma_int_t m,
+    magma_int_t k,
+    bool approx,
+    double *thrs,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    
+    const magma_int_t nb = MAGMA_SAMPLESELECT_BUCKETS;
+    const magma_int_t ns = MAGMA_SAMPLESELECT_SAMPLES;
+    double sample[MAGMA_SAMPLESELECT_SAMPLES];
+    double splitter[MAGMA_SAMPLESELECT_BUCKETS-1];
+    magma_int_t total[MAGMA_SAMPLESELECT_BUCKETS+1];
+    double *tmp = NULL, *cur = a, *other = NULL;
+    unsigned char *oracle = NULL;
+    magma_int_t *hist = NULL;
+    magma_int_t num_threads = 1;
+    
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+    CHECK( magma_malloc_cpu( (void**)&oracle, m ));
+    CHECK( magma_malloc_cpu( (void**)&hist, 
+                             num_threads*(nb+1)*sizeof(magma_int_t) ));
+    
+    while( m > MAGMA_SAMPLESELECT_BASECASE ){
+        magma_int_t bucket = 0, nthr = num_threads;
+        
+        // splitters from a sorted sample
+        for( magma_int_t i=0; i<ns; i++ ){
+            sample[i] = cur[ (int64_t) i*m/ns ];
+        }
+        std::sort( sample, sample+ns );
+        for( magma_int_t b=0; b<nb-1; b++ ){
+            splitter[b] = sample[ (b+1)*ns/nb ];
+        }
+        
+        // per-thread bucket histograms
+        #pragma omp parallel
+        {
+            magma_int_t id = 0;
+#ifdef _OPENMP
+            id = omp_get_thread_num();
+            #pragma omp single
+            nthr = omp_get_num_threads();
+#endif
+            magma_int_t *h = hist + id*(nb+1);
+            magma_int_t lo = (int64_t) m*id/nthr;
+            magma_int_t hi = (int64_t) m*(id+1)/nthr;
+            for( magma_int_t b=0; b<nb+1; b++ ){
+                h[b] = 0;
+            }
+            for( magma_int_t i=lo; i<hi; i++ ){
+                magma_int_t b = std::upper_bound( splitter, splitter+nb-1, 
+                                                  cur[i] ) - splitter;
+                oracle[i] = (unsigned char) b;
+                h[b]++;
+            }
+        }
+        
+        // bucket containing rank k
+        total[0] = 0;
+        for( magma_int_t b=0; b<nb; b++ ){
+            magma_int_t cnt = 0;
+            for( magma_int_t t=0; t<nthr; t++ ){
+                cnt += hist[ t*(nb+1)+b ];
+            }
+            total[b+1] = total[b] + cnt;
+        }
+        while( total[bucket+1] <= k ){
+            bucket++;
+        }
+        
+        if( approx ){
+            // closest bucket boundary, clamped to the sampled range
+            if( k-total[bucket] <= total[bucket+1]-k ){
+                *thrs = (bucket == 0) ? sample[0] : splitter[bucket-1];
+            } else {
+                *thrs = (bucket == nb-1) ? sample[ns-1] : splitter[bucket];
+            }
+            goto cleanup;
+        }
+        if( total[bucket+1]-total[bucket] == m ){
+            // no progress possible (many equal values)
+            break;
+        }
+        
+        // collect the bucket, every thread writes behind its predecessors
+        if( tmp == NULL ){
+            CHECK( magma_malloc_cpu( (void**)&tmp, 
+                        (total[bucket+1]-total[bucket])*sizeof(double) ));
+            other = tmp;
+        }
+        #pragma omp parallel for schedule(static,1)
+        for( magma_int_t id=0; id<nthr; id++ ){
+            magma_int_t lo = (int64_t) m*id/nthr;
+            magma_int_t hi = (int64_t) m*(id+1)/nthr;
+            magma_int_t pos = 0;
+            for( magma_int_t t=0; t<id; t++ ){
+                pos += hist[ t*(nb+1)+bucket ];
+            }
+            for( magma_int_t i=lo; i<hi; i++ ){
+                if( oracle[i] == bucket ){
+                    other[pos++] = cur[i];
+                }
+            }
+        }
+        k -= total[bucket];
+        m = total[bucket+1]-total[bucket];
+        other = cur;
+        cur = (cur == a) ? tmp : a;
+    }
+    
+    std::nth_element( cur, cur+k, cur+m );
+    *thrs = cur[k];
+    
+cleanup:
+    magma_free_cpu( oracle );
+    magma_free_cpu( hist );
+    magma_free_cpu( tmp );
+    return info;
+}
+
+
+/* magnitudes of val (parallel copy) and sample-select on them */
+static magma_int_t
+magma_zsampleselect_cpu_template(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    bool approx,
+    double *thrs,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    double *a = NULL;
+    
+    if( total_size <= 0 ){
+        *thrs = 0.0;
+        return info;
+    }
+    subset_size = max( (magma_int_t) 0, min( subset_size, total_size-1 ));
+    
+    CHECK( magma_dmalloc_cpu( &a, total_size ));
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<total_size; i++ ){
+        a[i] = MAGMA_Z_ABS( val[i] );
+    }
+    CHECK( magma_zsampleselect_abs_cpu( a, total_size, subset_size, approx, 
+                                        thrs, queue ));
+    
+cleanup:
+    magma_free_cpu( a );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects a threshold separating the subset_size smallest
+    magnitude elements from the rest on the host, i.e., the magnitude of the
+    element of rank subset_size (counting from 0). It is the host version of
+    magma_zsampleselect: parallel splitter sampling, per-thread bucket
+    histograms, and recursion into the bucket containing the rank only.
+    val is not modified.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_queue_t queue )
+{
+    return magma_zsampleselect_cpu_template( total_size, subset_size, val, 
+                                             false, thrs, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects an approximate threshold separating the subset_size
+    smallest magnitude elements from the rest on the host. Only one level of
+    sample-select is done and the bucket boundary closest to rank
+    subset_size is returned; the rank error is about 
+    total_size/MAGMA_SAMPLESELECT_BUCKETS. Small arrays are handled exactly.
+    val is not modified.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_queue_t queue )
+{
+    return magma_zsampleselect_cpu_template( total_size, subset_size, val, 
+                                             true, thrs, queue );
+}
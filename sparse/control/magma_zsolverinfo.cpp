@@ -11,6 +11,8 @@
 */
 #include "magmasparse_internal.h"
 
+#define PRECISION_z
+
 #define RTOLERANCE     lapackf77_dlamch( "E" )
 #define ATOLERANCE     lapackf77_dlamch( "E" )
 
@@ -18,7 +20,9 @@
     Purpose
     -------
 
-    Prints information about a previously called solver.
+    Prints information about a previously called solver. For the host
+    solvers, the summary ends with the per-phase counters, see
+    magma_zsolverinfo_phases.
 
     Arguments
     ---------
@@ -99,6 +103,26 @@ magma_zsolverinfo(
                 printf("%%   IDR(%lld) performance analysis every %lld iterations\n",
                         (long long) solver_par->restart, (long long) k );
                 break;
+            case Magma_CACG:
+                printf("%%   CA-CG(%lld) performance analysis every %lld iterations\n",
+                        (long long) solver_par->sstep, (long long) k );
+                break;
+            case Magma_CAGMRES:
+            case Magma_PCAGMRES:
+                printf("%%   CA-GMRES(%lld,%lld) performance analysis every %lld iterations\n",
+                        (long long) solver_par->restart, (long long) solver_par->sstep,
+                        (long long) k );
+                break;
+            case Magma_PIPECG:
+            case Magma_PPIPECG:
+                printf("%%   pipelined CG performance analysis every %lld iterations\n",
+                        (long long) k );
+                break;
+            case Magma_PIPEGMRES:
+            case Magma_PPIPEGMRES:
+                printf("%%   pipelined GMRES(%lld) performance analysis every %lld iterations\n",
+                        (long long) solver_par->restart, (long long) k );
+                break;
             case Magma_ITERREF:
                 printf("%%   Iterative refinement performance analysis every %lld iterations\n",
                         (long long) k );
@@ -284,6 +308,13 @@ magma_zsolverinfo(
             case Magma_JACOBI:
             case Magma_BAITER:
             case Magma_BAITERO:
+            case Magma_CACG:
+            case Magma_CAGMRES:
+            case Magma_PCAGMRES:
+            case Magma_PIPECG:
+            case Magma_PPIPECG:
+            case Magma_PIPEGMRES:
+            case Magma_PPIPEGMRES:
                 printf("%%   iter   ||   residual-nrm2    ||   runtime    ||   SpMV-count*  ||   info\n");
                 printf("%%=================================================================================%%\n");
                 for( int j=0; j<(solver_par->numiter)/k+1; j++ ) {
@@ -390,6 +421,32 @@ magma_zsolverinfo(
         case Magma_PQMRMERGE:
             printf("%% PQMR solver summary:\n");
             break;
+        case Magma_CACG:
+            printf("%% CA-CG(%lld) solver summary:\n",
+                    (long long) solver_par->sstep );
+            break;
+        case Magma_CAGMRES:
+            printf("%% CA-GMRES(%lld,%lld) solver summary:\n",
+                    (long long) solver_par->restart, (long long) solver_par->sstep );
+            break;
+        case Magma_PCAGMRES:
+            printf("%% PCA-GMRES(%lld,%lld) solver summary:\n",
+                    (long long) solver_par->restart, (long long) solver_par->sstep );
+            break;
+        case Magma_PIPECG:
+            printf("%% pipelined CG solver summary:\n");
+            break;
+        case Magma_PPIPECG:
+            printf("%% pipelined PCG solver summary:\n");
+            break;
+        case Magma_PIPEGMRES:
+            printf("%% pipelined GMRES(%lld) solver summary:\n",
+                    (long long) solver_par->restart );
+            break;
+        case Magma_PPIPEGMRES:
+            printf("%% pipelined PGMRES(%lld) solver summary:\n",
+                    (long long) solver_par->restart );
+            break;
         case Magma_ITERREF:
             printf("%% Iterative refinement solver summary:\n");
             break;
@@ -422,12 +479,296 @@ magma_zsolverinfo(
            "%%    runtime: %.4f sec\n",
             solver_par->final_res, solver_par->runtime);
     printf("%%    preconditioner runtime: %.4f sec\n", precond_par->runtime );
+    magma_zsolverinfo_phases( solver_par, queue );
 cleanup:
     printf("%%=================================================================================%%\n");
     return MAGMA_SUCCESS;
 }
 
 
+/*
+    Ticks of magma_sparse_cycles per second, measured once over 20 ms of
+    magma_wtime. Only called when the counters are reported.
+*/
+static double
+magma_sparse_cycles_rate( void )
+{
+    static double rate = 0.0;
+    if ( rate == 0.0 ) {
+        real_Double_t t0 = magma_wtime(), t1;
+        magma_sparse_cycles_t c0 = magma_sparse_cycles();
+        do {
+            t1 = magma_wtime();
+        } while ( t1 - t0 < 0.02 );
+        rate = (double)( magma_sparse_cycles() - c0 ) / ( t1 - t0 );
+    }
+    return rate;
+}
+
+static const char *magma_phase_names[ Magma_NUM_PHASES ] =
+    { "setup", "spmv", "precond", "ortho", "reduce" };
+
+/*
+    Writes "name": value, as null if value is not finite (diverged solver).
+*/
+static void
+magma_json_double( FILE *f, const char *name, double value )
+{
+    if ( isfinite( value ) ) {
+        fprintf( f, "  \"%s\": %.6e,\n", name, value );
+    } else {
+        fprintf( f, "  \"%s\": null,\n", name );
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Estimates the memory traffic and the floating point operations of one
+    call of each phase of a host solver, as added to the counters of
+    solver_par->phase by magma_sparse_phase:
+    cost[Magma_PHASE_SPMV]      one SpMV with A,
+    cost[Magma_PHASE_PRECOND]   one application of the preconditioner
+                                (left and right),
+    cost[Magma_PHASE_REDUCE]    one dot product of two vectors of length
+                                A.num_rows,
+    cost[Magma_PHASE_ORTHO]     orthogonalization of one vector of length
+                                A.num_rows against one basis vector
+                                (a dot product and an axpy),
+    cost[Magma_PHASE_SETUP]     zero, the setup is only timed.
+    The traffic counts every stored entry of A, with the value precision of
+    A.lval if present, and the index arrays once; the caches are assumed to
+    hold no vector across calls. The calls and cycles of cost are zero.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                system matrix
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                preconditioner, after its setup
+
+    @param[out]
+    cost        magma_solver_phase[Magma_NUM_PHASES]
+                estimated bytes and flops of one call per phase
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zsolverinfo_costs(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond_par,
+    magma_solver_phase *cost,
+    magma_queue_t queue )
+{
+    #if defined(PRECISION_z) || defined(PRECISION_c)
+    const double fma = 8.0;
+    #else
+    const double fma = 2.0;
+    #endif
+    const double vsize = sizeof(magmaDoubleComplex);
+    const double isize = sizeof(magma_index_t);
+    double n = A.num_rows, asize = vsize, pnnz = 0.0, prows = 0.0;
+    const magma_z_matrix *pm[3] = { &precond_par->M, &precond_par->L, &precond_par->U };
+
+    memset( cost, 0, Magma_NUM_PHASES*sizeof(magma_solver_phase) );
+    if ( A.lval != NULL ) {
+        asize = vsize * A.lval_bits / ( 8*sizeof(double) );
+    }
+    cost[Magma_PHASE_SPMV].bytes = A.nnz*( asize + isize ) + ( n+1 )*isize
+                                   + ( A.num_cols + n )*vsize;
+    cost[Magma_PHASE_SPMV].flops = fma*A.nnz;
+
+    if ( precond_par->solver != Magma_NONE && precond_par->solver != 0 ) {
+        // M (block-Jacobi), L and U (incomplete factorizations), d (Jacobi)
+        for( magma_int_t k=0; k < 3; k++ ) {
+            if ( pm[k]->val != NULL ) {
+                pnnz += pm[k]->nnz;
+                prows += pm[k]->num_rows + 1;
+            }
+        }
+        if ( precond_par->d.val != NULL ) {
+            pnnz += precond_par->d.nnz;
+        }
+        cost[Magma_PHASE_PRECOND].bytes = pnnz*( vsize + isize ) + prows*isize
+                                          + 4.0*n*vsize;
+        cost[Magma_PHASE_PRECOND].flops = fma*pnnz;
+    }
+    cost[Magma_PHASE_REDUCE].bytes = 2.0*n*vsize;
+    cost[Magma_PHASE_REDUCE].flops = fma*n;
+    cost[Magma_PHASE_ORTHO].bytes  = 5.0*n*vsize;
+    cost[Magma_PHASE_ORTHO].flops  = 2.0*fma*n;
+
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Prints the per-phase counters of a previously called host solver:
+    calls, time, share of the solver runtime, estimated memory traffic and
+    floating point operations, and the resulting bandwidth and flop rate.
+    The setup runs before the timed iteration, so it has no share; the
+    remainder of the runtime (vector updates, bookkeeping) is listed as
+    "other". Nothing is printed if the solver does not collect the
+    counters.
+
+    Arguments
+    ---------
+
+    @param[in]
+    solver_par  magma_z_solver_par*
+                structure containing all solver information
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zsolverinfo_phases(
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue )
+{
+    const magma_solver_phase *phase = solver_par->phase;
+    double rate, sec, other = solver_par->runtime;
+    magma_int_t calls = 0;
+
+    for( magma_int_t k=0; k < Magma_NUM_PHASES; k++ ) {
+        calls += phase[k].calls;
+    }
+    if ( calls == 0 ) {
+        return MAGMA_SUCCESS;
+    }
+    rate = magma_sparse_cycles_rate();
+    printf("%%    phase        calls     time [s]   share     GB/s    GFlop/s\n");
+    for( magma_int_t k=0; k < Magma_NUM_PHASES; k++ ) {
+        sec = phase[k].cycles / rate;
+        if ( k != Magma_PHASE_SETUP ) {
+            other -= sec;
+        }
+        printf("%%    %-8s  %8lld   %10.6f   ", magma_phase_names[k],
+                (long long) phase[k].calls, sec );
+        if ( k == Magma_PHASE_SETUP || solver_par->runtime <= 0.0 ) {
+            printf("    -");
+        } else {
+            printf("%4.0f%%", 100.0 * sec / solver_par->runtime );
+        }
+        printf("   %6.2f    %7.2f\n",
+                sec > 0.0 ? phase[k].bytes / sec / 1e9 : 0.0,
+                sec > 0.0 ? phase[k].flops / sec / 1e9 : 0.0 );
+    }
+    if ( solver_par->runtime > 0.0 ) {
+        printf("%%    %-8s  %8s   %10.6f   %4.0f%%\n", "other", "-",
+                max( other, 0.0 ), 100.0 * max( other, 0.0 ) / solver_par->runtime );
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Writes the summary and the per-phase counters of a previously called
+    solver as a JSON object, for scripts that collect the counters of many
+    runs. Times are in seconds, the cycles are the raw ticks of
+    magma_sparse_cycles, bytes and flops are estimates. The caller opens
+    the stream, so the objects of several solves can be written into one
+    JSON array.
+
+    Arguments
+    ---------
+
+    @param[in]
+    solver_par  magma_z_solver_par*
+                structure containing all solver information
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                structure containing all preconditioner information
+
+    @param[in]
+    matrix      const char*
+                name of the matrix, written as "matrix" if not NULL
+
+    @param[in]
+    f           FILE*
+                output stream, stdout if NULL
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zsolverinfo_json(
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    const char *matrix,
+    FILE *f,
+    magma_queue_t queue )
+{
+    const magma_solver_phase *phase = solver_par->phase;
+    double rate = magma_sparse_cycles_rate();
+
+    if ( f == NULL ) {
+        f = stdout;
+    }
+    fprintf( f, "{\n" );
+    if ( matrix != NULL ) {
+        // file names are written as they are, except for the characters
+        // that need an escape in a JSON string
+        fprintf( f, "  \"matrix\": \"" );
+        for( const char *c = matrix; *c != '\0'; c++ ) {
+            if ( *c == '"' || *c == '\\' ) {
+                fputc( '\\', f );
+            }
+            fputc( *c, f );
+        }
+        fprintf( f, "\",\n" );
+    }
+    fprintf( f, "  \"solver\": %lld,\n", (long long) solver_par->solver );
+    fprintf( f, "  \"precond\": %lld,\n", (long long) precond_par->solver );
+    fprintf( f, "  \"info\": %lld,\n", (long long) solver_par->info );
+    fprintf( f, "  \"iterations\": %lld,\n", (long long) solver_par->numiter );
+    fprintf( f, "  \"spmv_count\": %lld,\n", (long long) solver_par->spmv_count );
+    magma_json_double( f, "init_res", solver_par->init_res );
+    magma_json_double( f, "final_res", solver_par->final_res );
+    magma_json_double( f, "runtime", solver_par->runtime );
+    magma_json_double( f, "precond_setuptime", precond_par->setuptime );
+    magma_json_double( f, "precond_runtime", precond_par->runtime );
+    magma_json_double( f, "cycles_per_second", rate );
+    fprintf( f, "  \"phases\": {\n" );
+    for( magma_int_t k=0; k < Magma_NUM_PHASES; k++ ) {
+        fprintf( f, "    \"%s\": { \"calls\": %lld, \"cycles\": %llu, "
+                    "\"seconds\": %.6e, \"bytes\": %.6e, \"flops\": %.6e }%s\n",
+                 magma_phase_names[k], (long long) phase[k].calls, phase[k].cycles,
+                 phase[k].cycles / rate, phase[k].bytes, phase[k].flops,
+                 k+1 < Magma_NUM_PHASES ? "," : "" );
+    }
+    fprintf( f, "  }\n" );
+    fprintf( f, "}" );
+    return MAGMA_SUCCESS;
+}
+
+
 /**
     Purpose
     -------
@@ -525,6 +866,7 @@ magma_zsolverinfo_init(
     solver_par->timing = NULL;
     solver_par->eigenvectors = NULL;
     solver_par->eigenvalues = NULL;
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
 
     if( solver_par->maxiter == 0 )
         solver_par->maxiter = 1000;
@@ -532,6 +874,12 @@ magma_zsolverinfo_init(
         solver_par->version = 0;
     if( solver_par->restart == 0 )
         solver_par->restart = 30;
+    if( solver_par->sstep == 0 )
+        solver_par->sstep = 5;
+    if( solver_par->basis == 0 )
+        solver_par->basis = Magma_NEWTON;
+    if( solver_par->ortho == 0 )
+        solver_par->ortho = Magma_CGSO;
     if( solver_par->solver == 0 )
         solver_par->solver = Magma_CG;
 
@@ -609,6 +957,19 @@ magma_zsolverinfo_init(
     precond_par->L_dgraphindegree_bak = NULL;
     precond_par->U_dgraphindegree_bak = NULL;
 
+    precond_par->RA.val = NULL;
+    precond_par->RA.col = NULL;
+    precond_par->RA.row = NULL;
+    precond_par->RA.rowidx = NULL;
+    precond_par->RL.val = NULL;
+    precond_par->RL.col = NULL;
+    precond_par->RL.row = NULL;
+    precond_par->RUT.val = NULL;
+    precond_par->RUT.col = NULL;
+    precond_par->RUT.row = NULL;
+    precond_par->RA_map = NULL;
+    precond_par->RUT_map = NULL;
+
 cleanup:
     if( info != 0 ){
         magma_free( solver_par->timing );
@@ -26,24 +26,53 @@ static const char *usage_sparse =
 " --solver      Possibility to choose a solver:\n"
 "               CG, PCG, BICGSTAB, PBICGSTAB, GMRES, PGMRES, LOBPCG, JACOBI,\n"
 "               BAITER, IDR, PIDR, CGS, PCGS, TFQMR, PTFQMR, QMR, PQMR, BICG,\n"
-"               PBICG, BOMBARDMENT, ITERREF.\n"
+"               PBICG, BOMBARDMENT, ITERREF, CACG, CAGMRES, PCAGMRES,\n"
+"               PIPECG, PPIPECG, PIPEGMRES, PPIPEGMRES.\n"
 " --basic       Use non-optimized version\n"
 " --ev x        For eigensolvers, set number of eigenvalues/eigenvectors to compute.\n"
 " --restart     For GMRES: possibility to choose the restart.\n"
 "               For IDR: Number of distinct subspaces (1,2,4,8).\n"
+" --sstep x     For CACG, CAGMRES: number of basis vectors s per block (default 5).\n"
+" --basis       For CACG, CAGMRES: basis of the s-step blocks:\n"
+"               MONOMIAL   powers of A\n"
+"               NEWTON     powers of A shifted by Leja-ordered Ritz values (default)\n"
+" --ortho       For CAGMRES: block orthogonalization of the s-step blocks:\n"
+"               CGS        block classical Gram-Schmidt, twice (default)\n"
+"               FUSEDCGS   block classical Gram-Schmidt, once\n"
+"               MGS        block modified Gram-Schmidt\n"
 " --atol x      Set an absolute residual stopping criterion.\n"
 " --verbose x   Possibility to print intermediate residuals every x iteration.\n"
+" --profile f   Write the per-phase counters of the CPU solvers to f, as a JSON\n"
+"               array with one object per matrix.\n"
 " --maxiter x   Set an upper limit for the iteration count.\n"
 " --rtol x      Set a relative residual stopping criterion.\n"
 " --format      Possibility to choose a format for the sparse matrix:\n"
-"               CSR, ELL, SELLP, CUSPARSECSR, CSR5.\n"
+"               CSR, ELL, SELLP, CUSPARSECSR, CSR5, CSRDELTA (CPU only),\n"
+"               AUTO (CSR, ELL, SELLP or CSR5 chosen per matrix).\n"
+" --formattrials x  For AUTO: time x SpMVs per candidate format (0: model only).\n"
+" --formatcache f   For AUTO: cache the decisions in file f.\n"
 " --blocksize x Set a specific blocksize for SELL-P format.\n"
 " --alignment x Set a specific alignment for SELL-P format.\n"
 " --mscale      Possibility to scale the original matrix:\n"
 "               NOSCALE   no scaling\n"
 "               UNITDIAG   symmetric scaling to unit diagonal\n"
+" --mreorder    Possibility to reorder the original matrix symmetrically:\n"
+"               NOREORDER  no reordering\n"
+"               RCM        reverse Cuthill-McKee (bandwidth reduction)\n"
+"               ND         nested dissection (fill reduction)\n"
+" --location    Where the solver runs:\n"
+"               DEV        on the device (default)\n"
+"               CPU        on the host: CG, BICGSTAB, GMRES, IDR and their\n"
+"                          preconditioned variants, CACG, CAGMRES, PCAGMRES,\n"
+"                          PIPECG, PPIPECG, PIPEGMRES, PPIPEGMRES,\n"
+"                          with NONE, JACOBI, VBJACOBI,\n"
+"                          PARILU or PARILUT as preconditioner\n"
+" --valprec     Precision of the matrix values read by the CPU SpMV (CSR, SELLP):\n"
+"               DOUBLE     working precision\n"
+"               SINGLE     single precision, double accumulation\n"
+"               BF16       bfloat16, double accumulation\n"
 " --precond x   Possibility to choose a preconditioner:\n"
-"               CG, BICGSTAB, GMRES, LOBPCG, JACOBI,\n"
+"               CG, BICGSTAB, GMRES, LOBPCG, JACOBI, VBJACOBI,\n"
 "               BAITER, IDR, CGS, TFQMR, QMR, BICG\n"
 "               BOMBARDMENT, ITERREF, ILU, PARILU, PARILUT, NONE.\n"
 "                   --patol atol  Absolute residual stopping criterion for preconditioner.\n"
@@ -51,8 +80,10 @@ static const char *usage_sparse =
 "                   --piters k    Iteration count for iterative preconditioner.\n"
 "                   --plevels k   Number of ILU levels.\n"
 "                   --triolver k  Solver for triangular ILU factors: e.g. CUSOLVE, JACOBI, ISAI.\n"
-"                   --ppattern k  Pattern used for ISAI preconditioner.\n"
+"                   --ppattern k  Pattern used for ISAI preconditioner,\n"
+"                                 max. block size (<= 32) for VBJACOBI.\n"
 "                   --psweeps x   Number of iterative ParILU sweeps.\n"
+"                   --pvalprec x  Precision of the CPU ISAI matrices: DOUBLE, SINGLE, BF16.\n"
 " --trisolver   Possibility to choose a triangular solver for ILU preconditioning: \n"
 "               e.g. CUSOLVE, ISPTRSV, JACOBI, VBJACOBI, ISAI.\n"
 " --ppattern k  Possibility to choose a pattern for the trisolver: ISAI(k) or Block Jacobi.\n"
@@ -113,7 +144,14 @@ magma_zparse_opts(
     opts->output_format = Magma_CSR;
     opts->input_location = Magma_CPU;
     opts->output_location = Magma_CPU;
+    opts->compute_location = Magma_DEV;
     opts->scaling = Magma_NOSCALE;
+    opts->reordering = Magma_NOREORDER;
+    opts->lval_bits = 0;
+    opts->autoformat = 0;
+    opts->format_trials = 0;
+    opts->format_cache = NULL;
+    opts->profile_file = NULL;
     #if defined(PRECISION_z) | defined(PRECISION_d)
         opts->solver_par.atol = 1e-16;
         opts->solver_par.rtol = 1e-10;
@@ -125,6 +163,9 @@ magma_zparse_opts(
     opts->solver_par.verbose = 0;
     opts->solver_par.version = 0;
     opts->solver_par.restart = 50;
+    opts->solver_par.sstep = 5;
+    opts->solver_par.basis = Magma_NEWTON;
+    opts->solver_par.ortho = Magma_CGSO;
     opts->solver_par.num_eigenvalues = 0;
     opts->precond_par.solver = Magma_NONE;
     opts->precond_par.trisolver = Magma_CUSOLVE;
@@ -141,6 +182,7 @@ magma_zparse_opts(
     opts->precond_par.sweeps = 5;
     opts->precond_par.maxiter = 1;
     opts->precond_par.pattern = 1;
+    opts->precond_par.lval_bits = 0;
     opts->solver_par.solver = Magma_CGMERGE;
     
     printf( usage_sparse_short, argv[0] );
@@ -163,6 +205,10 @@ magma_zparse_opts(
                 opts->output_format = Magma_CUCSR;
             } else if ( strcmp("CSR5", argv[i]) == 0 ) {
                 opts->output_format = Magma_CSR5;
+            } else if ( strcmp("CSRDELTA", argv[i]) == 0 ) {
+                opts->output_format = Magma_CSRDELTA;
+            } else if ( strcmp("AUTO", argv[i]) == 0 ) {
+                opts->autoformat = 1;
             } else {
                 printf( "%%error: invalid format, use default (CSR).\n" );
             }
@@ -189,6 +235,48 @@ magma_zparse_opts(
             else {
                 printf( "%%error: invalid scaling, use default.\n" );
             }
+        } else if ( strcmp("--mreorder", argv[i]) == 0 && i+1 < argc ) {
+            i++;
+            if ( strcmp("NOREORDER", argv[i]) == 0 ) {
+                opts->reordering = Magma_NOREORDER;
+            }
+            else if ( strcmp("RCM", argv[i]) == 0 ) {
+                opts->reordering = Magma_RCM;
+            }
+            else if ( strcmp("ND", argv[i]) == 0 ) {
+                opts->reordering = Magma_ND;
+            }
+            else {
+                printf( "%%error: invalid reordering, use default.\n" );
+            }
+        } else if ( strcmp("--location", argv[i]) == 0 && i+1 < argc ) {
+            i++;
+            if ( strcmp("DEV", argv[i]) == 0 ) {
+                opts->compute_location = Magma_DEV;
+            }
+            else if ( strcmp("CPU", argv[i]) == 0 ) {
+                opts->compute_location = Magma_CPU;
+            }
+            else {
+                printf( "%%error: invalid location, use default (DEV).\n" );
+            }
+        } else if ( ( strcmp("--valprec", argv[i]) == 0 ||
+                      strcmp("--pvalprec", argv[i]) == 0 ) && i+1 < argc ) {
+            magma_int_t *bits = ( strcmp("--valprec", argv[i]) == 0 ) ?
+                                &opts->lval_bits : &opts->precond_par.lval_bits;
+            i++;
+            if ( strcmp("DOUBLE", argv[i]) == 0 ) {
+                *bits = 0;
+            }
+            else if ( strcmp("SINGLE", argv[i]) == 0 ) {
+                *bits = 32;
+            }
+            else if ( strcmp("BF16", argv[i]) == 0 ) {
+                *bits = 16;
+            }
+            else {
+                printf( "%%error: invalid value precision, use default.\n" );
+            }
         } else if ( strcmp("--solver", argv[i]) == 0 && i+1 < argc ) {
             i++;
             if ( strcmp("CG", argv[i]) == 0 ) {
@@ -263,11 +351,59 @@ magma_zparse_opts(
             else if ( strcmp("PARDISO", argv[i]) == 0 ) {
                 opts->solver_par.solver = Magma_PARDISO;
             }
+            else if ( strcmp("CACG", argv[i]) == 0 ) {
+                opts->solver_par.solver = Magma_CACG;
+            }
+            else if ( strcmp("CAGMRES", argv[i]) == 0 ) {
+                opts->solver_par.solver = Magma_PCAGMRES;
+            }
+            else if ( strcmp("PCAGMRES", argv[i]) == 0 ) {
+                opts->solver_par.solver = Magma_PCAGMRES;
+            }
+            else if ( strcmp("PIPECG", argv[i]) == 0 ) {
+                opts->solver_par.solver = Magma_PPIPECG;
+            }
+            else if ( strcmp("PPIPECG", argv[i]) == 0 ) {
+                opts->solver_par.solver = Magma_PPIPECG;
+            }
+            else if ( strcmp("PIPEGMRES", argv[i]) == 0 ) {
+                opts->solver_par.solver = Magma_PPIPEGMRES;
+            }
+            else if ( strcmp("PPIPEGMRES", argv[i]) == 0 ) {
+                opts->solver_par.solver = Magma_PPIPEGMRES;
+            }
             else {
                 printf( "%%error: invalid solver.\n" );
             }
         } else if ( strcmp("--restart", argv[i]) == 0 && i+1 < argc ) {
             opts->solver_par.restart = atoi( argv[++i] );
+        } else if ( strcmp("--sstep", argv[i]) == 0 && i+1 < argc ) {
+            opts->solver_par.sstep = atoi( argv[++i] );
+        } else if ( strcmp("--basis", argv[i]) == 0 && i+1 < argc ) {
+            i++;
+            if ( strcmp("MONOMIAL", argv[i]) == 0 ) {
+                opts->solver_par.basis = Magma_MONOMIAL;
+            }
+            else if ( strcmp("NEWTON", argv[i]) == 0 ) {
+                opts->solver_par.basis = Magma_NEWTON;
+            }
+            else {
+                printf( "%%error: invalid basis.\n" );
+            }
+        } else if ( strcmp("--ortho", argv[i]) == 0 && i+1 < argc ) {
+            i++;
+            if ( strcmp("CGS", argv[i]) == 0 ) {
+                opts->solver_par.ortho = Magma_CGSO;
+            }
+            else if ( strcmp("FUSEDCGS", argv[i]) == 0 ) {
+                opts->solver_par.ortho = Magma_FUSED_CGSO;
+            }
+            else if ( strcmp("MGS", argv[i]) == 0 ) {
+                opts->solver_par.ortho = Magma_MGSO;
+            }
+            else {
+                printf( "%%error: invalid orthogonalization.\n" );
+            }
         } else if ( strcmp("--precond", argv[i]) == 0 && i+1 < argc ) {
             i++;
             if ( strcmp("CG", argv[i]) == 0 ) {
@@ -300,6 +436,9 @@ magma_zparse_opts(
             else if ( strcmp("JACOBI", argv[i]) == 0 ) {
                 opts->precond_par.solver = Magma_JACOBI;
             }
+            else if ( strcmp("VBJACOBI", argv[i]) == 0 ) {
+                opts->precond_par.solver = Magma_VBJACOBI;
+            }
             else if ( strcmp("BA", argv[i]) == 0 ) {
                 opts->precond_par.solver = Magma_BAITER;
             }
@@ -427,6 +566,12 @@ magma_zparse_opts(
             opts->blocksize = atoi( argv[++i] );
         } else if ( strcmp("--alignment", argv[i]) == 0 && i+1 < argc ) {
             opts->alignment = atoi( argv[++i] );
+        } else if ( strcmp("--formattrials", argv[i]) == 0 && i+1 < argc ) {
+            opts->format_trials = atoi( argv[++i] );
+        } else if ( strcmp("--formatcache", argv[i]) == 0 && i+1 < argc ) {
+            opts->format_cache = argv[++i];
+        } else if ( strcmp("--profile", argv[i]) == 0 && i+1 < argc ) {
+            opts->profile_file = argv[++i];
         } else if ( strcmp("--verbose", argv[i]) == 0 && i+1 < argc ) {
             opts->solver_par.verbose = atoi( argv[++i] );
         }  else if ( strcmp("--maxiter", argv[i]) == 0 && i+1 < argc ) {
@@ -494,15 +639,20 @@ magma_zparse_opts(
             case  Magma_PIDR:               opts->solver_par.solver = Magma_IDR; break;          
             case  Magma_PIDRMERGE:          opts->solver_par.solver = Magma_IDRMERGE; break;     
             case  Magma_PGMRES:             opts->solver_par.solver = Magma_GMRES; break;        
+            case  Magma_PCAGMRES:           opts->solver_par.solver = Magma_CAGMRES; break;
+            case  Magma_PPIPECG:            opts->solver_par.solver = Magma_PIPECG; break;
+            case  Magma_PPIPEGMRES:         opts->solver_par.solver = Magma_PIPEGMRES; break;
             default:    break;
         }
     }
     
-    // ensure to take a symmetric preconditioner for the PCG
-    if ( ( opts->solver_par.solver == Magma_PCG || opts->solver_par.solver == Magma_PCGMERGE )
+    // ensure to take a symmetric preconditioner for the PCG and the pipelined CG
+    if ( ( opts->solver_par.solver == Magma_PCG || opts->solver_par.solver == Magma_PCGMERGE
+           || opts->solver_par.solver == Magma_PPIPECG )
         && opts->precond_par.solver == Magma_ILU )
             opts->precond_par.solver = Magma_ICC;
-    if ( ( opts->solver_par.solver == Magma_PCG || opts->solver_par.solver == Magma_PCGMERGE )
+    if ( ( opts->solver_par.solver == Magma_PCG || opts->solver_par.solver == Magma_PCGMERGE
+           || opts->solver_par.solver == Magma_PPIPECG )
         && opts->precond_par.solver == Magma_PARILU )
             opts->precond_par.solver = Magma_PARIC;
             
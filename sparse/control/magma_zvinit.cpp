@@ -63,6 +63,8 @@ magma_zvinit(
     // make sure the target structure is empty
     magma_zmfree( x, queue );
     x->ownership = MagmaTrue;
+    x->mapping = NULL;
+    x->lval = NULL;
     x->val = NULL;
     x->diag = NULL;
     x->row = NULL;
@@ -93,9 +95,8 @@ magma_zvinit(
     x->ld = num_rows;
     if ( mem_loc == Magma_CPU ) {
         CHECK( magma_zmalloc_cpu( &x->val, x->nnz ));
-        for( magma_int_t i=0; i<x->nnz; i++) {
-             x->val[i] = values;
-        }
+        // parallel first touch, see magma_zset_cpu
+        magma_zset_cpu( x->nnz, values, x->val, queue );
     }
     else if ( mem_loc == Magma_DEV ) {
         CHECK( magma_zmalloc( &x->val, x->nnz ));
@@ -155,6 +156,8 @@ magma_zvinit_rand(
     // make sure the target structure is empty
     magma_zmfree( x, queue );
     x->ownership = MagmaTrue;
+    x->mapping = NULL;
+    x->lval = NULL;
     magma_z_matrix x_h = {Magma_CSR};
     
     x->val = NULL;
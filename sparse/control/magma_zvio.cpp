@@ -8,7 +8,13 @@
        @precisions normal z -> s d c
        @author Hartwig Anzt
 */
+#include <ctype.h>
+
 #include "magmasparse_internal.h"
+#include "magmasparse_mmio.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define COMPLEX
 #define PRECISION_z
@@ -106,6 +112,9 @@ cleanup:
     -------
 
     Reads in a double vector of length "length".
+    Each line holds one entry; two values per line are read as real and
+    imaginary part. The file is memory-mapped and parsed in parallel,
+    using the same line splitting and number parsing as magma_z_csr_mtx.
 
     Arguments
     ---------
@@ -137,15 +146,18 @@ magma_zvread(
 {
     magma_int_t info = 0;
     
-    magma_int_t nnz=0, i=0;
-    FILE *fid;
-    char buff[BUFSIZ]={0};
-    int count=0;
-    char *p;
+    mm_mapped_file mf = { NULL, 0, 0 };
+    size_t *bounds = NULL;
+    magma_int_t *chunk_start = NULL;
+    magma_int_t nchunks = 1, total = 0, errors = 0;
+    int count = 0;
+    const char *p, *end;
     
     // make sure the target structure is empty
     magma_zmfree( x, queue );
     x->ownership = MagmaTrue;
+    x->mapping = NULL;
+    x->lval = NULL;
     
     x->memory_location = Magma_CPU;
     x->storage_type = Magma_DENSE;
@@ -153,92 +165,89 @@ magma_zvread(
     x->num_cols = 1;
     x->major = MagmaColMajor;
     
-    fid = fopen(filename, "r");
-
-    if(NULL==fgets(buff, BUFSIZ, fid))
-        return -1;
-    rewind(fid);
-    for( p=buff; NULL != strtok(p, " \t\n"); p=NULL)
-        count++;
-    while( !feof(fid) )
-    {
-        double VAL1;
-
-        magmaDoubleComplex VAL;
-        
-        #if defined(PRECISION_z) || defined(PRECISION_d)
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%lg %lg\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%lg\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #else // single-complex or single
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%g %g\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%g\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #endif
-        
-        if ( VAL != MAGMA_Z_ZERO )
-            nnz++;
-        i++;
+    if ( mm_map_file( filename, 0, &mf ) != 0 ) {
+        printf("%% Unable to open file %s\n", filename);
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
     }
     
-    x->num_rows = i;
-    x->nnz = i;
-    i=0; nnz=0; count=0;
-    // printf("n:%d\n");
-    
-    CHECK( magma_zmalloc_cpu( &x->val, length ));
-    
-    rewind(fid);
-    for( p=buff; NULL != strtok(p, " \t\n"); p=NULL)
+    // the number of values in the first line decides real or complex
+    p = mf.data;
+    end = mf.data + mf.size;
+    p = mm_skip_blanks( p, end );
+    while ( p < end && *p != '\n' ) {
         count++;
-    //while( i<length )  // eof() is 'true' at the end of data
-    while( !feof(fid) )
+        while ( p < end && ! isspace( (unsigned char) *p ) )
+            p++;
+        p = mm_skip_blanks( p, end );
+    }
+    
+#ifdef _OPENMP
+    #pragma omp parallel
     {
-        double VAL1;
-
-        magmaDoubleComplex VAL;
-        
-        #if defined(PRECISION_z) || defined(PRECISION_d)
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%lg %lg\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%lg\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #else // single-complex or single
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%g %g\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%g\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #endif
-        
-        if ( VAL != MAGMA_Z_ZERO )
-            nnz++;
-        x->val[i] = VAL;
-        i++;
+        nchunks = omp_get_max_threads();
     }
-    fclose(fid);
+    nchunks *= 4;
+#endif
+    CHECK( magma_malloc_cpu( (void**) &bounds, (nchunks+1)*sizeof(size_t) ));
+    CHECK( magma_malloc_cpu( (void**) &chunk_start, (nchunks+1)*sizeof(magma_int_t) ));
+    mm_split_lines( mf.data, 0, mf.size, nchunks, bounds );
     
-    // magma_zprint_vector( *x, 0, x->num_rows, queue );
+    // pass 1: count the entries in each chunk
+    #pragma omp parallel for schedule(dynamic,1)
+    for( magma_int_t c=0; c < nchunks; c++ ){
+        const char *q   = mf.data + bounds[c];
+        const char *qend = mf.data + bounds[c+1];
+        magma_int_t lines = 0;
+        while( q < qend ){
+            q = mm_skip_blanks( q, qend );
+            if( q < qend && *q != '\n' )
+                lines++;
+            q = mm_next_line( q, qend );
+        }
+        chunk_start[c] = lines;
+    }
+    for( magma_int_t c=0; c < nchunks; c++ ){
+        magma_int_t lines = chunk_start[c];
+        chunk_start[c] = total;
+        total += lines;
+    }
+    
+    x->num_rows = total;
+    x->nnz = total;
     
+    CHECK( magma_zmalloc_cpu( &x->val, max( length, total ) ));
+    
+    // pass 2: parse the entries
+    #pragma omp parallel for schedule(dynamic,1) reduction(+:errors)
+    for( magma_int_t c=0; c < nchunks; c++ ){
+        const char *q   = mf.data + bounds[c];
+        const char *qend = mf.data + bounds[c+1];
+        magma_int_t i = chunk_start[c];
+        while( q < qend ){
+            const char *line = mm_skip_blanks( q, qend );
+            q = mm_next_line( line, qend );
+            if( line == qend || *line == '\n' )
+                continue;
+            real_Double_t VAL1 = 0.0, VAL2 = 0.0;
+            line = mm_parse_value( line, q, &VAL1 );
+            if( line != NULL && count == 2 )
+                line = mm_parse_value( line, q, &VAL2 );
+            if( line == NULL )
+                errors++;
+            x->val[i] = MAGMA_Z_MAKE( VAL1, VAL2 );
+            i++;
+        }
+    }
+    if ( errors > 0 ) {
+        printf("%% Could not parse %d entries of %s\n", int(errors), filename);
+        info = MAGMA_ERR_UNKNOWN;
+    }
     
 cleanup:
+    mm_unmap_file( &mf );
+    magma_free_cpu( bounds );
+    magma_free_cpu( chunk_start );
     return info;
 }
 
@@ -279,6 +288,8 @@ magma_zvspread(
     magma_int_t entry=0;
     magma_zmfree( x, queue );
     x->ownership = MagmaTrue;
+    x->mapping = NULL;
+    x->lval = NULL;
      //   char *vfilename[] = {"/mnt/sparse_matrices/mtx/rail_79841_B.mtx"};
     CHECK( magma_z_csr_mtx( &A,  filename, queue  ));
     CHECK( magma_zmconvert( A, &B, Magma_CSR, Magma_DENSE, queue ));
@@ -62,6 +62,8 @@ magma_zvset(
     v->major = MagmaColMajor;
     v->storage_type = Magma_DENSE;
     v->ownership = MagmaFalse;
+    v->mapping = NULL;
+    v->lval = NULL;
 
     return MAGMA_SUCCESS;
 }
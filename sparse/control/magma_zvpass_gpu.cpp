@@ -63,6 +63,8 @@ magma_zvset_dev(
     v->dval = val;
     v->major = MagmaColMajor;
     v->ownership = MagmaFalse;
+    v->mapping = NULL;
+    v->lval = NULL;
     
     return MAGMA_SUCCESS;
 }
@@ -9,6 +9,9 @@
        @author Hartwig Anzt
 */
 #include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 /**
@@ -50,9 +53,9 @@ magma_zvtranspose(
     // make sure the target structure is empty
     magma_zmfree( y, queue );
     y->ownership = MagmaTrue;
+    y->mapping = NULL;
+    y->lval = NULL;
     
-    magma_z_matrix dx={Magma_CSR}, dy={Magma_CSR};
-            
     if ( x.memory_location == Magma_DEV ) {
         CHECK( magma_zvinit( y, Magma_DEV, x.num_rows,x.num_cols, MAGMA_Z_ZERO, queue ));
         y->num_rows = x.num_rows;
@@ -67,16 +70,33 @@ magma_zvtranspose(
             magmablas_ztranspose( n, m, x.val, n, y->val, m, queue );
         }
     } else {
-        CHECK( magma_zmtransfer( x, &dx, Magma_CPU, Magma_DEV, queue ));
-        CHECK( magma_zvtranspose( dx, &dy, queue ));
-        CHECK( magma_zmtransfer( dy, y, Magma_DEV, Magma_CPU, queue ));
+        CHECK( magma_zvinit( y, Magma_CPU, x.num_rows,x.num_cols, MAGMA_Z_ZERO, queue ));
+        y->num_rows = x.num_rows;
+        y->num_cols = x.num_cols;
+        y->storage_type = x.storage_type;
+        if ( x.major == MagmaColMajor) {
+            y->major = MagmaRowMajor;
+            #pragma omp parallel for
+            for( magma_int_t i=0; i < m; i++ ) {
+                for( magma_int_t j=0; j < n; j++ ) {
+                    y->val[ i*n+j ] = x.val[ i+j*m ];
+                }
+            }
+        }
+        else {
+            y->major = MagmaColMajor;
+            #pragma omp parallel for
+            for( magma_int_t j=0; j < n; j++ ) {
+                for( magma_int_t i=0; i < m; i++ ) {
+                    y->val[ i+j*m ] = x.val[ i*n+j ];
+                }
+            }
+        }
     }
     
 cleanup:
     if( info != 0 ){
         magma_zmfree( y, queue );
     }
-    magma_zmfree( &dx, queue );
-    magma_zmfree( &dy, queue );
     return info;
 }
@@ -14,6 +14,14 @@
 #include "magma_internal.h"
 #include "magmasparse.h"
 
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#else
+    #include <time.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -74,6 +82,114 @@ magma_int_t cusparse2magma_error( cusparseStatus_t status );
     } while(0)
 
 
+/**
+    Static partition of the OpenMP host vector kernels.
+    n entries are split into chunks of at least MAGMA_SPARSE_CPU_CHUNK
+    entries, at most MAGMA_SPARSE_CPU_MAXCHUNKS of them; the chunks are
+    distributed with schedule(static). The split only depends on n, so
+    - every kernel assigns the same entries to the same thread, and pages
+      first touched by a kernel stay on the NUMA node that works on them;
+    - reductions add one partial sum per chunk, in chunk order, and give
+      the same result for any number of threads.
+    Returns the number of chunks, len is set to the chunk length.
+    ********************************************************************/
+#define MAGMA_SPARSE_CPU_CHUNK      4096
+#define MAGMA_SPARSE_CPU_MAXCHUNKS  1024
+
+static inline magma_int_t
+magma_sparse_cpu_chunks( magma_int_t n, magma_int_t *len )
+{
+    *len = magma_ceildiv( n, MAGMA_SPARSE_CPU_MAXCHUNKS );
+    if ( *len < MAGMA_SPARSE_CPU_CHUNK ) {
+        *len = MAGMA_SPARSE_CPU_CHUNK;
+    }
+    return magma_ceildiv( n, *len );
+}
+
+
+/**
+    Per-phase instrumentation of the host solvers, see magma_solver_phase.
+    magma_sparse_cycles reads the time stamp counter on x86, and the
+    monotonic clock in nanoseconds elsewhere; neither is a system call.
+    magma_sparse_phase adds one call and the ticks since start to phase[k],
+    and nbytes times the bytes and nflops times the flops of one call from
+    the estimates of magma_zsolverinfo_costs; block operations, which read
+    a vector once for several products, pass different multipliers.
+    The pair costs a few tens of cycles per timed call, so the counters
+    are always collected, also in production runs (verbose = 0). The
+    ticks are converted to seconds when the counters are reported by
+    magma_zsolverinfo.
+    Example:
+
+        magma_sparse_cycles_t t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, p, c_zero, q, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+    ********************************************************************/
+typedef unsigned long long magma_sparse_cycles_t;
+
+static inline magma_sparse_cycles_t
+magma_sparse_cycles( void )
+{
+    #if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+    #else
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (magma_sparse_cycles_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    #endif
+}
+
+static inline void
+magma_sparse_phase(
+    magma_solver_phase *phase, const magma_solver_phase *cost,
+    magma_phase_t k, magma_sparse_cycles_t start, double nbytes, double nflops )
+{
+    phase[k].cycles += magma_sparse_cycles() - start;
+    phase[k].calls++;
+    phase[k].bytes += nbytes * cost[k].bytes;
+    phase[k].flops += nflops * cost[k].flops;
+}
+
+
+/**
+    On-disk header of the binary CSR container written by
+    magma_zwrite_csr_binary and loaded by magma_z_csr_binary.
+    The header is followed by the row, col, and val arrays, each starting
+    at a multiple of MAGMA_SPARSE_BINARY_ALIGN bytes from the start of
+    the file, so a mapping of the file can be used as CSR arrays directly.
+    All offsets and lengths are in bytes.
+    ********************************************************************/
+#define MAGMA_SPARSE_BINARY_MAGIC    "MAGMASPB"
+#define MAGMA_SPARSE_BINARY_VERSION  1
+#define MAGMA_SPARSE_BINARY_ENDIAN   0x01020304
+#define MAGMA_SPARSE_BINARY_ALIGN    64
+
+typedef struct magma_sparse_binary_header
+{
+    char    magic[8];           // MAGMA_SPARSE_BINARY_MAGIC, not terminated
+    int32_t version;            // MAGMA_SPARSE_BINARY_VERSION
+    int32_t endian;             // MAGMA_SPARSE_BINARY_ENDIAN as written
+    int32_t value_size;         // sizeof one entry of val
+    int32_t num_components;     // 2 for c/z, 1 for s/d
+    int32_t index_size;         // sizeof(magma_index_t)
+    int32_t storage_type;       // magma_storage_t of the CSR arrays
+    int32_t sym;                // magma_symmetry_t
+    int32_t fill_mode;          // magma_uplo_t
+    int32_t diagorder_type;     // magma_diagorder_t
+    int32_t reserved0;
+    int64_t num_rows;
+    int64_t num_cols;
+    int64_t nnz;
+    int64_t true_nnz;
+    int64_t max_nnz_row;
+    int64_t diameter;
+    int64_t row_offset;
+    int64_t col_offset;
+    int64_t val_offset;
+    int64_t file_size;
+    int64_t reserved[8];
+} magma_sparse_binary_header;
+
 #ifdef __cplusplus
 } // extern C
 #endif
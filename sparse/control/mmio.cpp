@@ -5,6 +5,17 @@
 *
 *
 */
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "magmasparse_internal.h"
 #include "magmasparse_mmio.h"
 
@@ -541,3 +552,259 @@ void mm_snprintf_typecode( char *buffer, size_t buflen, MM_typecode matcode )
 
     snprintf( buffer, buflen, "%s %s %s %s", types[0], types[1], types[2], types[3] );
 }
+
+
+/******************** memory-mapped parsing support *************************
+
+   The routines below give the Matrix Market readers random access to the
+   whole file, so that the coordinate section can be split at line
+   boundaries and parsed by several threads at once.
+   mm_parse_value returns exactly the value strtod (and hence fscanf "%lf")
+   returns for the same token.
+   mm_map_file with writable != 0 gives a private copy-on-write view:
+   stores into data never reach the file. Used by the binary CSR loader,
+   whose arrays point straight into the mapping.
+
+ ***********************************************************************/
+
+int mm_map_file(const char *fname, int writable, mm_mapped_file *mf)
+{
+    mf->data = NULL;
+    mf->size = 0;
+    mf->mapped = 0;
+
+#if !defined(_WIN32)
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0)
+        return MM_COULD_NOT_READ_FILE;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return MM_COULD_NOT_READ_FILE;
+    }
+    mf->size = (size_t) st.st_size;
+    if (mf->size > 0) {
+        int prot = (writable ? PROT_READ | PROT_WRITE : PROT_READ);
+        void *addr = mmap(NULL, mf->size, prot, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            #if defined(MADV_SEQUENTIAL)
+            madvise(addr, mf->size, MADV_SEQUENTIAL);
+            #endif
+            mf->data = (char*) addr;
+            mf->mapped = 1;
+        }
+    }
+    close(fd);
+    if (mf->mapped || mf->size == 0)
+        return 0;
+#endif
+
+    /* no mmap available: read the whole file into an aligned buffer */
+    FILE *f = fopen(fname, "rb");
+    if (f == NULL)
+        return MM_COULD_NOT_READ_FILE;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (len < 0) {
+        fclose(f);
+        return MM_COULD_NOT_READ_FILE;
+    }
+    char *buf = NULL;
+    if (magma_malloc_cpu( (void**) &buf, len > 0 ? len : 1 ) != MAGMA_SUCCESS) {
+        fclose(f);
+        return MM_COULD_NOT_READ_FILE;
+    }
+    if (fread(buf, 1, len, f) != (size_t) len) {
+        magma_free_cpu(buf);
+        fclose(f);
+        return MM_PREMATURE_EOF;
+    }
+    fclose(f);
+    mf->data = buf;
+    mf->size = (size_t) len;
+    mf->mapped = 0;
+    return 0;
+}
+
+
+void mm_unmap_file(mm_mapped_file *mf)
+{
+    if (mf->data != NULL) {
+#if !defined(_WIN32)
+        if (mf->mapped)
+            munmap((void*) mf->data, mf->size);
+        else
+#endif
+            magma_free_cpu(mf->data);
+    }
+    mf->data = NULL;
+    mf->size = 0;
+    mf->mapped = 0;
+}
+
+
+/* returns the start of the line following p, or end */
+const char* mm_next_line(const char *p, const char *end)
+{
+    const char *nl = (const char*) memchr(p, '\n', end - p);
+    return (nl == NULL) ? end : nl + 1;
+}
+
+
+/* skips blanks within a line; stops at the newline or end */
+const char* mm_skip_blanks(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || 
+                       *p == '\v' || *p == '\f'))
+        p++;
+    return p;
+}
+
+
+/* Splits data[begin, end) into nchunks pieces, each starting at the
+   beginning of a line. Chunk i is data[bounds[i], bounds[i+1]). */
+void mm_split_lines(const char *data, size_t begin, size_t end, 
+                    int nchunks, size_t *bounds)
+{
+    size_t len = end - begin;
+    bounds[0] = begin;
+    for (int i = 1; i < nchunks; i++) {
+        size_t guess = begin + (len / nchunks) * i;
+        if (guess <= bounds[i-1]) {
+            bounds[i] = bounds[i-1];
+        } else {
+            /* move to the line start following the byte before guess */
+            bounds[i] = mm_next_line(data + guess - 1, data + end) - data;
+        }
+    }
+    bounds[nchunks] = end;
+}
+
+
+const char* mm_parse_index(const char *p, const char *end, magma_index_t *v)
+{
+    p = mm_skip_blanks(p, end);
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9')
+        return NULL;
+    long long r = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        r = 10*r + (*p - '0');
+        if (r > INT_MAX)
+            return NULL;
+        p++;
+    }
+    *v = (magma_index_t) (neg ? -r : r);
+    return p;
+}
+
+
+/* powers of ten that are exactly representable in double precision */
+static const double mm_exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+const char* mm_parse_value(const char *p, const char *end, double *v)
+{
+    p = mm_skip_blanks(p, end);
+    const char *start = p;
+
+    /* fast path: at most 19 significant digits and a small exponent.
+       If the mantissa fits in 53 bits and |exponent| <= 22, both operands
+       of the final multiplication/division are exact and IEEE arithmetic
+       rounds the result correctly, i.e., identical to strtod. */
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    unsigned long long mant = 0;
+    int ndigits = 0;      // significant digits collected in mant
+    int nread = 0;        // digits seen at all
+    int exp10 = 0;
+    int fallback = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (mant != 0 || *p != '0') {
+            if (ndigits < 19) {
+                mant = 10*mant + (*p - '0');
+                ndigits++;
+            } else {
+                fallback = 1;
+            }
+        }
+        nread++;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (mant != 0 || *p != '0') {
+                if (ndigits < 19) {
+                    mant = 10*mant + (*p - '0');
+                    ndigits++;
+                } else {
+                    fallback = 1;
+                }
+            }
+            exp10--;
+            nread++;
+            p++;
+        }
+    }
+    if (nread == 0)
+        fallback = 1;     // inf, nan, hex floats, ...
+    if (! fallback && p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = 0;
+        if (q < end && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            q++;
+        }
+        if (q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            while (q < end && *q >= '0' && *q <= '9') {
+                if (e < 100000)
+                    e = 10*e + (*q - '0');
+                q++;
+            }
+            exp10 += eneg ? -e : e;
+            p = q;
+        }
+    }
+    if (! fallback && p < end && ! (*p == ' '  || *p == '\t' || *p == '\r' ||
+                                    *p == '\n' || *p == '\v' || *p == '\f'))
+        fallback = 1;     // trailing characters, let strtod decide
+    if (! fallback && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        double r = (double) mant;
+        r = (exp10 < 0) ? r / mm_exact_pow10[ -exp10 ]
+                        : r * mm_exact_pow10[ exp10 ];
+        *v = neg ? -r : r;
+        return p;
+    }
+
+    /* slow path: copy the token and hand it to strtod */
+    char token[MM_MAX_LINE_LENGTH];
+    size_t len = 0;
+    p = start;
+    while (p < end && len < sizeof(token)-1 && 
+           ! (*p == ' '  || *p == '\t' || *p == '\r' ||
+              *p == '\n' || *p == '\v' || *p == '\f')) {
+        token[len++] = *p++;
+    }
+    token[len] = '\0';
+    if (len == 0)
+        return NULL;
+    char *tend;
+    *v = strtod(token, &tend);
+    if (tend == token)
+        return NULL;
+    return start + (tend - token);
+}
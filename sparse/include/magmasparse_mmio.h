@@ -32,6 +32,26 @@ int mm_write_mtx_crd_size(FILE *f, magma_index_t M, magma_index_t N,
 int mm_write_mtx_array_size(FILE *f, magma_index_t M, magma_index_t N);
 
 
+/********************* memory-mapped parsing support ************************/
+
+typedef struct mm_mapped_file
+{
+    char       *data;       // file contents
+    size_t      size;       // number of bytes in data
+    int         mapped;     // 1 if data is a mmap'ed region, 0 if read into a buffer
+} mm_mapped_file;
+
+int mm_map_file(const char *fname, int writable, mm_mapped_file *mf);
+void mm_unmap_file(mm_mapped_file *mf);
+
+void mm_split_lines(const char *data, size_t begin, size_t end, 
+                    int nchunks, size_t *bounds);
+const char* mm_next_line(const char *p, const char *end);
+const char* mm_skip_blanks(const char *p, const char *end);
+const char* mm_parse_index(const char *p, const char *end, magma_index_t *v);
+const char* mm_parse_value(const char *p, const char *end, double *v);
+
+
 /********************* MM_typecode query fucntions ***************************/
 
 #define mm_is_matrix(typecode)  ((typecode)[0]=='M')
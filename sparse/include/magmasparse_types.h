@@ -69,6 +69,9 @@ extern "C"
 
 #define MAGMA_CSR5_OMEGA 32
 
+// nonzeros per chunk of compressed column indices in CSRDELTA
+#define MAGMA_CSRDELTA_CHUNK 16
+
     typedef struct magma_z_matrix
     {
         magma_storage_t storage_type;     // matrix format - CSR, ELL, SELL-P, CSR5
@@ -151,6 +154,13 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: memory-mapped file holding val/row/col
+        void *lval;                          // opt: CPU copy of val in reduced precision for the SpMV
+        magma_int_t lval_bits;               // opt: bits per real value in lval, 32 (single) or 16 (bfloat16)
+        unsigned char *delta_col;            // opt: CSRDELTA column offsets to delta_base, 8/16/32 bit per chunk
+        magma_uindex_t *delta_desc;          // opt: CSRDELTA chunk descriptor: 8-byte offset into delta_col << 2 | width
+        magma_index_t *delta_ptr;            // opt: CSRDELTA first chunk of each row
+        magma_index_t *delta_base;           // opt: CSRDELTA smallest column of each row
     } magma_z_matrix;
 
     typedef struct magma_c_matrix
@@ -235,6 +245,13 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: memory-mapped file holding val/row/col
+        void *lval;                          // opt: CPU copy of val in reduced precision for the SpMV
+        magma_int_t lval_bits;               // opt: bits per real value in lval, 32 (single) or 16 (bfloat16)
+        unsigned char *delta_col;            // opt: CSRDELTA column offsets to delta_base, 8/16/32 bit per chunk
+        magma_uindex_t *delta_desc;          // opt: CSRDELTA chunk descriptor: 8-byte offset into delta_col << 2 | width
+        magma_index_t *delta_ptr;            // opt: CSRDELTA first chunk of each row
+        magma_index_t *delta_base;           // opt: CSRDELTA smallest column of each row
     } magma_c_matrix;
 
     typedef struct magma_d_matrix
@@ -319,6 +336,13 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: memory-mapped file holding val/row/col
+        void *lval;                          // opt: CPU copy of val in reduced precision for the SpMV
+        magma_int_t lval_bits;               // opt: bits per real value in lval, 32 (single) or 16 (bfloat16)
+        unsigned char *delta_col;            // opt: CSRDELTA column offsets to delta_base, 8/16/32 bit per chunk
+        magma_uindex_t *delta_desc;          // opt: CSRDELTA chunk descriptor: 8-byte offset into delta_col << 2 | width
+        magma_index_t *delta_ptr;            // opt: CSRDELTA first chunk of each row
+        magma_index_t *delta_base;           // opt: CSRDELTA smallest column of each row
     } magma_d_matrix;
 
     typedef struct magma_s_matrix
@@ -403,6 +427,13 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        void *mapping;                       // opt: memory-mapped file holding val/row/col
+        void *lval;                          // opt: CPU copy of val in reduced precision for the SpMV
+        magma_int_t lval_bits;               // opt: bits per real value in lval, 32 (single) or 16 (bfloat16)
+        unsigned char *delta_col;            // opt: CSRDELTA column offsets to delta_base, 8/16/32 bit per chunk
+        magma_uindex_t *delta_desc;          // opt: CSRDELTA chunk descriptor: 8-byte offset into delta_col << 2 | width
+        magma_index_t *delta_ptr;            // opt: CSRDELTA first chunk of each row
+        magma_index_t *delta_base;           // opt: CSRDELTA smallest column of each row
     } magma_s_matrix;
 
     // for backwards compatability, make these aliases.
@@ -472,6 +503,83 @@ typedef struct magma_s_vector
 } magma_s_vector;
 */
 
+    // row-block view of a matrix file that is split into CSR shards on disk,
+    // see magma_z_csr_mtx_stream_open
+    typedef struct magma_mtx_stream
+    {
+        char *prefix;                     // file name prefix of the shards
+        magma_int_t num_rows;             // number of rows of the whole matrix
+        magma_int_t num_cols;             // number of columns of the whole matrix
+        int64_t nnz;                      // nonzeros of the whole matrix (symmetric part expanded)
+        magma_symmetry_t sym;             // symmetry of the whole matrix
+        magma_int_t num_blocks;           // number of row blocks
+        magma_index_t *block_start;       // first row of each block, num_blocks+1 entries
+        magma_int_t current;              // next block returned by the iterator
+    } magma_mtx_stream;
+
+    // description of a synthetic test matrix, see magma_zmgenerate
+    typedef struct magma_matrix_generator
+    {
+        magma_int_t stencil;              // 5, 9 (2D), 7, 27 (3D) point stencil; 0 = random graph Laplacian
+        magma_int_t nx;                   // grid points in x; number of vertices of the graph
+        magma_int_t ny;                   // grid points in y
+        magma_int_t nz;                   // grid points in z, ignored in 2D
+        double hx, hy, hz;                // coupling weight per direction (anisotropy)
+        double contrast;                  // coefficient exp(contrast*s(x)) with s smooth in [-1,1]; 0 = constant
+        double shift;                     // added to every diagonal entry
+        magma_int_t degree;               // random graph: edges drawn per vertex
+        magma_int_t seed;                 // random graph: seed of the edge hash
+    } magma_matrix_generator;
+
+    // SELL-P candidates examined by magma_zmselect_format
+    #define MAGMA_FORMAT_TUNE_BLOCKSIZES 4    // slice sizes 8, 16, 32, 64
+    #define MAGMA_FORMAT_TUNE_ALIGNMENTS 5    // alignments 1, 4, 8, 16, 32
+
+    // matrix statistics and SpMV format decision, see magma_zmselect_format
+    typedef struct magma_format_tuning
+    {
+        uint64_t fingerprint;             // hash of dimensions, sparsity pattern and value size
+        double row_mean;                  // mean nonzeros per row
+        double row_var;                   // variance of the nonzeros per row
+        magma_int_t max_nnz_row;          // longest row
+        magma_int_t diameter;             // max |i-j| over all nonzeros
+        double ell_padding;               // ELL stored entries / nnz
+        magma_int_t sellp_blocksize[MAGMA_FORMAT_TUNE_BLOCKSIZES];
+        magma_int_t sellp_alignment[MAGMA_FORMAT_TUNE_ALIGNMENTS];
+        double sellp_padding[MAGMA_FORMAT_TUNE_BLOCKSIZES][MAGMA_FORMAT_TUNE_ALIGNMENTS];
+                                          // SELL-P stored entries / nnz; 0 = not usable
+        magma_storage_t format;           // selected format: CSR, ELL, SELLP or CSR5
+        magma_int_t blocksize;            // SELL-P slice size of the selection
+        magma_int_t alignment;            // SELL-P alignment of the selection
+        double time[4];                   // seconds per SpMV for CSR, ELL, SELLP, CSR5; 0 = not run
+        magma_int_t cached;               // decision was taken from the cache file
+    } magma_format_tuning;
+
+    // helper threads of the non-blocking reductions of the pipelined host
+    // solvers, see magma_zdotc_start_cpu
+    typedef struct magma_z_reduction *magma_z_reduction_t;
+    typedef struct magma_c_reduction *magma_c_reduction_t;
+    typedef struct magma_d_reduction *magma_d_reduction_t;
+    typedef struct magma_s_reduction *magma_s_reduction_t;
+
+    // per-phase counters of the host solvers, see magma_zsolverinfo_phases
+    typedef enum {
+        Magma_PHASE_SETUP   = 0,    // workspace and initial residual
+        Magma_PHASE_SPMV    = 1,    // sparse matrix vector products
+        Magma_PHASE_PRECOND = 2,    // preconditioner applications
+        Magma_PHASE_ORTHO   = 3,    // Gram-Schmidt, block orthogonalization
+        Magma_PHASE_REDUCE  = 4,    // dot products and norms
+        Magma_NUM_PHASES    = 5
+    } magma_phase_t;
+
+    typedef struct magma_solver_phase
+    {
+        magma_int_t calls;                   // number of timed calls
+        unsigned long long cycles;           // ticks of magma_sparse_cycles
+        double bytes;                        // estimated memory traffic
+        double flops;                        // estimated floating point operations
+    } magma_solver_phase;
+
     //*****************     solver parameters     ********************************//
 
     typedef struct magma_z_solver_par
@@ -482,7 +590,9 @@ typedef struct magma_s_vector
         double rtol;                         // relative residual stopping criterion
         magma_int_t maxiter;                 // upper iteration limit
         magma_int_t restart;                 // for GMRES
-        magma_ortho_t ortho;                 // for GMRES
+        magma_ortho_t ortho;                 // for GMRES, block CGS/MGS for CA-GMRES
+        magma_int_t sstep;                   // for CA-CG/CA-GMRES: basis length s
+        magma_basis_t basis;                 // for CA-CG/CA-GMRES: monomial or Newton basis
         magma_int_t numiter;                 // feedback: number of needed iterations
         magma_int_t spmv_count;              // feedback: number of needed SpMV - can be different to iteration count
         double init_res;                     // feedback: initial residual
@@ -497,6 +607,7 @@ typedef struct magma_s_vector
         double *eigenvalues;                 // feedback: array containing eigenvalues
         magmaDoubleComplex_ptr eigenvectors; // feedback: array containing eigenvectors on DEV
         magma_int_t info;                    // feedback: did the solver converge etc.
+        magma_solver_phase phase[Magma_NUM_PHASES]; // feedback: per-phase counters, host solvers
 
         //---------------------------------
         // the input for verbose is:
@@ -519,7 +630,9 @@ typedef struct magma_s_vector
         float rtol;                         // relative residual stopping criterion
         magma_int_t maxiter;                // upper iteration limit
         magma_int_t restart;                // for GMRES
-        magma_ortho_t ortho;                // for GMRES
+        magma_ortho_t ortho;                // for GMRES, block CGS/MGS for CA-GMRES
+        magma_int_t sstep;                  // for CA-CG/CA-GMRES: basis length s
+        magma_basis_t basis;                // for CA-CG/CA-GMRES: monomial or Newton basis
         magma_int_t numiter;                // feedback: number of needed iterations
         magma_int_t spmv_count;             // feedback: number of needed SpMV - can be different to iteration count
         float init_res;                     // feedback: initial residual
@@ -534,6 +647,7 @@ typedef struct magma_s_vector
         float *eigenvalues;                 // feedback: array containing eigenvalues
         magmaFloatComplex_ptr eigenvectors; // feedback: array containing eigenvectors on DEV
         magma_int_t info;                   // feedback: did the solver converge etc.
+        magma_solver_phase phase[Magma_NUM_PHASES]; // feedback: per-phase counters, host solvers
 
         //---------------------------------
         // the input for verbose is:
@@ -556,7 +670,9 @@ typedef struct magma_s_vector
         double rtol;                  // relative residual stopping criterion
         magma_int_t maxiter;          // upper iteration limit
         magma_int_t restart;          // for GMRES
-        magma_ortho_t ortho;          // for GMRES
+        magma_ortho_t ortho;          // for GMRES, block CGS/MGS for CA-GMRES
+        magma_int_t sstep;            // for CA-CG/CA-GMRES: basis length s
+        magma_basis_t basis;          // for CA-CG/CA-GMRES: monomial or Newton basis
         magma_int_t numiter;          // feedback: number of needed iterations
         magma_int_t spmv_count;       // feedback: number of needed SpMV - can be different to iteration count
         double init_res;              // feedback: initial residual
@@ -571,6 +687,7 @@ typedef struct magma_s_vector
         double *eigenvalues;          // feedback: array containing eigenvalues
         magmaDouble_ptr eigenvectors; // feedback: array containing eigenvectors on DEV
         magma_int_t info;             // feedback: did the solver converge etc.
+        magma_solver_phase phase[Magma_NUM_PHASES]; // feedback: per-phase counters, host solvers
 
         //---------------------------------
         // the input for verbose is:
@@ -593,7 +710,9 @@ typedef struct magma_s_vector
         float rtol;                  // relative residual stopping criterion
         magma_int_t maxiter;         // upper iteration limit
         magma_int_t restart;         // for GMRES
-        magma_ortho_t ortho;         // for GMRES
+        magma_ortho_t ortho;         // for GMRES, block CGS/MGS for CA-GMRES
+        magma_int_t sstep;           // for CA-CG/CA-GMRES: basis length s
+        magma_basis_t basis;         // for CA-CG/CA-GMRES: monomial or Newton basis
         magma_int_t numiter;         // feedback: number of needed iterations
         magma_int_t spmv_count;      // feedback: number of needed SpMV - can be different to iteration count
         float init_res;              // feedback: initial residual
@@ -608,6 +727,7 @@ typedef struct magma_s_vector
         float *eigenvalues;          // feedback: array containing eigenvalues
         magmaFloat_ptr eigenvectors; // feedback: array containing eigenvectors on DEV
         magma_int_t info;            // feedback: did the solver converge etc.
+        magma_solver_phase phase[Magma_NUM_PHASES]; // feedback: per-phase counters, host solvers
 
         //---------------------------------
         // the input for verbose is:
@@ -635,6 +755,16 @@ typedef struct magma_solve_info_t
 {
     csrsm2Info_t descr{};
     void *buffer{};
+    // host level-scheduled solve (matrix on Magma_CPU):
+    // rows ordered by level, off-diagonal part and diagonal stored separately
+    magma_int_t num_rows{};
+    magma_int_t num_levels{};
+    magma_index_t *level_ptr{};  // start of every level in perm
+    magma_index_t *perm{};       // row indices ordered by level
+    magma_index_t *row{};        // row pointer of the level-ordered rows
+    magma_index_t *col{};
+    void *val{};
+    void *diag{};
 } magma_solve_info_t;
 //#define magma_ilu_info_t cusparseSolveAnalysisInfo_t
 #define magma_ilu_info_t csrsm2Info_t
@@ -643,6 +773,16 @@ typedef struct magma_solve_info_t
 {
     cusparseSpSMDescr_t descr{};
     void *buffer{};
+    // host level-scheduled solve (matrix on Magma_CPU):
+    // rows ordered by level, off-diagonal part and diagonal stored separately
+    magma_int_t num_rows{};
+    magma_int_t num_levels{};
+    magma_index_t *level_ptr{};  // start of every level in perm
+    magma_index_t *perm{};       // row indices ordered by level
+    magma_index_t *row{};        // row pointer of the level-ordered rows
+    magma_index_t *col{};
+    void *val{};
+    void *diag{};
 } magma_solve_info_t;
 #define magma_ilu_info_t csrsm2Info_t
 #endif
@@ -692,6 +832,12 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_z_matrix RA;     // host L+U pattern with values of A, for refactorization
+        magma_z_matrix RL;     // host L (CSR), for refactorization
+        magma_z_matrix RUT;    // host U^T (CSR), for refactorization
+        magma_index_t *RA_map;  // nonzero of A -> nonzero of RA, -1 if dropped
+        magma_index_t *RUT_map; // nonzero of RUT -> nonzero of U
+        magma_int_t lval_bits;  // reduced precision for the CPU ISAI matrices: 0, 32 or 16
 
         /* was merge conflict, assume master */
         magma_ilu_info_t cuinfoILU;
@@ -753,6 +899,12 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_c_matrix RA;     // host L+U pattern with values of A, for refactorization
+        magma_c_matrix RL;     // host L (CSR), for refactorization
+        magma_c_matrix RUT;    // host U^T (CSR), for refactorization
+        magma_index_t *RA_map;  // nonzero of A -> nonzero of RA, -1 if dropped
+        magma_index_t *RUT_map; // nonzero of RUT -> nonzero of U
+        magma_int_t lval_bits;  // reduced precision for the CPU ISAI matrices: 0, 32 or 16
 
         magma_ilu_info_t cuinfoILU;
         magma_solve_info_t cuinfoL;
@@ -813,6 +965,12 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_d_matrix RA;     // host L+U pattern with values of A, for refactorization
+        magma_d_matrix RL;     // host L (CSR), for refactorization
+        magma_d_matrix RUT;    // host U^T (CSR), for refactorization
+        magma_index_t *RA_map;  // nonzero of A -> nonzero of RA, -1 if dropped
+        magma_index_t *RUT_map; // nonzero of RUT -> nonzero of U
+        magma_int_t lval_bits;  // reduced precision for the CPU ISAI matrices: 0, 32 or 16
 
         magma_ilu_info_t cuinfoILU;
         magma_solve_info_t cuinfoL;
@@ -873,6 +1031,12 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_s_matrix RA;     // host L+U pattern with values of A, for refactorization
+        magma_s_matrix RL;     // host L (CSR), for refactorization
+        magma_s_matrix RUT;    // host U^T (CSR), for refactorization
+        magma_index_t *RA_map;  // nonzero of A -> nonzero of RA, -1 if dropped
+        magma_index_t *RUT_map; // nonzero of RUT -> nonzero of U
+        magma_int_t lval_bits;  // reduced precision for the CPU ISAI matrices: 0, 32 or 16
 
         magma_ilu_info_t cuinfoILU;
         magma_solve_info_t cuinfoL;
@@ -908,6 +1072,12 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_reorder_t reordering;
+        magma_int_t lval_bits;   // reduced precision for the CPU system matrix: 0, 32 or 16
+        magma_int_t autoformat;  // choose output_format per matrix, see magma_zmselect_format
+        magma_int_t format_trials; // timed SpMVs per candidate format, 0 = model only
+        const char *format_cache;  // file caching the format decisions, or NULL
+        const char *profile_file;  // JSON dump of the per-phase solver counters, or NULL
     } magma_zopts;
 
     typedef struct magma_copts
@@ -924,6 +1094,12 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_reorder_t reordering;
+        magma_int_t lval_bits;   // reduced precision for the CPU system matrix: 0, 32 or 16
+        magma_int_t autoformat;  // choose output_format per matrix, see magma_zmselect_format
+        magma_int_t format_trials; // timed SpMVs per candidate format, 0 = model only
+        const char *format_cache;  // file caching the format decisions, or NULL
+        const char *profile_file;  // JSON dump of the per-phase solver counters, or NULL
     } magma_copts;
 
     typedef struct magma_dopts
@@ -940,6 +1116,12 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_reorder_t reordering;
+        magma_int_t lval_bits;   // reduced precision for the CPU system matrix: 0, 32 or 16
+        magma_int_t autoformat;  // choose output_format per matrix, see magma_zmselect_format
+        magma_int_t format_trials; // timed SpMVs per candidate format, 0 = model only
+        const char *format_cache;  // file caching the format decisions, or NULL
+        const char *profile_file;  // JSON dump of the per-phase solver counters, or NULL
     } magma_dopts;
 
     typedef struct magma_sopts
@@ -956,6 +1138,12 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_reorder_t reordering;
+        magma_int_t lval_bits;   // reduced precision for the CPU system matrix: 0, 32 or 16
+        magma_int_t autoformat;  // choose output_format per matrix, see magma_zmselect_format
+        magma_int_t format_trials; // timed SpMVs per candidate format, 0 = model only
+        const char *format_cache;  // file caching the format decisions, or NULL
+        const char *profile_file;  // JSON dump of the per-phase solver counters, or NULL
     } magma_sopts;
 
 #ifdef __cplusplus
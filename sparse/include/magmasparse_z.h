@@ -15,6 +15,8 @@
 #include "magma_types.h"
 #include "magmasparse_types.h"
 
+#include <stdio.h>  // FILE, for magma_zsolverinfo_json
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -97,6 +99,32 @@ magma_z_csr_mtx(
     const char *filename,
     magma_queue_t queue );
 
+magma_int_t 
+magma_z_csr_binary( 
+    magma_z_matrix *A, 
+    const char *filename,
+    magma_queue_t queue );
+
+magma_int_t 
+magma_z_csr_mtx_stream_open( 
+    magma_mtx_stream *S, 
+    const char *filename,
+    const char *prefix,
+    magma_int_t block_nnz,
+    magma_queue_t queue );
+
+magma_int_t 
+magma_z_csr_mtx_stream_next( 
+    magma_mtx_stream *S, 
+    magma_z_matrix *A,
+    magma_index_t *row_offset,
+    magma_queue_t queue );
+
+magma_int_t 
+magma_z_csr_mtx_stream_close( 
+    magma_mtx_stream *S, 
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zcsrset( 
     magma_int_t m, 
@@ -424,6 +452,22 @@ magma_zselectrandom(
     magma_int_t k,
     magma_queue_t queue );
 
+magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    magmaDoubleComplex *val,
+    double *thrs,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zdomainoverlap(
     magma_index_t num_rows,
@@ -461,6 +505,18 @@ magma_zwrite_csrtomtx(
     const char *filename,
     magma_queue_t queue );
 
+magma_int_t 
+magma_zwrite_csr_binary( 
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zwrite_csr_generator(
+    magma_matrix_generator gen,
+    const char *filename,
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zprint_csr( 
     magma_int_t n_row, 
@@ -513,6 +569,22 @@ magma_zmtransposeconj_cpu(
     magma_z_matrix *B,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmlag2c_cpu(
+    magma_z_matrix *A,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmlag2bf_cpu(
+    magma_z_matrix *A,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmlag_cpu(
+    magma_int_t bits,
+    magma_z_matrix *A,
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zmtransfer(
     magma_z_matrix A, 
@@ -582,6 +654,24 @@ magma_zrowentries(
     magma_z_matrix *A,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmselect_format(
+    magma_z_matrix A,
+    magma_location_t location,
+    magma_int_t trials,
+    const char *cachefile,
+    magma_format_tuning *tuning,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmconvert_auto(
+    magma_z_matrix A,
+    magma_z_matrix *B,
+    magma_location_t location,
+    magma_int_t trials,
+    const char *cachefile,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zmfree(
     magma_z_matrix *A,
@@ -635,6 +725,41 @@ magma_zm_5stencil(
     magma_z_matrix *A,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmgenerate(
+    magma_matrix_generator gen,
+    magma_z_matrix *A,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgenerate_rows(
+    magma_matrix_generator gen,
+    magma_int_t first_row,
+    magma_int_t last_row,
+    magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgenerate_size(
+    magma_matrix_generator gen,
+    magma_int_t *num_rows,
+    int64_t *nnz,
+    magma_int_t *max_nnz_row,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgenerate_parse(
+    const char *spec,
+    magma_matrix_generator *gen,
+    magma_queue_t queue );
+
+void
+magma_zindex_scan_cpu(
+    magma_int_t n,
+    magma_index_t *x );
+
 magma_int_t
 magma_zsolverinfo(
     magma_z_solver_par *solver_par, 
@@ -647,6 +772,26 @@ magma_zsolverinfo_init(
     magma_z_preconditioner *precond,
     magma_queue_t queue );
 
+magma_int_t
+magma_zsolverinfo_costs(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond_par,
+    magma_solver_phase *cost,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsolverinfo_phases(
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsolverinfo_json(
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    const char *matrix,
+    FILE *f,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zeigensolverinfo_init(
     magma_z_solver_par *solver_par,
@@ -694,6 +839,12 @@ magma_zparilu_cpu(
     magma_z_preconditioner *precond,
     magma_queue_t queue );
 
+magma_int_t
+magma_zparilu_cpu_refactor( 
+    magma_z_matrix A, 
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zparic_gpu( 
     magma_z_matrix A, 
@@ -1079,6 +1230,17 @@ magma_zparilu_sweep_sync(
     magma_z_matrix *U,
     magma_queue_t queue );
 
+magma_int_t
+magma_zparilu_sweep_async(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_z_matrix *U,
+    magma_int_t maxsweeps,
+    double rtol,
+    magma_int_t *sweeps,
+    double *res,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zparic_sweep(
     magma_z_matrix A,
@@ -1091,6 +1253,16 @@ magma_zparic_sweep_sync(
     magma_z_matrix *L,
     magma_queue_t queue );
 
+magma_int_t
+magma_zparic_sweep_async(
+    magma_z_matrix A,
+    magma_z_matrix *L,
+    magma_int_t maxsweeps,
+    double rtol,
+    magma_int_t *sweeps,
+    double *res,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zparict_sweep_sync(
     magma_z_matrix *A,
@@ -1543,6 +1715,27 @@ magma_zicisaisetup(
     magma_z_preconditioner *precond,
     magma_queue_t queue );
 
+magma_int_t
+magma_ziluisaisetup_lower_cpu(
+    magma_z_matrix L,
+    magma_z_matrix S,
+    magma_z_matrix *ISAIL,
+    magma_queue_t queue );
+
+magma_int_t
+magma_ziluisaisetup_upper_cpu(
+    magma_z_matrix U,
+    magma_z_matrix S,
+    magma_z_matrix *ISAIU,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zicisaisetup_cpu(
+    magma_z_matrix A,
+    magma_z_matrix b,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zisai_l(
     magma_z_matrix b,
@@ -1593,6 +1786,15 @@ magma_zisai_generator_regs(
     magma_z_matrix *M,
     magma_queue_t queue );
 
+magma_int_t
+magma_zisai_generator_cpu(
+    magma_uplo_t uplotype,
+    magma_trans_t transtype,
+    magma_diag_t diagtype,
+    magma_z_matrix T,
+    magma_z_matrix *M,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zcsr_sort(
     magma_z_matrix *A,
@@ -1619,6 +1821,46 @@ magma_zmsupernodal(
     magma_z_matrix *S,
     magma_queue_t queue );
 
+magma_int_t
+magma_zmrcm(
+    magma_z_matrix A,
+    magma_index_t **perm,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmnd(
+    magma_z_matrix A,
+    magma_index_t **perm,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmpermute(
+    magma_z_matrix A,
+    magma_index_t *perm,
+    magma_z_matrix *B,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zvpermute(
+    magma_z_matrix x,
+    magma_index_t *perm,
+    magma_z_matrix *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zvunpermute(
+    magma_z_matrix x,
+    magma_index_t *perm,
+    magma_z_matrix *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmreorder(
+    magma_z_matrix *A,
+    magma_reorder_t reordering,
+    magma_index_t **perm,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zmvarsizeblockstruct(
     magma_int_t n,
@@ -1865,6 +2107,74 @@ magma_zpidr_strms(
     magma_z_preconditioner *precond_par,
     magma_queue_t queue );
 
+magma_int_t
+magma_zpcg_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zpbicgstab_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zpcg_merge_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zbicgstab_merge_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zfgmres_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zpidr_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcacg_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcagmres_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zpipecg_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zpipegmres_cpu(
+    magma_z_matrix A, magma_z_matrix b,
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zbombard(
     magma_z_matrix A, magma_z_matrix b, 
@@ -2346,6 +2656,12 @@ magma_z_precondsetup(
     magma_z_preconditioner *precond,
     magma_queue_t queue );
 
+magma_int_t
+magma_z_precondrefactor(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
 magma_int_t
 magma_z_applyprecond(
     magma_z_matrix A, magma_z_matrix b, 
@@ -2690,6 +3006,449 @@ magma_zgecsr5mv(
     magmaDoubleComplex_ptr  dy,
     magma_queue_t           queue );
 
+magma_int_t
+magma_zgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgeellmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t nnz_per_row,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgeelltmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t nnz_per_row,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgeellrtmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t nnz_per_row,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowlength,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_int_t alignment,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowptr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowptr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgecsrmv_mixed_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magma_int_t bits,
+    const void *lval,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr colind,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgesellpmv_mixed_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    magma_int_t bits,
+    const void *lval,
+    magmaIndex_ptr colind,
+    magmaIndex_ptr rowptr,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgecsrdeltamv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex_ptr val,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr delta_ptr,
+    magmaUIndex_ptr delta_desc,
+    magmaIndex_ptr delta_base,
+    unsigned char *delta_col,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgecsrdeltamv_mixed_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magma_int_t bits,
+    const void *lval,
+    magmaIndex_ptr rowptr,
+    magmaIndex_ptr delta_ptr,
+    magmaUIndex_ptr delta_desc,
+    magmaIndex_ptr delta_base,
+    unsigned char *delta_col,
+    magmaDoubleComplex_ptr x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex_ptr y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgecsr5mv_cpu(
+    magma_trans_t           transA,
+    magma_int_t             m, 
+    magma_int_t             n, 
+    magma_int_t             p,
+    magmaDoubleComplex      alpha,
+    magma_int_t             sigma,
+    magma_int_t             bit_y_offset,
+    magma_int_t             bit_scansum_offset,
+    magma_int_t             num_packet,
+    magmaUIndex_ptr         tile_ptr,
+    magmaUIndex_ptr         tile_desc,
+    magmaIndex_ptr          tile_desc_offset_ptr,
+    magmaIndex_ptr          tile_desc_offset,
+    magmaDoubleComplex_ptr  calibrator,
+    magma_int_t             tail_tile_start,
+    magmaDoubleComplex_ptr  val,
+    magmaIndex_ptr          rowptr,
+    magmaIndex_ptr          colind,
+    magmaDoubleComplex_ptr  x,
+    magmaDoubleComplex      beta,
+    magmaDoubleComplex_ptr  y,
+    magma_queue_t           queue );
+
+void
+magma_zcopy_cpu(
+    magma_int_t n,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+void
+magma_zset_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *x,
+    magma_queue_t queue );
+
+void
+magma_zscal_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *x,
+    magma_queue_t queue );
+
+void
+magma_zaxpy_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+void
+magma_zaxpy2_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y,
+    magmaDoubleComplex beta,
+    const magmaDoubleComplex *u,
+    magmaDoubleComplex *v,
+    magma_queue_t queue );
+
+magmaDoubleComplex
+magma_zdotc_cpu(
+    magma_int_t n,
+    const magmaDoubleComplex *x,
+    const magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+double
+magma_dznrm2_cpu(
+    magma_int_t n,
+    const magmaDoubleComplex *x,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmdotc_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    const magmaDoubleComplex *V,
+    magma_int_t ldv,
+    magma_int_t l,
+    const magmaDoubleComplex *W,
+    magma_int_t ldw,
+    magmaDoubleComplex *G,
+    magma_int_t ldg,
+    magma_queue_t queue );
+
+void
+magma_zmgemm_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magma_int_t l,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *V,
+    magma_int_t ldv,
+    const magmaDoubleComplex *C,
+    magma_int_t ldc,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *W,
+    magma_int_t ldw,
+    magma_queue_t queue );
+
+magma_int_t
+magma_ztsqr_cpu(
+    magma_int_t n,
+    magma_int_t k,
+    magmaDoubleComplex *V,
+    magma_int_t ldv,
+    magmaDoubleComplex *R,
+    magma_int_t ldr,
+    magma_queue_t queue );
+
+magma_int_t
+magma_znewtonshifts_cpu(
+    magma_int_t m,
+    const magmaDoubleComplex *H,
+    magma_int_t ldh,
+    magma_int_t s,
+    magmaDoubleComplex *theta,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zreduction_create_cpu(
+    magma_z_matrix A,
+    magma_int_t maxdots,
+    magma_int_t nvec,
+    magma_z_reduction_t *red,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zreduction_destroy_cpu(
+    magma_z_reduction_t red,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zdotc_start_cpu(
+    magma_int_t ndots,
+    const magmaDoubleComplex **x,
+    const magmaDoubleComplex **y,
+    magmaDoubleComplex *dots,
+    magma_z_reduction_t red,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zdotc_wait_cpu(
+    magma_z_reduction_t red,
+    magma_queue_t queue );
+
+void
+magma_zbicgstab_1_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex omega,
+    const magmaDoubleComplex *r,
+    const magmaDoubleComplex *v,
+    magmaDoubleComplex *p,
+    magma_queue_t queue );
+
+void
+magma_zbicgstab_2_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *r,
+    const magmaDoubleComplex *v,
+    magmaDoubleComplex *s,
+    magma_queue_t queue );
+
+void
+magma_zbicgstab_4_cpu(
+    magma_int_t num_rows,
+    magma_int_t num_cols,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex omega,
+    const magmaDoubleComplex *y,
+    const magmaDoubleComplex *z,
+    const magmaDoubleComplex *s,
+    const magmaDoubleComplex *t,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcgmerge_spmv1_cpu(
+    magma_z_matrix A,
+    magmaDoubleComplex beta,
+    magma_z_matrix h,
+    magma_z_matrix d,
+    magma_z_matrix z,
+    magmaDoubleComplex *rho,
+    magma_queue_t queue );
+
+void
+magma_zcgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *d,
+    const magmaDoubleComplex *z,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    double *nom,
+    magma_queue_t queue );
+
+void
+magma_zjcgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *diag,
+    const magmaDoubleComplex *d,
+    const magmaDoubleComplex *z,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magmaDoubleComplex *h,
+    double *nom,
+    magmaDoubleComplex *gamma,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zbicgmerge_spmv1_cpu(
+    magma_z_matrix A,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex omega,
+    magma_z_matrix r,
+    magma_z_matrix rr,
+    magma_z_matrix p,
+    magma_z_matrix v,
+    magmaDoubleComplex *rrv,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zbicgmerge_spmv2_cpu(
+    magma_z_matrix A,
+    magmaDoubleComplex alpha,
+    magma_z_matrix r,
+    magma_z_matrix v,
+    magma_z_matrix s,
+    magma_z_matrix t,
+    magmaDoubleComplex *ts,
+    magmaDoubleComplex *tt,
+    magma_queue_t queue );
+
+void
+magma_zbicgmerge_xr_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex omega,
+    const magmaDoubleComplex *rr,
+    const magmaDoubleComplex *p,
+    const magmaDoubleComplex *s,
+    const magmaDoubleComplex *t,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magmaDoubleComplex *rho,
+    double *nom,
+    magma_queue_t queue );
+
+void
+magma_zpipecg_update_cpu(
+    magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex beta,
+    const magmaDoubleComplex *m,
+    const magmaDoubleComplex *nv,
+    magmaDoubleComplex *x,
+    magmaDoubleComplex *r,
+    magmaDoubleComplex *u,
+    magmaDoubleComplex *w,
+    magmaDoubleComplex *z,
+    magmaDoubleComplex *q,
+    magmaDoubleComplex *s,
+    magmaDoubleComplex *p,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zgecscsyncfreetrsm_analysis(
     magma_int_t             m, 
@@ -2808,6 +3567,32 @@ magma_zjacobisetup_diagscal(
     magma_z_matrix A, magma_z_matrix *d,
     magma_queue_t queue );
 
+magma_int_t
+magma_zjacobisetup_diagscal_cpu(
+    magma_z_matrix A, magma_z_matrix *d,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zjacobi_diagscal_cpu(
+    magma_int_t num_rows, 
+    magma_z_matrix d, 
+    magma_z_matrix b, 
+    magma_z_matrix *c,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zvbjacobisetup_cpu(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zvbjacobi_apply_cpu(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
 
 //##################   kernel fusion for Krylov methods
 
@@ -10,6 +10,114 @@
 
 */
 #include "magmasparse_internal.h"
+#include "../blas/magma_trisolve.h"
+
+
+/*
+    Attaches the reduced-precision values selected by precond->lval_bits to
+    the approximate inverses LD and UD if they are CSR matrices on the CPU,
+    so the SpMV in the ISAI and Jacobi trisolver reads the smaller copy.
+    Warns and keeps double precision for any other preconditioner.
+*/
+static magma_int_t
+magma_z_precond_lval(
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( precond->lval_bits == 0 ) {
+        goto cleanup;
+    }
+    if ( precond->LD.memory_location != Magma_CPU || precond->LD.val == NULL ) {
+        printf("%% warning: reduced-precision preconditioner values are only\n");
+        printf("%% supported for the ISAI of host factors, using double.\n");
+        goto cleanup;
+    }
+    CHECK( magma_zmlag_cpu( precond->lval_bits, &precond->LD, queue ));
+    if ( precond->UD.memory_location == Magma_CPU && precond->UD.val != NULL ) {
+        CHECK( magma_zmlag_cpu( precond->lval_bits, &precond->UD, queue ));
+    }
+
+cleanup:
+    return info;
+}
+
+/*
+    Returns true if the triangular solves of the preconditioner are
+    approximated by the ISAI (or Jacobi) iteration.
+*/
+static bool
+magma_z_precond_isai(
+    magma_z_preconditioner *precond )
+{
+    return precond->trisolver == Magma_ISAI ||
+           precond->trisolver == Magma_JACOBI ||
+           precond->trisolver == Magma_VBJACOBI;
+}
+
+
+/*
+    Generates the ISAI of the ILU factors L and U on the CPU. If a pattern
+    is too large for the ISAI, falls back to the level-scheduled triangular
+    solves.
+*/
+static magma_int_t
+magma_z_precond_isai_cpu(
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    info = magma_ziluisaisetup_lower( precond->L, precond->L, &precond->LD, queue );
+    if ( info == 0 ) {
+        info = magma_ziluisaisetup_upper( precond->U, precond->U, &precond->UD, queue );
+    }
+    if ( info == Magma_CUSOLVE ) {
+        magma_zmfree( &precond->LD, queue );
+        magma_zmfree( &precond->UD, queue );
+        precond->trisolver = Magma_CUSOLVE;
+        info = magma_zcumilugeneratesolverinfo( precond, queue );
+    }
+
+    return info;
+}
+
+
+/*
+    x = b, on the CPU or on the device depending on where b is located.
+*/
+static void
+magma_z_precond_copy(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_queue_t queue )
+{
+    if ( b.memory_location == Magma_CPU ) {
+        magma_zcopy_cpu( b.num_rows*b.num_cols, b.val, x->val, queue );
+    } else {
+        magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );
+    }
+}
+
+
+/*
+    Jacobi scaling x = D^(-1) b, on the CPU or on the device depending on
+    where b is located.
+*/
+static magma_int_t
+magma_z_precond_diagscal(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    if ( b.memory_location == Magma_CPU ) {
+        return magma_zjacobi_diagscal_cpu( b.num_rows, precond->d, b, x, queue );
+    } else {
+        return magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue );
+    }
+}
 
 
 /**
@@ -153,9 +261,67 @@ magma_z_precondsetup(
         precond->solver = Magma_NONE;
     } 
     
-    if ( precond->solver == Magma_JACOBI ) {
+    if ( A.memory_location == Magma_CPU && b.memory_location == Magma_CPU ) {
+        // host setup: the preconditioner is generated and applied on the CPU
+        if ( ( precond->solver == Magma_PARILU ||
+               precond->solver == Magma_PARILUT ||
+               precond->solver == Magma_PARIC ) &&
+             precond->trisolver != 0 && precond->trisolver != Magma_CUSOLVE &&
+             ! magma_z_precond_isai( precond ) ) {
+            printf("%% warning: triangular solver not supported on the CPU.\n");
+            printf("%% Fallback: level-scheduled triangular solves.\n");
+            precond->trisolver = Magma_CUSOLVE;
+        }
+        if ( precond->solver == Magma_JACOBI ) {
+            info = magma_zjacobisetup_diagscal_cpu( A, &(precond->d), queue );
+        }
+        else if ( precond->solver == Magma_VBJACOBI ) {
+            info = magma_zvbjacobisetup_cpu( A, precond, queue );
+        }
+        else if ( precond->solver == Magma_PARILU ) {
+            info = magma_zparilu_cpu( A, b, precond, queue );
+            if ( info == 0 && magma_z_precond_isai( precond ) ) {
+                info = magma_z_precond_isai_cpu( precond, queue );
+            }
+        }
+        else if ( precond->solver == Magma_PARILUT ) {
+            #ifdef _OPENMP
+                info = magma_zparilut_cpu( A, b, precond, queue );
+                precond->solver = Magma_PARILU; // handle as PARILU
+                if ( info == 0 && magma_z_precond_isai( precond ) ) {
+                    info = magma_z_precond_isai_cpu( precond, queue );
+                }
+            #else
+                printf( "error: preconditioner requires OpenMP.\n" );
+                info = MAGMA_ERR_NOT_SUPPORTED;
+            #endif
+        }
+        else if ( precond->solver == Magma_PARIC ) {
+            info = magma_zparic_cpu( A, b, precond, queue );
+            if ( info == 0 && magma_z_precond_isai( precond ) ) {
+                info = magma_zicisaisetup_cpu( A, b, precond, queue );
+                if ( info == Magma_CUSOLVE ) {
+                    precond->trisolver = Magma_CUSOLVE;
+                    info = magma_zcumicgeneratesolverinfo( precond, queue );
+                }
+            }
+        }
+        else if ( precond->solver == Magma_NONE ) {
+            info = MAGMA_SUCCESS;
+        }
+        else {
+            printf( "error: preconditioner not supported on the CPU.\n" );
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
+    }
+    else if ( precond->solver == Magma_JACOBI ) {
         info = magma_zjacobisetup_diagscal( A, &(precond->d), queue );
     }
+    else if ( precond->solver == Magma_VBJACOBI ) {
+        // host-only: applying it would copy b and x to the CPU and back
+        printf( "error: preconditioner only supported on the CPU.\n" );
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
     else if ( precond->solver == Magma_PASTIX ) {
         //info = magma_zpastixsetup( A, b, precond, queue );
         info = MAGMA_ERR_NOT_SUPPORTED;
@@ -259,6 +425,9 @@ magma_z_precondsetup(
         printf( "error: preconditioner type not yet supported.\n" );
         info = MAGMA_ERR_NOT_SUPPORTED;
     }
+    if ( info == 0 ) {
+        info = magma_z_precond_lval( precond, queue );
+    }
     if( 
         ( solver->solver == Magma_PQMR  || 
           solver->solver == Magma_PQMRMERGE  || 
@@ -289,6 +458,92 @@ magma_z_precondsetup(
 
 
 
+/**
+    Purpose
+    -------
+
+    Updates an existing preconditioner to a matrix A that has the same
+    sparsity pattern as the matrix used in magma_z_precondsetup, but
+    different values, e.g. in a time-stepping or Newton loop.
+    
+    For ParILU and ParILUT (and custom ILU factors, all handled as ParILU
+    after the setup), the pattern of the factors is kept and only value
+    sweeps are run, starting from the previous factors. Depending on the
+    triangular solver, the solve information, the ISAI approximations and
+    the transposed factors are updated as well.
+    For all other preconditioners, MAGMA_ERR_NOT_SUPPORTED is returned and
+    a new setup is needed.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                sparse matrix A with the new values
+                
+    @param[in,out]
+    precond     magma_z_preconditioner
+                preconditioner
+                
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_z_precondrefactor(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    
+    //Chronometry
+    real_Double_t tempo1, tempo2;
+    
+    tempo1 = magma_sync_wtime( queue );
+    
+    if ( precond->solver == Magma_PARILU ) {
+        CHECK( magma_zparilu_cpu_refactor( A, precond, queue ));
+        if ( precond->trisolver == Magma_ISAI ||
+             precond->trisolver == Magma_JACOBI ||
+             precond->trisolver == Magma_VBJACOBI ){
+            magma_zmfree( &precond->LD, queue );
+            magma_zmfree( &precond->UD, queue );
+            CHECK( magma_ziluisaisetup_lower( precond->L, precond->L, &precond->LD, queue ));
+            CHECK( magma_ziluisaisetup_upper( precond->U, precond->U, &precond->UD, queue ));
+            CHECK( magma_z_precond_lval( precond, queue ));
+        }
+        if ( precond->LT.val != NULL ) {  // the transpose was prepared
+            magma_zmfree( &precond->LT, queue );
+            magma_zmfree( &precond->UT, queue );
+            magma_trisolve_free( &precond->cuinfoLT );
+            magma_trisolve_free( &precond->cuinfoUT );
+            CHECK( magma_zcumilusetup_transpose( A, precond, queue ));
+            if ( precond->LDT.val != NULL ) {
+                magma_zmfree( &precond->LDT, queue );
+                magma_zmfree( &precond->UDT, queue );
+                CHECK( magma_zmtranspose( precond->LD, &precond->LDT, queue ));
+                CHECK( magma_zmtranspose( precond->UD, &precond->UDT, queue ));
+            }
+        }
+    }
+    else {
+        printf( "error: refactorization not supported for this preconditioner.\n" );
+        info = MAGMA_ERR_NOT_SUPPORTED;
+    }
+    
+cleanup:
+    tempo2 = magma_sync_wtime( queue );
+    precond->setuptime = tempo2-tempo1;
+    
+    return info;
+}
+
+
+
 /**
     Purpose
     -------
@@ -337,7 +592,10 @@ magma_z_applyprecond(
     magma_z_matrix tmp={Magma_CSR};
 
     if ( precond->solver == Magma_JACOBI ) {
-        CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
+        CHECK( magma_z_precond_diagscal( b, x, precond, queue ));
+    }
+    else if ( precond->solver == Magma_VBJACOBI ) {
+        CHECK( magma_zvbjacobi_apply_cpu( b, x, precond, queue ));
     }
     else if ( precond->solver == Magma_PASTIX ) {
         //CHECK( magma_zapplypastix( b, x, precond, queue ));
@@ -350,7 +608,7 @@ magma_z_applyprecond(
         CHECK( magma_zvinit( &tmp, Magma_DEV, b.num_rows, b.num_cols, MAGMA_Z_ZERO, queue ));
     }
     else if ( precond->solver == Magma_NONE ) {
-        magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
+        magma_z_precond_copy( b, x, queue );      //  x = b
     }
     else {
         printf( "error: preconditioner type not yet supported.\n" );
@@ -429,7 +687,10 @@ magma_z_applyprecond_left(
     
     if( trans == MagmaNoTrans ) {
         if ( precond->solver == Magma_JACOBI ) {
-            CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
+            CHECK( magma_z_precond_diagscal( b, x, precond, queue ));
+        }
+        else if ( precond->solver == Magma_VBJACOBI ) {
+            CHECK( magma_zvbjacobi_apply_cpu( b, x, precond, queue ));
         }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
@@ -474,7 +735,7 @@ magma_z_applyprecond_left(
             magma_z_solver( precond->L, b, x, &zopts, queue );
         }
         else if ( precond->solver == Magma_NONE ) {
-            magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
+            magma_z_precond_copy( b, x, queue );      //  x = b
         }
         else if ( precond->solver == Magma_FUNCTION ) {
             CHECK( magma_zapplycustomprecond_l( b, x, precond, queue ));
@@ -485,7 +746,10 @@ magma_z_applyprecond_left(
         }
     } else if ( trans == MagmaTrans ){
         if ( precond->solver == Magma_JACOBI ) {
-            CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
+            CHECK( magma_z_precond_diagscal( b, x, precond, queue ));
+        }
+        else if ( precond->solver == Magma_VBJACOBI ) {
+            CHECK( magma_zvbjacobi_apply_cpu( b, x, precond, queue ));
         }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
@@ -511,7 +775,7 @@ magma_z_applyprecond_left(
             magma_z_solver( precond->L, b, x, &zopts, queue );
         }
         else if ( precond->solver == Magma_NONE ) {
-            magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
+            magma_z_precond_copy( b, x, queue );      //  x = b
         }
         else if ( precond->solver == Magma_FUNCTION ) {
             CHECK( magma_zapplycustomprecond_l( b, x, precond, queue ));
@@ -599,7 +863,10 @@ magma_z_applyprecond_right(
     
     if( trans == MagmaNoTrans ) {
         if ( precond->solver == Magma_JACOBI ) {
-            magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );    // x = b
+            magma_z_precond_copy( b, x, queue );    // x = b
+        }
+        else if ( precond->solver == Magma_VBJACOBI ) {
+            magma_z_precond_copy( b, x, queue );    // x = b
         }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
@@ -644,7 +911,7 @@ magma_z_applyprecond_right(
             magma_z_solver( precond->U, b, x, &zopts, queue );
         }
         else if ( precond->solver == Magma_NONE ) {
-            magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
+            magma_z_precond_copy( b, x, queue );      //  x = b
         }
       //  else if ( precond->solver == Magma_ISAI ) {
       //      CHECK( magma_zisai_r( b, x, precond, queue ) );
@@ -659,7 +926,10 @@ magma_z_applyprecond_right(
         }
     } else if ( trans == MagmaTrans ){
         if ( precond->solver == Magma_JACOBI ) {
-            magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );    // x = b
+            magma_z_precond_copy( b, x, queue );    // x = b
+        }
+        else if ( precond->solver == Magma_VBJACOBI ) {
+            magma_z_precond_copy( b, x, queue );    // x = b
         }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
@@ -686,7 +956,7 @@ magma_z_applyprecond_right(
             magma_z_solver( precond->U, b, x, &zopts, queue );
         }
         else if ( precond->solver == Magma_NONE ) {
-            magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );      //  x = b
+            magma_z_precond_copy( b, x, queue );      //  x = b
         }
         else if ( precond->solver == Magma_FUNCTION ) {
             CHECK( magma_zapplycustomprecond_r( b, x, precond, queue ));
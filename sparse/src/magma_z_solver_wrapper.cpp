@@ -20,6 +20,14 @@
     system Ax = b. All linear algebra objects are expected to be on the device,
     the linear algebra objects are MAGMA-sparse specific structures 
     (dense matrix b, dense matrix x, sparse/dense matrix A).
+    If A is located on the CPU, b and x have to be on the CPU as well, and
+    the host backend is used: CG, BiCGSTAB, GMRES and IDR (with or without
+    preconditioner, the merged variants map to the same host solvers) run
+    with OpenMP vector kernels, the CPU SpMV and a preconditioner set up on
+    the CPU by magma_z_precondsetup. The communication-avoiding s-step
+    solvers CA-CG and CA-GMRES and the pipelined solvers PIPECG and
+    PIPEGMRES, which overlap their reductions with the SpMV, are only
+    available in the host backend.
     The additional parameter zopts contains information about the solver
     and the preconditioner.
     * the type of solver
@@ -29,6 +37,9 @@
     * ...
     Please see magmasparse_types.h for details about the fields and
     magma_zutil_sparse.cpp for the possible options.
+    If zopts->lval_bits is set and A is in CSR or SELL-P format on the CPU,
+    the SpMV of the Krylov loop reads a single precision (32) or bfloat16
+    (16) copy of the values of A.
 
     Arguments
     ---------
@@ -68,7 +79,73 @@ magma_z_solver(
         printf( "error: sparse RHS not yet supported.\n" );
         return MAGMA_ERR_NOT_SUPPORTED;
     }
-    if( b.num_cols == 1 ){
+    // reduced-precision values for the CPU SpMV, attached to the local copy
+    // of A only, so the caller's matrix is not modified
+    magma_int_t attach_lval = ( zopts->lval_bits != 0 &&
+                                A.memory_location == Magma_CPU &&
+                                A.lval == NULL );
+    // the unpreconditioned solvers run as their preconditioned host variant
+    magma_z_preconditioner precond_none = { Magma_NONE };
+    if ( attach_lval ) {
+        CHECK( magma_zmlag_cpu( zopts->lval_bits, &A, queue ));
+    }
+    if ( A.memory_location == Magma_CPU ) {
+        // host backend: A, b and x are all expected in CPU memory
+        if ( b.memory_location != Magma_CPU || x->memory_location != Magma_CPU ) {
+            printf("error: A is on the CPU, b and x must be on the CPU as well.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        if ( b.num_cols != 1 ) {
+            printf("error: only 1 RHS supported on the CPU.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        switch( zopts->solver_par.solver ) {
+            case  Magma_CG:
+                    CHECK( magma_zpcg_cpu( A, b, x, &zopts->solver_par, &precond_none, queue )); break;
+            case  Magma_CGMERGE:
+                    CHECK( magma_zpcg_merge_cpu( A, b, x, &zopts->solver_par, &precond_none, queue )); break;
+            case  Magma_PCG:
+                    CHECK( magma_zpcg_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_PCGMERGE:
+                    CHECK( magma_zpcg_merge_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_BICGSTAB:
+                    CHECK( magma_zpbicgstab_cpu( A, b, x, &zopts->solver_par, &precond_none, queue )); break;
+            case  Magma_BICGSTABMERGE:
+                    CHECK( magma_zbicgstab_merge_cpu( A, b, x, &zopts->solver_par, queue )); break;
+            case  Magma_PBICGSTAB:
+            case  Magma_PBICGSTABMERGE:
+                    CHECK( magma_zpbicgstab_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_GMRES:
+            case  Magma_PGMRES:
+                    CHECK( magma_zfgmres_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_IDR:
+            case  Magma_IDRMERGE:
+                    CHECK( magma_zpidr_cpu( A, b, x, &zopts->solver_par, &precond_none, queue )); break;
+            case  Magma_PIDR:
+            case  Magma_PIDRMERGE:
+                    CHECK( magma_zpidr_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_CACG:
+                    CHECK( magma_zcacg_cpu( A, b, x, &zopts->solver_par, queue )); break;
+            case  Magma_CAGMRES:
+                    CHECK( magma_zcagmres_cpu( A, b, x, &zopts->solver_par, &precond_none, queue )); break;
+            case  Magma_PCAGMRES:
+                    CHECK( magma_zcagmres_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_PIPECG:
+                    CHECK( magma_zpipecg_cpu( A, b, x, &zopts->solver_par, &precond_none, queue )); break;
+            case  Magma_PPIPECG:
+                    CHECK( magma_zpipecg_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            case  Magma_PIPEGMRES:
+                    CHECK( magma_zpipegmres_cpu( A, b, x, &zopts->solver_par, &precond_none, queue )); break;
+            case  Magma_PPIPEGMRES:
+                    CHECK( magma_zpipegmres_cpu( A, b, x, &zopts->solver_par, &zopts->precond_par, queue )); break;
+            default:
+                    printf("error: solver not supported on the CPU.\n");
+                    info = MAGMA_ERR_NOT_SUPPORTED; break;
+        }
+    }
+    else if( b.num_cols == 1 ){
         switch( zopts->solver_par.solver ) {
             case  Magma_BICG:
                     CHECK( magma_zbicg( A, b, x, &zopts->solver_par, queue )); break;
@@ -161,5 +238,8 @@ magma_z_solver(
         }
     }
 cleanup:
+    if ( attach_lval ) {
+        magma_free_cpu( A.lval );
+    }
     return info; 
 }
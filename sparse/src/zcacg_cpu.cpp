@@ -0,0 +1,429 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+// simulate 2-D arrays at the cost of some arithmetic
+#define Y(i)   (Y+(i)*dofs)
+#define G(i,j) (G[(j)*ldg+(i)])
+#define B(i,j) (B[(j)*ldg+(i)])
+#define T(i,j) (T[(j)*warmup+(i)])
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+// relative gap between the residual norm recomputed from the new basis and
+// the one updated in the coordinates of the previous basis, above which the
+// basis is considered too ill-conditioned and the solver falls back to s=1
+#define CACG_RESGAP    0.1
+
+
+// x^H * G * y for vectors of length n
+static magmaDoubleComplex
+zquad( magma_int_t n, const magmaDoubleComplex *G, magma_int_t ldg,
+       const magmaDoubleComplex *x, const magmaDoubleComplex *y )
+{
+    magmaDoubleComplex sum = MAGMA_Z_ZERO;
+    for( magma_int_t i=0; i < n; i++ ) {
+        magmaDoubleComplex row = MAGMA_Z_ZERO;
+        for( magma_int_t j=0; j < n; j++ ) {
+            row += G(i,j) * y[j];
+        }
+        sum += MAGMA_Z_CONJ( x[i] ) * row;
+    }
+    return sum;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex Hermitian N-by-N positive definite matrix A.
+    This is a CPU implementation of the communication-avoiding (s-step)
+    Conjugate Gradient method, for A, B and X stored in the CPU memory.
+
+    Each outer step builds the bases P = [p, rho_1(A) p, ..., rho_s(A) p]
+    and R = [r, rho_1(A) r, ..., rho_{s-1}(A) r] with 2s-1 SpMVs, and
+    computes their Gram matrix [P,R]^H [P,R] with one global reduction
+    (magma_zmdotc_cpu). The next s CG iterations then run on coordinate
+    vectors of length 2s+1 without touching the long vectors, and x, r
+    and p are recovered from the bases at the end of the outer step.
+    Classical CG needs two global reductions per iteration, this needs
+    one per s iterations.
+
+    solver_par->sstep sets s. solver_par->basis selects the polynomials
+    rho_i: Magma_MONOMIAL uses powers of A, Magma_NEWTON uses products of
+    (A - theta_j I) with Leja-ordered Ritz values theta_j, estimated from
+    the Lanczos coefficients of 2s classical CG iterations run first.
+    If the basis becomes numerically rank deficient - a non-positive
+    quadratic form in the coordinates, or a gap above 10% between the
+    recomputed and the updated residual norm - the solver falls back to
+    s=1, i.e. classical CG with one reduction per iteration, for the rest
+    of the solve.
+
+    numiter counts CG iterations, spmv_count all SpMVs including the ones
+    of discarded bases.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zposv
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcacg_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_CACG;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
+    magma_sparse_cycles_t t0 = magma_sparse_cycles();
+    magma_solver_phase cost[Magma_NUM_PHASES];
+    magma_z_preconditioner precond_none = { Magma_NONE };
+
+    magma_int_t dofs = A.num_rows;
+    magma_int_t s = max( 1, min( solver_par->sstep, dofs ));
+    magma_int_t newton = ( solver_par->basis == Magma_NEWTON && s > 1 );
+    // classical iterations for the Lanczos coefficients of the Newton basis
+    magma_int_t warmup = newton ? min( 2*s, dofs ) : 0;
+    magma_int_t ldg = 2*s+1;
+    // basis length of the current outer step
+    magma_int_t sb = newton ? 1 : s;
+    magma_int_t fallback = 0, converged = 0, nb, sbnext;
+
+    // solver variables
+    magmaDoubleComplex alpha, beta, den;
+    double nom0, r0, res = 0.0, nomb, rr, rrnew, rrest = 0.0, alphaold = 1.0, betaold = 0.0;
+    // local variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE;
+    real_Double_t tempo1, tempo2;
+    double residual;
+
+    // CPU workspace
+    magma_z_matrix r={Magma_CSR}, Ya={Magma_CSR}, Yb={Magma_CSR};
+    magma_z_matrix v_t={Magma_CSR}, w_t={Magma_CSR};
+    magmaDoubleComplex *Y, *Ynext, *tmp;
+    magmaDoubleComplex *G=NULL, *B=NULL, *T=NULL, *theta=NULL, *C=NULL,
+                       *xc=NULL, *Bp=NULL, *rcold=NULL, *xcold=NULL;
+    magmaDoubleComplex *rc, *pc;
+
+    v_t.memory_location = Magma_CPU;
+    v_t.num_rows = dofs;
+    v_t.num_cols = 1;
+    v_t.val = NULL;
+    v_t.storage_type = Magma_DENSE;
+    w_t = v_t;
+
+    CHECK( magma_zsolverinfo_costs( A, &precond_none, cost, queue ));
+    CHECK( magma_zvinit( &r,  Magma_CPU, dofs, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &Ya, Magma_CPU, dofs*ldg, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &Yb, Magma_CPU, dofs*ldg, 1, c_zero, queue ));
+    CHECK( magma_zmalloc_cpu( &G, ldg*ldg ));
+    CHECK( magma_zmalloc_cpu( &B, ldg*ldg ));
+    CHECK( magma_zmalloc_cpu( &C, 2*ldg ));
+    CHECK( magma_zmalloc_cpu( &xc, ldg ));
+    CHECK( magma_zmalloc_cpu( &Bp, ldg ));
+    CHECK( magma_zmalloc_cpu( &xcold, ldg ));
+    CHECK( magma_zmalloc_cpu( &rcold, ldg ));
+    CHECK( magma_zmalloc_cpu( &theta, s ));
+    CHECK( magma_zmalloc_cpu( &T, max( 1, warmup*warmup )));
+    // coordinates of p and r are the two columns of C
+    pc = C;
+    rc = C + ldg;
+    Y = Ya.val;
+    Ynext = Yb.val;
+    for( magma_int_t i=0; i < s; i++ ) {
+        theta[i] = c_zero;
+    }
+    for( magma_int_t i=0; i < warmup*warmup; i++ ) {
+        T[i] = c_zero;
+    }
+
+    // solver setup
+    CHECK( magma_zresidualvec( A, b, *x, &r, &nom0, queue ));
+    magma_zcopy_cpu( dofs, r.val, Y(0), queue );                      // p = r
+    magma_zcopy_cpu( dofs, r.val, Y(sb+1), queue );
+    solver_par->init_res = nom0;
+
+    nomb = magma_dznrm2_cpu( dofs, b.val, queue );
+    magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SETUP, t0, 1, 1 );
+    if ( nomb == 0.0 ){
+        nomb=1.0;
+    }
+    if ( (r0 = nomb * solver_par->rtol) < ATOLERANCE ){
+        r0 = ATOLERANCE;
+    }
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    res = nom0;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t)nom0;
+        solver_par->timing[0] = 0.0;
+    }
+    if ( nom0 < r0 ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    //Chronometry
+    tempo1 = magma_wtime();
+
+    // start iteration
+    do
+    {
+        // bases and Gram matrix, rebuilt with s=1 if the basis is unusable
+        while( 1 ) {
+            nb = 2*sb+1;
+            for( magma_int_t i=0; i < sb; i++ ) {                     // P
+                v_t.val = Y(i);
+                w_t.val = Y(i+1);
+                t0 = magma_sparse_cycles();
+                CHECK( magma_z_spmv( c_one, A, v_t, c_zero, w_t, queue ));
+                magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+                solver_par->spmv_count++;
+                if ( theta[i] != c_zero ) {
+                    magma_zaxpy_cpu( dofs, -theta[i], Y(i), Y(i+1), queue );
+                }
+            }
+            for( magma_int_t i=0; i < sb-1; i++ ) {                   // R
+                v_t.val = Y(sb+1+i);
+                w_t.val = Y(sb+2+i);
+                t0 = magma_sparse_cycles();
+                CHECK( magma_z_spmv( c_one, A, v_t, c_zero, w_t, queue ));
+                magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+                solver_par->spmv_count++;
+                if ( theta[i] != c_zero ) {
+                    magma_zaxpy_cpu( dofs, -theta[i], Y(sb+1+i), Y(sb+2+i), queue );
+                }
+            }
+            // the only global reduction of the outer step, reads Y once
+            t0 = magma_sparse_cycles();
+            CHECK( magma_zmdotc_cpu( dofs, nb, Y, dofs, nb, Y, dofs, G, ldg, queue ));
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, nb/2.0, nb*nb );
+
+            // G(sb+1,sb+1) = r^H r, compare with the coordinate update
+            rr = MAGMA_Z_REAL( G(sb+1,sb+1) );
+            if ( sb > 1 && ( rr != rr || ( rrest > 0.0 &&
+                 fabs( rr - rrest ) > CACG_RESGAP * rr ))) {
+                fallback = 1;
+                magma_zcopy_cpu( dofs, Y(sb+1), Y(2), queue );       // r
+                sb = 1;
+                continue;
+            }
+            break;
+        }
+
+        // change of basis, A * Y(:,i) = Y * B(:,i)
+        for( magma_int_t i=0; i < nb*ldg; i++ ) {
+            B[i] = c_zero;
+        }
+        for( magma_int_t i=0; i < sb; i++ ) {
+            B(i,i) = theta[i];
+            B(i+1,i) = c_one;
+        }
+        for( magma_int_t i=0; i < sb-1; i++ ) {
+            B(sb+1+i,sb+1+i) = theta[i];
+            B(sb+2+i,sb+1+i) = c_one;
+        }
+
+        // coordinates: x' = 0, p' = e_0, r' = e_{sb+1}
+        for( magma_int_t i=0; i < nb; i++ ) {
+            xc[i] = c_zero;
+            pc[i] = c_zero;
+            rc[i] = c_zero;
+        }
+        pc[0] = c_one;
+        rc[sb+1] = c_one;
+
+        // s CG iterations on the coordinates
+        for( magma_int_t j=0; j < sb; j++ ) {
+            for( magma_int_t i=0; i < nb; i++ ) {                     // Bp = B p'
+                Bp[i] = c_zero;
+                for( magma_int_t k=0; k < nb; k++ ) {
+                    Bp[i] += B(i,k) * pc[k];
+                }
+            }
+            den = zquad( nb, G, ldg, pc, Bp );                        // den = p^H A p
+            if ( !( MAGMA_Z_REAL(den) > 0.0 ) ) {
+                if ( sb > 1 ) {
+                    fallback = 1;
+                    break;
+                }
+                info = MAGMA_NONSPD;
+                solver_par->runtime = (real_Double_t) magma_wtime() - tempo1;
+                goto cleanup;
+            }
+            alpha = MAGMA_Z_MAKE( rr, 0.0 ) / den;
+            for( magma_int_t i=0; i < nb; i++ ) {
+                xcold[i] = xc[i];
+                rcold[i] = rc[i];
+                xc[i] += alpha * pc[i];                               // x' = x' + alpha p'
+                rc[i] -= alpha * Bp[i];                               // r' = r' - alpha B p'
+            }
+            rrnew = MAGMA_Z_REAL( zquad( nb, G, ldg, rc, rc ));
+            if ( !( rrnew >= 0.0 ) ) {
+                if ( sb > 1 ) {
+                    // roll back this iteration
+                    for( magma_int_t i=0; i < nb; i++ ) {
+                        xc[i] = xcold[i];
+                        rc[i] = rcold[i];
+                    }
+                    fallback = 1;
+                    break;
+                }
+                rrnew = 0.0;
+            }
+            beta = MAGMA_Z_MAKE( rrnew / rr, 0.0 );
+            for( magma_int_t i=0; i < nb; i++ ) {
+                pc[i] = rc[i] + beta * pc[i];                         // p' = r' + beta p'
+            }
+
+            // Lanczos tridiagonal matrix for the Newton shifts
+            if ( solver_par->numiter < warmup ) {
+                magma_int_t k = solver_par->numiter;
+                double a = MAGMA_Z_REAL( alpha );
+                T(k,k) = MAGMA_Z_MAKE( 1.0/a + betaold/alphaold, 0.0 );
+                if ( k+1 < warmup ) {
+                    T(k+1,k) = MAGMA_Z_MAKE( sqrt( MAGMA_Z_REAL( beta ))/a, 0.0 );
+                    T(k,k+1) = T(k+1,k);
+                }
+                alphaold = a;
+                betaold = MAGMA_Z_REAL( beta );
+            }
+
+            solver_par->numiter++;
+            rr = rrnew;
+            res = sqrt( rr );
+            if ( solver_par->verbose > 0 ) {
+                tempo2 = magma_wtime();
+                if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                    solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                            = (real_Double_t) res;
+                    solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                            = (real_Double_t) tempo2-tempo1;
+                }
+            }
+            if ( res/nomb <= solver_par->rtol || res <= solver_par->atol ){
+                converged = 1;
+                break;
+            }
+            if ( solver_par->numiter >= solver_par->maxiter ) {
+                break;
+            }
+        }
+
+        // basis length of the next outer step
+        sbnext = sb;
+        if ( fallback ) {
+            sbnext = 1;
+        } else if ( newton && sb == 1 && solver_par->numiter >= warmup ) {
+            magma_znewtonshifts_cpu( warmup, T, warmup, s, theta, queue );
+            sbnext = s;
+        }
+
+        // x = x + Y x', [p, r] = Y [p', r'] in the layout of the next basis
+        magma_zmgemm_cpu( dofs, nb, 1, c_one, Y, dofs, xc, ldg, c_one, x->val, dofs, queue );
+        if ( !converged ) {
+            magma_zmgemm_cpu( dofs, nb, 2, c_one, Y, dofs, C, ldg, c_zero,
+                              Ynext, (sbnext+1)*dofs, queue );
+        }
+        rrest = rr;
+        tmp = Y;
+        Y = Ynext;
+        Ynext = tmp;
+        sb = sbnext;
+    }
+    while ( !converged && solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    CHECK(  magma_zresidualvec( A, b, *x, &r, &residual, queue));
+    solver_par->iter_res = res;
+    solver_par->final_res = residual;
+
+    if ( solver_par->numiter < solver_par->maxiter || converged ) {
+        info = MAGMA_SUCCESS;
+    } else if ( solver_par->init_res > solver_par->final_res ) {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_SLOW_CONVERGENCE;
+        if( solver_par->iter_res < solver_par->rtol*nomb ||
+            solver_par->iter_res < solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+        }
+    }
+    else {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_DIVERGENCE;
+    }
+    if ( fallback && solver_par->verbose > 0 ) {
+        printf("%% CA-CG: s-step basis ill-conditioned, fell back to s=1.\n");
+    }
+
+cleanup:
+    magma_zmfree( &r, queue );
+    magma_zmfree( &Ya, queue );
+    magma_zmfree( &Yb, queue );
+    magma_free_cpu( G );
+    magma_free_cpu( B );
+    magma_free_cpu( C );
+    magma_free_cpu( xc );
+    magma_free_cpu( Bp );
+    magma_free_cpu( xcold );
+    magma_free_cpu( rcold );
+    magma_free_cpu( theta );
+    magma_free_cpu( T );
+
+    solver_par->info = info;
+    return info;
+}   /* magma_zcacg_cpu */
@@ -0,0 +1,468 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+// simulate 2-D arrays at the cost of some arithmetic
+#define Q(i) (Q.val+(i)*dofs)
+#define Hh(i,j) (Hh[(j)*ldh+(i)])
+#define Hr(i,j) (Hr[(j)*ldh+(i)])
+#define RV(i,j) (RV[(j)*ldh+(i)])
+#define MX(i,j) (Mx[(j)*ldh+(i)])
+
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+
+// same rotations as in magma_zfgmres
+static void
+GeneratePlaneRotation(magmaDoubleComplex dx, magmaDoubleComplex dy, magmaDoubleComplex *cs, magmaDoubleComplex *sn)
+{
+#if defined(PRECISION_s) | defined(PRECISION_d)
+    if (dy == MAGMA_Z_ZERO) {
+        *cs = MAGMA_Z_ONE;
+        *sn = MAGMA_Z_ZERO;
+    } else if (MAGMA_Z_ABS((dy)) > MAGMA_Z_ABS((dx))) {
+        magmaDoubleComplex temp = dx / dy;
+        *sn = MAGMA_Z_ONE / magma_zsqrt( ( MAGMA_Z_ONE + temp*temp));
+        *cs = temp * (*sn);
+    } else {
+        magmaDoubleComplex temp = dy / dx;
+        *cs = MAGMA_Z_ONE / magma_zsqrt( ( MAGMA_Z_ONE + temp*temp ));
+        *sn = temp * (*cs);
+    }
+#else
+    real_Double_t rho = sqrt(MAGMA_Z_REAL(MAGMA_Z_CONJ(dx)*dx + MAGMA_Z_CONJ(dy)*dy));
+    *cs = dx / rho;
+    *sn = dy / rho;
+#endif
+}
+
+static void ApplyPlaneRotation(magmaDoubleComplex *dx, magmaDoubleComplex *dy, magmaDoubleComplex cs, magmaDoubleComplex sn)
+{
+#if defined(PRECISION_s) | defined(PRECISION_d)
+    magmaDoubleComplex temp = (*dx);
+    *dx =  cs * (*dx) + sn * (*dy);
+    *dy = -sn * temp + cs * (*dy);
+#else
+    magmaDoubleComplex temp  =  MAGMA_Z_CONJ(cs) * (*dx) +  MAGMA_Z_CONJ(sn) * (*dy);
+    *dy = -(sn) * (*dx) + cs * (*dy);
+    *dx = temp;
+#endif
+}
+
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex sparse matrix stored in the CPU memory.
+    X and B are complex vectors stored on the CPU memory.
+    This is a CPU implementation of the right-preconditioned
+    communication-avoiding GMRES (CA-GMRES), restarted after
+    solver_par->restart steps.
+
+    Instead of one SpMV followed by the orthogonalization of one vector,
+    each block generates s basis vectors with s SpMVs (matrix powers
+    kernel), and orthogonalizes them at once: block Gram-Schmidt against
+    the previous basis vectors, then TSQR (magma_ztsqr_cpu) within the
+    block. The Hessenberg matrix of the Arnoldi relation is recovered from
+    the R factors and the change of basis. solver_par->ortho selects the
+    block Gram-Schmidt variant:
+    - Magma_FUSED_CGSO: block classical Gram-Schmidt, one reduction per
+      block, plus one for TSQR;
+    - Magma_CGSO: block classical Gram-Schmidt with one
+      reorthogonalization pass (BCGS2), two reductions per block;
+    - Magma_MGSO: block modified Gram-Schmidt over panels of s previous
+      vectors, one reduction per panel.
+
+    solver_par->sstep sets s. solver_par->basis selects the basis
+    polynomials: Magma_MONOMIAL uses powers of A M^(-1), Magma_NEWTON
+    uses products of (A M^(-1) - theta_j I) with Leja-ordered Ritz values
+    theta_j from the Hessenberg matrix of a first restart cycle, which is
+    run with s=1.
+    If a block is numerically rank deficient (a diagonal entry of its R
+    factor below sqrt(eps) times the norm of the column), it is discarded
+    and the solver falls back to s=1, i.e. GMRES with classical
+    Gram-Schmidt, for the rest of the solve.
+
+    numiter counts Krylov steps, spmv_count all SpMVs including the
+    residual computations at restart and the ones of discarded blocks.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                descriptor for matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b vector
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                preconditioner
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgesv
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcagmres_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    magma_int_t dofs = A.num_rows;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_PCAGMRES;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
+    magma_sparse_cycles_t t0 = magma_sparse_cycles();
+    magma_solver_phase cost[Magma_NUM_PHASES];
+
+    //Chronometry
+    real_Double_t tempo1, tempo2;
+
+    magma_int_t m = max( 1, min( solver_par->restart, dofs ));
+    magma_int_t ldh = m+1; // used inside Hh, Hr, RV and MX macros
+    magma_int_t s = max( 1, min( solver_par->sstep, m ));
+    magma_int_t newton = ( solver_par->basis == Magma_NEWTON && s > 1 );
+    // basis length of the blocks, s=1 for the first cycle of the Newton basis
+    magma_int_t sb = newton ? 1 : s;
+    magma_int_t shifts = !newton, fallback = 0, converged = 0, first = 1;
+    magma_int_t i, j, k, js, sc, qn, last = -1, bad, mrows;
+    magma_int_t npass = ( solver_par->ortho == Magma_CGSO ) ? 2 : 1;
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE, c_mone = MAGMA_Z_NEG_ONE;
+    double betanom = 0.0, nomb, r0 = 0.0, colnrm;
+    double tol = sqrt( lapackf77_dlamch( "E" ));
+    double residual;
+
+    // views of the columns of Q
+    magma_z_matrix v_t={Magma_CSR}, w_t={Magma_CSR}, t={Magma_CSR}, t2={Magma_CSR}, u={Magma_CSR}, Q={Magma_CSR};
+    v_t.memory_location = Magma_CPU;
+    v_t.num_rows = dofs;
+    v_t.num_cols = 1;
+    v_t.val = NULL;
+    v_t.storage_type = Magma_DENSE;
+    w_t = v_t;
+
+    magmaDoubleComplex *Hh=NULL, *Hr=NULL, *RV=NULL, *Mx=NULL, *Cw=NULL,
+                       *g=NULL, *y=NULL, *cs=NULL, *sn=NULL, *theta=NULL;
+
+    CHECK( magma_zsolverinfo_costs( A, precond_par, cost, queue ));
+    CHECK( magma_zvinit( &t, Magma_CPU, dofs, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &t2, Magma_CPU, dofs, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &u, Magma_CPU, dofs, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &Q, Magma_CPU, dofs*(m+1), 1, c_zero, queue ));
+
+    CHECK( magma_zmalloc_cpu( &Hh, ldh*m ));
+    CHECK( magma_zmalloc_cpu( &Hr, ldh*m ));
+    CHECK( magma_zmalloc_cpu( &RV, ldh*(s+1) ));
+    CHECK( magma_zmalloc_cpu( &Mx, ldh*s ));
+    CHECK( magma_zmalloc_cpu( &Cw, ldh*s ));
+    CHECK( magma_zmalloc_cpu( &g,  m+1 ));
+    CHECK( magma_zmalloc_cpu( &y,  m+1 ));
+    CHECK( magma_zmalloc_cpu( &cs, m ));
+    CHECK( magma_zmalloc_cpu( &sn, m ));
+    CHECK( magma_zmalloc_cpu( &theta, s ));
+    for (i = 0; i < s; i++)
+        theta[i] = c_zero;
+    for (i = 0; i < ldh*m; i++)
+        Hh[i] = c_zero;
+
+    nomb = magma_dznrm2_cpu( dofs, b.val, queue );
+    if ( nomb == 0.0 ){
+        nomb=1.0;
+    }
+    if ( (r0 = nomb * solver_par->rtol) < ATOLERANCE ){
+        r0 = ATOLERANCE;
+    }
+    magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SETUP, t0, 1, 1 );
+
+    tempo1 = magma_wtime();
+    do
+    {
+        // Q(0) = ( b - A x ) / beta
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, *x, c_zero, t, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+        solver_par->spmv_count++;
+        magma_zcopy_cpu( dofs, b.val, Q(0), queue );
+        magma_zaxpy_cpu( dofs, c_mone, t.val, Q(0), queue );
+        t0 = magma_sparse_cycles();
+        betanom = magma_dznrm2_cpu( dofs, Q(0), queue );
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 0.5, 0.5 );
+        if( betanom != betanom ){
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+        if ( first ) {
+            first = 0;
+            solver_par->init_res = betanom;
+            if ( solver_par->verbose > 0 ) {
+                solver_par->res_vec[0] = (real_Double_t) betanom;
+                solver_par->timing[0] = 0.0;
+            }
+            if ( betanom < r0 ) {
+                solver_par->final_res = solver_par->init_res;
+                solver_par->iter_res = solver_par->init_res;
+                info = MAGMA_SUCCESS;
+                goto cleanup;
+            }
+        }
+        magma_zscal_cpu( dofs, MAGMA_Z_MAKE( 1.0/betanom, 0.0 ), Q(0), queue );
+        for (i = 1; i < m+1; i++)
+            g[i] = c_zero;
+        g[0] = MAGMA_Z_MAKE( betanom, 0.0 );
+
+        js = 0;
+        last = -1;
+        while ( js < m && !converged && solver_par->numiter < solver_par->maxiter ) {
+            sc = min( sb, m - js );
+
+            // matrix powers: Q(js+i+1) = ( A M^(-1) - theta_i I ) Q(js+i)
+            for (i = 0; i < sc; i++) {
+                v_t.val = Q(js+i);
+                t0 = magma_sparse_cycles();
+                CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, v_t, &t, precond_par, queue ));
+                CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, t, &t2, precond_par, queue ));
+                magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+                w_t.val = Q(js+i+1);
+                t0 = magma_sparse_cycles();
+                CHECK( magma_z_spmv( c_one, A, t2, c_zero, w_t, queue ));
+                magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+                solver_par->spmv_count++;
+                if ( theta[i] != c_zero ) {
+                    magma_zaxpy_cpu( dofs, -theta[i], Q(js+i), Q(js+i+1), queue );
+                }
+            }
+
+            // RV: coordinates of [Q(js), raw block] in the new basis Q(0:js+sc)
+            for (i = 0; i < ldh*(sc+1); i++)
+                RV[i] = c_zero;
+            RV(js,0) = c_one;
+
+            // block Gram-Schmidt against Q(0:js)
+            t0 = magma_sparse_cycles();
+            for (k = 0; k <= js; k += qn) {
+                qn = ( solver_par->ortho == Magma_MGSO ) ? min( s, js+1-k ) : js+1;
+                CHECK( magma_zmdotc_cpu( dofs, qn, Q(k), dofs, sc, Q(js+1), dofs,
+                                         &RV(k,1), ldh, queue ));
+                magma_zmgemm_cpu( dofs, qn, sc, c_mone, Q(k), dofs, &RV(k,1), ldh,
+                                  c_one, Q(js+1), dofs, queue );
+            }
+            if ( solver_par->ortho == Magma_CGSO ) {
+                // reorthogonalization
+                CHECK( magma_zmdotc_cpu( dofs, js+1, Q(0), dofs, sc, Q(js+1), dofs,
+                                         Cw, ldh, queue ));
+                magma_zmgemm_cpu( dofs, js+1, sc, c_mone, Q(0), dofs, Cw, ldh,
+                                  c_one, Q(js+1), dofs, queue );
+                for (j = 0; j < sc; j++)
+                    for (k = 0; k <= js; k++)
+                        RV(k,j+1) += Cw[ j*ldh + k ];
+            }
+            // TSQR within the block
+            CHECK( magma_ztsqr_cpu( dofs, sc, Q(js+1), dofs, &RV(js+1,1), ldh, queue ));
+            // each pass reads Q(0:js) once and the block three times,
+            // TSQR makes about three passes over the block
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_ORTHO, t0,
+                                ( npass*( js+1 + 3*sc ) + 3*sc ) / 5.0,
+                                npass*( js+1 )*sc + sc*sc );
+
+            // safeguard: a column nearly in the span of the previous ones
+            bad = 0;
+            for (j = 0; j < sc; j++) {
+                colnrm = 0.0;
+                for (k = 0; k <= js+sc; k++) {
+                    if ( magma_z_isnan_inf( RV(k,j+1) ) )
+                        bad = 1;
+                    colnrm += MAGMA_Z_REAL( MAGMA_Z_CONJ( RV(k,j+1) ) * RV(k,j+1) );
+                }
+                if ( j < sc-1 && MAGMA_Z_ABS( RV(js+1+j,j+1) ) <= tol * sqrt( colnrm ) )
+                    bad = 1;
+            }
+            if ( bad && sc > 1 ) {
+                // discard the block, Q(0:js) is untouched
+                sb = 1;
+                fallback = 1;
+                continue;
+            }
+            else if ( bad ) {
+                info = MAGMA_DIVERGENCE;
+                break;
+            }
+
+            // Hessenberg columns js:js+sc-1:
+            // H = ( RV * Bmat - [ H(0:js,0:js-1) * RV(0:js-1,0:sc-1); 0 ] ) * T^(-1)
+            mrows = js+sc+1;
+            for (j = 0; j < sc; j++)
+                for (k = 0; k < mrows; k++)
+                    MX(k,j) = theta[j] * RV(k,j) + RV(k,j+1);
+            if ( js > 0 ) {
+                magma_int_t js1 = js+1;
+                blasf77_zgemm( "N", "N", &js1, &sc, &js, &c_mone, Hh, &ldh,
+                               RV, &ldh, &c_one, Mx, &ldh );
+            }
+            blasf77_ztrsm( "R", "U", "N", "N", &mrows, &sc, &c_one,
+                           &RV(js,0), &ldh, Mx, &ldh );
+            for (j = 0; j < sc; j++)
+                for (k = 0; k < ldh; k++)
+                    Hh(k,js+j) = ( k <= js+j+1 ) ? MX(k,j) : c_zero;
+
+            // Givens rotations on the new columns
+            for (j = 0; j < sc; j++) {
+                i = js+j;
+                for (k = 0; k <= i+1; k++)
+                    Hr(k,i) = Hh(k,i);
+                for (k = 0; k < i; k++)
+                    ApplyPlaneRotation(&Hr(k,i), &Hr(k+1,i), cs[k], sn[k]);
+
+                GeneratePlaneRotation(Hr(i,i), Hr(i+1,i), &cs[i], &sn[i]);
+                ApplyPlaneRotation(&Hr(i,i), &Hr(i+1,i), cs[i], sn[i]);
+                ApplyPlaneRotation(&g[i], &g[i+1], cs[i], sn[i]);
+
+                solver_par->numiter++;
+                last = i;
+                betanom = MAGMA_Z_ABS( g[i+1] );
+                if ( solver_par->verbose > 0 ) {
+                    tempo2 = magma_wtime();
+                    if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                        solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                                = (real_Double_t) betanom;
+                        solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                                = (real_Double_t) tempo2-tempo1;
+                    }
+                }
+                if ( betanom/nomb <= solver_par->rtol || betanom <= solver_par->atol ) {
+                    converged = 1;
+                    break;
+                }
+                if ( solver_par->numiter >= solver_par->maxiter )
+                    break;
+            }
+            js += sc;
+        }
+        if ( last < 0 ) {
+            break;
+        }
+
+        // Newton shifts from the Hessenberg matrix of the first cycle
+        if ( !shifts && !fallback ) {
+            magma_znewtonshifts_cpu( last+1, Hh, ldh, s, theta, queue );
+            shifts = 1;
+            sb = s;
+        }
+
+        // solve upper triangular system
+        for (j = 0; j <= last; j++)
+            y[j] = g[j];
+        for (j = last; j >= 0; j--)
+        {
+            y[j] /= Hr(j,j);
+            for (k = j-1; k >= 0; k--)
+                y[k] -= Hr(k,j) * y[j];
+        }
+
+        // x = x + M^(-1) Q y
+        magma_zmgemm_cpu( dofs, last+1, 1, c_one, Q(0), dofs, y, m+1, c_zero, u.val, dofs, queue );
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, u, &t, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, t, &t2, precond_par, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+        magma_zaxpy_cpu( dofs, c_one, t2.val, x->val, queue );
+    }
+    while ( !converged && info != MAGMA_DIVERGENCE
+                && solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    CHECK( magma_zresidual( A, b, *x, &residual, queue ));
+    solver_par->iter_res = betanom;
+    solver_par->final_res = residual;
+
+    // keep a breakdown detected in the iteration
+    if ( info != MAGMA_NOTCONVERGED ) {
+        goto cleanup;
+    }
+
+    if ( converged ) {
+        info = MAGMA_SUCCESS;
+    } else if ( solver_par->init_res > solver_par->final_res ) {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) betanom;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_SLOW_CONVERGENCE;
+        if( solver_par->iter_res < solver_par->rtol*nomb ||
+            solver_par->iter_res < solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+        }
+    }
+    else {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) betanom;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_DIVERGENCE;
+    }
+    if ( fallback && solver_par->verbose > 0 ) {
+        printf("%% CA-GMRES: s-step basis ill-conditioned, fell back to s=1.\n");
+    }
+
+cleanup:
+    magma_free_cpu( Hh );
+    magma_free_cpu( Hr );
+    magma_free_cpu( RV );
+    magma_free_cpu( Mx );
+    magma_free_cpu( Cw );
+    magma_free_cpu( g );
+    magma_free_cpu( y );
+    magma_free_cpu( cs );
+    magma_free_cpu( sn );
+    magma_free_cpu( theta );
+
+    magma_zmfree( &Q, queue );
+    magma_zmfree( &t, queue );
+    magma_zmfree( &t2, queue );
+    magma_zmfree( &u, queue );
+
+    solver_par->info = info;
+    return info;
+} /* magma_zcagmres_cpu */
@@ -16,6 +16,30 @@
 #define PRECISION_z
 
 
+/*
+    x = x - w + d, the update of the ISAI relaxation steps. Runs on the host
+    if the vectors are in CPU memory.
+*/
+static void
+magma_zisai_update(
+    magma_int_t n,
+    magma_z_matrix w,
+    magma_z_matrix d,
+    magma_z_matrix *x,
+    magma_queue_t queue )
+{
+    if( x->memory_location == Magma_CPU ){
+        #pragma omp parallel for
+        for( magma_int_t i=0; i<n; i++ ){
+            x->val[i] = x->val[i] - w.val[i] + d.val[i];
+        }
+    } else {
+        magma_zaxpy( n, -MAGMA_Z_ONE, w.dval, 1 , x->dval, 1, queue );        // x = x - w
+        magma_zaxpy( n, MAGMA_Z_ONE, d.dval, 1 , x->dval, 1, queue );         // x = x + d
+    }
+}
+
+
 /***************************************************************************//**
     Purpose
     -------
@@ -61,8 +85,7 @@ magma_zisai_l(
         for( int z=0; z<precond->maxiter; z++ ){
             magma_z_spmv( MAGMA_Z_ONE, precond->L, *x, MAGMA_Z_ZERO, precond->work1, queue ); // work1 = L * x
             magma_z_spmv( MAGMA_Z_ONE, precond->LD, precond->work1, MAGMA_Z_ZERO, precond->work2, queue ); // work2 = L_d^(-1)work1
-            magma_zaxpy( b.num_rows*b.num_cols, -MAGMA_Z_ONE, precond->work2.dval, 1 , x->dval, 1, queue );        // x = - work2
-            magma_zaxpy( b.num_rows*b.num_cols, MAGMA_Z_ONE, precond->d.dval, 1 , x->dval, 1, queue );        // x = d + x = L_d^(-1)b - work2 = L_d^(-1)b - L_d^(-1) * L * x
+            magma_zisai_update( b.num_rows*b.num_cols, precond->work2, precond->d, x, queue ); // x = x - work2 + d
         }
     }
 
@@ -115,8 +138,7 @@ magma_zisai_r(
         for( int z=0; z<precond->maxiter; z++ ){
             magma_z_spmv( MAGMA_Z_ONE, precond->U, *x, MAGMA_Z_ZERO, precond->work1, queue ); // work1=b+Lb
             magma_z_spmv( MAGMA_Z_ONE, precond->UD, precond->work1, MAGMA_Z_ZERO, precond->work2, queue ); // x=x+L^(-1)work1
-            magma_zaxpy( b.num_rows*b.num_cols, -MAGMA_Z_ONE, precond->work2.dval, 1 , x->dval, 1, queue );        // t = t + c
-            magma_zaxpy( b.num_rows*b.num_cols, MAGMA_Z_ONE, precond->d.dval, 1 , x->dval, 1, queue );        // t = t + c
+            magma_zisai_update( b.num_rows*b.num_cols, precond->work2, precond->d, x, queue ); // x = x - work2 + d
         }
     }
 
@@ -169,8 +191,7 @@ magma_zisai_l_t(
         for( int z=0; z<precond->maxiter; z++ ){
             magma_z_spmv( MAGMA_Z_ONE, precond->LT, *x, MAGMA_Z_ZERO, precond->work1, queue ); // work1=L*M_L*b
             magma_z_spmv( MAGMA_Z_ONE, precond->LDT, precond->work1, MAGMA_Z_ZERO, precond->work2, queue ); // work2 = M_L*L*M_L*b
-            magma_zaxpy( b.num_rows*b.num_cols, -MAGMA_Z_ONE, precond->work2.dval, 1 , x->dval, 1, queue );        // x = M_L*x -M_L*L*M_L*b
-            magma_zaxpy( b.num_rows*b.num_cols, MAGMA_Z_ONE, precond->d.dval, 1 , x->dval, 1, queue );        // x = M_L*x + M_L*b - M_L *L*M_L *b 
+            magma_zisai_update( b.num_rows*b.num_cols, precond->work2, precond->d, x, queue ); // x = x - work2 + d
         }
     }
 
@@ -223,8 +244,7 @@ magma_zisai_r_t(
         for( int z=0; z<precond->maxiter; z++ ){
             magma_z_spmv( MAGMA_Z_ONE, precond->UT, *x, MAGMA_Z_ZERO, precond->work1, queue ); // work1=b+Lb
             magma_z_spmv( MAGMA_Z_ONE, precond->UDT, precond->work1, MAGMA_Z_ZERO, precond->work2, queue ); // x=x+L^(-1)work1
-            magma_zaxpy( b.num_rows*b.num_cols, -MAGMA_Z_ONE, precond->work2.dval, 1 , x->dval, 1, queue );        // t = t + c
-            magma_zaxpy( b.num_rows*b.num_cols, MAGMA_Z_ONE, precond->d.dval, 1 , x->dval, 1, queue );        // t = t + c
+            magma_zisai_update( b.num_rows*b.num_cols, precond->work2, precond->d, x, queue ); // x = x - work2 + d
         }
     }
 
@@ -0,0 +1,407 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PRECISION_z
+
+// largest triangular system handled by the host ISAI
+#define MAGMA_ISAI_MAX_SIZE 32
+
+
+/*
+    Generates the columns of the ISAI listed in rows[0..count-1], all of
+    size at most N. Column i of M has the pattern J = M.col[M.row[i]..] and
+    solves T(J,J) m = e, with e the unit vector of i (first entry of J for
+    the lower, last one for the upper case). The system is padded to N x N
+    with the identity, stored column-major, so all loops have a fixed trip
+    count. M is the ISAI in transposed (CSR) form.
+*/
+template<int N>
+static void
+magma_zisai_generate_class(
+    magma_uplo_t uplotype,
+    magma_diag_t diagtype,
+    magma_z_matrix T,
+    magma_z_matrix *M,
+    magma_index_t *rows,
+    magma_int_t count )
+{
+    #pragma omp parallel for schedule(dynamic,64)
+    for (magma_int_t r=0; r < count; r++) {
+        magmaDoubleComplex D[ N*N ], x[ N ];
+        magma_int_t i = rows[r];
+        magma_int_t mstart = M->row[i];
+        magma_int_t n = M->row[i+1] - mstart;
+        const magma_index_t *J = M->col + mstart;
+
+        if (n == 0) {
+            continue;
+        }
+        for (int k=0; k < N*N; k++) {
+            D[k] = MAGMA_Z_ZERO;
+        }
+        for (int k=0; k < N; k++) {
+            x[k] = MAGMA_Z_ZERO;
+        }
+        for (int k=n; k < N; k++) {
+            D[k*N+k] = MAGMA_Z_ONE;
+        }
+        // row a of T(J,J): merge row J[a] of T with J
+        for (magma_int_t a=0; a < n; a++) {
+            magma_int_t k = T.row[ J[a] ];
+            magma_int_t klim = T.row[ J[a]+1 ];
+            magma_int_t b = 0;
+            while (k < klim && b < n) {
+                if (T.col[k] == J[b]) {
+                    D[b*N+a] = T.val[k];
+                    k++;
+                    b++;
+                } else if (T.col[k] < J[b]) {
+                    k++;
+                } else {
+                    b++;
+                }
+            }
+            if (diagtype == MagmaUnit) {
+                D[a*N+a] = MAGMA_Z_ONE;
+            }
+        }
+
+        if (uplotype == MagmaLower) {
+            x[0] = MAGMA_Z_ONE;
+            for (int k=0; k < N; k++) {
+                x[k] = x[k] / D[k*N+k];
+                magmaDoubleComplex xk = x[k];
+                #pragma omp simd
+                for (int a=k+1; a < N; a++) {
+                    x[a] = x[a] - D[k*N+a] * xk;
+                }
+            }
+        } else {
+            x[n-1] = MAGMA_Z_ONE;
+            for (int k=N-1; k >= 0; k--) {
+                x[k] = x[k] / D[k*N+k];
+                magmaDoubleComplex xk = x[k];
+                #pragma omp simd
+                for (int a=0; a < k; a++) {
+                    x[a] = x[a] - D[k*N+a] * xk;
+                }
+            }
+        }
+
+        for (magma_int_t a=0; a < n; a++) {
+            M->val[mstart+a] = x[a];
+        }
+    }
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Host counterpart of magma_zisai_generator_regs: computes the values of
+    the ISAI for the triangular matrix T on the pattern of M, where M holds
+    the ISAI in transposed form (one row per column of the ISAI).
+
+    The small triangular systems are sorted into the size classes
+    1, 2, 4, 8, 16 and 32 and every class is solved as a batch with a
+    solver of fixed size.
+
+    Arguments
+    ---------
+
+    @param[in]
+    uplotype    magma_uplo_t
+                lower or upper triangular
+
+    @param[in]
+    transtype   magma_trans_t
+                possibility for transposed matrix (only MagmaNoTrans)
+
+    @param[in]
+    diagtype    magma_diag_t
+                unit diagonal or not
+
+    @param[in]
+    T           magma_z_matrix
+                triangular matrix in CSR on the CPU
+
+    @param[in,out]
+    M           magma_z_matrix*
+                transposed ISAI pattern in CSR on the CPU, on exit the values
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zisai_generator_cpu(
+    magma_uplo_t uplotype,
+    magma_trans_t transtype,
+    magma_diag_t diagtype,
+    magma_z_matrix T,
+    magma_z_matrix *M,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_index_t *rows = NULL, *sclass = NULL;
+    magma_int_t start[7] = { 0 }, fill[6];
+
+    if (transtype != MagmaNoTrans) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK(magma_index_malloc_cpu(&rows, M->num_rows));
+    CHECK(magma_index_malloc_cpu(&sclass, M->num_rows));
+
+    // counting sort of the columns into the size classes 1, 2, 4, ..., 32
+    for (magma_int_t i=0; i < M->num_rows; i++) {
+        magma_int_t n = M->row[i+1] - M->row[i];
+        magma_int_t c = 0;
+        if (n > MAGMA_ISAI_MAX_SIZE) {
+            info = MAGMA_ERR_NOT_SUPPORTED;
+            goto cleanup;
+        }
+        while ((1 << c) < n) {
+            c++;
+        }
+        sclass[i] = c;
+        start[c+1]++;
+    }
+    for (magma_int_t c=0; c < 6; c++) {
+        start[c+1] += start[c];
+        fill[c] = start[c];
+    }
+    for (magma_int_t i=0; i < M->num_rows; i++) {
+        rows[ fill[ sclass[i] ]++ ] = i;
+    }
+
+    magma_zisai_generate_class<1>(uplotype, diagtype, T, M,
+            rows+start[0], start[1]-start[0]);
+    magma_zisai_generate_class<2>(uplotype, diagtype, T, M,
+            rows+start[1], start[2]-start[1]);
+    magma_zisai_generate_class<4>(uplotype, diagtype, T, M,
+            rows+start[2], start[3]-start[2]);
+    magma_zisai_generate_class<8>(uplotype, diagtype, T, M,
+            rows+start[3], start[4]-start[3]);
+    magma_zisai_generate_class<16>(uplotype, diagtype, T, M,
+            rows+start[4], start[5]-start[4]);
+    magma_zisai_generate_class<32>(uplotype, diagtype, T, M,
+            rows+start[5], start[6]-start[5]);
+
+cleanup:
+    magma_free_cpu(rows);
+    magma_free_cpu(sclass);
+    return info;
+}
+
+
+/*
+    Host ISAI for one triangular factor: copies T and the pattern S to the
+    CPU, generates the ISAI there and returns it in the memory location of T.
+*/
+static magma_int_t
+magma_zisaisetup_cpu(
+    magma_uplo_t uplotype,
+    magma_z_matrix T,
+    magma_z_matrix S,
+    magma_z_matrix *ISAI,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix hT={Magma_CSR}, hS={Magma_CSR}, MT={Magma_CSR}, hM={Magma_CSR};
+    magma_int_t maxsize = 0;
+
+    CHECK(magma_zmtransfer(T, &hT, T.memory_location, Magma_CPU, queue));
+    CHECK(magma_zmtransfer(S, &hS, S.memory_location, Magma_CPU, queue));
+    // the ISAI is generated in transpose fashion
+    CHECK(magma_zmtranspose(hS, &MT, queue));
+
+    for (magma_int_t i=0; i < MT.num_rows; i++) {
+        maxsize = max(maxsize, MT.row[i+1] - MT.row[i]);
+    }
+    if (maxsize > MAGMA_ISAI_MAX_SIZE) {
+        printf("%% error for ISAI: size of system is too large by %d\n",
+                (int) (maxsize-MAGMA_ISAI_MAX_SIZE));
+        printf("%% fallback: use exact triangular solve (cuSOLVE)\n");
+        info = Magma_CUSOLVE;
+        goto cleanup;
+    }
+
+    CHECK(magma_zisai_generator_cpu(uplotype, MagmaNoTrans, MagmaNonUnit,
+            hT, &MT, queue));
+    if (T.memory_location == Magma_CPU) {
+        CHECK(magma_zmtranspose(MT, ISAI, queue));
+    } else {
+        CHECK(magma_zmtranspose(MT, &hM, queue));
+        CHECK(magma_zmtransfer(hM, ISAI, Magma_CPU, T.memory_location, queue));
+    }
+
+cleanup:
+    magma_zmfree(&hT, queue);
+    magma_zmfree(&hS, queue);
+    magma_zmfree(&MT, queue);
+    magma_zmfree(&hM, queue);
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Prepares the ISAI for the lower triangular factor L on the CPU. The
+    return value is 0 in case of success, and Magma_CUSOLVE if the pattern
+    is too large to be handled. The result is in the memory location of L.
+
+    Arguments
+    ---------
+
+    @param[in]
+    L           magma_z_matrix
+                lower triangular factor
+
+    @param[in]
+    S           magma_z_matrix
+                pattern for the ISAI preconditioner for L
+
+    @param[out]
+    ISAIL       magma_z_matrix*
+                ISAI preconditioner for L
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_ziluisaisetup_lower_cpu(
+    magma_z_matrix L,
+    magma_z_matrix S,
+    magma_z_matrix *ISAIL,
+    magma_queue_t queue )
+{
+    return magma_zisaisetup_cpu(MagmaLower, L, S, ISAIL, queue);
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Prepares the ISAI for the upper triangular factor U on the CPU. The
+    return value is 0 in case of success, and Magma_CUSOLVE if the pattern
+    is too large to be handled. The result is in the memory location of U.
+
+    Arguments
+    ---------
+
+    @param[in]
+    U           magma_z_matrix
+                upper triangular factor
+
+    @param[in]
+    S           magma_z_matrix
+                pattern for the ISAI preconditioner for U
+
+    @param[out]
+    ISAIU       magma_z_matrix*
+                ISAI preconditioner for U
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_ziluisaisetup_upper_cpu(
+    magma_z_matrix U,
+    magma_z_matrix S,
+    magma_z_matrix *ISAIU,
+    magma_queue_t queue )
+{
+    return magma_zisaisetup_cpu(MagmaUpper, U, S, ISAIU, queue);
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Prepares the ISAI for an incomplete Cholesky factorization on the CPU.
+    Only the ISAI of L (pattern of L) is generated; as U = L^H, its
+    conjugate transpose serves as the ISAI of U.
+    The return value is 0 in case of success, and Magma_CUSOLVE if the
+    pattern is too large to be handled.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                input RHS b
+
+    @param[in,out]
+    precond     magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zicisaisetup_cpu(
+    magma_z_matrix A,
+    magma_z_matrix b,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix hL={Magma_CSR}, hLD={Magma_CSR}, hUD={Magma_CSR};
+    magma_location_t loc = precond->L.memory_location;
+
+    CHECK(magma_zmtransfer(precond->L, &hL, loc, Magma_CPU, queue));
+    CHECK(magma_ziluisaisetup_lower_cpu(hL, hL, &hLD, queue));
+    CHECK(magma_zmtransposeconj_cpu(hLD, &hUD, queue));
+    CHECK(magma_zmtransfer(hLD, &precond->LD, Magma_CPU, loc, queue));
+    CHECK(magma_zmtransfer(hUD, &precond->UD, Magma_CPU, loc, queue));
+
+cleanup:
+    magma_zmfree(&hL, queue);
+    magma_zmfree(&hLD, queue);
+    magma_zmfree(&hUD, queue);
+    return info;
+}
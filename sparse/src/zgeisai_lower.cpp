@@ -25,7 +25,7 @@
     
     This routine only handles the lower triangular part. The return value is 0
     in case of success, and Magma_CUSOLVE if the pattern is too large to be 
-    handled.
+    handled. If L is in CPU memory, the ISAI is generated on the host.
 
     Arguments
     ---------
@@ -64,6 +64,12 @@ magma_ziluisaisetup_lower(
 
     int warpsize=32;
 
+    // factors in CPU memory: generate the ISAI on the host
+    if( L.memory_location == Magma_CPU ){
+        CHECK( magma_ziluisaisetup_lower_cpu( L, S, ISAIL, queue ) );
+        goto cleanup;
+    }
+
     // we need this in any case as the ISAI matrix is generated in transpose fashion
     CHECK( magma_zmtranspose( S, &MT, queue ) );
 
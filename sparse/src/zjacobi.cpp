@@ -255,7 +255,7 @@ cleanup:
     -------
 
 
-    It returns a vector d
+    It returns a vector d on the CPU
     containing the inverse diagonal elements.
 
     Arguments
@@ -267,7 +267,7 @@ cleanup:
 
     @param[in,out]
     d           magma_z_matrix*
-                vector with diagonal elements
+                vector with diagonal elements (on the CPU)
     @param[in]
     queue       magma_queue_t
                 Queue to execute in.
@@ -276,7 +276,7 @@ cleanup:
     ********************************************************************/
 
 extern "C" magma_int_t
-magma_zjacobisetup_diagscal(
+magma_zjacobisetup_diagscal_cpu(
     magma_z_matrix A, magma_z_matrix *d,
     magma_queue_t queue )
 {
@@ -285,65 +285,84 @@ magma_zjacobisetup_diagscal(
     magma_int_t i;
 
     magma_z_matrix A_h1={Magma_CSR}, B={Magma_CSR};
-    magma_z_matrix diag={Magma_CSR};
-    CHECK( magma_zvinit( &diag, Magma_CPU, A.num_rows, 1, MAGMA_Z_ZERO, queue ));
+    magma_z_matrix hA={Magma_CSR};
+    CHECK( magma_zvinit( d, Magma_CPU, A.num_rows, 1, MAGMA_Z_ZERO, queue ));
 
     if ( A.storage_type != Magma_CSR || A.memory_location != Magma_CPU ) {
         CHECK( magma_zmtransfer( A, &A_h1, A.memory_location, Magma_CPU, queue ));
         CHECK( magma_zmconvert( A_h1, &B, A_h1.storage_type, Magma_CSR, queue ));
-        
-        for( magma_int_t rowindex=0; rowindex<B.num_rows; rowindex++ ) {
-            magma_int_t start = (B.drow[rowindex]);
-            magma_int_t end = (B.drow[rowindex+1]);
-            for( i=start; i<end; i++ ) {
-                if ( B.dcol[i]==rowindex ) {
-                    diag.val[rowindex] = 1.0/B.val[i];
-                    break;
-                }
-            }
-            if ( diag.val[rowindex] == MAGMA_Z_ZERO ){
-                printf(" error: zero diagonal element in row %d!\n",
-                                                            int(rowindex));
-                
-                if ( A.storage_type != Magma_CSR) {
-                    magma_zmfree( &A_h1, queue );
-                }
-                magma_zmfree( &B, queue );
-                magma_zmfree( &diag, queue );
-                info = MAGMA_ERR_BADPRECOND;
-                goto cleanup;
-            }
-        }
+        hA = B;
+    } else {
+        hA = A;
+        hA.mapping = NULL;
     }
-    else{
-        for( magma_int_t rowindex=0; rowindex<A.num_rows; rowindex++ ) {
-            magma_int_t start = (A.drow[rowindex]);
-            magma_int_t end = (A.drow[rowindex+1]);
-            for( i=start; i<end; i++ ) {
-                if ( A.dcol[i]==rowindex ) {
-                    diag.val[rowindex] = 1.0/A.val[i];
-                    break;
-                }
-            }
-            if ( diag.val[rowindex] == MAGMA_Z_ZERO ){
-                printf(" error: zero diagonal element in row %d!\n",
-                                                            int(rowindex));
-                
-                if ( A.storage_type != Magma_CSR) {
-                    magma_zmfree( &A_h1, queue );
-                }
-                magma_zmfree( &B, queue );
-                magma_zmfree( &diag, queue );
-                info = MAGMA_ERR_BADPRECOND;
-                goto cleanup;
+    
+    for( magma_int_t rowindex=0; rowindex<hA.num_rows; rowindex++ ) {
+        magma_int_t start = (hA.row[rowindex]);
+        magma_int_t end = (hA.row[rowindex+1]);
+        for( i=start; i<end; i++ ) {
+            if ( hA.col[i]==rowindex ) {
+                d->val[rowindex] = 1.0/hA.val[i];
+                break;
             }
         }
+        if ( d->val[rowindex] == MAGMA_Z_ZERO ){
+            printf(" error: zero diagonal element in row %d!\n",
+                                                        int(rowindex));
+            info = MAGMA_ERR_BADPRECOND;
+            goto cleanup;
+        }
     }
-    CHECK( magma_zmtransfer( diag, d, Magma_CPU, Magma_DEV, queue ));
     
 cleanup:
+    if ( info != 0 ) {
+        magma_zmfree( d, queue );
+    }
     magma_zmfree( &A_h1, queue );
     magma_zmfree( &B, queue );
+ 
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+
+    It returns a vector d on the device
+    containing the inverse diagonal elements.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in,out]
+    d           magma_z_matrix*
+                vector with diagonal elements
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_z
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zjacobisetup_diagscal(
+    magma_z_matrix A, magma_z_matrix *d,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    
+    magma_z_matrix diag={Magma_CSR};
+
+    CHECK( magma_zjacobisetup_diagscal_cpu( A, &diag, queue ));
+    CHECK( magma_zmtransfer( diag, d, Magma_CPU, Magma_DEV, queue ));
+    
+cleanup:
     magma_zmfree( &diag, queue );
  
     return info;
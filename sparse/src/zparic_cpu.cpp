@@ -29,6 +29,19 @@
     
     This is the CPU implementation of the ParIC
 
+    The sweeps are asynchronous: threads update their part of the factors in
+    place without synchronizing, and stop once the nonlinear residual is
+    small enough. The parameter list is:
+
+    precond.sweeps : maximum number of sweeps
+    precond.rtol   : relative tolerance for the nonlinear residual
+    precond.numiter   : on exit, number of sweeps done
+    precond.final_res : on exit, relative nonlinear residual (estimate)
+
+    If A and b are both located on the CPU, the factors stay in CPU memory
+    and the triangular solves use the host level-scheduled path or the host
+    ISAI; otherwise they are transferred to the device.
+
     Arguments
     ---------
 
@@ -65,6 +78,8 @@ magma_zparic_cpu(
 
     magma_z_matrix hAT={Magma_CSR}, hA={Magma_CSR}, hAL={Magma_CSR}, 
     hAU={Magma_CSR}, hAUT={Magma_CSR}, hAtmp={Magma_CSR}, hACOO={Magma_CSR};
+    magma_location_t location = ( A.memory_location == Magma_CPU &&
+        b.memory_location == Magma_CPU ) ? Magma_CPU : Magma_DEV;
 
     // copy original matrix as COO to device
     if (A.memory_location != Magma_CPU || A.storage_type != Magma_CSR) {
@@ -95,28 +110,38 @@ magma_zparic_cpu(
     // - hAL is the lower triangular in CSR on the CPU
     // The kernel is located in sparse/control/magma_zparic_kernels.cpp
     //
-    for (int i=0; i<precond->sweeps; i++) {
-        CHECK(magma_zparic_sweep(hACOO, &hAL, queue));
-    }
+    // The sweeps run asynchronously and stop early once the nonlinear 
+    // residual drops below precond->rtol, precond->sweeps is the upper bound.
+    CHECK(magma_zparic_sweep_async(hACOO, &hAL, precond->sweeps, 
+        precond->rtol, &precond->numiter, &precond->final_res, queue));
     
 
-    CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_DEV, queue));
-    CHECK(magma_z_cucsrtranspose(precond->L, &precond->U, queue));
-    CHECK(magma_zmtransfer(precond->L, &precond->M, Magma_DEV, Magma_DEV, queue));
+    if (location == Magma_CPU) {
+        CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_CPU, queue));
+        CHECK(magma_zmtransposeconj_cpu(precond->L, &precond->U, queue));
+        CHECK(magma_zmtransfer(precond->L, &precond->M, Magma_CPU, Magma_CPU, queue));
+    } else {
+        CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_DEV, queue));
+        CHECK(magma_z_cucsrtranspose(precond->L, &precond->U, queue));
+        CHECK(magma_zmtransfer(precond->L, &precond->M, Magma_DEV, Magma_DEV, queue));
+    }
     
     if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
         CHECK(magma_zcumicgeneratesolverinfo(precond, queue));
     } else {
-        //prepare for iterative solves
-
-        // extract the diagonal of L into precond->d
-        CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
-        CHECK(magma_zvinit(&precond->work1, Magma_DEV, hA.num_rows, 1, 
+        //prepare for iterative solves, in the memory location of the factors
+
+        // extract the diagonals of L and U into precond->d and precond->d2
+        if (location == Magma_CPU) {
+            CHECK(magma_zjacobisetup_diagscal_cpu(precond->L, &precond->d, queue));
+            CHECK(magma_zjacobisetup_diagscal_cpu(precond->U, &precond->d2, queue));
+        } else {
+            CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
+            CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
+        }
+        CHECK(magma_zvinit(&precond->work1, location, hA.num_rows, 1, 
             MAGMA_Z_ZERO, queue));
-
-        // extract the diagonal of U into precond->d2
-        CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
-        CHECK(magma_zvinit(&precond->work2, Magma_DEV, hA.num_rows, 1, 
+        CHECK(magma_zvinit(&precond->work2, location, hA.num_rows, 1, 
             MAGMA_Z_ZERO, queue));
     }
 
@@ -11,6 +11,7 @@
 */
 
 #include "magmasparse_internal.h"
+#include "../blas/magma_trisolve.h"
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -29,6 +30,19 @@
     
     This is the CPU implementation of the ParILU
 
+    The sweeps are asynchronous: threads update their part of the factors in
+    place without synchronizing, and stop once the nonlinear residual is
+    small enough. The parameter list is:
+
+    precond.sweeps : maximum number of sweeps
+    precond.rtol   : relative tolerance for the nonlinear residual
+    precond.numiter   : on exit, number of sweeps done
+    precond.final_res : on exit, relative nonlinear residual (estimate)
+
+    If A and b are both located on the CPU, the factors stay in CPU memory
+    and the triangular solves use the host level-scheduled path; otherwise
+    they are transferred to the device.
+
     Arguments
     ---------
 
@@ -66,6 +80,8 @@ magma_zparilu_cpu(
 
     magma_z_matrix hAT={Magma_CSR}, hA={Magma_CSR}, hAL={Magma_CSR}, 
     hAU={Magma_CSR}, hAUT={Magma_CSR}, hAtmp={Magma_CSR}, hACOO={Magma_CSR};
+    magma_location_t location = ( A.memory_location == Magma_CPU &&
+        b.memory_location == Magma_CPU ) ? Magma_CPU : Magma_DEV;
 
     // copy original matrix as COO to device
     if (A.memory_location != Magma_CPU || A.storage_type != Magma_CSR) {
@@ -104,27 +120,31 @@ magma_zparilu_cpu(
     // - hAU is the upper triangular in CSC on the CPU (U transpose in CSR)
     // The kernel is located in sparse/control/magma_zparilu_kernels.cpp
     //
-    for (int i=0; i<precond->sweeps; i++) {
-        CHECK(magma_zparilu_sweep(hACOO, &hAL, &hAU, queue));
-    }
-    CHECK(magma_z_cucsrtranspose(hAU, &hAUT, queue));
+    // The sweeps run asynchronously and stop early once the nonlinear 
+    // residual drops below precond->rtol, precond->sweeps is the upper bound.
+    CHECK(magma_zparilu_sweep_async(hACOO, &hAL, &hAU, precond->sweeps, 
+        precond->rtol, &precond->numiter, &precond->final_res, queue));
+    CHECK(magma_zmtranspose(hAU, &hAUT, queue));
 
-    CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_DEV, queue));
-    CHECK(magma_zmtransfer(hAUT, &precond->U, Magma_CPU, Magma_DEV, queue));
+    CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, location, queue));
+    CHECK(magma_zmtransfer(hAUT, &precond->U, Magma_CPU, location, queue));
     
     if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
         CHECK(magma_zcumilugeneratesolverinfo(precond, queue));
     } else {
-        //prepare for iterative solves
+        //prepare for iterative solves, in the memory location of the factors
 
-        // extract the diagonal of L into precond->d
-        CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
-        CHECK(magma_zvinit(&precond->work1, Magma_DEV, hA.num_rows, 1, 
+        // extract the diagonals of L and U into precond->d and precond->d2
+        if (location == Magma_CPU) {
+            CHECK(magma_zjacobisetup_diagscal_cpu(precond->L, &precond->d, queue));
+            CHECK(magma_zjacobisetup_diagscal_cpu(precond->U, &precond->d2, queue));
+        } else {
+            CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
+            CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
+        }
+        CHECK(magma_zvinit(&precond->work1, location, hA.num_rows, 1, 
             MAGMA_Z_ZERO, queue));
-
-        // extract the diagonal of U into precond->d2
-        CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
-        CHECK(magma_zvinit(&precond->work2, Magma_DEV, hA.num_rows, 1, 
+        CHECK(magma_zvinit(&precond->work2, location, hA.num_rows, 1, 
             MAGMA_Z_ZERO, queue));
     }
 
@@ -140,3 +160,302 @@ cleanup:
 #endif
     return info;
 }
+
+
+/*
+    Releases the host data kept for the numeric refactorization.
+*/
+static void
+magma_zparilu_refactor_free(
+    magma_z_preconditioner *precond)
+{
+    magma_free_cpu( precond->RA.val );
+    magma_free_cpu( precond->RA.col );
+    magma_free_cpu( precond->RA.row );
+    magma_free_cpu( precond->RA.rowidx );
+    magma_free_cpu( precond->RL.val );
+    magma_free_cpu( precond->RL.col );
+    magma_free_cpu( precond->RL.row );
+    magma_free_cpu( precond->RUT.val );
+    magma_free_cpu( precond->RUT.col );
+    magma_free_cpu( precond->RUT.row );
+    magma_free_cpu( precond->RA_map );
+    magma_free_cpu( precond->RUT_map );
+    precond->RA.val = NULL;
+    precond->RA.col = NULL;
+    precond->RA.row = NULL;
+    precond->RA.rowidx = NULL;
+    precond->RL.val = NULL;
+    precond->RL.col = NULL;
+    precond->RL.row = NULL;
+    precond->RUT.val = NULL;
+    precond->RUT.col = NULL;
+    precond->RUT.row = NULL;
+    precond->RA_map = NULL;
+    precond->RUT_map = NULL;
+}
+
+
+/*
+    Builds the host data for the numeric refactorization from the current
+    factors precond->L (CSR, unit diagonal last) and precond->U (CSR, diagonal
+    first) and the pattern of A (CSR on the host):
+    RL is a copy of L, RUT is U^T with RUT_map pointing from every entry of
+    RUT to the same entry of U, RA is the pattern of L+U in CSRCOO, and
+    RA_map points from every entry of A to the same entry of RA, or is -1 if
+    the entry is not part of the factor pattern (dropped by the threshold).
+*/
+static magma_int_t
+magma_zparilu_refactor_init(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue)
+{
+    magma_int_t info = 0;
+    magma_z_matrix hU={Magma_CSR};
+    magma_index_t *next = NULL;
+    magma_int_t n = precond->L.num_rows;
+
+    magma_zparilu_refactor_free( precond );
+    CHECK(magma_zmtransfer(precond->L, &precond->RL, 
+        precond->L.memory_location, Magma_CPU, queue));
+    CHECK(magma_zmtransfer(precond->U, &hU, 
+        precond->U.memory_location, Magma_CPU, queue));
+
+    // U^T and the transpose permutation, a stable counting sort by column
+    precond->RUT.storage_type = Magma_CSR;
+    precond->RUT.memory_location = Magma_CPU;
+    precond->RUT.num_rows = n;
+    precond->RUT.num_cols = n;
+    precond->RUT.nnz = hU.nnz;
+    precond->RUT.ownership = MagmaTrue;
+    CHECK(magma_index_malloc_cpu(&precond->RUT.row, n+1));
+    CHECK(magma_index_malloc_cpu(&precond->RUT.col, hU.nnz));
+    CHECK(magma_zmalloc_cpu(&precond->RUT.val, hU.nnz));
+    CHECK(magma_index_malloc_cpu(&precond->RUT_map, hU.nnz));
+    CHECK(magma_index_malloc_cpu(&next, n+1));
+    for (magma_int_t i=0; i < n+1; i++) {
+        precond->RUT.row[i] = 0;
+    }
+    for (magma_int_t k=0; k < hU.nnz; k++) {
+        precond->RUT.row[hU.col[k]+1]++;
+    }
+    CHECK(magma_zmatrix_createrowptr(n, precond->RUT.row, queue));
+    for (magma_int_t i=0; i < n; i++) {
+        next[i] = precond->RUT.row[i];
+    }
+    for (magma_int_t i=0; i < n; i++) {
+        for (magma_int_t k=hU.row[i]; k < hU.row[i+1]; k++) {
+            magma_index_t el = next[hU.col[k]]++;
+            precond->RUT.col[el] = i;
+            precond->RUT.val[el] = hU.val[k];
+            precond->RUT_map[el] = k;
+        }
+    }
+
+    // pattern of L+U: strictly lower part of L, then row i of U
+    precond->RA.storage_type = Magma_CSRCOO;
+    precond->RA.memory_location = Magma_CPU;
+    precond->RA.num_rows = n;
+    precond->RA.num_cols = n;
+    precond->RA.ownership = MagmaTrue;
+    CHECK(magma_index_malloc_cpu(&precond->RA.row, n+1));
+    precond->RA.row[0] = 0;
+    #pragma omp parallel for
+    for (magma_int_t i=0; i < n; i++) {
+        precond->RA.row[i+1] = precond->RL.row[i+1] - precond->RL.row[i] - 1 
+            + hU.row[i+1] - hU.row[i];
+    }
+    CHECK(magma_zmatrix_createrowptr(n, precond->RA.row, queue));
+    precond->RA.nnz = precond->RA.row[n];
+    CHECK(magma_index_malloc_cpu(&precond->RA.col, precond->RA.nnz));
+    CHECK(magma_index_malloc_cpu(&precond->RA.rowidx, precond->RA.nnz));
+    CHECK(magma_zmalloc_cpu(&precond->RA.val, precond->RA.nnz));
+    #pragma omp parallel for
+    for (magma_int_t i=0; i < n; i++) {
+        magma_index_t el = precond->RA.row[i];
+        for (magma_int_t k=precond->RL.row[i]; k < precond->RL.row[i+1]-1; k++) {
+            precond->RA.rowidx[el] = i;
+            precond->RA.col[el++] = precond->RL.col[k];
+        }
+        for (magma_int_t k=hU.row[i]; k < hU.row[i+1]; k++) {
+            precond->RA.rowidx[el] = i;
+            precond->RA.col[el++] = hU.col[k];
+        }
+    }
+
+    // position of every entry of A in the factor pattern
+    CHECK(magma_index_malloc_cpu(&precond->RA_map, A.nnz));
+    precond->RA.true_nnz = A.nnz;
+    #pragma omp parallel for
+    for (magma_int_t i=0; i < n; i++) {
+        for (magma_int_t k=A.row[i]; k < A.row[i+1]; k++) {
+            magma_int_t lo = precond->RA.row[i], hi = precond->RA.row[i+1];
+            while (lo < hi) {
+                magma_int_t mid = lo + (hi-lo)/2;
+                if (precond->RA.col[mid] < A.col[k]) {
+                    lo = mid+1;
+                } else {
+                    hi = mid;
+                }
+            }
+            precond->RA_map[k] = ( lo < precond->RA.row[i+1] 
+                && precond->RA.col[lo] == A.col[k] ) ? lo : -1;
+        }
+    }
+
+cleanup:
+    if (info != 0) {
+        magma_zparilu_refactor_free( precond );
+    }
+    magma_zmfree(&hU, queue);
+    magma_free_cpu(next);
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Numeric-only refactorization of a ParILU or ParILUT preconditioner for a
+    matrix A that has the same sparsity pattern as the matrix used in the
+    setup, but different values.
+    The pattern of the factors is kept, and the previous factors are the
+    initial guess for the ParILU sweeps on the new values. No symbolic work,
+    candidate search or thresholding is done.
+
+    On the first call, the pattern of L+U, the transpose permutation of U
+    and the position of every entry of A in the factor pattern are computed
+    and kept in the preconditioner, together with host copies of the
+    factors. Later calls only scatter the values of A, sweep, and copy the
+    new values back into precond->L and precond->U.
+    The data is rebuilt if the number of nonzeros of A or the factors
+    changes.
+
+    The parameter list is:
+
+    precond.sweeps : maximum number of sweeps
+    precond.rtol   : relative tolerance for the nonlinear residual
+    precond.numiter   : on exit, number of sweeps done
+    precond.final_res : on exit, relative nonlinear residual (estimate)
+
+    The triangular solve information (or the diagonals for the iterative
+    triangular solves) is updated to the new values.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A, same pattern as in the setup
+
+    @param[in,out]
+    precond     magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zparilu_cpu_refactor(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue)
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix hAT={Magma_CSR}, hA={Magma_CSR}, hAcopy={Magma_CSR};
+    magmaDoubleComplex *Uval = NULL;
+
+    if (precond->L.storage_type != Magma_CSR || 
+        precond->U.storage_type != Magma_CSR) {
+        printf("error: refactorization requires the factors in CSR.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    // the values of A on the host in CSR
+    if (A.memory_location != Magma_CPU || A.storage_type != Magma_CSR) {
+        CHECK(magma_zmtransfer(A, &hAT, A.memory_location, Magma_CPU, queue));
+        CHECK(magma_zmconvert(hAT, &hAcopy, hAT.storage_type, Magma_CSR, queue));
+        magma_zmfree(&hAT, queue);
+        hA = hAcopy;
+    } else {
+        hA = A;
+        hA.mapping = NULL;
+    }
+
+    if (precond->RA_map == NULL || 
+        precond->RA.num_rows != hA.num_rows ||
+        precond->RA.true_nnz != hA.nnz ||
+        precond->RL.nnz != precond->L.nnz ||
+        precond->RUT.nnz != precond->U.nnz) {
+        CHECK(magma_zparilu_refactor_init(hA, precond, queue));
+    }
+
+    // scatter the new values into the factor pattern
+    #pragma omp parallel for
+    for (magma_int_t k=0; k < precond->RA.nnz; k++) {
+        precond->RA.val[k] = MAGMA_Z_ZERO;
+    }
+    #pragma omp parallel for
+    for (magma_int_t k=0; k < hA.nnz; k++) {
+        if (precond->RA_map[k] >= 0) {
+            precond->RA.val[precond->RA_map[k]] = hA.val[k];
+        }
+    }
+
+    // value sweeps, starting from the previous factors
+    CHECK(magma_zparilu_sweep_async(precond->RA, &precond->RL, &precond->RUT, 
+        precond->sweeps, precond->rtol, &precond->numiter, &precond->final_res, 
+        queue));
+
+    // write the values back, U through the transpose permutation
+    CHECK(magma_zmalloc_cpu(&Uval, precond->RUT.nnz));
+    #pragma omp parallel for
+    for (magma_int_t k=0; k < precond->RUT.nnz; k++) {
+        Uval[precond->RUT_map[k]] = precond->RUT.val[k];
+    }
+    if (precond->L.memory_location == Magma_DEV) {
+        magma_zsetvector(precond->RL.nnz, precond->RL.val, 1, 
+            precond->L.dval, 1, queue);
+        magma_zsetvector(precond->RUT.nnz, Uval, 1, 
+            precond->U.dval, 1, queue);
+    } else {
+        #pragma omp parallel for
+        for (magma_int_t k=0; k < precond->RL.nnz; k++) {
+            precond->L.val[k] = precond->RL.val[k];
+        }
+        #pragma omp parallel for
+        for (magma_int_t k=0; k < precond->RUT.nnz; k++) {
+            precond->U.val[k] = Uval[k];
+        }
+    }
+
+    if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
+        magma_trisolve_free(&precond->cuinfoL);
+        magma_trisolve_free(&precond->cuinfoU);
+        CHECK(magma_ztrisolve_analysis(precond->L, &precond->cuinfoL, 
+            false, false, false, queue));
+        CHECK(magma_ztrisolve_analysis(precond->U, &precond->cuinfoU, 
+            true, false, false, queue));
+    } else {
+        // the diagonals of L and U for the iterative solves
+        magma_zmfree(&precond->d, queue);
+        magma_zmfree(&precond->d2, queue);
+        CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
+        CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
+    }
+
+cleanup:
+    magma_zmfree(&hAT, queue);
+    magma_zmfree(&hAcopy, queue);
+    magma_free_cpu(Uval);
+    return info;
+}
@@ -10,6 +10,8 @@
        @precisions normal z -> s d c
 */
 
+#include <vector>
+#include <algorithm>
 #include "magmasparse_internal.h"
 #ifdef _OPENMP
 #include <omp.h>
@@ -17,6 +19,531 @@
 
 #define PRECISION_z
 
+// capacity of a segment holding len entries when the storage is (re)built;
+// the slack takes the candidates of the following steps without a rebuild
+#define MAGMA_ROWSEG_CAP( len )  ( 2*(len) + 4 )
+
+
+#ifdef _OPENMP
+
+/*
+    Array-of-rows storage of an incomplete factor. Segment i occupies
+    col/val[ start[i] : start[i+1] ), the first len[i] entries are used and
+    sorted by index, the remaining ones are slack. The diagonal is the last
+    entry of every segment. L is stored by rows, U by columns.
+*/
+typedef struct magma_z_rowseg
+{
+    magma_int_t num_rows;
+    magma_int_t nnz;
+    magma_index_t *start;
+    magma_index_t *len;
+    magma_index_t *col;
+    magmaDoubleComplex *val;
+} magma_z_rowseg;
+
+
+static void
+magma_zrowseg_free(
+    magma_z_rowseg *S )
+{
+    magma_free_cpu( S->start );
+    magma_free_cpu( S->len );
+    magma_free_cpu( S->col );
+    magma_free_cpu( S->val );
+    S->start = NULL;
+    S->len = NULL;
+    S->col = NULL;
+    S->val = NULL;
+    S->num_rows = 0;
+    S->nnz = 0;
+}
+
+
+/* creates n empty segments without capacity */
+static magma_int_t
+magma_zrowseg_create(
+    magma_int_t n,
+    magma_z_rowseg *S,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_zrowseg_free( S );
+    S->num_rows = n;
+    CHECK( magma_index_malloc_cpu( &S->start, n+1 ));
+    CHECK( magma_index_malloc_cpu( &S->len, n ));
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<n; i++ ){
+        S->start[ i+1 ] = 0;
+        S->len[ i ] = 0;
+    }
+    S->start[ 0 ] = 0;
+
+cleanup:
+    return info;
+}
+
+
+/*
+    Inserts the entries of the CSR matrix C into the segments. C has sorted
+    rows and no entry already present in S. Rows that fit into their slack
+    are merged in place, starting from the back. If any segment overflows,
+    the whole storage is rebuilt with fresh slack in one pass.
+*/
+static magma_int_t
+magma_zrowseg_insert(
+    magma_z_rowseg *S,
+    magma_z_matrix C,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = S->num_rows;
+    magma_int_t overflow = 0, nnz = 0;
+    magma_index_t *pending = NULL, *start = NULL, *col = NULL, *swp = NULL;
+    magmaDoubleComplex *val = NULL, *vswp = NULL;
+
+    CHECK( magma_index_malloc_cpu( &pending, n ));
+
+    #pragma omp parallel for reduction(+:overflow,nnz)
+    for( magma_int_t i=0; i<n; i++ ){
+        magma_int_t c = C.row[ i+1 ] - C.row[ i ];
+        pending[ i ] = 0;
+        if( c > 0 && S->len[ i ] + c <= S->start[ i+1 ] - S->start[ i ] ){
+            magma_index_t *scol = S->col + S->start[ i ];
+            magmaDoubleComplex *sval = S->val + S->start[ i ];
+            magma_int_t a = S->len[ i ] - 1;
+            magma_int_t b = C.row[ i+1 ] - 1;
+            magma_int_t w = S->len[ i ] + c - 1;
+            while( b >= C.row[ i ] ){
+                if( a >= 0 && scol[ a ] > C.col[ b ] ){
+                    scol[ w ] = scol[ a ];
+                    sval[ w ] = sval[ a ];
+                    a--;
+                } else {
+                    scol[ w ] = C.col[ b ];
+                    sval[ w ] = C.val[ b ];
+                    b--;
+                }
+                w--;
+            }
+            S->len[ i ] += c;
+        } else if( c > 0 ){
+            pending[ i ] = c;
+            overflow++;
+        }
+        nnz += S->len[ i ] + pending[ i ];
+    }
+    S->nnz = nnz;
+
+    if( overflow > 0 ){
+        CHECK( magma_index_malloc_cpu( &start, n+1 ));
+        #pragma omp parallel for
+        for( magma_int_t i=0; i<n; i++ ){
+            start[ i+1 ] = MAGMA_ROWSEG_CAP( S->len[ i ] + pending[ i ] );
+        }
+        start[ 0 ] = 0;
+        CHECK( magma_zmatrix_createrowptr( n, start, queue ));
+        CHECK( magma_index_malloc_cpu( &col, start[ n ] ));
+        CHECK( magma_zmalloc_cpu( &val, start[ n ] ));
+
+        #pragma omp parallel for schedule(dynamic, 256)
+        for( magma_int_t i=0; i<n; i++ ){
+            magma_int_t a = S->start[ i ];
+            magma_int_t enda = a + S->len[ i ];
+            magma_int_t b = C.row[ i ];
+            magma_int_t endb = ( pending[ i ] > 0 ) ? C.row[ i+1 ] : b;
+            magma_int_t w = start[ i ];
+            while( a < enda || b < endb ){
+                if( b == endb || ( a < enda && S->col[ a ] < C.col[ b ] ) ){
+                    col[ w ] = S->col[ a ];
+                    val[ w ] = S->val[ a ];
+                    a++;
+                } else {
+                    col[ w ] = C.col[ b ];
+                    val[ w ] = C.val[ b ];
+                    b++;
+                }
+                w++;
+            }
+            S->len[ i ] += pending[ i ];
+        }
+        swp = S->start; S->start = start; start = swp;
+        swp = S->col; S->col = col; col = swp;
+        vswp = S->val; S->val = val; val = vswp;
+    }
+
+cleanup:
+    magma_free_cpu( pending );
+    magma_free_cpu( start );
+    magma_free_cpu( col );
+    magma_free_cpu( val );
+    return info;
+}
+
+
+/* copies the used part of the segments into a compact CSR matrix A */
+static magma_int_t
+magma_zrowseg_tocsr(
+    magma_z_rowseg S,
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = S.num_rows;
+
+    magma_zmfree( A, queue );
+    A->storage_type = Magma_CSR;
+    A->memory_location = Magma_CPU;
+    A->num_rows = n;
+    A->num_cols = n;
+    A->ownership = MagmaTrue;
+    CHECK( magma_index_malloc_cpu( &A->row, n+1 ));
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<n; i++ ){
+        A->row[ i+1 ] = S.len[ i ];
+    }
+    A->row[ 0 ] = 0;
+    CHECK( magma_zmatrix_createrowptr( n, A->row, queue ));
+    A->nnz = A->row[ n ];
+    CHECK( magma_index_malloc_cpu( &A->col, A->nnz ));
+    CHECK( magma_zmalloc_cpu( &A->val, A->nnz ));
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for( magma_int_t i=0; i<n; i++ ){
+        magma_int_t offset = A->row[ i ] - S.start[ i ];
+        for( magma_int_t p=S.start[ i ]; p<S.start[ i ]+S.len[ i ]; p++ ){
+            A->col[ p+offset ] = S.col[ p ];
+            A->val[ p+offset ] = S.val[ p ];
+        }
+    }
+
+cleanup:
+    return info;
+}
+
+
+/*
+    Synchronous ParILUT sweep on the segmented factors. U is updated column
+    by column from the old values of L and U, then L row by row using the
+    new values of U. A(i,j) is read by walking row i of A for L and row j
+    of A^T for U, so every inner loop streams contiguous memory.
+*/
+static magma_int_t
+magma_zrowseg_sweep(
+    magma_z_matrix A,
+    magma_z_matrix AT,
+    magma_z_rowseg *L,
+    magma_z_rowseg *U,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = L->num_rows;
+    magmaDoubleComplex *Lval = NULL, *Uval = NULL, *swp = NULL;
+
+    CHECK( magma_zmalloc_cpu( &Lval, L->start[ n ] ));
+    CHECK( magma_zmalloc_cpu( &Uval, U->start[ n ] ));
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for( magma_int_t j=0; j<n; j++ ){
+        magma_int_t su = U->start[ j ];
+        magma_int_t eu = su + U->len[ j ];
+        magma_int_t a = AT.row[ j ];
+        magma_int_t enda = AT.row[ j+1 ];
+        for( magma_int_t p=su; p<eu; p++ ){
+            magma_index_t i = U->col[ p ];
+            magmaDoubleComplex A_e = MAGMA_Z_ZERO;
+            while( a < enda && AT.col[ a ] < i ){
+                a++;
+            }
+            if( a < enda && AT.col[ a ] == i ){
+                A_e = AT.val[ a ];
+            }
+            // sum_{k<i} L(i,k) U(k,j), the U(k,j) precede p in column j
+            magmaDoubleComplex sum = MAGMA_Z_ZERO;
+            magma_int_t l = L->start[ i ];
+            magma_int_t endl = l + L->len[ i ] - 1;
+            magma_int_t q = su;
+            while( l < endl && q < p ){
+                magma_index_t lcol = L->col[ l ];
+                magma_index_t urow = U->col[ q ];
+                if( lcol == urow ){
+                    sum += L->val[ l ] * U->val[ q ];
+                    l++;
+                    q++;
+                } else if( lcol < urow ){
+                    l++;
+                } else {
+                    q++;
+                }
+            }
+            Uval[ p ] = A_e - sum;
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for( magma_int_t i=0; i<n; i++ ){
+        magma_int_t sl = L->start[ i ];
+        magma_int_t el = sl + L->len[ i ] - 1;
+        magma_int_t a = A.row[ i ];
+        if( L->len[ i ] == 0 ){
+            continue;
+        }
+        magma_int_t enda = A.row[ i+1 ];
+        for( magma_int_t p=sl; p<el; p++ ){
+            magma_index_t j = L->col[ p ];
+            magmaDoubleComplex A_e = MAGMA_Z_ZERO;
+            while( a < enda && A.col[ a ] < j ){
+                a++;
+            }
+            if( a < enda && A.col[ a ] == j ){
+                A_e = A.val[ a ];
+            }
+            // sum_{k<j} L(i,k) U(k,j), the L(i,k) precede p in row i
+            magmaDoubleComplex sum = MAGMA_Z_ZERO;
+            magma_int_t l = sl;
+            magma_int_t q = U->start[ j ];
+            magma_int_t endq = q + U->len[ j ] - 1;
+            while( l < p && q < endq ){
+                magma_index_t lcol = L->col[ l ];
+                magma_index_t urow = U->col[ q ];
+                if( lcol == urow ){
+                    sum += L->val[ l ] * Uval[ q ];
+                    l++;
+                    q++;
+                } else if( lcol < urow ){
+                    l++;
+                } else {
+                    q++;
+                }
+            }
+            Lval[ p ] = ( A_e - sum ) / Uval[ endq ];
+        }
+        Lval[ el ] = MAGMA_Z_ONE;
+    }
+
+    swp = L->val; L->val = Lval; Lval = swp;
+    swp = U->val; U->val = Uval; Uval = swp;
+
+cleanup:
+    magma_free_cpu( Lval );
+    magma_free_cpu( Uval );
+    return info;
+}
+
+
+/*
+    Computes the ILU residual A - LU on the candidate locations, i.e. on
+    pattern( A + LU ) without the current pattern of L and U. Row i of LU is
+    accumulated in a dense per-thread work vector from row i of L and the
+    rows of U (UR is U in row-major CSR). Candidates for L are returned in
+    CL with the initial value r_ij / u_jj, candidates for U in CU (both
+    row-major CSR) with the value r_ij. res is the sum of |r_ij|.
+*/
+static magma_int_t
+magma_zrowseg_candidates(
+    magma_z_matrix A,
+    magma_z_rowseg L,
+    magma_z_matrix UR,
+    magma_z_rowseg U,
+    magma_z_matrix *CL,
+    magma_z_matrix *CU,
+    double *res,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = L.num_rows;
+    magma_int_t num_threads = omp_get_max_threads();
+    magma_int_t num_parts = 1;
+    double sum = 0.0;
+    std::vector< magma_index_t > first( num_threads+1, n );
+    std::vector< std::vector< magma_index_t > > Lcol( num_threads ), Ucol( num_threads );
+    std::vector< std::vector< magmaDoubleComplex > > Lval( num_threads ), Uval( num_threads );
+
+    magma_zmfree( CL, queue );
+    magma_zmfree( CU, queue );
+    CL->storage_type = CU->storage_type = Magma_CSR;
+    CL->memory_location = CU->memory_location = Magma_CPU;
+    CL->num_rows = CU->num_rows = n;
+    CL->num_cols = CU->num_cols = n;
+    CL->ownership = CU->ownership = MagmaTrue;
+    CHECK( magma_index_malloc_cpu( &CL->row, n+1 ));
+    CHECK( magma_index_malloc_cpu( &CU->row, n+1 ));
+
+    #pragma omp parallel reduction(+:sum)
+    {
+        magma_int_t nthr = omp_get_num_threads();
+        magma_int_t t = omp_get_thread_num();
+        magma_int_t begin = t * n / nthr;
+        magma_int_t end = ( t+1 ) * n / nthr;
+        std::vector< magma_index_t > touched( n, -1 ), existing( n, -1 ), nz;
+        std::vector< magmaDoubleComplex > acc( n );
+        #pragma omp single
+        {
+            num_parts = nthr;
+        }
+        first[ t ] = begin;
+        for( magma_int_t i=begin; i<end; i++ ){
+            magma_int_t cntL = 0, cntU = 0;
+            nz.clear();
+            for( magma_int_t p=L.start[ i ]; p<L.start[ i ]+L.len[ i ]; p++ ){
+                existing[ L.col[ p ] ] = i;
+            }
+            for( magma_int_t p=UR.row[ i ]; p<UR.row[ i+1 ]; p++ ){
+                existing[ UR.col[ p ] ] = i;
+            }
+            // acc = LU(i,:) - A(i,:)
+            for( magma_int_t p=A.row[ i ]; p<A.row[ i+1 ]; p++ ){
+                touched[ A.col[ p ] ] = i;
+                acc[ A.col[ p ] ] = -A.val[ p ];
+                nz.push_back( A.col[ p ] );
+            }
+            for( magma_int_t p=L.start[ i ]; p<L.start[ i ]+L.len[ i ]; p++ ){
+                magma_index_t k = L.col[ p ];
+                magmaDoubleComplex lik = ( k == i ) ? MAGMA_Z_ONE : L.val[ p ];
+                for( magma_int_t q=UR.row[ k ]; q<UR.row[ k+1 ]; q++ ){
+                    magma_index_t j = UR.col[ q ];
+                    if( touched[ j ] != i ){
+                        touched[ j ] = i;
+                        acc[ j ] = MAGMA_Z_ZERO;
+                        nz.push_back( j );
+                    }
+                    acc[ j ] += lik * UR.val[ q ];
+                }
+            }
+            std::sort( nz.begin(), nz.end() );
+            for( size_t p=0; p<nz.size(); p++ ){
+                magma_index_t j = nz[ p ];
+                if( existing[ j ] == i ){
+                    continue;
+                }
+                magmaDoubleComplex r = -acc[ j ];
+                sum += MAGMA_Z_ABS( r );
+                if( j < i ){
+                    Lcol[ t ].push_back( j );
+                    Lval[ t ].push_back( r / U.val[ U.start[ j ] + U.len[ j ] - 1 ] );
+                    cntL++;
+                } else {
+                    Ucol[ t ].push_back( j );
+                    Uval[ t ].push_back( r );
+                    cntU++;
+                }
+            }
+            CL->row[ i+1 ] = cntL;
+            CU->row[ i+1 ] = cntU;
+        }
+    }
+    *res = sum;
+
+    CL->row[ 0 ] = 0;
+    CU->row[ 0 ] = 0;
+    CHECK( magma_zmatrix_createrowptr( n, CL->row, queue ));
+    CHECK( magma_zmatrix_createrowptr( n, CU->row, queue ));
+    CL->nnz = CL->row[ n ];
+    CU->nnz = CU->row[ n ];
+    CHECK( magma_index_malloc_cpu( &CL->col, CL->nnz ));
+    CHECK( magma_zmalloc_cpu( &CL->val, CL->nnz ));
+    CHECK( magma_index_malloc_cpu( &CU->col, CU->nnz ));
+    CHECK( magma_zmalloc_cpu( &CU->val, CU->nnz ));
+
+    // the thread buffers hold consecutive row ranges, copy them in place
+    #pragma omp parallel for
+    for( magma_int_t t=0; t<num_parts; t++ ){
+        std::copy( Lcol[ t ].begin(), Lcol[ t ].end(), CL->col + CL->row[ first[ t ] ] );
+        std::copy( Lval[ t ].begin(), Lval[ t ].end(), CL->val + CL->row[ first[ t ] ] );
+        std::copy( Ucol[ t ].begin(), Ucol[ t ].end(), CU->col + CU->row[ first[ t ] ] );
+        std::copy( Uval[ t ].begin(), Uval[ t ].end(), CU->val + CU->row[ first[ t ] ] );
+    }
+
+cleanup:
+    return info;
+}
+
+
+/*
+    Returns in thrs the (approximate) magnitude of the num_rm-th smallest
+    off-diagonal entry of S. thrs is zero if nothing is to be removed.
+*/
+static magma_int_t
+magma_zrowseg_thrs(
+    magma_z_rowseg S,
+    magma_int_t num_rm,
+    double *thrs,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = S.num_rows;
+    magma_index_t *offset = NULL;
+    magmaDoubleComplex *val = NULL;
+
+    *thrs = 0.0;
+    if( num_rm <= 0 || num_rm >= S.nnz - n ){
+        goto cleanup;
+    }
+    CHECK( magma_index_malloc_cpu( &offset, n+1 ));
+    #pragma omp parallel for
+    for( magma_int_t i=0; i<n; i++ ){
+        offset[ i+1 ] = max( S.len[ i ] - 1, 0 );
+    }
+    offset[ 0 ] = 0;
+    CHECK( magma_zmatrix_createrowptr( n, offset, queue ));
+    CHECK( magma_zmalloc_cpu( &val, offset[ n ] ));
+    #pragma omp parallel for schedule(dynamic, 256)
+    for( magma_int_t i=0; i<n; i++ ){
+        magma_int_t shift = offset[ i ] - S.start[ i ];
+        for( magma_int_t p=S.start[ i ]; p<S.start[ i ]+S.len[ i ]-1; p++ ){
+            val[ p+shift ] = S.val[ p ];
+        }
+    }
+    CHECK( magma_zsampleselect_approx_cpu( offset[ n ], num_rm, val, thrs, queue ));
+
+cleanup:
+    magma_free_cpu( offset );
+    magma_free_cpu( val );
+    return info;
+}
+
+
+/*
+    Removes the off-diagonal entries with magnitude not above thrs. Every
+    segment is compacted in place, the freed space becomes slack.
+*/
+static magma_int_t
+magma_zrowseg_thrsrm(
+    magma_z_rowseg *S,
+    double thrs,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t nnz = 0;
+
+    #pragma omp parallel for schedule(dynamic, 256) reduction(+:nnz)
+    for( magma_int_t i=0; i<S->num_rows; i++ ){
+        magma_int_t s = S->start[ i ];
+        magma_int_t e = s + S->len[ i ] - 1;
+        magma_int_t w = s;
+        if( S->len[ i ] == 0 ){
+            continue;
+        }
+        for( magma_int_t p=s; p<e; p++ ){
+            if( MAGMA_Z_ABS( S->val[ p ] ) > thrs ){
+                S->col[ w ] = S->col[ p ];
+                S->val[ w ] = S->val[ p ];
+                w++;
+            }
+        }
+        S->col[ w ] = S->col[ e ];
+        S->val[ w ] = S->val[ e ];
+        S->len[ i ] = w - s + 1;
+        nnz += S->len[ i ];
+    }
+    S->nnz = nnz;
+
+    return info;
+}
+
+#endif
+
 
 /***************************************************************************//**
     Purpose
@@ -36,7 +563,16 @@
     This version uses the default setting which adds all candidates to the
     sparsity pattern.
 
+    The factors are kept in array-of-rows storage: L by rows and U by
+    columns, every row (column) a sorted contiguous segment with slack
+    capacity. Candidates are merged into the slack in place, and the storage
+    is only rebuilt when a segment overflows. Sweeps, residuals and removal
+    operate directly on the segments.
+
     This function requires OpenMP, and is only available if OpenMP is activated.
+
+    If A and b are both located on the CPU, the factors stay in CPU memory;
+    otherwise they are transferred to the device.
     
     The parameter list is:
     
@@ -78,22 +614,25 @@ magma_zparilut_cpu(
 #ifdef _OPENMP
 
     real_Double_t start, end;
-    real_Double_t t_rm=0.0, t_add=0.0, t_res=0.0, t_sweep1=0.0, t_sweep2=0.0, 
-        t_cand=0.0, t_sort=0.0, t_transpose1=0.0, t_transpose2=0.0, t_selectrm=0.0,
-        t_nrm=0.0, t_total = 0.0, accum=0.0;
+    real_Double_t t_rm=0.0, t_add=0.0, t_sweep1=0.0, t_sweep2=0.0, 
+        t_cand=0.0, t_transpose=0.0, t_selectrm=0.0,
+        t_total = 0.0, accum=0.0;
                     
-    double sum, sumL, sumU;
+    double sum = 0.0;
 
     magma_z_matrix hA={Magma_CSR}, hAT={Magma_CSR}, hL={Magma_CSR}, 
-        hU={Magma_CSR}, oneL={Magma_CSR}, oneU={Magma_CSR},
-        L={Magma_CSR}, U={Magma_CSR}, L_new={Magma_CSR}, U_new={Magma_CSR}, 
-        UT={Magma_CSR}, L0={Magma_CSR}, U0={Magma_CSR};
+        hU={Magma_CSR}, L={Magma_CSR}, U={Magma_CSR}, UT={Magma_CSR}, 
+        UR={Magma_CSR}, CL={Magma_CSR}, CU={Magma_CSR};
+    magma_z_rowseg Ls={0, 0, NULL, NULL, NULL, NULL}, 
+        Us={0, 0, NULL, NULL, NULL, NULL};
     magma_int_t num_rmL, num_rmU;
     double thrsL = 0.0;
     double thrsU = 0.0;
 
     magma_int_t num_threads = 1, timing = 1; // print timing
     magma_int_t L0nnz, U0nnz;
+    magma_location_t location = ( A.memory_location == Magma_CPU &&
+        b.memory_location == Magma_CPU ) ? Magma_CPU : Magma_DEV;
 
     #pragma omp parallel
     {
@@ -108,137 +647,97 @@ magma_zparilut_cpu(
         magma_zmfree(&hU, queue);
         magma_zmfree(&hL, queue);
     }
-    CHECK(magma_zmatrix_tril(hA, &L0, queue));
-    CHECK(magma_zmatrix_triu(hA, &U0, queue));
-    magma_zmfree(&hU, queue);
-    magma_zmfree(&hL, queue);
-    CHECK(magma_zmatrix_tril(hA, &L, queue));
     CHECK(magma_zmtranspose(hA, &hAT, queue));
-    CHECK(magma_zmatrix_tril(hAT, &U, queue));
-    CHECK(magma_zmatrix_addrowindex(&L, queue)); 
-    CHECK(magma_zmatrix_addrowindex(&U, queue)); 
-    L0nnz=L.nnz;
-    U0nnz=U.nnz;
-    oneL.memory_location = Magma_CPU;
-    oneU.memory_location = Magma_CPU;
+    // L by rows, U by columns, i.e. the rows of tril(A^T)
+    CHECK(magma_zmatrix_tril(hA, &hL, queue));
+    CHECK(magma_zmatrix_tril(hAT, &hU, queue));
+    CHECK(magma_zrowseg_create(hA.num_rows, &Ls, queue));
+    CHECK(magma_zrowseg_create(hA.num_rows, &Us, queue));
+    CHECK(magma_zrowseg_insert(&Ls, hL, queue));
+    CHECK(magma_zrowseg_insert(&Us, hU, queue));
+    magma_zmfree(&hL, queue);
+    magma_zmfree(&hU, queue);
+    L0nnz=Ls.nnz;
+    U0nnz=Us.nnz;
         
     if (timing == 1) {
         printf("ilut_fill_ratio = %.6f;\n\n", precond->atol);  
-        printf("performance_%d = [\n%%iter      L.nnz      U.nnz    ILU-Norm    transp    candidat  resid     sort    transcand    add      sweep1   selectrm    remove    sweep2     total       accum\n", 
+        printf("performance_%d = [\n%%iter      L.nnz      U.nnz    ILU-Norm    transp    candidat  add       sweep1    selectrm  remove    sweep2     total       accum\n", 
             (int) num_threads);
     }
 
     //##########################################################################
 
     for (magma_int_t iters =0; iters<precond->sweeps; iters++) {
-        t_rm=0.0; t_add=0.0; t_res=0.0; t_sweep1=0.0; t_sweep2=0.0; t_cand=0.0;
-        t_transpose1=0.0; t_transpose2=0.0;  t_selectrm=0.0; t_sort = 0;
-        t_sort=0.0; t_nrm=0.0; t_total = 0.0;
+        t_rm=0.0; t_add=0.0; t_sweep1=0.0; t_sweep2=0.0; t_cand=0.0;
+        t_transpose=0.0; t_selectrm=0.0; t_total = 0.0;
      
-        // step 1: transpose U
-        start = magma_sync_wtime(queue);
-        magma_zmfree(&UT, queue);
-        CHECK(magma_zcsrcoo_transpose(U, &UT, queue));
-        end = magma_sync_wtime(queue); t_transpose1+=end-start;
-        
-        
-        // step 2: find candidates
-        start = magma_sync_wtime(queue);
-        CHECK(magma_zparilut_candidates(L0, U0, L, UT, &hL, &hU, queue));
-        end = magma_sync_wtime(queue); t_cand=+end-start;
-        
-        
-        // step 3: compute residuals (optional when adding all candidates)
-        start = magma_sync_wtime(queue);
-        CHECK(magma_zparilut_residuals(hA, L, U, &hL, queue));
-        CHECK(magma_zparilut_residuals(hA, L, U, &hU, queue));
-        end = magma_sync_wtime(queue); t_res=+end-start;
-        start = magma_sync_wtime(queue);
-        CHECK(magma_zmatrix_abssum(hL, &sumL, queue));
-        CHECK(magma_zmatrix_abssum(hU, &sumU, queue));
-        sum = sumL + sumU;
-        end = magma_sync_wtime(queue); t_nrm+=end-start;
-        CHECK(magma_zmatrix_swap(&hL, &oneL, queue));
-        magma_zmfree(&hL, queue);
-        
-        
-        // step 4: sort candidates
+        // step 1: row-major copy of U for the products L*U
         start = magma_sync_wtime(queue);
-        CHECK(magma_zcsr_sort(&hL, queue));
-        CHECK(magma_zcsr_sort(&hU, queue));
-        end = magma_sync_wtime(queue); t_sort+=end-start;
+        CHECK(magma_zrowseg_tocsr(Us, &hU, queue));
+        CHECK(magma_zmtranspose_cpu(hU, &UR, queue));
+        magma_zmfree(&hU, queue);
+        end = magma_sync_wtime(queue); t_transpose+=end-start;
         
         
-        // step 5: transpose candidates
+        // step 2: find candidates and compute their residuals
         start = magma_sync_wtime(queue);
-        magma_zcsrcoo_transpose(hU, &oneU, queue);
-        end = magma_sync_wtime(queue); t_transpose2+=end-start;
+        CHECK(magma_zrowseg_candidates(hA, Ls, UR, Us, &CL, &hU, &sum, 
+            queue));
+        CHECK(magma_zmtranspose_cpu(hU, &CU, queue));
+        magma_zmfree(&hU, queue);
+        end = magma_sync_wtime(queue); t_cand+=end-start;
         
         
-        // step 6: add candidates
+        // step 3: add candidates
         start = magma_sync_wtime(queue);
-        CHECK(magma_zmatrix_cup(L, oneL, &L_new, queue));   
-        CHECK(magma_zmatrix_cup(U, oneU, &U_new, queue));
-        end = magma_sync_wtime(queue); t_add=+end-start;
-        magma_zmfree(&oneL, queue);
-        magma_zmfree(&oneU, queue);
+        CHECK(magma_zrowseg_insert(&Ls, CL, queue));
+        CHECK(magma_zrowseg_insert(&Us, CU, queue));
+        magma_zmfree(&CL, queue);
+        magma_zmfree(&CU, queue);
+        end = magma_sync_wtime(queue); t_add+=end-start;
        
         
-        // step 7: sweep
+        // step 4: sweep
         start = magma_sync_wtime(queue);
-        CHECK(magma_zparilut_sweep_sync(&hA, &L_new, &U_new, queue));
+        CHECK(magma_zrowseg_sweep(hA, hAT, &Ls, &Us, queue));
         end = magma_sync_wtime(queue); t_sweep1+=end-start;
         
         
-        // step 8: select threshold to remove elements
+        // step 5: select threshold to remove elements, ignoring the diagonal
         start = magma_sync_wtime(queue);
-        num_rmL = max((L_new.nnz-L0nnz*(1+(precond->atol-1.)
+        num_rmL = max((Ls.nnz-L0nnz*(1+(precond->atol-1.)
             *(iters+1)/precond->sweeps)), 0);
-        num_rmU = max((U_new.nnz-U0nnz*(1+(precond->atol-1.)
+        num_rmU = max((Us.nnz-U0nnz*(1+(precond->atol-1.)
             *(iters+1)/precond->sweeps)), 0);
-        // pre-select: ignore the diagonal entries
-        CHECK(magma_zparilut_preselect(0, &L_new, &oneL, queue));
-        CHECK(magma_zparilut_preselect(0, &U_new, &oneU, queue));
-        if (num_rmL>0) {
-            CHECK(magma_zparilut_set_thrs_randomselect_approx(num_rmL, 
-                &oneL, 0, &thrsL, queue));
-        } else {
-            thrsL = 0.0;
-        }
-        if (num_rmU>0) {
-            CHECK(magma_zparilut_set_thrs_randomselect_approx(num_rmU, 
-                &oneU, 0, &thrsU, queue));
-        } else {
-            thrsU = 0.0;
-        }
-        magma_zmfree(&oneL, queue);
-        magma_zmfree(&oneU, queue);
+        CHECK(magma_zrowseg_thrs(Ls, num_rmL, &thrsL, queue));
+        CHECK(magma_zrowseg_thrs(Us, num_rmU, &thrsU, queue));
         end = magma_sync_wtime(queue); t_selectrm=end-start;
 
         
-        // step 9: remove elements
+        // step 6: remove elements
         start = magma_sync_wtime(queue);
-        CHECK(magma_zparilut_thrsrm(1, &L_new, &thrsL, queue));
-        CHECK(magma_zparilut_thrsrm(1, &U_new, &thrsU, queue));
-        CHECK(magma_zmatrix_swap(&L_new, &L, queue));
-        CHECK(magma_zmatrix_swap(&U_new, &U, queue));
-        magma_zmfree(&L_new, queue);
-        magma_zmfree(&U_new, queue);
+        if (num_rmL > 0) {
+            CHECK(magma_zrowseg_thrsrm(&Ls, thrsL, queue));
+        }
+        if (num_rmU > 0) {
+            CHECK(magma_zrowseg_thrsrm(&Us, thrsU, queue));
+        }
         end = magma_sync_wtime(queue); t_rm=end-start;
         
         
-        // step 10: sweep
+        // step 7: sweep
         start = magma_sync_wtime(queue);
-        CHECK(magma_zparilut_sweep_sync(&hA, &L, &U, queue));
+        CHECK(magma_zrowseg_sweep(hA, hAT, &Ls, &Us, queue));
         end = magma_sync_wtime(queue); t_sweep2+=end-start;
         
         if (timing == 1) {
-            t_total = t_transpose1+ t_cand+ t_res+ t_sort+ t_transpose2+ t_add+ t_sweep1+ t_selectrm+ t_rm+ t_sweep2;
+            t_total = t_transpose+ t_cand+ t_add+ t_sweep1+ t_selectrm+ t_rm+ t_sweep2;
             accum = accum + t_total;
-            printf("%5lld %10lld %10lld  %.4e   %.2e  %.2e  %.2e  %.2e  %.2e  %.2e  %.2e  %.2e  %.2e  %.2e  %.2e      %.2e\n",
-                (long long) iters, (long long) L.nnz, (long long) U.nnz, 
+            printf("%5lld %10lld %10lld  %.4e   %.2e  %.2e  %.2e  %.2e  %.2e  %.2e  %.2e  %.2e      %.2e\n",
+                (long long) iters, (long long) Ls.nnz, (long long) Us.nnz, 
                 (double) sum, 
-                t_transpose1, t_cand, t_res, t_sort, t_transpose2, t_add, t_sweep1, t_selectrm, t_rm, t_sweep2, t_total, accum);
+                t_transpose, t_cand, t_add, t_sweep1, t_selectrm, t_rm, t_sweep2, t_total, accum);
             fflush(stdout);
         }
     }
@@ -249,23 +748,28 @@ magma_zparilut_cpu(
     }
     //##########################################################################
 
-    // for CUSPARSE
-    CHECK(magma_zmtransfer(L, &precond->L, Magma_CPU, Magma_DEV , queue));
-    CHECK(magma_zcsrcoo_transpose(U, &UT, queue));
-    //magma_zmtranspose(U, &UT, queue);
-    CHECK(magma_zmtransfer(UT, &precond->U, Magma_CPU, Magma_DEV , queue));
+    // for CUSPARSE, or the host solves if A and b are on the CPU
+    CHECK(magma_zrowseg_tocsr(Ls, &L, queue));
+    CHECK(magma_zrowseg_tocsr(Us, &U, queue));
+    CHECK(magma_zmtransfer(L, &precond->L, Magma_CPU, location, queue));
+    CHECK(magma_zmtranspose_cpu(U, &UT, queue));
+    CHECK(magma_zmtransfer(UT, &precond->U, Magma_CPU, location, queue));
     
     if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
         CHECK(magma_zcumilugeneratesolverinfo(precond, queue));
     } else {
-        //prepare for iterative solves
-        // extract the diagonal of L into precond->d
-        CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
-        CHECK(magma_zvinit(&precond->work1, Magma_DEV, hA.num_rows, 1, 
+        //prepare for iterative solves, in the memory location of the factors
+        // extract the diagonals of L and U into precond->d and precond->d2
+        if (location == Magma_CPU) {
+            CHECK(magma_zjacobisetup_diagscal_cpu(precond->L, &precond->d, queue));
+            CHECK(magma_zjacobisetup_diagscal_cpu(precond->U, &precond->d2, queue));
+        } else {
+            CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
+            CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
+        }
+        CHECK(magma_zvinit(&precond->work1, location, hA.num_rows, 1, 
             MAGMA_Z_ZERO, queue));
-        // extract the diagonal of U into precond->d2
-        CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
-        CHECK(magma_zvinit(&precond->work2, Magma_DEV, hA.num_rows, 1, 
+        CHECK(magma_zvinit(&precond->work2, location, hA.num_rows, 1, 
             MAGMA_Z_ZERO, queue));
     }
 
@@ -275,12 +779,13 @@ cleanup:
     magma_zmfree(&L, queue);
     magma_zmfree(&U, queue);
     magma_zmfree(&UT, queue);
-    magma_zmfree(&L0, queue);
-    magma_zmfree(&U0, queue);
-    magma_zmfree(&L_new, queue);
-    magma_zmfree(&U_new, queue);
+    magma_zmfree(&UR, queue);
+    magma_zmfree(&CL, queue);
+    magma_zmfree(&CU, queue);
     magma_zmfree(&hL, queue);
     magma_zmfree(&hU, queue);
+    magma_zrowseg_free(&Ls);
+    magma_zrowseg_free(&Us);
 #endif
     return info;
 }
@@ -0,0 +1,276 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+
+*/
+#include "magmasparse_internal.h"
+
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex N-by-N general matrix.
+    This is a CPU implementation of the preconditioned
+    Biconjugate Gradient Stabelized method, for A, B and X stored in the
+    CPU memory. It runs the same iteration as magma_zpbicgstab, with the
+    vector updates merged into the OpenMP kernels magma_zbicgstab_1_cpu,
+    magma_zbicgstab_2_cpu and magma_zbicgstab_4_cpu, and fills the solver
+    parameters in the same way.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgesv
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zpbicgstab_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_PBICGSTAB;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
+    magma_sparse_cycles_t t0 = magma_sparse_cycles();
+    magma_solver_phase cost[Magma_NUM_PHASES];
+
+    // some useful variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    magmaDoubleComplex c_one  = MAGMA_Z_ONE;
+
+    magma_int_t dofs = A.num_rows*b.num_cols;
+
+    // workspace
+    magma_z_matrix r={Magma_CSR}, rr={Magma_CSR}, p={Magma_CSR}, v={Magma_CSR}, s={Magma_CSR}, t={Magma_CSR}, ms={Magma_CSR}, mt={Magma_CSR}, y={Magma_CSR}, z={Magma_CSR};
+    CHECK( magma_zsolverinfo_costs( A, precond_par, cost, queue ));
+    CHECK( magma_zvinit( &r, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &rr,Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &p, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &v, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &s, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &t, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &ms,Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &mt,Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &y, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &z, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+
+
+    // solver variables
+    magmaDoubleComplex alpha, beta, omega, rho_old, rho_new;
+    double betanom, nom0, r0, res, nomb;
+    res=0;
+
+    // solver setup
+    CHECK(  magma_zresidualvec( A, b, *x, &r, &nom0, queue));
+    magma_zcopy_cpu( dofs, r.val, rr.val, queue );                      // rr = r
+    betanom = nom0;
+    rho_new = omega = alpha = MAGMA_Z_MAKE( 1.0, 0. );
+    solver_par->init_res = nom0;
+
+    nomb = magma_dznrm2_cpu( dofs, b.val, queue );
+    magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SETUP, t0, 1, 1 );
+    if ( nomb == 0.0 ){
+        nomb=1.0;
+    }
+    if ( (r0 = nomb * solver_par->rtol) < ATOLERANCE ){
+        r0 = ATOLERANCE;
+    }
+
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = nom0;
+        solver_par->timing[0] = 0.0;
+    }
+    if ( nom0 < r0 ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    //Chronometry
+    real_Double_t tempo1, tempo2;
+    tempo1 = magma_wtime();
+
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    // start iteration
+    do
+    {
+        solver_par->numiter++;
+        rho_old = rho_new;                                    // rho_old=rho
+
+        t0 = magma_sparse_cycles();
+        rho_new = magma_zdotc_cpu( dofs, rr.val, r.val, queue );  // rho=<rr,r>
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 1, 1 );
+        beta = rho_new/rho_old * alpha/omega;   // beta=rho/rho_old *alpha/omega
+        if( magma_z_isnan_inf( beta ) ){
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+        // p = r + beta * ( p - omega * v )
+        magma_zbicgstab_1_cpu( A.num_rows, b.num_cols, beta, omega,
+                               r.val, v.val, p.val, queue );
+
+        // preconditioner
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, p, &mt, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, mt, &y, precond_par, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, y, c_zero, v, queue ));      // v = Ap
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+        solver_par->spmv_count++;
+        t0 = magma_sparse_cycles();
+        alpha = rho_new / magma_zdotc_cpu( dofs, rr.val, v.val, queue );
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 1, 1 );
+        if( magma_z_isnan_inf( alpha ) ){
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+        // s = r - alpha v
+        magma_zbicgstab_2_cpu( A.num_rows, b.num_cols, alpha,
+                               r.val, v.val, s.val, queue );
+
+        // preconditioner
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, s, &ms, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, ms, &z, precond_par, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, z, c_zero, t, queue ));       // t=As
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+        solver_par->spmv_count++;
+        // omega = <s,t>/<t,t>
+        t0 = magma_sparse_cycles();
+        omega = magma_zdotc_cpu( dofs, t.val, s.val, queue )
+                   / magma_zdotc_cpu( dofs, t.val, t.val, queue );
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 1.5, 2 );
+
+        if( magma_z_isnan_inf( omega ) ){
+            magma_zaxpy_cpu( dofs, alpha, y.val, x->val, queue );    // x=x+alpha*p
+            res = magma_dznrm2_cpu( dofs, r.val, queue );
+            if ( res/nomb <= solver_par->rtol || res <= solver_par->atol ){
+                info = MAGMA_SUCCESS;
+            } else {
+                info = MAGMA_DIVERGENCE;
+            }
+            break;
+        }
+        // x = x + alpha * p + omega * s, r = s - omega * t
+        magma_zbicgstab_4_cpu( A.num_rows, b.num_cols, alpha, omega,
+                               y.val, z.val, s.val, t.val, x->val, r.val, queue );
+        t0 = magma_sparse_cycles();
+        res = betanom = magma_dznrm2_cpu( dofs, r.val, queue );
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 0.5, 0.5 );
+
+        if ( solver_par->verbose > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+
+        if ( res/nomb <= solver_par->rtol || res <= solver_par->atol ){
+            break;
+        }
+    }
+    while ( solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    double residual;
+    CHECK(  magma_zresidualvec( A, b, *x, &r, &residual, queue));
+    solver_par->final_res = residual;
+    solver_par->iter_res = res;
+
+    if ( solver_par->numiter < solver_par->maxiter && info == MAGMA_SUCCESS ) {
+        info = MAGMA_SUCCESS;
+    } else if ( solver_par->init_res > solver_par->final_res ) {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) betanom;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_SLOW_CONVERGENCE;
+        if( solver_par->iter_res < solver_par->rtol*nomb ||
+            solver_par->iter_res < solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+        }
+    }
+    else {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) betanom;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_DIVERGENCE;
+    }
+
+cleanup:
+    magma_zmfree(&r, queue );
+    magma_zmfree(&rr, queue );
+    magma_zmfree(&p, queue );
+    magma_zmfree(&v, queue );
+    magma_zmfree(&s, queue );
+    magma_zmfree(&t, queue );
+    magma_zmfree(&ms, queue );
+    magma_zmfree(&mt, queue );
+    magma_zmfree(&y, queue );
+    magma_zmfree(&z, queue );
+
+    solver_par->info = info;
+    return info;
+}   /* magma_zpbicgstab_cpu */
@@ -0,0 +1,244 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+
+/*******************************************************************************
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex Hermitian N-by-N positive definite matrix A.
+    This is a CPU implementation of the merged preconditioned Conjugate
+    Gradient method, for A, B and X stored in the CPU memory.
+    The search direction update, the SpMV and the dot product are merged
+    into magma_zcgmerge_spmv1_cpu, the solution and residual update and
+    the residual norm into magma_zcgmerge_xr_cpu. For the Jacobi
+    preconditioner, the scaling and its dot product are merged into the
+    update as well (magma_zjcgmerge_xr_cpu); any other preconditioner is
+    applied in between.
+    Without preconditioner (precond_par->solver == Magma_NONE), this is
+    the merged CG.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                preconditioner
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zposv
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zpcg_merge_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_PCGMERGE;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    // the fused kernels are not split into phases, the counters stay zero
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
+
+    // solver variables
+    magmaDoubleComplex alpha, beta, rho, gammanew, gammaold;
+    double nom, nom0, r0, res, nomb;
+    // local variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+
+    magma_int_t dofs = A.num_rows* b.num_cols;
+    bool precond_none = ( precond_par->solver == Magma_NONE );
+    bool precond_jacobi = ( precond_par->solver == Magma_JACOBI &&
+                            precond_par->d.memory_location == Magma_CPU );
+
+    // CPU workspace
+    magma_z_matrix r={Magma_CSR}, rt={Magma_CSR}, d={Magma_CSR}, z={Magma_CSR}, h={Magma_CSR};
+    magma_z_matrix *hp = precond_none ? &r : &h;
+    CHECK( magma_zvinit( &r, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &rt,Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &d, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &z, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &h, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+
+
+    // solver setup
+    CHECK(  magma_zresidualvec( A, b, *x, &r, &nom0, queue));
+
+    // preconditioner, without preconditioner the search direction is
+    // updated with r directly
+    if ( ! precond_none ) {
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, r, &rt, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, rt, &h, precond_par, queue ));
+    }
+    gammaold = magma_zdotc_cpu( dofs, r.val, hp->val, queue );      // go = < r,h>
+    beta = c_zero;                                                // d = h
+    res = nom0;
+    solver_par->init_res = nom0;
+
+    nomb = magma_dznrm2_cpu( dofs, b.val, queue );
+    if ( nomb == 0.0 ){
+        nomb=1.0;
+    }
+    if ( (r0 = nomb * solver_par->rtol) < ATOLERANCE ){
+        r0 = ATOLERANCE;
+    }
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t)nom0;
+        solver_par->timing[0] = 0.0;
+    }
+    if ( nom0 < r0 ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    //Chronometry
+    real_Double_t tempo1, tempo2;
+    tempo1 = magma_wtime();
+
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    // start iteration
+    do
+    {
+        solver_par->numiter++;
+
+        // d = h + beta d, z = A d, rho = d' z
+        CHECK( magma_zcgmerge_spmv1_cpu( A, beta, *hp, d, z, &rho, queue ));
+        solver_par->spmv_count++;
+        // check positive definite
+        if ( MAGMA_Z_ABS(rho) <= 0.0 ) {
+            info = MAGMA_NONSPD;
+            break;
+        }
+        alpha = gammaold / rho;
+        if( magma_z_isnan_inf( alpha ) ){
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+
+        // x = x + alpha d, r = r - alpha z, nom = r' r
+        if ( precond_jacobi ) {
+            // h = D^{-1} r, gn = < r,h>
+            magma_zjcgmerge_xr_cpu( dofs, alpha, precond_par->d.val, d.val, z.val,
+                                    x->val, r.val, h.val, &nom, &gammanew, queue );
+        } else {
+            magma_zcgmerge_xr_cpu( dofs, alpha, d.val, z.val,
+                                   x->val, r.val, &nom, queue );
+            if ( precond_none ) {
+                gammanew = MAGMA_Z_MAKE( nom, 0.0 );
+            } else {
+                CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, r, &rt, precond_par, queue ));
+                CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, rt, &h, precond_par, queue ));
+                gammanew = magma_zdotc_cpu( dofs, r.val, h.val, queue );   // gn = < r,h>
+            }
+        }
+        beta = gammanew / gammaold;                                   // beta = gn/go
+        gammaold = gammanew;
+
+        res = sqrt( nom );
+        if ( solver_par->verbose > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+
+        if ( res/nomb <= solver_par->rtol || res <= solver_par->atol ){
+            break;
+        }
+    }
+    while ( solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    double residual;
+    CHECK(  magma_zresidualvec( A, b, *x, &r, &residual, queue));
+    solver_par->iter_res = res;
+    solver_par->final_res = residual;
+
+    // keep a breakdown detected in the iteration
+    if ( info != MAGMA_NOTCONVERGED ) {
+        goto cleanup;
+    }
+
+    if ( solver_par->numiter < solver_par->maxiter ) {
+        info = MAGMA_SUCCESS;
+    } else if ( solver_par->init_res > solver_par->final_res ) {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_SLOW_CONVERGENCE;
+        if( solver_par->iter_res < solver_par->rtol*nomb ||
+            solver_par->iter_res < solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+        }
+    }
+    else {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_DIVERGENCE;
+    }
+
+cleanup:
+    magma_zmfree(&r, queue );
+    magma_zmfree(&rt, queue );
+    magma_zmfree(&d, queue );
+    magma_zmfree(&z, queue );
+    magma_zmfree(&h, queue );
+
+    solver_par->info = info;
+    return info;
+}   /* magma_zpcg_merge_cpu */
@@ -0,0 +1,611 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+
+/*******************************************************************************
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex Hermitian N-by-N positive definite matrix A.
+    This is a CPU implementation of the preconditioned Induced Dimension
+    Reduction method, for A, B and X stored in the CPU memory.
+    It runs the same iteration as magma_zpidr (shadow space from
+    solver_par->restart, residual smoothing), with the OpenMP BLAS-1 kernels
+    for the vector operations and host BLAS/LAPACK for the operations on
+    the n-by-s blocks, and fills the solver parameters in the same way.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                preconditioner
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zposv
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zpidr_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_PIDR;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    solver_par->init_res = 0.0;
+    solver_par->final_res = 0.0;
+    solver_par->iter_res = 0.0;
+    solver_par->runtime = 0.0;
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
+    magma_sparse_cycles_t t0 = magma_sparse_cycles();
+    magma_solver_phase cost[Magma_NUM_PHASES];
+
+    // constants
+    const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
+    const magmaDoubleComplex c_one = MAGMA_Z_ONE;
+    const magmaDoubleComplex c_n_one = MAGMA_Z_NEG_ONE;
+    const magma_int_t ione = 1;
+
+    // internal user parameters
+    const magma_int_t smoothing = 1;   // 0 = disable, 1 = enable
+    const double angle = 0.7;          // [0-1]
+
+    // local variables
+    magma_int_t iseed[4] = {0, 0, 0, 1};
+    magma_int_t dof;
+    magma_int_t s;
+    magma_int_t distr;
+    magma_int_t k, i, sk;
+    magma_int_t innerflag;
+    magma_int_t lwork, lapinfo;
+    double residual;
+    double nrm;
+    double nrmb;
+    double nrmr;
+    double nrmt;
+    double rho;
+    magmaDoubleComplex om;
+    magmaDoubleComplex tt;
+    magmaDoubleComplex tr;
+    magmaDoubleComplex gamma;
+    magmaDoubleComplex alpha;
+    magmaDoubleComplex mkk;
+    magmaDoubleComplex fk;
+    magmaDoubleComplex query[2];
+    magmaDoubleComplex *tau = NULL, *work = NULL;
+
+    // matrices and vectors
+    magma_z_matrix xs = {Magma_CSR};
+    magma_z_matrix r = {Magma_CSR}, rs = {Magma_CSR};
+    magma_z_matrix P = {Magma_CSR};
+    magma_z_matrix G = {Magma_CSR};
+    magma_z_matrix U = {Magma_CSR};
+    magma_z_matrix M = {Magma_CSR};
+    magma_z_matrix f = {Magma_CSR};
+    magma_z_matrix t = {Magma_CSR};
+    magma_z_matrix c = {Magma_CSR};
+    magma_z_matrix v = {Magma_CSR};
+    magma_z_matrix hbeta = {Magma_CSR};
+    magma_z_matrix lu = {Magma_CSR};
+    // views of the columns U(:,k) and G(:,k)
+    magma_z_matrix u_t = {Magma_CSR}, g_t = {Magma_CSR};
+
+    // chronometry
+    real_Double_t tempo1, tempo2;
+
+    // initial s space, same convention as magma_zpidr:
+    // '--restart' is used as the shadow space number
+    s = 1;
+    if ( solver_par->restart != 50 ) {
+        if ( solver_par->restart > A.num_cols ) {
+            s = A.num_cols;
+        } else {
+            s = solver_par->restart;
+        }
+    }
+    solver_par->restart = s;
+
+    // set max iterations
+    solver_par->maxiter = min( 2 * A.num_cols, solver_par->maxiter );
+
+    // check if matrix A is square
+    if ( A.num_rows != A.num_cols ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( magma_zsolverinfo_costs( A, precond_par, cost, queue ));
+
+    // |b|
+    nrmb = magma_dznrm2_cpu( b.num_rows, b.val, queue );
+    if ( nrmb == 0.0 ) {
+        magma_zscal_cpu( x->num_rows, MAGMA_Z_ZERO, x->val, queue );
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    // r = b - A x
+    CHECK( magma_zvinit( &r, Magma_CPU, b.num_rows, 1, c_zero, queue ));
+    CHECK( magma_zresidualvec( A, b, *x, &r, &nrmr, queue ));
+
+    // |r|
+    solver_par->init_res = nrmr;
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t)nrmr;
+    }
+
+    // check if initial is guess good enough
+    if ( nrmr <= solver_par->atol ||
+        nrmr/nrmb <= solver_par->rtol ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    // P = randn(n, s)
+    CHECK( magma_zvinit( &P, Magma_CPU, A.num_cols, s, c_zero, queue ));
+    distr = 3;        // 1 = unif (0,1), 2 = unif (-1,1), 3 = normal (0,1)
+    dof = P.num_rows * P.num_cols;
+    lapackf77_zlarnv( &distr, iseed, &dof, P.val );
+
+    // P = ortho(P)
+    if ( P.num_cols > 1 ) {
+        // explicit Q of the QR factorization
+        lwork = -1;
+        lapackf77_zgeqrf( &P.num_rows, &P.num_cols, P.val, &P.ld,
+                          query, &query[0], &lwork, &lapinfo );
+        lapackf77_zungqr( &P.num_rows, &P.num_cols, &P.num_cols, P.val, &P.ld,
+                          query, &query[1], &lwork, &lapinfo );
+        lwork = (magma_int_t) max( MAGMA_Z_REAL( query[0] ), MAGMA_Z_REAL( query[1] ));
+        CHECK( magma_zmalloc_cpu( &tau, P.num_cols ));
+        CHECK( magma_zmalloc_cpu( &work, lwork ));
+        lapackf77_zgeqrf( &P.num_rows, &P.num_cols, P.val, &P.ld,
+                          tau, work, &lwork, &lapinfo );
+        lapackf77_zungqr( &P.num_rows, &P.num_cols, &P.num_cols, P.val, &P.ld,
+                          tau, work, &lwork, &lapinfo );
+    } else {
+        // P = P / |P|
+        nrm = magma_dznrm2_cpu( dof, P.val, queue );
+        nrm = 1.0 / nrm;
+        magma_zscal_cpu( dof, MAGMA_Z_MAKE( nrm, 0.0 ), P.val, queue );
+    }
+
+    // allocate memory for the scalar products
+    CHECK( magma_zvinit( &hbeta, Magma_CPU, s, 1, c_zero, queue ));
+
+    // smoothing enabled
+    if ( smoothing > 0 ) {
+        // set smoothing solution vector
+        CHECK( magma_zmtransfer( *x, &xs, Magma_CPU, Magma_CPU, queue ));
+
+        // set smoothing residual vector
+        CHECK( magma_zmtransfer( r, &rs, Magma_CPU, Magma_CPU, queue ));
+    }
+
+    // G(n,s) = 0
+    CHECK( magma_zvinit( &G, Magma_CPU, A.num_cols, s, c_zero, queue ));
+
+    // U(n,s) = 0
+    CHECK( magma_zvinit( &U, Magma_CPU, A.num_cols, s, c_zero, queue ));
+
+    // M(s,s) = I
+    CHECK( magma_zvinit( &M, Magma_CPU, s, s, c_zero, queue ));
+    for ( i = 0; i < s; ++i ) {
+        M.val[i*M.ld+i] = c_one;
+    }
+
+    // f = 0
+    CHECK( magma_zvinit( &f, Magma_CPU, P.num_cols, 1, c_zero, queue ));
+
+    // t = 0
+    CHECK( magma_zvinit( &t, Magma_CPU, r.num_rows, 1, c_zero, queue ));
+
+    // c = 0
+    CHECK( magma_zvinit( &c, Magma_CPU, M.num_cols, 1, c_zero, queue ));
+
+    // v = 0
+    CHECK( magma_zvinit( &v, Magma_CPU, r.num_rows, 1, c_zero, queue ));
+
+    // lu = 0
+    CHECK( magma_zvinit( &lu, Magma_CPU, A.num_rows, 1, c_zero, queue ));
+
+    u_t.memory_location = Magma_CPU;
+    u_t.storage_type = Magma_DENSE;
+    u_t.num_rows = U.num_rows;
+    u_t.num_cols = 1;
+    g_t.memory_location = Magma_CPU;
+    g_t.storage_type = Magma_DENSE;
+    g_t.num_rows = G.num_rows;
+    g_t.num_cols = 1;
+    magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SETUP, t0, 1, 1 );
+
+    //--------------START TIME---------------
+    // chronometry
+    tempo1 = magma_wtime();
+    if ( solver_par->verbose > 0 ) {
+        solver_par->timing[0] = 0.0;
+    }
+
+    om = MAGMA_Z_ONE;
+    innerflag = 0;
+
+    // start iteration
+    do
+    {
+        solver_par->numiter++;
+
+        // new RHS for small systems
+        // f = P' r, reads r once for the s products
+        t0 = magma_sparse_cycles();
+        blasf77_zgemv( lapack_trans_const(MagmaConjTrans), &P.num_rows, &P.num_cols,
+                       &c_one, P.val, &P.ld, r.val, &ione, &c_zero, f.val, &ione );
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, (s+1)/2.0, s );
+
+        // shadow space loop
+        for ( k = 0; k < s; ++k ) {
+            sk = s - k;
+
+            // f(k:s) = M(k:s,k:s) c(k:s)
+            magma_zcopy_cpu( sk, &f.val[k], &c.val[k], queue );
+            blasf77_ztrsv( lapack_uplo_const(MagmaLower), lapack_trans_const(MagmaNoTrans),
+                           lapack_diag_const(MagmaNonUnit), &sk, &M.val[k*M.ld+k], &M.ld,
+                           &c.val[k], &ione );
+
+            // v = r - G(:,k:s) c(k:s)
+            magma_zcopy_cpu( r.num_rows, r.val, v.val, queue );
+            blasf77_zgemv( lapack_trans_const(MagmaNoTrans), &G.num_rows, &sk,
+                           &c_n_one, &G.val[k*G.ld], &G.ld, &c.val[k], &ione,
+                           &c_one, v.val, &ione );
+
+            // preconditioning operation
+            // v = L \ v;
+            // v = U \ v;
+            t0 = magma_sparse_cycles();
+            CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, v, &lu, precond_par, queue ));
+            CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, lu, &v, precond_par, queue ));
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+
+            // U(:,k) = om * v + U(:,k:s) c(k:s)
+            blasf77_zgemv( lapack_trans_const(MagmaNoTrans), &U.num_rows, &sk,
+                           &c_one, &U.val[k*U.ld], &U.ld, &c.val[k], &ione,
+                           &om, v.val, &ione );
+            magma_zcopy_cpu( U.num_rows, v.val, &U.val[k*U.ld], queue );
+
+            // G(:,k) = A U(:,k)
+            u_t.val = &U.val[k*U.ld];
+            g_t.val = &G.val[k*G.ld];
+            t0 = magma_sparse_cycles();
+            CHECK( magma_z_spmv( c_one, A, u_t, c_zero, g_t, queue ));
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+            solver_par->spmv_count++;
+
+            // bi-orthogonalize the new basis vectors; each step is one dot
+            // product and two AXPYs, the new column of M reads G(:,k) once
+            t0 = magma_sparse_cycles();
+            for ( i = 0; i < k; ++i ) {
+                // alpha = P(:,i)' G(:,k)
+                alpha = magma_zdotc_cpu( P.num_rows, &P.val[i*P.ld], &G.val[k*G.ld], queue );
+
+                // alpha = alpha / M(i,i)
+                mkk = M.val[i*M.ld+i];
+                alpha = alpha / mkk;
+
+                // G(:,k) = G(:,k) - alpha * G(:,i)
+                // U(:,k) = U(:,k) - alpha * U(:,i)
+                magma_zaxpy2_cpu( G.num_rows, -alpha, &G.val[i*G.ld], &G.val[k*G.ld],
+                                  -alpha, &U.val[i*U.ld], &U.val[k*U.ld], queue );
+            }
+
+            // new column of M = P'G, first k-1 entries are zero
+            // M(k:s,k) = P(:,k:s)' G(:,k)
+            blasf77_zgemv( lapack_trans_const(MagmaConjTrans), &P.num_rows, &sk,
+                           &c_one, &P.val[k*P.ld], &P.ld, &G.val[k*G.ld], &ione,
+                           &c_zero, &M.val[k*M.ld+k], &ione );
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_ORTHO, t0,
+                                ( 8*k + sk + 1 )/5.0, ( 3*k + sk )/2.0 );
+
+            // check M(k,k) == 0
+            mkk = M.val[k*M.ld+k];
+            if ( MAGMA_Z_EQUAL(mkk, MAGMA_Z_ZERO) ) {
+                innerflag = 1;
+                info = MAGMA_DIVERGENCE;
+                break;
+            }
+
+            // beta = f(k) / M(k,k)
+            fk = f.val[k];
+            hbeta.val[k] = fk / mkk;
+
+            // check for nan
+            if ( magma_z_isnan( hbeta.val[k] ) || magma_z_isinf( hbeta.val[k] )) {
+                innerflag = 1;
+                info = MAGMA_DIVERGENCE;
+                break;
+            }
+
+            // r = r - beta * G(:,k)
+            magma_zaxpy_cpu( r.num_rows, -hbeta.val[k], &G.val[k*G.ld], r.val, queue );
+
+            // smoothing disabled
+            if ( smoothing <= 0 ) {
+                // |r|
+                t0 = magma_sparse_cycles();
+                nrmr = magma_dznrm2_cpu( r.num_rows, r.val, queue );
+                magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 0.5, 0.5 );
+
+            // smoothing enabled
+            } else {
+                // x = x + beta * U(:,k)
+                magma_zaxpy_cpu( x->num_rows, hbeta.val[k], &U.val[k*U.ld], x->val, queue );
+
+                // smoothing operation
+//---------------------------------------
+                // t = rs - r
+                magma_zcopy_cpu( rs.num_rows, rs.val, t.val, queue );
+                magma_zaxpy_cpu( t.num_rows, c_n_one, r.val, t.val, queue );
+
+                // t't
+                // t'rs
+                t0 = magma_sparse_cycles();
+                tt = magma_zdotc_cpu( t.num_rows, t.val, t.val, queue );
+                tr = magma_zdotc_cpu( t.num_rows, t.val, rs.val, queue );
+                magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 1.5, 2 );
+
+                // gamma = (t' * rs) / (t' * t)
+                gamma = tr / tt;
+
+                // rs = rs - gamma * (rs - r)
+                magma_zaxpy_cpu( rs.num_rows, -gamma, t.val, rs.val, queue );
+
+                // xs = xs - gamma * (xs - x)
+                magma_zcopy_cpu( xs.num_rows, xs.val, t.val, queue );
+                magma_zaxpy_cpu( t.num_rows, c_n_one, x->val, t.val, queue );
+                magma_zaxpy_cpu( xs.num_rows, -gamma, t.val, xs.val, queue );
+
+                // |rs|
+                t0 = magma_sparse_cycles();
+                nrmr = magma_dznrm2_cpu( rs.num_rows, rs.val, queue );
+                magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 0.5, 0.5 );
+//---------------------------------------
+            }
+
+            // store current timing and residual
+            if ( solver_par->verbose > 0 ) {
+                tempo2 = magma_wtime();
+                if ( (solver_par->numiter) % solver_par->verbose == 0 ) {
+                    solver_par->res_vec[(solver_par->numiter) / solver_par->verbose]
+                            = (real_Double_t)nrmr;
+                    solver_par->timing[(solver_par->numiter) / solver_par->verbose]
+                            = (real_Double_t)tempo2 - tempo1;
+                }
+            }
+
+            // check convergence
+            if ( nrmr <= solver_par->atol ||
+                nrmr/nrmb <= solver_par->rtol ) {
+                s = k + 1; // for the x-update outside the loop
+                innerflag = 2;
+                info = MAGMA_SUCCESS;
+                break;
+            }
+
+            // non-last s iteration
+            if ( (k + 1) < s ) {
+                // f(k+1:s) = f(k+1:s) - beta * M(k+1:s,k)
+                magma_zaxpy_cpu( sk-1, -hbeta.val[k], &M.val[k*M.ld+(k+1)], &f.val[k+1], queue );
+            }
+        }
+
+        // smoothing disabled
+        if ( smoothing <= 0 && innerflag != 1 ) {
+            // update solution approximation x
+            // x = x + U(:,1:s) * beta(1:s)
+            blasf77_zgemv( lapack_trans_const(MagmaNoTrans), &U.num_rows, &s,
+                           &c_one, U.val, &U.ld, hbeta.val, &ione,
+                           &c_one, x->val, &ione );
+        }
+
+        // check convergence or iteration limit or invalid result of inner loop
+        if ( innerflag > 0 ) {
+            break;
+        }
+
+        // v = r
+        magma_zcopy_cpu( r.num_rows, r.val, v.val, queue );
+
+        // preconditioning operation
+        // v = L \ v;
+        // v = U \ v;
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, v, &lu, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, lu, &v, precond_par, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+
+        // t = A v
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, v, c_zero, t, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+        solver_par->spmv_count++;
+
+        // computation of a new omega
+//---------------------------------------
+        // |t|
+        t0 = magma_sparse_cycles();
+        nrmt = magma_dznrm2_cpu( t.num_rows, t.val, queue );
+
+        // t'r
+        tr = magma_zdotc_cpu( t.num_rows, t.val, r.val, queue );
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 1.5, 1.5 );
+
+        // rho = abs(t' * r) / (|t| * |r|))
+        rho = MAGMA_D_ABS( MAGMA_Z_REAL(tr) / (nrmt * nrmr) );
+
+        // om = (t' * r) / (|t| * |t|)
+        om = tr / (nrmt * nrmt);
+        if ( rho < angle ) {
+            om = (om * angle) / rho;
+        }
+//---------------------------------------
+        if ( MAGMA_Z_EQUAL(om, MAGMA_Z_ZERO) ) {
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+
+        // update approximation vector
+        // x = x + om * v
+        // update residual vector
+        // r = r - om * t
+        magma_zaxpy2_cpu( x->num_rows, om, v.val, x->val, -om, t.val, r.val, queue );
+
+        // smoothing disabled
+        if ( smoothing <= 0 ) {
+            // residual norm
+            t0 = magma_sparse_cycles();
+            nrmr = magma_dznrm2_cpu( b.num_rows, r.val, queue );
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 0.5, 0.5 );
+
+        // smoothing enabled
+        } else {
+            // smoothing operation
+//---------------------------------------
+            // t = rs - r
+            magma_zcopy_cpu( rs.num_rows, rs.val, t.val, queue );
+            magma_zaxpy_cpu( t.num_rows, c_n_one, r.val, t.val, queue );
+
+            // t't
+            // t'rs
+            t0 = magma_sparse_cycles();
+            tt = magma_zdotc_cpu( t.num_rows, t.val, t.val, queue );
+            tr = magma_zdotc_cpu( t.num_rows, t.val, rs.val, queue );
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 1.5, 2 );
+
+            // gamma = (t' * rs) / (|t| * |t|)
+            gamma = tr / tt;
+
+            // rs = rs - gamma * (rs - r)
+            magma_zaxpy_cpu( rs.num_rows, -gamma, t.val, rs.val, queue );
+
+            // xs = xs - gamma * (xs - x)
+            magma_zcopy_cpu( xs.num_rows, xs.val, t.val, queue );
+            magma_zaxpy_cpu( t.num_rows, c_n_one, x->val, t.val, queue );
+            magma_zaxpy_cpu( xs.num_rows, -gamma, t.val, xs.val, queue );
+
+            // |rs|
+            t0 = magma_sparse_cycles();
+            nrmr = magma_dznrm2_cpu( b.num_rows, rs.val, queue );
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 0.5, 0.5 );
+//---------------------------------------
+        }
+
+        // store current timing and residual
+        if ( solver_par->verbose > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter) % solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter) / solver_par->verbose]
+                        = (real_Double_t)nrmr;
+                solver_par->timing[(solver_par->numiter) / solver_par->verbose]
+                        = (real_Double_t)tempo2 - tempo1;
+            }
+        }
+
+        // check convergence
+        if ( nrmr <= solver_par->atol ||
+            nrmr/nrmb <= solver_par->rtol ) {
+            info = MAGMA_SUCCESS;
+            break;
+        }
+    }
+    while ( solver_par->numiter + 1 <= solver_par->maxiter );
+
+    // smoothing enabled
+    if ( smoothing > 0 ) {
+        // x = xs
+        magma_zcopy_cpu( x->num_rows, xs.val, x->val, queue );
+
+        // r = rs
+        magma_zcopy_cpu( r.num_rows, rs.val, r.val, queue );
+    }
+
+    // get last iteration timing
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t)tempo2 - tempo1;
+//--------------STOP TIME----------------
+
+    // get final stats
+    solver_par->iter_res = nrmr;
+    CHECK( magma_zresidualvec( A, b, *x, &r, &residual, queue ));
+    solver_par->final_res = residual;
+
+    // set solver conclusion
+    if ( info != MAGMA_SUCCESS && info != MAGMA_DIVERGENCE ) {
+        if ( solver_par->init_res > solver_par->final_res ) {
+            info = MAGMA_SLOW_CONVERGENCE;
+        }
+    }
+
+
+cleanup:
+    // free resources
+    // smoothing enabled
+    if ( smoothing > 0 ) {
+        magma_zmfree( &xs, queue );
+        magma_zmfree( &rs, queue );
+    }
+    magma_zmfree( &r, queue );
+    magma_zmfree( &P, queue );
+    magma_zmfree( &G, queue );
+    magma_zmfree( &U, queue );
+    magma_zmfree( &M, queue );
+    magma_zmfree( &f, queue );
+    magma_zmfree( &t, queue );
+    magma_zmfree( &c, queue );
+    magma_zmfree( &v, queue );
+    magma_zmfree( &lu, queue);
+    magma_zmfree( &hbeta, queue );
+    magma_free_cpu( tau );
+    magma_free_cpu( work );
+
+    solver_par->info = info;
+    return info;
+    /* magma_zpidr_cpu */
+}
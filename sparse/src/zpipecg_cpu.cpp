@@ -0,0 +1,284 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+
+/*******************************************************************************
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex Hermitian N-by-N positive definite matrix A.
+    This is a CPU implementation of the pipelined preconditioned Conjugate
+    Gradient method of Ghysels and Vanroose, for A, B and X stored in the
+    CPU memory.
+
+    The recurrences for w = A u, s = A p, q = M^(-1) s and z = A q make
+    the three dot products gamma = r^H u, delta = u^H w = u^H A u and
+    r^H r of an iteration independent of its preconditioner and SpMV,
+    with delta in the same order as p^H A p in the CG: they are computed
+    by helper threads (magma_zdotc_start_cpu) while the OpenMP threads
+    apply the preconditioner and the SpMV, and are only waited for before
+    the vector updates (magma_zpipecg_update_cpu). An iteration has one such overlapped
+    reduction, instead of two blocking ones in the classical CG.
+    The residual norm used in the stopping criterion is the one of the
+    iterate before the update, so the solver needs one more iteration than
+    the classical CG to detect convergence. As the recurrences accumulate
+    rounding errors, the final residual may be somewhat larger than the one
+    of the classical CG.
+    Without preconditioner (precond_par->solver == Magma_NONE), this is
+    the pipelined CG.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                preconditioner
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zposv
+*******************************************************************************/
+
+extern "C" magma_int_t
+magma_zpipecg_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_PPIPECG;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
+    magma_sparse_cycles_t t0 = magma_sparse_cycles();
+    magma_solver_phase cost[Magma_NUM_PHASES];
+
+    // solver variables
+    magmaDoubleComplex alpha = MAGMA_Z_ZERO, beta = MAGMA_Z_ZERO, denom;
+    magmaDoubleComplex gammaold = MAGMA_Z_ZERO, dots[3];
+    double nom0, r0, res = 0.0, nomb;
+    // local variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE;
+
+    magma_int_t dofs = A.num_rows* b.num_cols;
+    bool precond_none = ( precond_par->solver == Magma_NONE );
+
+    // CPU workspace; without preconditioner u = r, m = w and q = s
+    magma_z_matrix r={Magma_CSR}, rt={Magma_CSR}, u={Magma_CSR}, w={Magma_CSR},
+                   m={Magma_CSR}, nv={Magma_CSR}, z={Magma_CSR}, q={Magma_CSR},
+                   s={Magma_CSR}, p={Magma_CSR};
+    magma_z_matrix *up = precond_none ? &r : &u;
+    magma_z_matrix *mp = precond_none ? &w : &m;
+    magma_z_reduction_t red = NULL;
+    const magmaDoubleComplex *dx[3], *dy[3];
+
+    CHECK( magma_zsolverinfo_costs( A, precond_par, cost, queue ));
+    CHECK( magma_zvinit( &r,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &w,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &nv, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &z,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &s,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &p,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    if ( ! precond_none ) {
+        CHECK( magma_zvinit( &rt, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+        CHECK( magma_zvinit( &u,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+        CHECK( magma_zvinit( &m,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+        CHECK( magma_zvinit( &q,  Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    }
+    // dots = [ r^H u, u^H w, r^H r ], delta = u^H A u as p^H A p in the CG
+    dx[0] = r.val;  dy[0] = up->val;
+    dx[1] = up->val;  dy[1] = w.val;
+    dx[2] = r.val;  dy[2] = r.val;
+    CHECK( magma_zreduction_create_cpu( A, 3, precond_none ? 2 : 3, &red, queue ));
+
+    // solver setup: r = b - A x, u = M^(-1) r, w = A u
+    CHECK(  magma_zresidualvec( A, b, *x, &r, &nom0, queue));
+    if ( ! precond_none ) {
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, r, &rt, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, rt, &u, precond_par, queue ));
+    }
+    CHECK( magma_z_spmv( c_one, A, *up, c_zero, w, queue ));
+    solver_par->init_res = nom0;
+
+    nomb = magma_dznrm2_cpu( dofs, b.val, queue );
+    magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SETUP, t0, 1, 1 );
+    if ( nomb == 0.0 ){
+        nomb=1.0;
+    }
+    if ( (r0 = nomb * solver_par->rtol) < ATOLERANCE ){
+        r0 = ATOLERANCE;
+    }
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t)nom0;
+        solver_par->timing[0] = 0.0;
+    }
+    if ( nom0 < r0 ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+
+    //Chronometry
+    real_Double_t tempo1, tempo2;
+    tempo1 = magma_wtime();
+
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 1;
+    // start iteration
+    while( true )
+    {
+        // the dot products run on the helper threads ...
+        CHECK( magma_zdotc_start_cpu( 3, dx, dy, dots, red, queue ));
+        // ... while m = M^(-1) w and nv = A m are computed
+        if ( ! precond_none ) {
+            t0 = magma_sparse_cycles();
+            CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, w, &rt, precond_par, queue ));
+            CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, rt, &m, precond_par, queue ));
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+        }
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, *mp, c_zero, nv, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+        solver_par->spmv_count++;
+        // only the part of the reductions not hidden behind them is timed
+        t0 = magma_sparse_cycles();
+        CHECK( magma_zdotc_wait_cpu( red, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, precond_none ? 1.0 : 1.5, 3 );
+
+        // residual norm of the current iterate
+        res = sqrt( fabs( MAGMA_Z_REAL( dots[2] )));
+        if ( solver_par->verbose > 0 && solver_par->numiter > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        if ( res/nomb <= solver_par->rtol || res <= solver_par->atol ){
+            break;
+        }
+        if ( solver_par->numiter+1 > solver_par->maxiter ) {
+            break;
+        }
+
+        // beta = gamma / gammaold, alpha = gamma / ( delta - beta gamma / alphaold )
+        if ( solver_par->numiter == 0 ) {
+            beta = c_zero;
+            denom = dots[1];
+        } else {
+            beta = dots[0] / gammaold;
+            denom = dots[1] - beta * dots[0] / alpha;
+        }
+        // check positive definite
+        if ( MAGMA_Z_ABS( denom ) <= 0.0 ) {
+            info = MAGMA_NONSPD;
+            break;
+        }
+        alpha = dots[0] / denom;
+        if( magma_z_isnan_inf( alpha ) || magma_z_isnan_inf( beta ) ){
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+        gammaold = dots[0];
+
+        magma_zpipecg_update_cpu( dofs, alpha, beta,
+                                  precond_none ? NULL : m.val, nv.val,
+                                  x->val, r.val, precond_none ? NULL : u.val, w.val,
+                                  z.val, precond_none ? NULL : q.val, s.val, p.val, queue );
+        solver_par->numiter++;
+    }
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    double residual;
+    CHECK(  magma_zresidualvec( A, b, *x, &r, &residual, queue));
+    solver_par->iter_res = res;
+    solver_par->final_res = residual;
+
+    // keep a breakdown detected in the iteration
+    if ( info != MAGMA_NOTCONVERGED ) {
+        goto cleanup;
+    }
+
+    if ( solver_par->numiter < solver_par->maxiter ) {
+        info = MAGMA_SUCCESS;
+    } else if ( solver_par->init_res > solver_par->final_res ) {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_SLOW_CONVERGENCE;
+        if( solver_par->iter_res < solver_par->rtol*nomb ||
+            solver_par->iter_res < solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+        }
+    }
+    else {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose == 0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) res;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_DIVERGENCE;
+    }
+
+cleanup:
+    magma_zreduction_destroy_cpu( red, queue );
+    magma_zmfree(&r, queue );
+    magma_zmfree(&rt, queue );
+    magma_zmfree(&u, queue );
+    magma_zmfree(&w, queue );
+    magma_zmfree(&m, queue );
+    magma_zmfree(&nv, queue );
+    magma_zmfree(&z, queue );
+    magma_zmfree(&q, queue );
+    magma_zmfree(&s, queue );
+    magma_zmfree(&p, queue );
+
+    solver_par->info = info;
+    return info;
+}   /* magma_zpipecg_cpu */
@@ -0,0 +1,413 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+// simulate 2-D arrays at the cost of some arithmetic
+#define V(i) (V.val+(i)*dofs)
+#define Z(i) (Z.val+(i)*dofs)
+#define Hh(i,j) (Hh[(j)*ldh+(i)])
+#define Hr(i,j) (Hr[(j)*ldh+(i)])
+
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+
+// same rotations as in magma_zfgmres
+static void
+GeneratePlaneRotation(magmaDoubleComplex dx, magmaDoubleComplex dy, magmaDoubleComplex *cs, magmaDoubleComplex *sn)
+{
+#if defined(PRECISION_s) | defined(PRECISION_d)
+    if (dy == MAGMA_Z_ZERO) {
+        *cs = MAGMA_Z_ONE;
+        *sn = MAGMA_Z_ZERO;
+    } else if (MAGMA_Z_ABS((dy)) > MAGMA_Z_ABS((dx))) {
+        magmaDoubleComplex temp = dx / dy;
+        *sn = MAGMA_Z_ONE / magma_zsqrt( ( MAGMA_Z_ONE + temp*temp));
+        *cs = temp * (*sn);
+    } else {
+        magmaDoubleComplex temp = dy / dx;
+        *cs = MAGMA_Z_ONE / magma_zsqrt( ( MAGMA_Z_ONE + temp*temp ));
+        *sn = temp * (*cs);
+    }
+#else
+    real_Double_t rho = sqrt(MAGMA_Z_REAL(MAGMA_Z_CONJ(dx)*dx + MAGMA_Z_CONJ(dy)*dy));
+    *cs = dx / rho;
+    *sn = dy / rho;
+#endif
+}
+
+static void ApplyPlaneRotation(magmaDoubleComplex *dx, magmaDoubleComplex *dy, magmaDoubleComplex cs, magmaDoubleComplex sn)
+{
+#if defined(PRECISION_s) | defined(PRECISION_d)
+    magmaDoubleComplex temp = (*dx);
+    *dx =  cs * (*dx) + sn * (*dy);
+    *dy = -sn * temp + cs * (*dy);
+#else
+    magmaDoubleComplex temp  =  MAGMA_Z_CONJ(cs) * (*dx) +  MAGMA_Z_CONJ(sn) * (*dy);
+    *dy = -(sn) * (*dx) + cs * (*dy);
+    *dx = temp;
+#endif
+}
+
+
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex sparse matrix stored in the CPU memory.
+    X and B are complex vectors stored on the CPU memory.
+    This is a CPU implementation of the right-preconditioned pipelined
+    GMRES with pipeline depth 1, p(1)-GMRES of Ghysels, Ashby, Meerbergen
+    and Vanroose, restarted after solver_par->restart steps.
+
+    Besides the orthonormal basis V, the solver keeps Z = A M^(-1) V,
+    updated with the same Gram-Schmidt coefficients as V. In step i, the
+    dot products of the classical Gram-Schmidt of z_i against v_0, ..., v_i
+    and the norm of z_i are computed by helper threads
+    (magma_zdotc_start_cpu), while the OpenMP threads apply the
+    preconditioner and the SpMV to z_i, which gives z_(i+1) before
+    v_(i+1) is known. The norm of the new basis vector follows from
+    ||z_i||^2 minus the squared Gram-Schmidt coefficients; if this
+    difference has lost more than half of the digits, the new basis vector
+    is orthogonalized explicitly and its norm is computed with a blocking
+    reduction instead.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                descriptor for matrix A
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b vector
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+
+    @param[in]
+    precond_par magma_z_preconditioner*
+                preconditioner
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgesv
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zpipegmres_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_z_preconditioner *precond_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    magma_int_t dofs = A.num_rows;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_PPIPEGMRES;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+    memset( solver_par->phase, 0, sizeof(solver_par->phase) );
+    magma_sparse_cycles_t t0 = magma_sparse_cycles();
+    magma_solver_phase cost[Magma_NUM_PHASES];
+
+    //Chronometry
+    real_Double_t tempo1, tempo2;
+
+    magma_int_t m = max( 1, min( solver_par->restart, dofs ));
+    magma_int_t ldh = m+1; // used inside Hh and Hr macros
+    magma_int_t i, j, k, last = -1, converged = 0, first = 1;
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE, c_mone = MAGMA_Z_NEG_ONE;
+    double betanom = 0.0, nomb, r0 = 0.0, eta, hn2, hn;
+    double tol = sqrt( lapackf77_dlamch( "E" ));
+    double residual;
+
+    // views of the columns of V and Z
+    magma_z_matrix v_t={Magma_CSR}, w_t={Magma_CSR}, t={Magma_CSR}, t2={Magma_CSR}, u={Magma_CSR},
+                   V={Magma_CSR}, Z={Magma_CSR};
+    v_t.memory_location = Magma_CPU;
+    v_t.num_rows = dofs;
+    v_t.num_cols = 1;
+    v_t.val = NULL;
+    v_t.storage_type = Magma_DENSE;
+    w_t = v_t;
+
+    magmaDoubleComplex *Hh=NULL, *Hr=NULL, *g=NULL, *y=NULL, *cs=NULL, *sn=NULL, *dots=NULL;
+    const magmaDoubleComplex **dx=NULL, **dy=NULL;
+    magma_z_reduction_t red = NULL;
+
+    CHECK( magma_zsolverinfo_costs( A, precond_par, cost, queue ));
+    CHECK( magma_zvinit( &t, Magma_CPU, dofs, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &t2, Magma_CPU, dofs, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &u, Magma_CPU, dofs, 1, c_zero, queue ));
+    CHECK( magma_zvinit( &V, Magma_CPU, dofs*(m+1), 1, c_zero, queue ));
+    CHECK( magma_zvinit( &Z, Magma_CPU, dofs*(m+1), 1, c_zero, queue ));
+
+    CHECK( magma_zmalloc_cpu( &Hh, ldh*m ));
+    CHECK( magma_zmalloc_cpu( &Hr, ldh*m ));
+    CHECK( magma_zmalloc_cpu( &g,  m+1 ));
+    CHECK( magma_zmalloc_cpu( &y,  m+1 ));
+    CHECK( magma_zmalloc_cpu( &cs, m ));
+    CHECK( magma_zmalloc_cpu( &sn, m ));
+    CHECK( magma_zmalloc_cpu( &dots, m+2 ));
+    CHECK( magma_malloc_cpu( (void**) &dx, (m+2)*sizeof(magmaDoubleComplex*) ));
+    CHECK( magma_malloc_cpu( (void**) &dy, (m+2)*sizeof(magmaDoubleComplex*) ));
+    // on average, a reduction reads half of V and one vector of Z
+    CHECK( magma_zreduction_create_cpu( A, m+2, m/2+2, &red, queue ));
+    for (i = 0; i < ldh*m; i++)
+        Hh[i] = c_zero;
+
+    nomb = magma_dznrm2_cpu( dofs, b.val, queue );
+    if ( nomb == 0.0 ){
+        nomb=1.0;
+    }
+    if ( (r0 = nomb * solver_par->rtol) < ATOLERANCE ){
+        r0 = ATOLERANCE;
+    }
+    magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SETUP, t0, 1, 1 );
+
+    tempo1 = magma_wtime();
+    do
+    {
+        // V(0) = ( b - A x ) / beta
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, *x, c_zero, t, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+        solver_par->spmv_count++;
+        magma_zcopy_cpu( dofs, b.val, V(0), queue );
+        magma_zaxpy_cpu( dofs, c_mone, t.val, V(0), queue );
+        t0 = magma_sparse_cycles();
+        betanom = magma_dznrm2_cpu( dofs, V(0), queue );
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, 0.5, 0.5 );
+        if( betanom != betanom ){
+            info = MAGMA_DIVERGENCE;
+            break;
+        }
+        if ( first ) {
+            first = 0;
+            solver_par->init_res = betanom;
+            if ( solver_par->verbose > 0 ) {
+                solver_par->res_vec[0] = (real_Double_t) betanom;
+                solver_par->timing[0] = 0.0;
+            }
+            if ( betanom < r0 ) {
+                solver_par->final_res = solver_par->init_res;
+                solver_par->iter_res = solver_par->init_res;
+                info = MAGMA_SUCCESS;
+                goto cleanup;
+            }
+        }
+        magma_zscal_cpu( dofs, MAGMA_Z_MAKE( 1.0/betanom, 0.0 ), V(0), queue );
+        for (i = 1; i < m+1; i++)
+            g[i] = c_zero;
+        g[0] = MAGMA_Z_MAKE( betanom, 0.0 );
+
+        // Z(0) = A M^(-1) V(0)
+        v_t.val = V(0);
+        w_t.val = Z(0);
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, v_t, &t, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, t, &t2, precond_par, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_spmv( c_one, A, t2, c_zero, w_t, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+        solver_par->spmv_count++;
+
+        last = -1;
+        for (i = 0; i < m && !converged && solver_par->numiter < solver_par->maxiter; i++) {
+            // Hh(0:i,i) = V(0:i)' Z(i) and ||Z(i)||^2 on the helper threads ...
+            for (j = 0; j <= i; j++) {
+                dx[j] = V(j);
+                dy[j] = Z(i);
+            }
+            dx[i+1] = Z(i);
+            dy[i+1] = Z(i);
+            CHECK( magma_zdotc_start_cpu( i+2, dx, dy, dots, red, queue ));
+            // ... while Z(i+1) = A M^(-1) Z(i) is computed
+            v_t.val = Z(i);
+            w_t.val = Z(i+1);
+            t0 = magma_sparse_cycles();
+            CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, v_t, &t, precond_par, queue ));
+            CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, t, &t2, precond_par, queue ));
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+            t0 = magma_sparse_cycles();
+            CHECK( magma_z_spmv( c_one, A, t2, c_zero, w_t, queue ));
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_SPMV, t0, 1, 1 );
+            solver_par->spmv_count++;
+            // only the part of the reductions not hidden behind them is timed
+            t0 = magma_sparse_cycles();
+            CHECK( magma_zdotc_wait_cpu( red, queue ));
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_REDUCE, t0, ( i+2 )/2.0, i+2 );
+
+            eta = MAGMA_Z_REAL( dots[i+1] );
+            hn2 = eta;
+            for (j = 0; j <= i; j++) {
+                Hh(j,i) = dots[j];
+                hn2 -= MAGMA_Z_REAL( MAGMA_Z_CONJ( dots[j] ) * dots[j] );
+            }
+
+            // V(i+1) = ( Z(i) - V(0:i) Hh(0:i,i) ) / hn
+            t0 = magma_sparse_cycles();
+            magma_zcopy_cpu( dofs, Z(i), V(i+1), queue );
+            if ( hn2 > tol * eta ) {
+                hn = sqrt( hn2 );
+                magma_zmgemm_cpu( dofs, i+1, 1, MAGMA_Z_MAKE( -1.0/hn, 0.0 ), V(0), dofs,
+                                  &Hh(0,i), ldh, MAGMA_Z_MAKE( 1.0/hn, 0.0 ), V(i+1), dofs, queue );
+            } else {
+                // cancellation in hn2, orthogonalize explicitly
+                magma_zmgemm_cpu( dofs, i+1, 1, c_mone, V(0), dofs,
+                                  &Hh(0,i), ldh, c_one, V(i+1), dofs, queue );
+                hn = magma_dznrm2_cpu( dofs, V(i+1), queue );
+                if ( hn > 0.0 ) {
+                    magma_zscal_cpu( dofs, MAGMA_Z_MAKE( 1.0/hn, 0.0 ), V(i+1), queue );
+                }
+            }
+            if ( hn != hn ) {
+                info = MAGMA_DIVERGENCE;
+                break;
+            }
+            Hh(i+1,i) = MAGMA_Z_MAKE( hn, 0.0 );
+            // Z(i+1) = ( A M^(-1) Z(i) - Z(0:i) Hh(0:i,i) ) / hn = A M^(-1) V(i+1)
+            if ( hn > 0.0 ) {
+                magma_zmgemm_cpu( dofs, i+1, 1, MAGMA_Z_MAKE( -1.0/hn, 0.0 ), Z(0), dofs,
+                                  &Hh(0,i), ldh, MAGMA_Z_MAKE( 1.0/hn, 0.0 ), Z(i+1), dofs, queue );
+            }
+            // reads V(0:i) and Z(0:i) once, no dot products
+            magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_ORTHO, t0, ( 2*(i+1) + 5 )/5.0, i+1 );
+
+            // Givens rotations on the new column
+            for (k = 0; k <= i+1; k++)
+                Hr(k,i) = Hh(k,i);
+            for (k = 0; k < i; k++)
+                ApplyPlaneRotation(&Hr(k,i), &Hr(k+1,i), cs[k], sn[k]);
+
+            GeneratePlaneRotation(Hr(i,i), Hr(i+1,i), &cs[i], &sn[i]);
+            ApplyPlaneRotation(&Hr(i,i), &Hr(i+1,i), cs[i], sn[i]);
+            ApplyPlaneRotation(&g[i], &g[i+1], cs[i], sn[i]);
+
+            solver_par->numiter++;
+            last = i;
+            betanom = MAGMA_Z_ABS( g[i+1] );
+            if ( solver_par->verbose > 0 ) {
+                tempo2 = magma_wtime();
+                if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                    solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                            = (real_Double_t) betanom;
+                    solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                            = (real_Double_t) tempo2-tempo1;
+                }
+            }
+            if ( betanom/nomb <= solver_par->rtol || betanom <= solver_par->atol || hn == 0.0 ) {
+                converged = 1;
+            }
+        }
+        if ( last < 0 ) {
+            break;
+        }
+
+        // solve upper triangular system
+        for (j = 0; j <= last; j++)
+            y[j] = g[j];
+        for (j = last; j >= 0; j--)
+        {
+            y[j] /= Hr(j,j);
+            for (k = j-1; k >= 0; k--)
+                y[k] -= Hr(k,j) * y[j];
+        }
+
+        // x = x + M^(-1) V y
+        magma_zmgemm_cpu( dofs, last+1, 1, c_one, V(0), dofs, y, m+1, c_zero, u.val, dofs, queue );
+        t0 = magma_sparse_cycles();
+        CHECK( magma_z_applyprecond_left( MagmaNoTrans, A, u, &t, precond_par, queue ));
+        CHECK( magma_z_applyprecond_right( MagmaNoTrans, A, t, &t2, precond_par, queue ));
+        magma_sparse_phase( solver_par->phase, cost, Magma_PHASE_PRECOND, t0, 1, 1 );
+        magma_zaxpy_cpu( dofs, c_one, t2.val, x->val, queue );
+    }
+    while ( !converged && info != MAGMA_DIVERGENCE
+                && solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    CHECK( magma_zresidual( A, b, *x, &residual, queue ));
+    solver_par->iter_res = betanom;
+    solver_par->final_res = residual;
+
+    // keep a breakdown detected in the iteration
+    if ( info != MAGMA_NOTCONVERGED ) {
+        goto cleanup;
+    }
+
+    if ( converged ) {
+        info = MAGMA_SUCCESS;
+    } else if ( solver_par->init_res > solver_par->final_res ) {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) betanom;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_SLOW_CONVERGENCE;
+        if( solver_par->iter_res < solver_par->rtol*nomb ||
+            solver_par->iter_res < solver_par->atol ) {
+            info = MAGMA_SUCCESS;
+        }
+    }
+    else {
+        if ( solver_par->verbose > 0 ) {
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) betanom;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+        info = MAGMA_DIVERGENCE;
+    }
+
+cleanup:
+    magma_zreduction_destroy_cpu( red, queue );
+    magma_free_cpu( Hh );
+    magma_free_cpu( Hr );
+    magma_free_cpu( g );
+    magma_free_cpu( y );
+    magma_free_cpu( cs );
+    magma_free_cpu( sn );
+    magma_free_cpu( dots );
+    magma_free_cpu( dx );
+    magma_free_cpu( dy );
+
+    magma_zmfree( &V, queue );
+    magma_zmfree( &Z, queue );
+    magma_zmfree( &t, queue );
+    magma_zmfree( &t2, queue );
+    magma_zmfree( &u, queue );
+
+    solver_par->info = info;
+    return info;
+} /* magma_zpipegmres_cpu */
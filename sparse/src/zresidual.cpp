@@ -65,7 +65,28 @@ magma_zresidual(
     
     magma_z_matrix r = {Magma_CSR};
     
-    if ( A.num_rows == b.num_rows ) {
+    if ( A.memory_location == Magma_CPU ) {
+        // same operations on the CPU
+        if ( A.num_rows == b.num_rows ) {
+            CHECK( magma_zvinit( &r, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+
+            CHECK( magma_z_spmv( c_one, A, x, c_zero, r, queue ));    // r = A x
+            magma_zaxpy_cpu( dofs, c_neg_one, b.val, r.val, queue );   // r = r - b
+            *res = magma_dznrm2_cpu( dofs, r.val, queue );             // res = ||r||
+        } else if ((b.num_rows*b.num_cols)%A.num_rows == 0 ) {
+            CHECK( magma_zvinit( &r, Magma_CPU, b.num_rows, b.num_cols, c_zero, queue ));
+
+            CHECK( magma_z_spmv( c_one, A, x, c_zero, r, queue ));    // r = A x
+
+            for( magma_int_t i=0; i < num_vecs; i++) {
+                magma_zaxpy_cpu( dofs, c_neg_one, b(i), r(i), queue ); // r = r - b
+                res[i] = magma_dznrm2_cpu( dofs, r(i), queue );        // res = ||r||
+            }
+        } else {
+            printf("%%error: dimensions do not match.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
+    } else if ( A.num_rows == b.num_rows ) {
         CHECK( magma_zvinit( &r, Magma_DEV, A.num_rows, b.num_cols, c_zero, queue ));
 
         CHECK( magma_z_spmv( c_one, A, x, c_zero, r, queue ));        // r = A x
@@ -64,7 +64,26 @@ magma_zresidualvec(
                                             mone = MAGMA_Z_NEG_ONE;
     magma_int_t dofs = A.num_rows;
     
-    if ( A.num_rows == b.num_rows ) {
+    if ( A.memory_location == Magma_CPU ) {
+        // same operations on the CPU
+        if ( A.num_rows == b.num_rows ) {
+            CHECK( magma_z_spmv( mone, A, x, zero, *r, queue ));      // r = A x
+            magma_zaxpy_cpu( dofs, one, b.val, r->val, queue );        // r = r - b
+            *res = magma_dznrm2_cpu( dofs, r->val, queue );            // res = ||r||
+        } else if ((b.num_rows*b.num_cols)%A.num_rows== 0 ) {
+            magma_int_t num_vecs = b.num_rows*b.num_cols/A.num_rows;
+
+            CHECK( magma_z_spmv( mone, A, x, zero, *r, queue ));      // r = A x
+
+            for( magma_int_t i=0; i<num_vecs; i++) {
+                magma_zaxpy_cpu( dofs, one, b(i), r(i), queue );       // r = r - b
+                res[i] = magma_dznrm2_cpu( dofs, r(i), queue );        // res = ||r||
+            }
+        } else {
+            printf("%%error: dimensions do not match.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
+    } else if ( A.num_rows == b.num_rows ) {
         CHECK( magma_z_spmv( mone, A, x, zero, *r, queue ));      // r = A x
         magma_zaxpy( dofs, one, b.dval, 1, r->dval, 1, queue );          // r = r - b
         *res =  magma_dznrm2( dofs, r->dval, 1, queue );            // res = ||r||
@@ -0,0 +1,374 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define PRECISION_z
+
+// largest diagonal block of the host block-Jacobi
+#define MAGMA_VBJACOBI_MAX_BS 32
+
+
+/*
+    Extracts the diagonal block of size n starting at row/column start of
+    the CSR matrix A into an N x N row-major array, with the identity in the
+    padding, and inverts it via LU with partial pivoting.
+    The n x n inverse is written row-major to inv.
+    Returns 0, or k+1 if the k-th pivot is zero.
+*/
+template<int N>
+static magma_int_t
+magma_zvbjacobi_invert(
+    magma_z_matrix A,
+    magma_int_t start,
+    magma_int_t n,
+    magmaDoubleComplex *inv )
+{
+    magmaDoubleComplex D[ N*N ], W[ N*N ];
+    magma_int_t piv[ N ];
+
+    for (int i=0; i < N*N; i++) {
+        D[i] = MAGMA_Z_ZERO;
+        W[i] = MAGMA_Z_ZERO;
+    }
+    for (int i=0; i < N; i++) {
+        W[i*N+i] = MAGMA_Z_ONE;
+    }
+    for (int i=n; i < N; i++) {
+        D[i*N+i] = MAGMA_Z_ONE;
+    }
+    for (int i=0; i < n; i++) {
+        for (magma_int_t k=A.row[start+i]; k < A.row[start+i+1]; k++) {
+            magma_int_t j = A.col[k] - start;
+            if (j >= 0 && j < n) {
+                D[i*N+j] = A.val[k];
+            }
+        }
+    }
+
+    // LU with partial pivoting, rows are swapped explicitly
+    for (int k=0; k < N; k++) {
+        int p = k;
+        double amax = MAGMA_Z_ABS( D[k*N+k] );
+        for (int i=k+1; i < N; i++) {
+            double a = MAGMA_Z_ABS( D[i*N+k] );
+            if (a > amax) {
+                amax = a;
+                p = i;
+            }
+        }
+        if (amax == 0.0) {
+            return k+1;
+        }
+        piv[k] = p;
+        if (p != k) {
+            for (int j=0; j < N; j++) {
+                magmaDoubleComplex tmp = D[k*N+j];
+                D[k*N+j] = D[p*N+j];
+                D[p*N+j] = tmp;
+            }
+        }
+        magmaDoubleComplex rinv = MAGMA_Z_ONE / D[k*N+k];
+        for (int i=k+1; i < N; i++) {
+            magmaDoubleComplex lik = D[i*N+k] * rinv;
+            D[i*N+k] = lik;
+            #pragma omp simd
+            for (int j=k+1; j < N; j++) {
+                D[i*N+j] = D[i*N+j] - lik * D[k*N+j];
+            }
+        }
+    }
+
+    // solve L U X = P for all N columns at once, a row of X at a time
+    for (int k=0; k < N; k++) {
+        if (piv[k] != k) {
+            for (int j=0; j < N; j++) {
+                magmaDoubleComplex tmp = W[k*N+j];
+                W[k*N+j] = W[piv[k]*N+j];
+                W[piv[k]*N+j] = tmp;
+            }
+        }
+    }
+    for (int i=1; i < N; i++) {
+        for (int k=0; k < i; k++) {
+            magmaDoubleComplex lik = D[i*N+k];
+            #pragma omp simd
+            for (int j=0; j < N; j++) {
+                W[i*N+j] = W[i*N+j] - lik * W[k*N+j];
+            }
+        }
+    }
+    for (int i=N-1; i >= 0; i--) {
+        for (int k=i+1; k < N; k++) {
+            magmaDoubleComplex uik = D[i*N+k];
+            #pragma omp simd
+            for (int j=0; j < N; j++) {
+                W[i*N+j] = W[i*N+j] - uik * W[k*N+j];
+            }
+        }
+        magmaDoubleComplex rinv = MAGMA_Z_ONE / D[i*N+i];
+        #pragma omp simd
+        for (int j=0; j < N; j++) {
+            W[i*N+j] = W[i*N+j] * rinv;
+        }
+    }
+
+    // the padding decouples, the leading n x n part is the inverse
+    for (int i=0; i < n; i++) {
+        for (int j=0; j < n; j++) {
+            inv[i*n+j] = W[i*N+j];
+        }
+    }
+    return 0;
+}
+
+
+/*
+    Inverts a diagonal block with the smallest size class that fits.
+*/
+static magma_int_t
+magma_zvbjacobi_invert_block(
+    magma_z_matrix A,
+    magma_int_t start,
+    magma_int_t n,
+    magmaDoubleComplex *inv )
+{
+    if (n <= 1) {
+        return magma_zvbjacobi_invert<1>( A, start, n, inv );
+    } else if (n <= 2) {
+        return magma_zvbjacobi_invert<2>( A, start, n, inv );
+    } else if (n <= 4) {
+        return magma_zvbjacobi_invert<4>( A, start, n, inv );
+    } else if (n <= 8) {
+        return magma_zvbjacobi_invert<8>( A, start, n, inv );
+    } else if (n <= 16) {
+        return magma_zvbjacobi_invert<16>( A, start, n, inv );
+    } else {
+        return magma_zvbjacobi_invert<32>( A, start, n, inv );
+    }
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Prepares the variable-block Jacobi preconditioner on the CPU.
+    The diagonal blocks follow the supernodal structure of A found by
+    magma_zmsupernodal, with blocks of at most precond->pattern rows
+    (capped at 32). Every block is inverted by LU with partial pivoting,
+    specialized at compile time for the size classes 1, 2, 4, 8, 16 and 32.
+
+    The inverse is stored in precond->M as a block-diagonal CSR matrix on
+    the CPU. Every block is a contiguous row-major array, and the block
+    starts are in precond->M.blockinfo (precond->M.numblocks+1 entries).
+    It can be applied to vectors on the CPU only, so magma_z_precondsetup
+    rejects it for matrices on the device.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A
+
+    @param[in,out]
+    precond     magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zvbjacobisetup_cpu(
+    magma_z_matrix A,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix hAT={Magma_CSR}, hA={Magma_CSR}, S={Magma_CSR};
+    magma_index_t *bstart = NULL, *voff = NULL;
+    magma_int_t numblocks = 0, singular = 0;
+    magma_int_t max_bs = precond->pattern;
+
+    if (A.memory_location != Magma_CPU || A.storage_type != Magma_CSR) {
+        CHECK(magma_zmtransfer(A, &hAT, A.memory_location, Magma_CPU, queue));
+        CHECK(magma_zmconvert(hAT, &hA, hAT.storage_type, Magma_CSR, queue));
+        magma_zmfree(&hAT, queue);
+    } else {
+        CHECK(magma_zmtransfer(A, &hA, A.memory_location, Magma_CPU, queue));
+    }
+
+    max_bs = ( max_bs < 1 ) ? 1 : max_bs;
+    max_bs = ( max_bs > MAGMA_VBJACOBI_MAX_BS ) ? MAGMA_VBJACOBI_MAX_BS : max_bs;
+    CHECK(magma_zmsupernodal(&max_bs, hA, &S, queue));
+
+    // the supernodes may exceed max_bs by one row or be empty: split/skip
+    CHECK(magma_index_malloc_cpu(&bstart, hA.num_rows+1));
+    bstart[0] = 0;
+    for (magma_int_t b=0; b < S.numblocks; b++) {
+        magma_int_t s = S.tile_desc_offset_ptr[b];
+        magma_int_t e = S.tile_desc_offset_ptr[b+1];
+        while (s < e) {
+            s = ( e-s > max_bs ) ? s+max_bs : e;
+            bstart[++numblocks] = s;
+        }
+    }
+
+    // value offsets of the blocks, then the block-diagonal CSR structure
+    CHECK(magma_index_malloc_cpu(&voff, numblocks+1));
+    voff[0] = 0;
+    for (magma_int_t b=0; b < numblocks; b++) {
+        magma_int_t bs = bstart[b+1] - bstart[b];
+        voff[b+1] = voff[b] + bs*bs;
+    }
+    magma_zmfree(&precond->M, queue);
+    precond->M.storage_type = Magma_CSR;
+    precond->M.memory_location = Magma_CPU;
+    precond->M.num_rows = hA.num_rows;
+    precond->M.num_cols = hA.num_cols;
+    precond->M.nnz = voff[numblocks];
+    precond->M.numblocks = numblocks;
+    precond->M.blocksize = max_bs;
+    precond->M.ownership = MagmaTrue;
+    CHECK(magma_index_malloc_cpu(&precond->M.row, hA.num_rows+1));
+    CHECK(magma_index_malloc_cpu(&precond->M.col, precond->M.nnz));
+    CHECK(magma_zmalloc_cpu(&precond->M.val, precond->M.nnz));
+    precond->M.blockinfo = bstart;
+    bstart = NULL;
+
+    #pragma omp parallel for schedule(dynamic,64)
+    for (magma_int_t b=0; b < numblocks; b++) {
+        magma_int_t s = precond->M.blockinfo[b];
+        magma_int_t bs = precond->M.blockinfo[b+1] - s;
+        for (magma_int_t i=0; i < bs; i++) {
+            precond->M.row[s+i] = voff[b] + i*bs;
+            for (magma_int_t j=0; j < bs; j++) {
+                precond->M.col[voff[b]+i*bs+j] = s+j;
+            }
+        }
+        if (magma_zvbjacobi_invert_block(hA, s, bs, precond->M.val+voff[b]) != 0) {
+            #pragma omp atomic write
+            singular = 1;
+        }
+    }
+    precond->M.row[hA.num_rows] = precond->M.nnz;
+
+    if (singular) {
+        printf("error: singular diagonal block in block-Jacobi.\n");
+        info = MAGMA_ERR_BADPRECOND;
+    }
+
+cleanup:
+    magma_zmfree(&hAT, queue);
+    magma_zmfree(&hA, queue);
+    magma_free_cpu(S.val);
+    magma_free_cpu(S.col);
+    magma_free_cpu(S.row);
+    magma_free_cpu(S.tile_desc_offset_ptr);
+    magma_free_cpu(bstart);
+    magma_free_cpu(voff);
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+
+    Applies the variable-block Jacobi preconditioner prepared by
+    magma_zvbjacobisetup_cpu: x = M b, one dense block product per diagonal
+    block. b and x may hold several vectors (column-major) and have to be
+    on the CPU; vectors on the device return MAGMA_ERR_NOT_SUPPORTED.
+
+    Arguments
+    ---------
+
+    @param[in]
+    b           magma_z_matrix
+                input vector b
+
+    @param[in,out]
+    x           magma_z_matrix*
+                output vector x
+
+    @param[in]
+    precond     magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+*******************************************************************************/
+
+extern "C"
+magma_int_t
+magma_zvbjacobi_apply_cpu(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix M = precond->M;
+    magma_int_t n = M.num_rows;
+
+    if (b.memory_location != Magma_CPU || x->memory_location != Magma_CPU) {
+        printf( "error: preconditioner only supported on the CPU.\n" );
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    #pragma omp parallel for schedule(dynamic,64) collapse(2)
+    for (magma_int_t c=0; c < b.num_cols; c++) {
+        for (magma_int_t blk=0; blk < M.numblocks; blk++) {
+            magma_int_t s = M.blockinfo[blk];
+            magma_int_t bs = M.blockinfo[blk+1] - s;
+            const magmaDoubleComplex *bv = b.val + c*n + s;
+            magmaDoubleComplex *xv = x->val + c*n + s;
+            for (magma_int_t i=0; i < bs; i++) {
+                const magmaDoubleComplex *mv = M.val + M.row[s+i];
+                #if defined(PRECISION_z) || defined(PRECISION_c)
+                double re = 0.0, im = 0.0;
+                #pragma omp simd reduction(+:re,im)
+                for (magma_int_t j=0; j < bs; j++) {
+                    re += MAGMA_Z_REAL(mv[j]) * MAGMA_Z_REAL(bv[j])
+                        - MAGMA_Z_IMAG(mv[j]) * MAGMA_Z_IMAG(bv[j]);
+                    im += MAGMA_Z_REAL(mv[j]) * MAGMA_Z_IMAG(bv[j])
+                        + MAGMA_Z_IMAG(mv[j]) * MAGMA_Z_REAL(bv[j]);
+                }
+                xv[i] = MAGMA_Z_MAKE( re, im );
+                #else
+                double sum = 0.0;
+                #pragma omp simd reduction(+:sum)
+                for (magma_int_t j=0; j < bs; j++) {
+                    sum += mv[j] * bv[j];
+                }
+                xv[i] = sum;
+                #endif
+            }
+        }
+    }
+
+cleanup:
+    return info;
+}
@@ -190,6 +190,7 @@ parser.add_option(      '--bombard_merge'    , action='store_true', dest='bombar
 parser.add_option(      '--lsqr'             , action='store_true', dest='lsqr'          , help='run lsqr'          )
 parser.add_option(      '--bicg'             , action='store_true', dest='bicg'          , help='run bicg'          )
 parser.add_option(      '--pbicg'            , action='store_true', dest='pbicg'         , help='run pbicg'         )
+parser.add_option(      '--cpu-solvers'      , action='store_true', dest='cpu_solvers'   , help='run host solvers (--location CPU)')
 
                                                                                            
 parser.add_option(      '--jacobi-prec'      , action='store_true', dest='jacobi_prec'   , help='run Jacobi preconditioner')
@@ -198,6 +199,7 @@ parser.add_option(      '--ilu-jac'          , action='store_true', dest='ilu_ja
 parser.add_option(      '--ilu-bjac'         , action='store_true', dest='ilu_bjac_prec',  help='run ILU + Block Jacobi solve preconditioner')
 parser.add_option(      '--ilu-isai-prec'    , action='store_true', dest='ilu_isai_prec' , help='run ILU + ISAI preconditioner')
 parser.add_option(      '--ilut-prec'        , action='store_true', dest='ilut_prec',      help='run threshold ILU + exact solve preconditioner')
+parser.add_option(      '--cpu-isai-prec'    , action='store_true', dest='cpu_isai_prec',  help='run host ParIC/ParILU + ISAI preconditioner')
 
 (opts, args) = parser.parse_args()
 
@@ -254,7 +256,8 @@ if (     not opts.cg
      and not opts.bicg
      and not opts.pbicg
      and not opts.lsqr
-     and not opts.pidr ):
+     and not opts.pidr
+     and not opts.cpu_solvers ):
     opts.cg             = True
     opts.cg_merge       = True
     opts.pcg            = True
@@ -283,6 +286,7 @@ if (     not opts.cg
     opts.bicg           = True
     opts.pbicg          = True
     opts.lsqr           = True
+    opts.cpu_solvers    = True
 # end
 
 # default if no preconditioners given all
@@ -291,13 +295,15 @@ if (     not opts.jacobi_prec
      and not opts.ilut_prec
      and not opts.ilu_jac_prec
      and not opts.ilu_bjac_prec
-     and not opts.ilu_isai_prec ):
+     and not opts.ilu_isai_prec
+     and not opts.cpu_isai_prec ):
     opts.jacobi_prec      = True
     opts.ilu_prec         = True
     opts.ilu_jac_prec     = True
     opts.ilu_isai_prec    = True
     opts.ilu_bjac_prec    = True
     opts.ilut_prec        = True
+    opts.cpu_isai_prec    = True
 # end
 
 # default if no sizes given is all sizes
@@ -446,6 +452,40 @@ if ( opts.ilu_isai_prec ):
 # end
 
 
+# looping over solvers on the host; cpulapsolvers only on the LAPLACE2D
+# problems: the CG variants, and the GMRES variants without preconditioner,
+# which stagnate on ani5_crop within maxiter (restart 100 for LAPLACE2D 95)
+cpusolvers = []
+cpulapsolvers = []
+if ( opts.cpu_solvers ):
+    cpulapsolvers += ['--solver CG ']
+    cpulapsolvers += ['--solver PIPECG ']
+    cpulapsolvers += ['--solver PIPECG --precond PARIC --trisolver ISAI --piters 1 ']
+    cpulapsolvers += ['--solver PIPEGMRES --restart 100 ']
+    cpusolvers    += ['--solver BICGSTAB ']
+    cpusolvers    += ['--solver PIPEGMRES --precond PARILU --trisolver ISAI --piters 1 ']
+    # s-step solvers, with the Newton basis and block CGS by default;
+    # CACG has no preconditioned variant
+    cpulapsolvers += ['--solver CACG ']
+    cpulapsolvers += ['--solver CACG --basis MONOMIAL --sstep 4 ']
+    cpulapsolvers += ['--solver CAGMRES --restart 100 ']
+    cpulapsolvers += ['--solver CAGMRES --restart 100 --basis MONOMIAL --sstep 4 ']
+    cpulapsolvers += ['--solver CAGMRES --restart 100 --ortho MGS ']
+    cpulapsolvers += ['--solver CAGMRES --restart 100 --ortho FUSEDCGS ']
+    cpusolvers    += ['--solver PCAGMRES --precond PARILU --trisolver ISAI --piters 1 ']
+# end
+
+
+# looping over preconditioners generated and applied on the host
+cpuprecs = []
+if ( opts.cpu_isai_prec ):
+    cpuprecs += ['--solver PCG --precond PARIC --trisolver ISAI --piters 1 ']
+    cpuprecs += ['--solver PBICGSTAB --precond PARILU --trisolver ISAI --piters 1 ']
+    cpuprecs += ['--solver PCG --precond PARIC --trisolver ISAI --piters 1 --pvalprec SINGLE ']
+    cpuprecs += ['--solver PBICGSTAB --precond PARILU --trisolver ISAI --piters 1 --pvalprec BF16 ']
+# end
+
+
 # looping over preconditioners for Iter-Ref
 IRprecs = []
 if ( opts.iterref ):
@@ -624,6 +664,26 @@ for solver in precsolvers:
                 tests.append( [cmd, solver + ' ' + precond, size, ''] )
 
 
+# ----------------------------------------------------------------------
+for solver in cpusolvers + cpulapsolvers:
+    for size in sizes:
+        if ( solver in cpulapsolvers and not size.startswith( 'LAPLACE2D' )):
+            continue
+        for precision in opts.precisions:
+            # precision generation
+            cmd = substitute( 'testing_zsolver', 'z', precision )
+            tests.append( [cmd, '--location CPU ' + solver, size, ''] )
+
+
+# ----------------------------------------------------------------------
+for precond in cpuprecs:
+    for size in sizes:
+        for precision in opts.precisions:
+            # precision generation
+            cmd = substitute( 'testing_zsolver', 'z', precision )
+            tests.append( [cmd, '--location CPU ' + precond, size, ''] )
+
+
 # ----------------------------------------------------------------------
 for solver in IR:
     for precond in IRprecs:
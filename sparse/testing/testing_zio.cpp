@@ -41,16 +41,28 @@ int main(  int argc, char** argv )
     
     real_Double_t res;
     magma_z_matrix A={Magma_CSR}, A2={Magma_CSR}, 
-    A3={Magma_CSR}, A4={Magma_CSR}, A5={Magma_CSR};
+    A3={Magma_CSR}, A4={Magma_CSR}, A5={Magma_CSR}, A6={Magma_CSR},
+    Ablock={Magma_CSR};
+    magma_mtx_stream S;
+    magma_index_t row_offset;
+    magma_int_t stream_ok;
+    magma_matrix_generator gen;
+    magma_int_t generated;
     
     int i=1;
     TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
 
     while( i < argc ) {
+        generated = 0;
         if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
             i++;
             magma_int_t laplace_size = atoi( argv[i] );
             TESTING_CHECK( magma_zm_5stencil(  laplace_size, &A, queue ));
+        } else if ( strcmp("GENERATE", argv[i]) == 0 && i+1 < argc ) {   // synthetic matrix
+            i++;
+            TESTING_CHECK( magma_zmgenerate_parse( argv[i], &gen, queue ));
+            TESTING_CHECK( magma_zmgenerate( gen, &A, queue ));
+            generated = 1;
         } else {                        // file-matrix test
             TESTING_CHECK( magma_z_csr_mtx( &A,  argv[i], queue ));
         }
@@ -66,8 +78,38 @@ int main(  int argc, char** argv )
         // read from file
         TESTING_CHECK( magma_z_csr_mtx( &A2, filename, queue ));
 
+        // read it again in row blocks of about a quarter of the nonzeros
+        TESTING_CHECK( magma_z_csr_mtx_stream_open( &S, filename, NULL,
+                            A2.nnz/4 + 1, queue ));
+        stream_ok = ( S.nnz == A2.nnz && S.num_rows == A2.num_rows );
+        while ( S.current < S.num_blocks ) {
+            TESTING_CHECK( magma_z_csr_mtx_stream_next( &S, &Ablock, &row_offset, queue ));
+            for( magma_int_t k=0; k < Ablock.num_rows; k++ ) {
+                magma_index_t r = row_offset + k;
+                magma_index_t len = Ablock.row[k+1] - Ablock.row[k];
+                stream_ok = stream_ok && ( len == A2.row[r+1] - A2.row[r] );
+                for( magma_index_t j=0; stream_ok && j < len; j++ ) {
+                    // both read the same file, so the values match exactly
+                    stream_ok = ( Ablock.col[ Ablock.row[k]+j ] == A2.col[ A2.row[r]+j ]
+                        && MAGMA_Z_EQUAL( Ablock.val[ Ablock.row[k]+j ],
+                                          A2.val[ A2.row[r]+j ] ));
+                }
+            }
+        }
+        magma_zmfree( &Ablock, queue );
+        TESTING_CHECK( magma_z_csr_mtx_stream_close( &S, queue ));
+        if ( stream_ok )
+            printf("%% tester stream IO:  ok\n");
+        else
+            printf("%% tester stream IO:  failed\n");
+
         // delete temporary matrix
         unlink( filename );
+
+        // same round trip through the binary format
+        const char *binfilename = "testmatrix.bin";
+        TESTING_CHECK( magma_zwrite_csr_binary( A, binfilename, queue ));
+        TESTING_CHECK( magma_z_csr_binary( &A6, binfilename, queue ));
                 
         //visualize
         printf("A2:\n");
@@ -102,10 +144,40 @@ int main(  int argc, char** argv )
         else
             printf("%% tester matrix interface:  failed\n");
 
+        TESTING_CHECK( magma_zmdiff( A, A6, &res, queue ));
+        printf("%% ||A-B||_F = %8.2e\n", res);
+        if ( res == 0.0 && A6.sym == A.sym && A6.nnz == A.nnz )
+            printf("%% tester binary IO:  ok\n");
+        else
+            printf("%% tester binary IO:  failed\n");
+
+        // generated matrices: write them without building them in memory
+        if ( generated ) {
+            const char *genfilename[2] = { "testmatrix_gen.bin", "testmatrix_gen.mtx" };
+            for( magma_int_t k=0; k < 2; k++ ) {
+                magma_zmfree(&A6, queue );
+                TESTING_CHECK( magma_zwrite_csr_generator( gen, genfilename[k], queue ));
+                if ( k == 0 ) {
+                    TESTING_CHECK( magma_z_csr_binary( &A6, genfilename[k], queue ));
+                } else {
+                    TESTING_CHECK( magma_z_csr_mtx( &A6, genfilename[k], queue ));
+                }
+                TESTING_CHECK( magma_zmdiff( A, A6, &res, queue ));
+                printf("%% ||A-B||_F = %8.2e\n", res);
+                if ( res < .000001 && A6.nnz == A.nnz )
+                    printf("%% tester generator IO (%s):  ok\n", genfilename[k]);
+                else
+                    printf("%% tester generator IO (%s):  failed\n", genfilename[k]);
+                unlink( genfilename[k] );
+            }
+        }
+
         magma_zmfree(&A, queue );
         magma_zmfree(&A2, queue );
         magma_zmfree(&A4, queue );
         magma_zmfree(&A5, queue );
+        magma_zmfree(&A6, queue );
+        unlink( binfilename );
 
         i++;
     }
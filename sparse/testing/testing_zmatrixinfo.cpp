@@ -53,6 +53,29 @@ int main(  int argc, char** argv )
         printf("   %10lld          %10lld          %10lld\n",
                (long long) Z.num_rows, (long long) Z.nnz, (long long) (Z.nnz/Z.num_rows) );
 
+        if ( zopts.autoformat ) {
+            magma_format_tuning tuning;
+            TESTING_CHECK( magma_zmselect_format( Z, Magma_DEV, zopts.format_trials,
+                                                  zopts.format_cache, &tuning, queue ));
+            printf("%%   fingerprint %016llx: row length mean %.2f, std %.2f, max %lld, diameter %lld\n",
+                   (unsigned long long) tuning.fingerprint, tuning.row_mean, sqrt( tuning.row_var ),
+                   (long long) tuning.max_nnz_row, (long long) tuning.diameter );
+            printf("%%   padding: ELL %.2f, SELLP", tuning.ell_padding );
+            for( magma_int_t b=0; b < MAGMA_FORMAT_TUNE_BLOCKSIZES; b++ ) {
+                for( magma_int_t a=0; a < MAGMA_FORMAT_TUNE_ALIGNMENTS; a++ ) {
+                    if ( tuning.sellp_padding[b][a] > 0.0 ) {
+                        printf(" %lld/%lld:%.2f", (long long) tuning.sellp_blocksize[b],
+                               (long long) tuning.sellp_alignment[a], tuning.sellp_padding[b][a] );
+                    }
+                }
+            }
+            printf("\n%%   SpMV time: CSR %.2e  ELL %.2e  SELLP %.2e  CSR5 %.2e\n",
+                   tuning.time[0], tuning.time[1], tuning.time[2], tuning.time[3] );
+            printf("%%   selected format %lld (blocksize %lld, alignment %lld)%s\n",
+                   (long long) tuning.format, (long long) tuning.blocksize,
+                   (long long) tuning.alignment, tuning.cached ? ", cached" : "" );
+        }
+
         magma_zmfree(&Z, queue );
 
         i++;
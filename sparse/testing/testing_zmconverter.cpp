@@ -37,6 +37,8 @@ int main(  int argc, char** argv )
     real_Double_t res;
     magma_z_matrix Z={Magma_CSR}, Z2={Magma_CSR}, A={Magma_CSR}, A2={Magma_CSR}, 
     AT={Magma_CSR}, AT2={Magma_CSR}, B={Magma_CSR};
+    real_Double_t start, end;
+    magma_int_t ntiming = 0;
     int i=1;
     TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
 
@@ -44,6 +46,12 @@ int main(  int argc, char** argv )
     B.alignment = zopts.alignment;
 
     while( i < argc ) {
+        if ( strcmp("--timing", argv[i]) == 0 && i+1 < argc ) {
+            // time the CPU conversions from CSR for the matrices that follow
+            ntiming = atoi( argv[++i] );
+            i++;
+            continue;
+        }
         if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
             i++;
             magma_int_t laplace_size = atoi( argv[i] );
@@ -55,6 +63,26 @@ int main(  int argc, char** argv )
         printf("%% matrix info: %lld-by-%lld with %lld nonzeros\n",
                 (long long) Z.num_rows, (long long) Z.num_cols, (long long) Z.nnz );
         
+        if ( ntiming > 0 ) {
+            magma_storage_t formats[] = { Magma_ELL, Magma_ELLPACKT, Magma_ELLD,
+                                          Magma_ELLRT, Magma_SELLP, Magma_CSR5,
+                                          Magma_CSRDELTA };
+            const char *names[] = { "ELL", "ELLPACKT", "ELLD",
+                                    "ELLRT", "SELLP", "CSR5", "CSRDELTA" };
+            for( magma_int_t f=0; f < 7; f++ ) {
+                start = magma_wtime();
+                for( magma_int_t k=0; k < ntiming; k++ ) {
+                    AT2.blocksize = zopts.blocksize;
+                    AT2.alignment = zopts.alignment;
+                    TESTING_CHECK( magma_zmconvert( Z, &AT2, Magma_CSR, formats[f], queue ));
+                    magma_zmfree(&AT2, queue );
+                }
+                end = magma_wtime();
+                printf("%% CSR to %-8s conversion: %.6f sec\n",
+                        names[f], (end-start)/ntiming );
+            }
+        }
+
         // convert to be non-symmetric
         TESTING_CHECK( magma_zmconvert( Z, &A, Magma_CSR, Magma_CSRL, queue ));
         TESTING_CHECK( magma_zmconvert( Z, &B, Magma_CSR, Magma_CSRU, queue ));
@@ -93,6 +121,11 @@ int main(  int argc, char** argv )
         magma_zmfree(&AT, queue );
         TESTING_CHECK( magma_zmconvert( AT2, &AT, Magma_ELLD, Magma_CSR, queue ));
         magma_zmfree(&AT2, queue );
+        //CSRDELTA
+        TESTING_CHECK( magma_zmconvert( AT, &AT2, Magma_CSR, Magma_CSRDELTA, queue ));
+        magma_zmfree(&AT, queue );
+        TESTING_CHECK( magma_zmconvert( AT2, &AT, Magma_CSRDELTA, Magma_CSR, queue ));
+        magma_zmfree(&AT2, queue );
         //CSRCOO
         TESTING_CHECK( magma_zmconvert( AT, &AT2, Magma_CSR, Magma_CSRCOO, queue ));
         magma_zmfree(&AT, queue );
@@ -71,6 +71,9 @@ int main(  int argc, char** argv )
         // scale matrix
         TESTING_CHECK( magma_zmscale( &A, zopts.scaling, queue ));
 
+        // reorder matrix
+        TESTING_CHECK( magma_zmreorder( &A, zopts.reordering, NULL, queue ));
+
         TESTING_CHECK( magma_zmconvert( A, &B, Magma_CSR, zopts.output_format, queue ));
         TESTING_CHECK( magma_zmtransfer( B, &dB, Magma_CPU, Magma_DEV, queue ));
 
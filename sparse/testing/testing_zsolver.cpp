@@ -45,11 +45,29 @@ int main(  int argc, char** argv )
 
     TESTING_CHECK( magma_zsolverinfo_init( &zopts.solver_par, &zopts.precond_par, queue ));
 
+    // the counters of all matrices go into one JSON array
+    FILE *profile = NULL;
+    int nprofile = 0;
+    if ( zopts.profile_file != NULL ) {
+        profile = fopen( zopts.profile_file, "w" );
+        if ( profile == NULL ) {
+            printf( "%%error: cannot open %s.\n", zopts.profile_file );
+            TESTING_CHECK( MAGMA_ERR_NOT_FOUND );
+        }
+        fprintf( profile, "[\n" );
+    }
+
     while( i < argc ) {
+        const char *matrix = argv[i];
         if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
             i++;
             magma_int_t laplace_size = atoi( argv[i] );
             TESTING_CHECK( magma_zm_5stencil(  laplace_size, &A, queue ));
+        } else if ( strcmp("GENERATE", argv[i]) == 0 && i+1 < argc ) {   // synthetic matrix
+            i++;
+            magma_matrix_generator gen;
+            TESTING_CHECK( magma_zmgenerate_parse( argv[i], &gen, queue ));
+            TESTING_CHECK( magma_zmgenerate( gen, &A, queue ));
         } else {                        // file-matrix test
             TESTING_CHECK( magma_z_csr_mtx( &A,  argv[i], queue ));
         }
@@ -60,13 +78,26 @@ int main(  int argc, char** argv )
 
         // scale matrix
         TESTING_CHECK( magma_zmscale( &A, zopts.scaling, queue ));
+
+        // reorder matrix
+        TESTING_CHECK( magma_zmreorder( &A, zopts.reordering, NULL, queue ));
         
+        // on the host, the right-hand side has to be there for the setup
+        if ( zopts.compute_location == Magma_CPU ) {
+            TESTING_CHECK( magma_zvinit_rand( &b, Magma_CPU, A.num_rows, 1, queue ));
+        }
+
         // preconditioner
         if ( zopts.solver_par.solver != Magma_ITERREF ) {
             TESTING_CHECK( magma_z_precondsetup( A, b, &zopts.solver_par, &zopts.precond_par, queue ) );
         }
 
-        TESTING_CHECK( magma_zmconvert( A, &B, Magma_CSR, zopts.output_format, queue ));
+        if ( zopts.autoformat ) {
+            TESTING_CHECK( magma_zmconvert_auto( A, &B, zopts.compute_location, zopts.format_trials,
+                                                 zopts.format_cache, queue ));
+        } else {
+            TESTING_CHECK( magma_zmconvert( A, &B, Magma_CSR, zopts.output_format, queue ));
+        }
         
         printf( "\n%% matrix info: %lld-by-%lld with %lld nonzeros\n\n",
                             (long long) A.num_rows, (long long) A.num_cols, (long long) A.nnz );
@@ -80,20 +111,28 @@ int main(  int argc, char** argv )
         printf("%%============================================================================%%\n");
         printf("];\n");
 
-        TESTING_CHECK( magma_zmtransfer( B, &dB, Magma_CPU, Magma_DEV, queue ));
+        if ( zopts.compute_location == Magma_CPU ) {
+            // host backend: matrix and vectors stay in CPU memory
+            TESTING_CHECK( magma_zvinit_rand( &x, Magma_CPU, A.num_cols, 1, queue ));
+            info = magma_z_solver( B, b, &x, &zopts, queue );
+        } else {
+            TESTING_CHECK( magma_zmtransfer( B, &dB, Magma_CPU, Magma_DEV, queue ));
 
-        // vectors and initial guess
-        TESTING_CHECK( magma_zvinit_rand( &b, Magma_DEV, A.num_rows, 1, queue ));
-        //magma_zvinit( &x, Magma_DEV, A.num_cols, 1, one, queue );
-        //magma_z_spmv( one, dB, x, zero, b, queue );                 //  b = A x
-        //magma_zmfree(&x, queue );
-        TESTING_CHECK( magma_zvinit_rand( &x, Magma_DEV, A.num_cols, 1, queue ));
-        
-        info = magma_z_solver( dB, b, &x, &zopts, queue );
+            // vectors and initial guess
+            TESTING_CHECK( magma_zvinit_rand( &b, Magma_DEV, A.num_rows, 1, queue ));
+            //magma_zvinit( &x, Magma_DEV, A.num_cols, 1, one, queue );
+            //magma_z_spmv( one, dB, x, zero, b, queue );                 //  b = A x
+            //magma_zmfree(&x, queue );
+            TESTING_CHECK( magma_zvinit_rand( &x, Magma_DEV, A.num_cols, 1, queue ));
+
+            info = magma_z_solver( dB, b, &x, &zopts, queue );
+        }
         if( info != 0 ) {
             printf("%%error: solver returned: %s (%lld).\n",
                     magma_strerror( info ), (long long) info );
         }
+        // checked by run_tests.py
+        printf("%% solver info: %lld\n", (long long) info );
         printf("convergence = [\n");
         magma_zsolverinfo( &zopts.solver_par, &zopts.precond_par, queue );
         printf("];\n\n");
@@ -102,6 +141,20 @@ int main(  int argc, char** argv )
         printf("solverinfo = [\n");
         magma_zsolverinfo( &zopts.solver_par, &zopts.precond_par, queue );
         printf("];\n\n");
+        if ( profile != NULL ) {
+            // name the matrix as on the command line, e.g. "LAPLACE2D 47"
+            char name[1024];
+            if ( matrix != argv[i] ) {
+                snprintf( name, sizeof(name), "%s %s", matrix, argv[i] );
+            } else {
+                snprintf( name, sizeof(name), "%s", matrix );
+            }
+            if ( nprofile++ > 0 ) {
+                fprintf( profile, ",\n" );
+            }
+            TESTING_CHECK( magma_zsolverinfo_json( &zopts.solver_par, &zopts.precond_par,
+                                                   name, profile, queue ));
+        }
         
         printf("precondinfo = [\n");
         printf("%%   setup  runtime\n");        
@@ -116,6 +169,11 @@ int main(  int argc, char** argv )
         i++;
     }
 
+    if ( profile != NULL ) {
+        fprintf( profile, "\n]\n" );
+        fclose( profile );
+    }
+
     magma_queue_destroy( queue );
     TESTING_CHECK( magma_finalize() );
     return info;
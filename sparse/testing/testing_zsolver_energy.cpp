@@ -84,6 +84,9 @@ int main(  int argc, char** argv )
         // scale matrix
         TESTING_CHECK( magma_zmscale( &A, zopts.scaling, queue ));
 
+        // reorder matrix
+        TESTING_CHECK( magma_zmreorder( &A, zopts.reordering, NULL, queue ));
+
         /**************************** START PAPI **********************************/
     
 #ifdef PAPI
@@ -40,6 +40,7 @@ int main(  int argc, char** argv )
     magmaDoubleComplex zero = MAGMA_Z_MAKE(0.0, 0.0);
     magma_z_matrix A={Magma_CSR}, B={Magma_CSR}, dB={Magma_CSR};
     magma_z_matrix x={Magma_CSR}, x_h={Magma_CSR}, b_h={Magma_DENSE}, b={Magma_DENSE};
+    magma_index_t *perm = NULL;
     
     int i=1;
     TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
@@ -84,6 +85,12 @@ int main(  int argc, char** argv )
         zopts.precond_par.runtime = 0.0;
         //TESTING_CHECK( magma_zvinit( &b_h, Magma_CPU, A.num_cols, 1, MAGMA_Z_ONE, queue ));
 
+        // reorder matrix and right-hand side
+        TESTING_CHECK( magma_zmreorder( &A, zopts.reordering, &perm, queue ));
+        if ( perm != NULL ) {
+            TESTING_CHECK( magma_zvpermute( b_h, perm, &b_h, queue ));
+        }
+
         i++;
         tempo1 = magma_sync_wtime( queue );
         magma_z_vtransfer(b_h, &b, Magma_CPU, Magma_DEV, queue);
@@ -119,6 +126,12 @@ int main(  int argc, char** argv )
         magma_z_vtransfer(x, &x_h, Magma_DEV, Magma_CPU, queue);
         tempo2 = magma_sync_wtime( queue );
         t_transfer += tempo2-tempo1;  
+        // solution in the original ordering
+        if ( perm != NULL ) {
+            TESTING_CHECK( magma_zvunpermute( x_h, perm, &x_h, queue ));
+            magma_free_cpu( perm );
+            perm = NULL;
+        }
         
         printf("data = [\n");
         magma_zsolverinfo( &zopts.solver_par, &zopts.precond_par, queue );
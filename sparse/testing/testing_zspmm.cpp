@@ -280,6 +280,33 @@ int main(  int argc, char** argv )
         magma_zmfree(&dA_SELLP, queue );
 
 
+        // SpMM on CPU (CSR and SELLP)
+        TESTING_CHECK( magma_zmconvert(  hA, &hA_SELLP, Magma_CSR, Magma_SELLP, queue ));
+        for( magma_int_t k=0; k < 2; k++ ) {
+            magma_z_matrix *hB = ( k == 0 ) ? &hA : &hA_SELLP;
+            start = magma_wtime();
+            for (j=0; j < 10; j++) {
+                TESTING_CHECK( magma_z_spmv( c_one, *hB, hx, c_zero, hy, queue ));
+            }
+            end = magma_wtime();
+            printf( " > CPU  : %.2e seconds %.2e GFLOP/s    (%s).\n",
+                    (end-start)/10, FLOPS*10.*n/(end-start), ( k == 0 ) ? "CSR" : "SELLP" );
+            real_Double_t ref = 0.0;
+            res = 0.0;
+            for(magma_int_t l=0; l < hA.num_rows*n; l++ ) {
+                res = res + MAGMA_Z_ABS( MAGMA_Z_SUB( hy.val[l], hrefvec.val[l] ));
+                ref = ref + MAGMA_Z_ABS( hrefvec.val[l] );
+            }
+            res = ( ref > 0.0 ) ? res / ref : res;
+            printf("%% |x-y|_1/|y|_1 = %8.2e\n", res);
+            if ( res < accuracy )
+                printf("%% tester spmm CPU %s:  ok\n", ( k == 0 ) ? "CSR" : "SELL-P" );
+            else
+                printf("%% tester spmm CPU %s:  failed\n", ( k == 0 ) ? "CSR" : "SELL-P" );
+        }
+        magma_zmfree(&hA_SELLP, queue );
+
+
 
         // SpMV on GPU (CUSPARSE - CSR)
         // CUSPARSE context //
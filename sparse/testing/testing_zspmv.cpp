@@ -145,6 +145,11 @@ int main(  int argc, char** argv )
             i++;
             magma_int_t laplace_size = atoi( argv[i] );
             TESTING_CHECK( magma_zm_5stencil(  laplace_size, &hA, queue ));
+        } else if ( strcmp("GENERATE", argv[i]) == 0 && i+1 < argc ) {   // synthetic matrix
+            i++;
+            magma_matrix_generator gen;
+            TESTING_CHECK( magma_zmgenerate_parse( argv[i], &gen, queue ));
+            TESTING_CHECK( magma_zmgenerate( gen, &hA, queue ));
         } else {                        // file-matrix test
             TESTING_CHECK( magma_z_csr_mtx( &hA,  argv[i], queue ));
         }
@@ -433,6 +438,55 @@ int main(  int argc, char** argv )
         hybA=NULL;
 #endif // end test for HYB matrix format
 
+        // SpMV on the CPU, checked against the same reference
+        magma_zmfree( &hx, queue );
+        TESTING_CHECK( magma_zvinit( &hx, Magma_CPU, hA.num_rows, 1, c_one, queue ));
+        magma_storage_t cpu_formats[] = { Magma_CSR, Magma_SELLP, Magma_CSR5, Magma_CSRDELTA };
+        const char *cpu_names[] = { "CSR", "SELLP", "CSR5", "CSRDELTA" };
+        for( magma_int_t f=0; f < 4; f++ ) {
+            magma_z_matrix hB={Magma_CSR};
+            hB.blocksize = hA_SELLP.blocksize;
+            hB.alignment = hA_SELLP.alignment;
+            TESTING_CHECK( magma_zmconvert( hA, &hB, Magma_CSR, cpu_formats[f], queue ));
+            start = magma_wtime();
+            for (j=0; j < 200; j++) {
+                TESTING_CHECK( magma_z_spmv( c_one, hB, hx, c_zero, hy, queue ));
+            }
+            end = magma_wtime();
+            res = 0.0;
+            for(magma_int_t k=0; k < hA.num_rows; k++ ){
+                res = res + MAGMA_Z_ABS(hy.val[k] - hrefvec.val[k]);
+            }
+            res = ref == 0 ? res : res / ref;
+            printf( "%% > CPU  : %.2e seconds %.2e GFLOP/s    (%s).\n",
+                (end-start)/200, FLOPS*200/(end-start), cpu_names[f] );
+            printf("%% |x-y|_F/|y| = %8.2e Tester spmv CPU %s:  %s\n",
+                res, cpu_names[f], ( res < accuracy ) ? "ok" : "failed" );
+            // values in single precision and bfloat16, accumulated in double
+            magma_int_t lval_bits[] = { 32, 16 };
+            for( magma_int_t p=0; p < 2 && cpu_formats[f] != Magma_CSR5; p++ ) {
+                double lval_accuracy = ( lval_bits[p] == 32 ) ? 1e-5 : 1e-2;
+                TESTING_CHECK( magma_zmlag_cpu( lval_bits[p], &hB, queue ));
+                start = magma_wtime();
+                for (j=0; j < 200; j++) {
+                    TESTING_CHECK( magma_z_spmv( c_one, hB, hx, c_zero, hy, queue ));
+                }
+                end = magma_wtime();
+                res = 0.0;
+                for(magma_int_t k=0; k < hA.num_rows; k++ ){
+                    res = res + MAGMA_Z_ABS(hy.val[k] - hrefvec.val[k]);
+                }
+                res = ref == 0 ? res : res / ref;
+                printf( "%% > CPU  : %.2e seconds %.2e GFLOP/s    (%s, %lld-bit values).\n",
+                    (end-start)/200, FLOPS*200/(end-start), cpu_names[f],
+                    (long long) lval_bits[p] );
+                printf("%% |x-y|_F/|y| = %8.2e Tester spmv CPU %s %lld-bit:  %s\n",
+                    res, cpu_names[f], (long long) lval_bits[p],
+                    ( res < max( accuracy, lval_accuracy ) ) ? "ok" : "failed" );
+            }
+            magma_zmfree( &hB, queue );
+        }
+
         cusparseDestroyMatDescr( descr  );
         descr = NULL;
         
@@ -638,6 +638,8 @@ subs = {
     ('sp1gmres',       'dp1gmres',       'cp1gmres',       'zp1gmres'        ),
     ('sjacobi',        'djacobi',        'cjacobi',        'zjacobi'         ),
     ('sftjacobi',      'dftjacobi',      'cftjacobi',      'zftjacobi'       ),
+    ('svbjacobi',      'dvbjacobi',      'cvbjacobi',      'zvbjacobi'       ),
+    ('smlag2s',        'dmlag2s',        'cmlag2c',        'zmlag2c'         ),
     ('siterref',       'diterref',       'citerref',       'ziterref'        ),
     ('silu',           'dilu',           'cilu',           'zilu'            ),
     ('sailu',          'dailu',          'cailu',          'zailu'           ),
@@ -652,6 +654,10 @@ subs = {
     ('scustom',        'dcustom',        'ccustom',        'zcustom'         ),
     ('sparilu',        'dparilu',        'cparilu',        'zparilu'         ),
     ('sparic',         'dparic',         'cparic',         'zparic'          ),
+    ('scacg',          'dcacg',          'ccacg',          'zcacg'           ),
+    ('scagmres',       'dcagmres',       'ccagmres',       'zcagmres'        ),
+    ('spipecg',        'dpipecg',        'cpipecg',        'zpipecg'         ),
+    ('spipegmres',     'dpipegmres',     'cpipegmres',     'zpipegmres'      ),
 
     # ----- SPARSE Iterative Eigensolvers
     ('slobpcg',        'dlobpcg',        'clobpcg',        'zlobpcg'         ),